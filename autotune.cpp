@@ -0,0 +1,193 @@
+/**
+ * Autotuning of the registered kernels.
+ *
+ * Cache file format, one record per line, fields separated by tabs:
+ *   device  cc  M  N  K  in  out  kernel  block  median_ms  registry
+ * Lines starting with '#' are comments. Lines without the registry field,
+ * from before it was added, never match.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "autotune.h"
+#include "kernelTiming.h"
+
+#define TUNE_CACHE_FIELDS 11
+
+static bool ParseMatmulType(const std::string &name, MatmulType *type) {
+    const MatmulType types[] = {MATMUL_FP32, MATMUL_FP16, MATMUL_BF16};
+
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (name == MatmulTypeName(types[i])) {
+            *type = types[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool ParseTuneRecord(const char *line, TuneRecord *record) {
+    std::vector<std::string> fields;
+    std::string current;
+
+    for (const char *p = line; *p != '\0' && *p != '\n' && *p != '\r'; ++p) {
+        if (*p == '\t') {
+            fields.push_back(current);
+            current.clear();
+        } else {
+            current += *p;
+        }
+    }
+
+    fields.push_back(current);
+
+    if (fields.size() == TUNE_CACHE_FIELDS - 1) {
+        fields.push_back(std::string());
+    }
+
+    if (fields.size() != TUNE_CACHE_FIELDS) {
+        return false;
+    }
+
+    record->device = fields[0];
+    record->kernel = fields[7];
+    record->registry = fields[10];
+
+    return sscanf(fields[1].c_str(), "%d.%d", &record->major,
+                  &record->minor) == 2 &&
+           sscanf(fields[2].c_str(), "%d", &record->M) == 1 &&
+           sscanf(fields[3].c_str(), "%d", &record->N) == 1 &&
+           sscanf(fields[4].c_str(), "%d", &record->K) == 1 &&
+           ParseMatmulType(fields[5], &record->inType) &&
+           ParseMatmulType(fields[6], &record->outType) &&
+           sscanf(fields[8].c_str(), "%d", &record->block_size) == 1 &&
+           sscanf(fields[9].c_str(), "%lf", &record->median_ms) == 1;
+}
+
+std::string RegistryFingerprint() {
+    int count;
+    const KernelEntry *registry = GetKernelRegistry(&count);
+
+    // 64-bit FNV-1a over the fields that tell the entries apart
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < count; i++) {
+        const KernelEntry &e = registry[i];
+        char text[128];
+        snprintf(text, sizeof(text), "%s/%d/%d/%d/%d/%d/%d/%d/%d/%d;",
+                 e.name, e.block_size, e.thread_tile, e.stages, e.vec_width,
+                 e.layout, e.inType, e.outType, e.compute, e.minArch);
+
+        for (const char *p = text; *p != '\0'; ++p) {
+            hash = (hash ^ static_cast<unsigned char>(*p)) *
+                   1099511628211ULL;
+        }
+    }
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", hash);
+    return hex;
+}
+
+void LoadTuneCache(const char *path, std::vector<TuneRecord> *records) {
+    FILE *f = fopen(path, "r");
+
+    if (f == NULL) {
+        return;
+    }
+
+    char line[1024];
+    int lineNumber = 0;
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        lineNumber++;
+
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        TuneRecord record;
+
+        if (ParseTuneRecord(line, &record)) {
+            records->push_back(record);
+        } else {
+            fprintf(stderr, "Warning: skipping malformed line %d of %s\n",
+                    lineNumber, path);
+        }
+    }
+
+    fclose(f);
+}
+
+bool AppendTuneRecord(const char *path, const TuneRecord &record) {
+    // Write the header only when the file is created
+    FILE *existing = fopen(path, "r");
+    bool created = existing == NULL;
+
+    if (existing != NULL) {
+        fclose(existing);
+    }
+
+    FILE *f = fopen(path, "a");
+
+    if (f == NULL) {
+        fprintf(stderr, "Failed to open %s for writing!\n", path);
+        return false;
+    }
+
+    if (created) {
+        fprintf(f, "# device\tcc\tM\tN\tK\tin\tout\tkernel\tblock\t"
+                   "median_ms\tregistry\n");
+    }
+
+    fprintf(f, "%s\t%d.%d\t%d\t%d\t%d\t%s\t%s\t%s\t%d\t%.6f\t%s\n",
+            record.device.c_str(), record.major, record.minor, record.M,
+            record.N, record.K, MatmulTypeName(record.inType),
+            MatmulTypeName(record.outType), record.kernel.c_str(),
+            record.block_size, record.median_ms, record.registry.c_str());
+    fclose(f);
+
+    return true;
+}
+
+const TuneRecord *FindTuneRecord(const std::vector<TuneRecord> &records,
+                                 const TuneRecord &key) {
+    // Later records win, so that a re-tuned problem overrides older entries
+    for (size_t i = records.size(); i-- > 0;) {
+        const TuneRecord &r = records[i];
+
+        if (r.device == key.device && r.major == key.major &&
+                r.minor == key.minor && r.M == key.M && r.N == key.N &&
+                r.K == key.K && r.inType == key.inType &&
+                r.outType == key.outType && r.registry == key.registry) {
+            return &r;
+        }
+    }
+
+    return NULL;
+}
+
+const KernelEntry *AutotuneSearch(
+    const std::vector<const KernelEntry *> &candidates, void *d_C,
+    const void *d_A, const void *d_B, int M, int N, int K, double *best_ms) {
+    const KernelEntry *best = NULL;
+    *best_ms = 0.0;
+
+    for (size_t i = 0; i < candidates.size(); i++) {
+        std::vector<float> times;
+        TimeKernelLaunches(candidates[i], d_C, d_A, d_B, M, N, K,
+                           AUTOTUNE_WARMUP, AUTOTUNE_ITERS, 0, &times);
+        double median = Percentile(times, 50.0);
+
+        if (best == NULL || median < *best_ms) {
+            best = candidates[i];
+            *best_ms = median;
+        }
+    }
+
+    return best;
+}
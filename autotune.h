@@ -0,0 +1,79 @@
+/**
+ * Autotuning of the registered kernels.
+ *
+ * For one device, problem size and pair of element types the candidates
+ * (the registered template instances: block size, thread tile, pipeline
+ * depth and vector width) are timed and the fastest one is kept. Winners
+ * of searches over all registered kernels are stored in a tab separated
+ * cache file, so that later runs on the same device and problem skip the
+ * search.
+ */
+
+#ifndef AUTOTUNE_H_
+#define AUTOTUNE_H_
+
+// System includes
+#include <string>
+#include <vector>
+
+#include "kernelRegistry.h"
+
+// Launches per candidate while searching, cheaper than a full benchmark
+#define AUTOTUNE_WARMUP 2
+#define AUTOTUNE_ITERS 20
+
+// Best kernel of one device, problem size and pair of element types
+struct TuneRecord {
+    // Key: device name, compute capability, C is M x N, A is M x K
+    std::string device;
+    int major;
+    int minor;
+    int M;
+    int N;
+    int K;
+    MatmulType inType;
+    MatmulType outType;
+
+    // RegistryFingerprint of the build that searched, so that one with
+    // other kernels searches again
+    std::string registry;
+
+    // Winner and its median time per launch
+    std::string kernel;
+    int block_size;
+    double median_ms;
+};
+
+/**
+ * Hash of the names and parameters of all registered kernels, as hex
+ * digits
+ */
+std::string RegistryFingerprint();
+
+/**
+ * Read all records of the cache file at path into records. A missing file
+ * is an empty cache; malformed lines are skipped with a warning.
+ */
+void LoadTuneCache(const char *path, std::vector<TuneRecord> *records);
+
+/**
+ * Append record to the cache file at path, creating it if needed
+ */
+bool AppendTuneRecord(const char *path, const TuneRecord &record);
+
+/**
+ * The last record in records with the same key as key, or NULL
+ */
+const TuneRecord *FindTuneRecord(const std::vector<TuneRecord> &records,
+                                 const TuneRecord &key);
+
+/**
+ * Time every candidate on the M x N x K problem with inputs d_A and d_B
+ * (already in the candidates' input type) and return the fastest one.
+ * best_ms receives its median time per launch.
+ */
+const KernelEntry *AutotuneSearch(
+    const std::vector<const KernelEntry *> &candidates, void *d_C,
+    const void *d_A, const void *d_B, int M, int N, int K, double *best_ms);
+
+#endif  // AUTOTUNE_H_
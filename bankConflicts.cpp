@@ -0,0 +1,97 @@
+/**
+ * Host-side model of the shared memory bank conflicts of the multi-block
+ * kernels.
+ */
+
+// System includes
+#include <algorithm>
+#include <vector>
+
+#include "bankConflicts.h"
+
+// Which element of a tile a lane touches, given its thread index
+enum TileAccess {
+    // (tx, ty): the element stored by the thread
+    ACCESS_OWN,
+
+    // (k, ty): the value of A read in the k-loop
+    ACCESS_ROW_K,
+
+    // (tx, k): the value of B read in the k-loop
+    ACCESS_COL_K
+};
+
+/**
+ * Wavefronts of one warp-wide access of warp warp to a tile
+ */
+static int CountWavefronts(SmemLayout layout, int block_size, int warp,
+                           TileAccess access, int k) {
+    std::vector<int> words[SMEM_BANKS];
+    int threads = block_size * block_size;
+    int wavefronts = 1;
+
+    for (int lane = 0; lane < 32; lane++) {
+        int tid = warp * 32 + lane;
+
+        if (tid >= threads) {
+            break;
+        }
+
+        int tx = tid % block_size;
+        int ty = tid / block_size;
+        int index;
+
+        switch (access) {
+        case ACCESS_ROW_K:
+            index = SmemIndex(layout, block_size, k, ty);
+            break;
+
+        case ACCESS_COL_K:
+            index = SmemIndex(layout, block_size, tx, k);
+            break;
+
+        default:
+            index = SmemIndex(layout, block_size, tx, ty);
+            break;
+        }
+
+        // Lanes reading the same word are served by one broadcast
+        std::vector<int> &bank = words[index % SMEM_BANKS];
+
+        if (std::find(bank.begin(), bank.end(), index) == bank.end()) {
+            bank.push_back(index);
+            wavefronts = std::max(wavefronts, static_cast<int>(bank.size()));
+        }
+    }
+
+    return wavefronts;
+}
+
+bool SimulateBankConflicts(const KernelEntry *kernel,
+                           BankConflictStats *stats) {
+    if (kernel->layout == SMEM_FIXED) {
+        return false;
+    }
+
+    int block_size = kernel->block_size;
+    int warps = (block_size * block_size + 31) / 32;
+    stats->requests = 0;
+    stats->wavefronts = 0;
+
+    for (int w = 0; w < warps; w++) {
+        // The stores of the A and B tiles
+        stats->requests += 2;
+        stats->wavefronts += 2 * CountWavefronts(kernel->layout, block_size,
+                                                 w, ACCESS_OWN, 0);
+
+        for (int k = 0; k < block_size; k++) {
+            stats->requests += 2;
+            stats->wavefronts += CountWavefronts(kernel->layout, block_size,
+                                                 w, ACCESS_ROW_K, k);
+            stats->wavefronts += CountWavefronts(kernel->layout, block_size,
+                                                 w, ACCESS_COL_K, k);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,37 @@
+/**
+ * Host-side model of the shared memory bank conflicts of the multi-block
+ * kernels.
+ *
+ * Every warp-wide shared memory access of one k-step of a block (the stores
+ * of the A and B tiles and the BLOCK_SIZE pairs of reads in the k-loop) is
+ * replayed with the addresses of the kernel's layout (sharedLayout.cuh).
+ * An access takes as many wavefronts as the largest number of distinct
+ * 32-bit words it touches in one bank; every wavefront beyond the first is
+ * a bank conflict.
+ */
+
+#ifndef BANK_CONFLICTS_H_
+#define BANK_CONFLICTS_H_
+
+#include "kernelRegistry.h"
+
+// Number of shared memory banks, each 32 bits wide
+#define SMEM_BANKS 32
+
+// Shared memory accesses of one block per k-step
+struct BankConflictStats {
+    // Warp-wide shared memory instructions
+    long requests;
+
+    // Passes through the banks they need; requests if conflict-free
+    long wavefronts;
+};
+
+/**
+ * Model the shared memory accesses of kernel; false if its layout is
+ * SMEM_FIXED and there is nothing to model
+ */
+bool SimulateBankConflicts(const KernelEntry *kernel,
+                           BankConflictStats *stats);
+
+#endif  // BANK_CONFLICTS_H_
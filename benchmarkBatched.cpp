@@ -0,0 +1,198 @@
+/**
+ * Benchmark of the batched kernels (-batch): single launches of
+ * the sample kernel per problem against strided and pointer-array
+ * batched launches.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "kernelTiming.h"
+#include "matmulBatched.h"
+#include "matrixUtils.h"
+
+// Batch of problems of one shape, for the launchers of RunBatched
+struct BatchedProblem {
+    const KernelEntry *single;
+    float *d_C;
+    float *d_A;
+    float *d_B;
+    float **d_Cs;
+    const float **d_As;
+    const float **d_Bs;
+    ProblemSize size;
+    int batch;
+};
+
+// One launch per problem: the baseline the batched kernels replace
+static void LaunchBatchLoop(void *context, cudaStream_t stream) {
+    const BatchedProblem *p = static_cast<const BatchedProblem *>(context);
+    const ProblemSize &s = p->size;
+
+    for (int i = 0; i < p->batch; i++) {
+        p->single->launch(p->d_C + static_cast<long long>(i) * s.M * s.N,
+                          p->d_A + static_cast<long long>(i) * s.M * s.K,
+                          p->d_B + static_cast<long long>(i) * s.K * s.N,
+                          s.M, s.N, s.K, NULL, stream);
+    }
+}
+
+static void LaunchStridedBatch(void *context, cudaStream_t stream) {
+    const BatchedProblem *p = static_cast<const BatchedProblem *>(context);
+    const ProblemSize &s = p->size;
+    MatrixMulStridedBatched(p->d_C, p->d_A, p->d_B, s.M, s.N, s.K,
+                            static_cast<long long>(s.M) * s.K,
+                            static_cast<long long>(s.K) * s.N,
+                            static_cast<long long>(s.M) * s.N, p->batch,
+                            p->single->block_size, stream);
+}
+
+static void LaunchPointerBatch(void *context, cudaStream_t stream) {
+    const BatchedProblem *p = static_cast<const BatchedProblem *>(context);
+    const ProblemSize &s = p->size;
+    MatrixMulBatched(p->d_Cs, p->d_As, p->d_Bs, s.M, s.N, s.K, p->batch,
+                     p->single->block_size, stream);
+}
+
+/**
+ * Compare batch single-problem launches of the sample kernel with one
+ * strided-batched and one pointer-array batched launch, for every size and
+ * block size; returns false if any result is wrong
+ */
+static bool RunBatched(const std::vector<ProblemSize> &sizes,
+                       const std::vector<std::string> &blockSizes, int batch,
+                       int warmup, int iters) {
+    const float valB = 0.01f;
+    const int blocks[] = {16, 32};
+    const char *modes[] = {"loop", "strided", "pointers"};
+    void (*launchers[])(void *, cudaStream_t) = {
+        LaunchBatchLoop, LaunchStridedBatch, LaunchPointerBatch
+    };
+    bool allCorrect = true;
+
+    printf("%-10s %5s %6s %6s %6s %6s %10s %12s %10s %s\n", "batched",
+           "block", "batch", "M", "N", "K", "median_ms", "us/problem",
+           "GFlop/s", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K * batch;
+        size_t size_B = static_cast<size_t>(size.K) * size.N * batch;
+        size_t size_C = static_cast<size_t>(size.M) * size.N * batch;
+
+        float *h_A = reinterpret_cast<float *>(malloc(sizeof(float) * size_A));
+        float *h_B = reinterpret_cast<float *>(malloc(sizeof(float) * size_B));
+        float *h_C = reinterpret_cast<float *>(malloc(sizeof(float) * size_C));
+
+        if (h_A == NULL || h_B == NULL || h_C == NULL) {
+            fprintf(stderr, "Failed to allocate host matrices!\n");
+            exit(EXIT_FAILURE);
+        }
+
+        ConstantInit(h_A, static_cast<int>(size_A), 1.0f);
+        ConstantInit(h_B, static_cast<int>(size_B), valB);
+
+        BatchedProblem p;
+        p.size = size;
+        p.batch = batch;
+        checkCudaErrors(cudaMalloc(&p.d_A, sizeof(float) * size_A));
+        checkCudaErrors(cudaMalloc(&p.d_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMalloc(&p.d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMemcpy(p.d_A, h_A,
+                                   sizeof(float) * size_A,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(p.d_B, h_B,
+                                   sizeof(float) * size_B,
+                                   cudaMemcpyHostToDevice));
+
+        // Pointer arrays into the same storage as the strided batch
+        std::vector<float *> h_Cs(batch);
+        std::vector<const float *> h_As(batch);
+        std::vector<const float *> h_Bs(batch);
+
+        for (int i = 0; i < batch; i++) {
+            h_As[i] = p.d_A + static_cast<size_t>(i) * size.M * size.K;
+            h_Bs[i] = p.d_B + static_cast<size_t>(i) * size.K * size.N;
+            h_Cs[i] = p.d_C + static_cast<size_t>(i) * size.M * size.N;
+        }
+
+        checkCudaErrors(cudaMalloc(&p.d_As, sizeof(float *) * batch));
+        checkCudaErrors(cudaMalloc(&p.d_Bs, sizeof(float *) * batch));
+        checkCudaErrors(cudaMalloc(&p.d_Cs, sizeof(float *) * batch));
+        checkCudaErrors(cudaMemcpy(p.d_As, &h_As[0], sizeof(float *) * batch,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(p.d_Bs, &h_Bs[0], sizeof(float *) * batch,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(p.d_Cs, &h_Cs[0], sizeof(float *) * batch,
+                                   cudaMemcpyHostToDevice));
+
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            char blockName[16];
+            snprintf(blockName, sizeof(blockName), "%d", blocks[b]);
+
+            if (!InList(blockSizes, blockName)) {
+                continue;
+            }
+
+            p.single = FindKernel("sample", blocks[b]);
+
+            for (int m = 0; m < 3; m++) {
+                checkCudaErrors(cudaMemset(p.d_C, 0, sizeof(float) * size_C));
+
+                std::vector<float> times;
+                TimeLaunches(launchers[m], &p, warmup, iters, 0, &times);
+                TimingStats stats = SummarizeTimes(times);
+
+                checkCudaErrors(cudaMemcpy(h_C, p.d_C, sizeof(float) * size_C,
+                                           cudaMemcpyDeviceToHost));
+                double eps = (size.K + 1) * UnitRoundoff(MATMUL_FP32);
+                bool correct = CheckResult(h_C, static_cast<int>(size_C),
+                                           size.K * valB, eps);
+                allCorrect = allCorrect && correct;
+
+                double flops = 2.0 * size.M * size.N * size.K * batch;
+                printf("%-10s %5d %6d %6d %6d %6d %10.4f %12.3f %10.2f %s\n",
+                       modes[m], blocks[b], batch, size.M, size.N, size.K,
+                       stats.median_ms, stats.median_ms * 1000.0 / batch,
+                       flops * 1.0e-6 / stats.median_ms,
+                       correct ? "PASS" : "FAIL");
+            }
+        }
+
+        free(h_A);
+        free(h_B);
+        free(h_C);
+        checkCudaErrors(cudaFree(p.d_A));
+        checkCudaErrors(cudaFree(p.d_B));
+        checkCudaErrors(cudaFree(p.d_C));
+        checkCudaErrors(cudaFree(p.d_As));
+        checkCudaErrors(cudaFree(p.d_Bs));
+        checkCudaErrors(cudaFree(p.d_Cs));
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkBatched(const BenchmarkOptions &options) {
+    int batch = getCmdLineArgumentInt(options.argc, options.argv, "batch");
+
+    if (batch < 1) {
+        printf("Error: need -batch >= 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return RunBatched(options.sizes, options.blockSizes, batch,
+                      options.warmup, options.iters);
+}
@@ -0,0 +1,172 @@
+/**
+ * Benchmark of repeated host-to-host calls (-calls): per-call
+ * allocation against a library handle and its panel pipeline.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "kernelTiming.h"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+
+/**
+ * One call of the original MatrixMultiply() flow on host matrices:
+ * allocate, copy in, launch, copy out and free
+ */
+static void MultiplyUnpooled(const KernelEntry *kernel, float *h_C,
+                             const float *h_A, const float *h_B,
+                             const ProblemSize &size) {
+    size_t bytes_A = sizeof(float) * size.M * size.K;
+    size_t bytes_B = sizeof(float) * size.K * size.N;
+    size_t bytes_C = sizeof(float) * size.M * size.N;
+    void *d_A, *d_B, *d_C, *d_W = NULL;
+    checkCudaErrors(cudaMalloc(&d_A, bytes_A));
+    checkCudaErrors(cudaMalloc(&d_B, bytes_B));
+    checkCudaErrors(cudaMalloc(&d_C, bytes_C));
+    checkCudaErrors(MallocWorkspace(kernel, size, &d_W));
+    checkCudaErrors(cudaMemcpy(d_A, h_A, bytes_A, cudaMemcpyHostToDevice));
+    checkCudaErrors(cudaMemcpy(d_B, h_B, bytes_B, cudaMemcpyHostToDevice));
+    kernel->launch(d_C, d_A, d_B, size.M, size.N, size.K, d_W, 0);
+    getLastCudaError("Kernel launch failed");
+    checkCudaErrors(cudaMemcpy(h_C, d_C, bytes_C, cudaMemcpyDeviceToHost));
+    checkCudaErrors(cudaFree(d_A));
+    checkCudaErrors(cudaFree(d_B));
+    checkCudaErrors(cudaFree(d_C));
+    checkCudaErrors(cudaFree(d_W));
+}
+
+/**
+ * Time calls host-to-host multiplications per size: allocating every
+ * buffer per call, through a library handle with its memory pool, and
+ * through the handle's panel pipeline on streams streams; returns false
+ * if any result is wrong
+ */
+static bool RunServiceLoop(const std::vector<ProblemSize> &sizes,
+                           const char *kernelName, int block_size,
+                           int calls, int streams, int panelRows) {
+    const float valB = 0.01f;
+    const char *modes[] = {"per-call", "handle", "pipelined"};
+    MatmulHandle handle;
+    checkCudaErrors(MatmulCreate(&handle));
+
+    if (MatmulSetPipeline(handle, streams, panelRows) != cudaSuccess) {
+        printf("Error: need 1 <= -streams <= 16 and -panel >= 0\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (kernelName != NULL &&
+            MatmulSetKernel(handle, kernelName, block_size) != cudaSuccess) {
+        printf("Error: no fp32 kernel %s with block size %d for this"
+               " device\n", kernelName, block_size);
+        exit(EXIT_FAILURE);
+    }
+
+    const KernelEntry *kernel = MatmulGetKernel(handle);
+
+    if (kernel->inType != MATMUL_FP32 || kernel->outType != MATMUL_FP32) {
+        printf("Error: the service loop needs an fp32 kernel\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bool allCorrect = true;
+    printf("Service loop with %s, block %d, %d pipeline streams\n",
+           kernel->name, kernel->block_size, streams);
+    printf("%-10s %6s %6s %6s %6s %10s %10s %10s %s\n", "mode", "calls",
+           "M", "N", "K", "median_ms", "p5_ms", "p95_ms", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        int size_A = size.M * size.K;
+        int size_B = size.K * size.N;
+        int size_C = size.M * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B), h_C(size_C);
+        ConstantInit(&h_A[0], size_A, 1.0f);
+        ConstantInit(&h_B[0], size_B, valB);
+
+        for (int m = 0; m < 3; m++) {
+            std::vector<float> times(calls);
+            StopWatchInterface *timer = NULL;
+            sdkCreateTimer(&timer);
+
+            for (int i = 0; i < calls; i++) {
+                sdkResetTimer(&timer);
+                sdkStartTimer(&timer);
+
+                if (m == 0) {
+                    MultiplyUnpooled(kernel, &h_C[0], &h_A[0], &h_B[0],
+                                     size);
+                } else if (m == 1) {
+                    checkCudaErrors(MatmulMultiplyHost(handle, &h_C[0],
+                                                       &h_A[0], &h_B[0],
+                                                       size.M, size.N,
+                                                       size.K));
+                } else {
+                    checkCudaErrors(MatmulMultiplyHostPipelined(
+                        handle, &h_C[0], &h_A[0], &h_B[0], size.M, size.N,
+                        size.K));
+                }
+
+                sdkStopTimer(&timer);
+                times[i] = sdkGetTimerValue(&timer);
+            }
+
+            sdkDeleteTimer(&timer);
+
+            double eps = (size.K + 1) * UnitRoundoff(MATMUL_FP32) +
+                         ComputeRoundoff(kernel->compute);
+            bool correct = CheckResult(&h_C[0], size_C, size.K * valB, eps);
+            allCorrect = allCorrect && correct;
+
+            TimingStats stats = SummarizeTimes(times);
+            printf("%-10s %6d %6d %6d %6d %10.4f %10.4f %10.4f %s\n",
+                   modes[m], calls, size.M, size.N, size.K,
+                   stats.median_ms, stats.p5_ms, stats.p95_ms,
+                   correct ? "PASS" : "FAIL");
+        }
+    }
+
+    DeviceAllocatorStats pool = MatmulGetPoolStats(handle);
+    printf("Pool: %ld hits, %ld misses, %zu bytes cached\n", pool.hits,
+           pool.misses, pool.cachedBytes);
+    checkCudaErrors(MatmulDestroy(handle));
+
+    return allCorrect;
+}
+
+bool BenchmarkCalls(const BenchmarkOptions &options) {
+    int calls = getCmdLineArgumentInt(options.argc, options.argv, "calls");
+
+    if (calls < 1) {
+        printf("Error: need -calls >= 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int streams = MATMUL_PIPELINE_STREAMS;
+    int panelRows = 0;
+
+    if (checkCmdLineFlag(options.argc, options.argv, "streams")) {
+        streams = getCmdLineArgumentInt(options.argc, options.argv,
+                                        "streams");
+    }
+
+    if (checkCmdLineFlag(options.argc, options.argv, "panel")) {
+        panelRows = getCmdLineArgumentInt(options.argc, options.argv,
+                                          "panel");
+    }
+
+    return RunServiceLoop(options.sizes, FirstKernelName(options),
+                          FirstBlockSize(options), calls, streams,
+                          panelRows);
+}
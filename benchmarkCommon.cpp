@@ -0,0 +1,107 @@
+/**
+ * Parts of the matrix multiplication benchmark that its modes share.
+ */
+
+// System includes
+#include <stdlib.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "matrixUtils.h"
+
+std::vector<std::string> SplitList(const char *list) {
+    std::vector<std::string> items;
+    std::string current;
+
+    for (const char *p = list; ; ++p) {
+        if (*p == ',' || *p == '\0') {
+            if (!current.empty()) {
+                items.push_back(current);
+            }
+
+            current.clear();
+
+            if (*p == '\0') {
+                break;
+            }
+        } else {
+            current += *p;
+        }
+    }
+
+    return items;
+}
+
+bool InList(const std::vector<std::string> &list, const char *name) {
+    if (list.empty()) {
+        return true;
+    }
+
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i] == name) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unsigned int SeedOption(const BenchmarkOptions &options) {
+    if (checkCmdLineFlag(options.argc, options.argv, "seed")) {
+        return getCmdLineArgumentInt(options.argc, options.argv, "seed");
+    }
+
+    return 2024;
+}
+
+const char *FirstKernelName(const BenchmarkOptions &options) {
+    return options.kernelNames.empty() ? NULL :
+           options.kernelNames[0].c_str();
+}
+
+int FirstBlockSize(const BenchmarkOptions &options) {
+    return options.blockSizes.empty() ? 16 :
+           atoi(options.blockSizes[0].c_str());
+}
+
+size_t OutOfCoreBytes(const BenchmarkOptions &options) {
+    if (!checkCmdLineFlag(options.argc, options.argv, "oocmem")) {
+        return 0;
+    }
+
+    return static_cast<size_t>(getCmdLineArgumentInt(
+               options.argc, options.argv, "oocmem")) << 20;
+}
+
+void UploadInputs(MatmulType type, const float *h_A, const float *h_B,
+                  void *h_staging, void *d_A, void *d_B, int size_A,
+                  int size_B, int *loadedType) {
+    if (*loadedType == type) {
+        return;
+    }
+
+    size_t elem = MatmulTypeSize(type);
+    ConvertFromFloat(type, h_A, h_staging, size_A);
+    checkCudaErrors(cudaMemcpy(d_A, h_staging, elem * size_A,
+                               cudaMemcpyHostToDevice));
+    ConvertFromFloat(type, h_B, h_staging, size_B);
+    checkCudaErrors(cudaMemcpy(d_B, h_staging, elem * size_B,
+                               cudaMemcpyHostToDevice));
+    *loadedType = type;
+}
+
+cudaError_t MallocWorkspace(const KernelEntry *kernel,
+                            const ProblemSize &size, void **d_W) {
+    size_t bytes = kernel->workspace != NULL ?
+                   kernel->workspace(size.M, size.N, size.K) : 0;
+    *d_W = NULL;
+    return bytes > 0 ? cudaMalloc(d_W, bytes) : cudaSuccess;
+}
+
+double VerifyTolerance(const KernelEntry *kernel, int K) {
+    return 2.0 * (K + 1) * UnitRoundoff(MATMUL_FP32) +
+           UnitRoundoff(kernel->outType) + ComputeRoundoff(kernel->compute);
+}
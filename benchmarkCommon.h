@@ -0,0 +1,98 @@
+/**
+ * Parts of the matrix multiplication benchmark that its modes share:
+ * problem sizes, the options main parses for every mode, and helpers for
+ * flags and device buffers.
+ */
+
+#ifndef BENCHMARK_COMMON_H_
+#define BENCHMARK_COMMON_H_
+
+// System includes
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_cuda.h>
+
+#include "kernelRegistry.h"
+
+// C is M x N, A is M x K and B is K x N
+struct ProblemSize {
+    int M;
+    int N;
+    int K;
+};
+
+// Command line and device of a run, as main parsed them
+struct BenchmarkOptions {
+    int argc;
+    const char **argv;
+
+    // -sizes, or the single problem of -hA, -wB and -wA
+    std::vector<ProblemSize> sizes;
+
+    // -kernel and -block, empty for all
+    std::vector<std::string> kernelNames;
+    std::vector<std::string> blockSizes;
+
+    int warmup;
+    int iters;
+
+    // Compute capability of the device as major * 10 + minor, 0 without
+    // one
+    int arch;
+};
+
+/**
+ * Split a comma separated list into its items
+ */
+std::vector<std::string> SplitList(const char *list);
+
+/**
+ * Whether name is in list; an empty list holds every name
+ */
+bool InList(const std::vector<std::string> &list, const char *name);
+
+// -seed, 2024 if it is not given
+unsigned int SeedOption(const BenchmarkOptions &options);
+
+// The first of -kernel, or NULL for the library's default
+const char *FirstKernelName(const BenchmarkOptions &options);
+
+// The first of -block, 16 if it is not given
+int FirstBlockSize(const BenchmarkOptions &options);
+
+// -oocmem in bytes, 0 for most of the free memory
+size_t OutOfCoreBytes(const BenchmarkOptions &options);
+
+/**
+ * Convert the fp32 host inputs to type and copy them to d_A and d_B, unless
+ * loadedType says they already hold that type
+ */
+void UploadInputs(MatmulType type, const float *h_A, const float *h_B,
+                  void *h_staging, void *d_A, void *d_B, int size_A,
+                  int size_B, int *loadedType);
+
+// *d_W receives the workspace of kernel for size, NULL if it needs none
+cudaError_t MallocWorkspace(const KernelEntry *kernel,
+                            const ProblemSize &size, void **d_W);
+
+/**
+ * Tolerance of the error relative to |A| * |B|: the fp32 accumulations of
+ * the kernel and of the reference, the rounding to the output type and
+ * that of the inputs to TF32
+ */
+double VerifyTolerance(const KernelEntry *kernel, int K);
+
+// Device copy of n host values
+template <typename T> T *UploadArray(const T *h, size_t n) {
+    T *d;
+    checkCudaErrors(cudaMalloc(&d, sizeof(T) * n));
+    checkCudaErrors(cudaMemcpy(d, h, sizeof(T) * n, cudaMemcpyHostToDevice));
+    return d;
+}
+
+#endif  // BENCHMARK_COMMON_H_
@@ -0,0 +1,154 @@
+/**
+ * Benchmark of the compute modes (-compute): fp32 GEMM in fp32, TF32
+ * and 3xTF32.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+#include "matmulLibrary.h"
+#include "matmulVerify.h"
+
+// One GEMM of -compute through the library
+struct ComputePlan {
+    MatmulHandle handle;
+    ProblemSize size;
+    void *d_C;
+    const void *d_A;
+    const void *d_B;
+};
+
+static void LaunchComputePlan(void *context, cudaStream_t) {
+    const ComputePlan *p = static_cast<const ComputePlan *>(context);
+    MatmulMultiplyDevice(p->handle, p->d_C, p->d_A, p->d_B, p->size.M,
+                         p->size.N, p->size.K);
+}
+
+/**
+ * fp32 GEMM of random matrices in each compute mode of the library: speed,
+ * and the error against a host reference of the fp32 inputs. A mode the
+ * device cannot run is shown with the mode and kernel it fell back to.
+ */
+static bool RunComputeModes(const std::vector<ProblemSize> &sizes,
+                            unsigned int seed, int warmup, int iters) {
+    const MatmulCompute modes[] = {
+        MATMUL_COMPUTE_FP32, MATMUL_COMPUTE_TF32, MATMUL_COMPUTE_3XTF32
+    };
+    ComputePlan p;
+    checkCudaErrors(MatmulCreate(&p.handle));
+    cudaStream_t stream = MatmulGetStream(p.handle);
+    bool allCorrect = true;
+    printf("%-7s %-7s %-10s %5s %6s %6s %6s %10s %10s %9s %10s %8s %s\n",
+           "mode", "runs", "kernel", "block", "M", "N", "K", "median_ms",
+           "GFlop/s", "max/tol", "mean_rel", "<=1ulp", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B), ref(size_C), mag(size_C);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        float *d_A, *d_B, *d_C, *d_ref, *d_mag;
+        checkCudaErrors(cudaMalloc(&d_A, sizeof(float) * size_A));
+        checkCudaErrors(cudaMalloc(&d_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_ref, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_mag, sizeof(float) * size_C));
+        checkCudaErrors(cudaMemcpy(d_A, &h_A[0], sizeof(float) * size_A,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(d_B, &h_B[0], sizeof(float) * size_B,
+                                   cudaMemcpyHostToDevice));
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &ref[0], size.N, 0);
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = fabsf(h_A[i]);
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = fabsf(h_B[i]);
+        }
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &mag[0], size.N, 0);
+        checkCudaErrors(cudaMemcpy(d_ref, &ref[0], sizeof(float) * size_C,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(d_mag, &mag[0], sizeof(float) * size_C,
+                                   cudaMemcpyHostToDevice));
+
+        p.size = size;
+        p.d_C = d_C;
+        p.d_A = d_A;
+        p.d_B = d_B;
+
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            checkCudaErrors(MatmulSetComputeMode(p.handle, modes[m]));
+            const KernelEntry *kernel = MatmulGetKernel(p.handle);
+
+            // NaNs in C catch elements that are never written
+            checkCudaErrors(cudaMemsetAsync(d_C, 0xff, sizeof(float) * size_C,
+                                            stream));
+
+            std::vector<float> times;
+            TimeLaunches(LaunchComputePlan, &p, warmup, iters, stream,
+                         &times);
+            checkCudaErrors(cudaGetLastError());
+            TimingStats stats = SummarizeTimes(times);
+
+            VerifyStats error;
+            checkCudaErrors(CompareOnDevice(d_C, MATMUL_FP32, d_ref, d_mag,
+                                            size_C, &error, stream));
+            double ratio = error.maxRelError / VerifyTolerance(kernel,
+                                                               size.K);
+            bool correct = ratio <= 1.0 && error.nonFinite == 0;
+            double flops = 2.0 * size.M * static_cast<double>(size.N) *
+                           size.K;
+            printf("%-7s %-7s %-10s %5d %6d %6d %6d %10.4f %10.2f %9.3f"
+                   " %10.2e %7.2f%% %s\n", MatmulComputeName(modes[m]),
+                   MatmulComputeName(MatmulGetComputeMode(p.handle)),
+                   kernel->name, kernel->block_size, size.M, size.N, size.K,
+                   stats.median_ms, flops * 1.0e-6 / stats.median_ms, ratio,
+                   error.meanRelError, 100.0 * FractionWithinUlps(error, 1),
+                   correct ? "ok" : "FAIL");
+            allCorrect = allCorrect && correct;
+        }
+
+        checkCudaErrors(cudaFree(d_A));
+        checkCudaErrors(cudaFree(d_B));
+        checkCudaErrors(cudaFree(d_C));
+        checkCudaErrors(cudaFree(d_ref));
+        checkCudaErrors(cudaFree(d_mag));
+    }
+
+    checkCudaErrors(MatmulDestroy(p.handle));
+    return allCorrect;
+}
+
+bool BenchmarkCompute(const BenchmarkOptions &options) {
+    return RunComputeModes(options.sizes, SeedOption(options),
+                           options.warmup, options.iters);
+}
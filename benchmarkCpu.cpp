@@ -0,0 +1,125 @@
+/**
+ * Benchmark of the host GEMM (-cpu), which also runs without a CUDA
+ * device.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+
+/**
+ * Time CpuGemm with threads host threads (0 for all) on random matrices
+ * of every size, and check a sample of its rows against a dot product in
+ * double precision; returns false if any result is wrong. Needs no CUDA
+ * device.
+ */
+static bool RunCpu(const std::vector<ProblemSize> &sizes, int threads,
+                   int warmup, int iters) {
+    bool allCorrect = true;
+    printf("CPU GEMM (%s), %d threads (0 = all)\n", CpuGemmIsa(), threads);
+    printf("%6s %6s %6s %10s %10s %10s %s\n", "M", "N", "K", "median_ms",
+           "p5_ms", "GFlop/s", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        std::vector<float> h_A(static_cast<size_t>(size.M) * size.K);
+        std::vector<float> h_B(static_cast<size_t>(size.K) * size.N);
+        std::vector<float> h_C(static_cast<size_t>(size.M) * size.N);
+        srand(2024);
+
+        for (size_t i = 0; i < h_A.size(); i++) {
+            h_A[i] = rand() / static_cast<float>(RAND_MAX) - 0.5f;
+        }
+
+        for (size_t i = 0; i < h_B.size(); i++) {
+            h_B[i] = rand() / static_cast<float>(RAND_MAX) - 0.5f;
+        }
+
+        std::vector<float> times;
+        StopWatchInterface *timer = NULL;
+        sdkCreateTimer(&timer);
+
+        for (int i = 0; i < warmup + iters; i++) {
+            sdkResetTimer(&timer);
+            sdkStartTimer(&timer);
+            CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0],
+                    size.N, &h_C[0], size.N, threads);
+            sdkStopTimer(&timer);
+
+            if (i >= warmup) {
+                times.push_back(sdkGetTimerValue(&timer));
+            }
+        }
+
+        sdkDeleteTimer(&timer);
+        TimingStats stats = SummarizeTimes(times);
+
+        // The error of a sum of K products is bounded by K unit roundoffs
+        // times the sum of their magnitudes
+        bool correct = true;
+        int step = size.M > 64 ? size.M / 64 : 1;
+
+        for (int r = 0; r < size.M && correct; r += step) {
+            const float *a = &h_A[static_cast<size_t>(r) * size.K];
+            const float *c = &h_C[static_cast<size_t>(r) * size.N];
+
+            for (int n = 0; n < size.N && correct; n++) {
+                double ref = 0.0;
+                double magnitude = 0.0;
+
+                for (int k = 0; k < size.K; k++) {
+                    double p = static_cast<double>(a[k]) *
+                               h_B[static_cast<size_t>(k) * size.N + n];
+                    ref += p;
+                    magnitude += fabs(p);
+                }
+
+                if (fabs(c[n] - ref) > (size.K + 1) *
+                        UnitRoundoff(MATMUL_FP32) * magnitude) {
+                    printf("Error! Matrix[%05d][%05d]=%.8f, ref=%.8f\n", r,
+                           n, c[n], ref);
+                    correct = false;
+                }
+            }
+        }
+
+        double flops = 2.0 * size.M * size.N * size.K;
+        printf("%6d %6d %6d %10.3f %10.3f %10.2f %s\n", size.M, size.N,
+               size.K, stats.median_ms, stats.p5_ms,
+               flops * 1.0e-6 / stats.median_ms, correct ? "ok" : "FAIL");
+        allCorrect = allCorrect && correct;
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkCpu(const BenchmarkOptions &options) {
+    int threads = 0;
+    int iters = options.iters;
+
+    if (checkCmdLineFlag(options.argc, options.argv, "threads")) {
+        threads = getCmdLineArgumentInt(options.argc, options.argv,
+                                        "threads");
+    }
+
+    // -iters is meant for kernels; 10 runs suffice on the host
+    if (!checkCmdLineFlag(options.argc, options.argv, "iters")) {
+        iters = 10;
+    }
+
+    return RunCpu(options.sizes, threads, options.warmup, iters);
+}
@@ -0,0 +1,200 @@
+/**
+ * Benchmark of the fused epilogue (-epilogue) against a separate
+ * alpha/beta, bias and activation pass.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "kernelTiming.h"
+#include "matmulEpilogue.h"
+#include "matrixUtils.h"
+
+// Device buffers of one RunEpilogue problem
+struct EpilogueProblem {
+    const KernelEntry *kernel;
+    float *d_A;
+    float *d_B;
+    float *d_C;
+
+    // Accumulators of the unfused kernel
+    float *d_P;
+    ProblemSize size;
+    MatmulEpilogue epilogue;
+};
+
+// The kernel into a temporary, then the epilogue as a second pass
+static void LaunchSeparateEpilogue(void *context, cudaStream_t stream) {
+    const EpilogueProblem *p = static_cast<const EpilogueProblem *>(context);
+    const ProblemSize &s = p->size;
+    p->kernel->launch(p->d_P, p->d_A, p->d_B, s.M, s.N, s.K, NULL, stream);
+    MatrixApplyEpilogue(p->d_C, p->d_P, s.M, s.N, p->epilogue, stream);
+}
+
+static void LaunchFusedEpilogue(void *context, cudaStream_t stream) {
+    const EpilogueProblem *p = static_cast<const EpilogueProblem *>(context);
+    const ProblemSize &s = p->size;
+    MatrixMulEpilogue(p->d_C, p->d_A, p->d_B, s.M, s.N, s.K, p->epilogue,
+                      p->kernel->block_size, stream);
+}
+
+// Host version of the activations of epilogue.cuh
+static double ActivateHost(EpilogueActivation activation, double v) {
+    if (activation == EPILOGUE_ACT_RELU) {
+        return v > 0.0 ? v : 0.0;
+    }
+
+    if (activation == EPILOGUE_ACT_GELU) {
+        return 0.5 * v * (1.0 + tanh(0.7978845608 *
+                                     (v + 0.044715 * v * v * v)));
+    }
+
+    return v;
+}
+
+/**
+ * Compare C = act(alpha * A * B + beta * C + bias) as regTile4 followed by
+ * a separate epilogue pass with the fused epilogue of the same kernel, for
+ * every size and block size; returns false if any result is wrong
+ */
+static bool RunEpilogue(const std::vector<ProblemSize> &sizes,
+                        const std::vector<std::string> &blockSizes,
+                        EpilogueActivation activation, int warmup,
+                        int iters) {
+    const float valB = 0.01f;
+    const float valC = 1.0f;
+    const float valBias = 0.25f;
+    const int blocks[] = {16, 32};
+    const char *modes[] = {"separate", "fused"};
+    void (*launchers[])(void *, cudaStream_t) = {
+        LaunchSeparateEpilogue, LaunchFusedEpilogue
+    };
+    bool allCorrect = true;
+
+    printf("Epilogue: C = %s(2 * A * B + 0.5 * C + bias[col])\n",
+           EpilogueActivationName(activation));
+    printf("%-10s %5s %6s %6s %6s %10s %10s %s\n", "epilogue", "block", "M",
+           "N", "K", "median_ms", "GFlop/s", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        int size_A = size.M * size.K;
+        int size_B = size.K * size.N;
+        int size_C = size.M * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B), h_C(size_C);
+        std::vector<float> h_bias(size.N);
+        ConstantInit(&h_A[0], size_A, 1.0f);
+        ConstantInit(&h_B[0], size_B, valB);
+        ConstantInit(&h_bias[0], size.N, valBias);
+
+        EpilogueProblem p;
+        float *d_bias;
+        p.size = size;
+        checkCudaErrors(cudaMalloc(&p.d_A, sizeof(float) * size_A));
+        checkCudaErrors(cudaMalloc(&p.d_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMalloc(&p.d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&p.d_P, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_bias, sizeof(float) * size.N));
+        checkCudaErrors(cudaMemcpy(p.d_A, &h_A[0], sizeof(float) * size_A,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(p.d_B, &h_B[0], sizeof(float) * size_B,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(d_bias, &h_bias[0],
+                                   sizeof(float) * size.N,
+                                   cudaMemcpyHostToDevice));
+
+        p.epilogue.alpha = 2.0f;
+        p.epilogue.beta = 0.5f;
+        p.epilogue.biasMode = EPILOGUE_BIAS_COL;
+        p.epilogue.bias = d_bias;
+        p.epilogue.activation = activation;
+        p.epilogue.outType = MATMUL_FP32;
+        double ref = ActivateHost(activation, 2.0 * size.K * valB +
+                                  0.5 * valC + valBias);
+
+        for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+            char blockName[16];
+            snprintf(blockName, sizeof(blockName), "%d", blocks[b]);
+
+            if (!InList(blockSizes, blockName)) {
+                continue;
+            }
+
+            p.kernel = FindKernel("regTile4", blocks[b]);
+
+            for (int m = 0; m < 2; m++) {
+                // beta feeds C back into itself, so time first and check
+                // one call on a fresh C afterwards
+                std::vector<float> times;
+                TimeLaunches(launchers[m], &p, warmup, iters, 0, &times);
+                TimingStats stats = SummarizeTimes(times);
+
+                ConstantInit(&h_C[0], size_C, valC);
+                checkCudaErrors(cudaMemcpy(p.d_C, &h_C[0],
+                                           sizeof(float) * size_C,
+                                           cudaMemcpyHostToDevice));
+                launchers[m](&p, 0);
+                getLastCudaError("Kernel launch failed");
+                checkCudaErrors(cudaMemcpy(&h_C[0], p.d_C,
+                                           sizeof(float) * size_C,
+                                           cudaMemcpyDeviceToHost));
+
+                // The GELU approximation differs slightly between tanhf and
+                // the host tanh
+                double eps = (size.K + 4) * UnitRoundoff(MATMUL_FP32) +
+                             (activation == EPILOGUE_ACT_GELU ? 1.0e-5 : 0.0);
+                bool correct = CheckResult(&h_C[0], size_C,
+                                           static_cast<float>(ref), eps);
+                allCorrect = allCorrect && correct;
+
+                double flops = 2.0 * size.M * static_cast<double>(size.N) *
+                               size.K;
+                printf("%-10s %5d %6d %6d %6d %10.4f %10.2f %s\n", modes[m],
+                       blocks[b], size.M, size.N, size.K, stats.median_ms,
+                       flops * 1.0e-6 / stats.median_ms,
+                       correct ? "PASS" : "FAIL");
+            }
+        }
+
+        checkCudaErrors(cudaFree(p.d_A));
+        checkCudaErrors(cudaFree(p.d_B));
+        checkCudaErrors(cudaFree(p.d_C));
+        checkCudaErrors(cudaFree(p.d_P));
+        checkCudaErrors(cudaFree(d_bias));
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkEpilogue(const BenchmarkOptions &options) {
+    EpilogueActivation activation = EPILOGUE_ACT_RELU;
+    char *arg = NULL;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "epilogue",
+                                 &arg)) {
+        if (strcmp(arg, "gelu") == 0) {
+            activation = EPILOGUE_ACT_GELU;
+        } else if (strcmp(arg, "none") == 0) {
+            activation = EPILOGUE_ACT_NONE;
+        } else if (strcmp(arg, "relu") != 0) {
+            printf("Error: unknown activation %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return RunEpilogue(options.sizes, options.blockSizes, activation,
+                       options.warmup, options.iters);
+}
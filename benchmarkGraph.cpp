@@ -0,0 +1,283 @@
+/**
+ * Benchmark of CUDA graphs (-graph): eager launches of a plan
+ * against replays of its graph, and the cost of capture and update.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "kernelTiming.h"
+#include "matmulEpilogue.h"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+
+/**
+ * Buffers of the RunGraph plan: upload A, multiply with the handle's
+ * kernel, bias and ReLU as a separate pass, download C. A and C come in
+ * two sets, to replay the plan on other buffers.
+ */
+struct GraphPlan {
+    MatmulHandle handle;
+    MatmulGraph graph;
+    ProblemSize size;
+    float *h_A;
+    float *h_C[2];
+    float *d_A[2];
+    float *d_C[2];
+    float *d_B;
+    float *d_P;
+    MatmulEpilogue epilogue;
+
+    // Buffer set that the next eager launch uses
+    int set;
+};
+
+static void LaunchEagerPlan(void *context, cudaStream_t stream) {
+    const GraphPlan *p = static_cast<const GraphPlan *>(context);
+    const ProblemSize &s = p->size;
+    size_t bytes_A = sizeof(float) * s.M * s.K;
+    size_t bytes_C = sizeof(float) * s.M * s.N;
+    cudaMemcpyAsync(p->d_A[p->set], p->h_A, bytes_A, cudaMemcpyHostToDevice,
+                    stream);
+    MatmulMultiplyDevice(p->handle, p->d_P, p->d_A[p->set], p->d_B, s.M, s.N,
+                         s.K);
+    MatrixApplyEpilogue(p->d_C[p->set], p->d_P, s.M, s.N, p->epilogue,
+                        stream);
+    cudaMemcpyAsync(p->h_C[p->set], p->d_C[p->set], bytes_C,
+                    cudaMemcpyDeviceToHost, stream);
+}
+
+static void LaunchGraphPlan(void *context, cudaStream_t stream) {
+    const GraphPlan *p = static_cast<const GraphPlan *>(context);
+    MatmulGraphLaunch(p->graph, stream);
+}
+
+// MatmulMultiplyHostPipelined of pinned matrices, and its recording
+struct PipePlan {
+    MatmulHandle handle;
+    MatmulGraph graph;
+    ProblemSize size;
+    float *h_A;
+    float *h_B;
+    float *h_C;
+};
+
+static void LaunchEagerPipe(void *context, cudaStream_t) {
+    const PipePlan *q = static_cast<const PipePlan *>(context);
+    MatmulMultiplyHostPipelined(q->handle, q->h_C, q->h_A, q->h_B, q->size.M,
+                                q->size.N, q->size.K);
+}
+
+static void LaunchGraphPipe(void *context, cudaStream_t stream) {
+    const PipePlan *q = static_cast<const PipePlan *>(context);
+    MatmulGraphLaunch(q->graph, stream);
+}
+
+// Median host time in microseconds of a launch followed by a synchronize
+static double SyncedLatency(void (*launch)(void *, cudaStream_t),
+                            void *context, int iters, cudaStream_t stream) {
+    std::vector<float> times(iters);
+    StopWatchInterface *timer = NULL;
+    sdkCreateTimer(&timer);
+
+    for (int i = 0; i < iters; i++) {
+        sdkResetTimer(&timer);
+        sdkStartTimer(&timer);
+        launch(context, stream);
+        checkCudaErrors(cudaStreamSynchronize(stream));
+        sdkStopTimer(&timer);
+        times[i] = sdkGetTimerValue(&timer);
+    }
+
+    sdkDeleteTimer(&timer);
+    return SummarizeTimes(times).median_ms * 1000.0;
+}
+
+// Record the plan on buffer set set into p->graph; returns the host time
+// of capture and instantiation or update in microseconds
+static double CapturePlan(GraphPlan *p, int set) {
+    StopWatchInterface *timer = NULL;
+    sdkCreateTimer(&timer);
+    sdkStartTimer(&timer);
+    p->set = set;
+    checkCudaErrors(MatmulCaptureBegin(p->handle));
+    LaunchEagerPlan(p, MatmulGetStream(p->handle));
+    checkCudaErrors(MatmulCaptureEnd(p->handle, &p->graph));
+    sdkStopTimer(&timer);
+    double us = sdkGetTimerValue(&timer) * 1000.0;
+    sdkDeleteTimer(&timer);
+    return us;
+}
+
+/**
+ * Compare eager launches of a copy, GEMM, epilogue, copy plan with replays
+ * of its CUDA graph, back to back and synchronized after every call, and
+ * the cost of capturing it and of updating it to other buffers; returns
+ * false if any result is wrong
+ */
+static bool RunGraph(const std::vector<ProblemSize> &sizes,
+                     const char *kernelName, int block_size, int warmup,
+                     int iters) {
+    const float valB = 0.01f;
+    const float valBias = 0.25f;
+    const char *modes[] = {"eager", "graph"};
+    void (*launchers[])(void *, cudaStream_t) = {
+        LaunchEagerPlan, LaunchGraphPlan
+    };
+    GraphPlan p;
+    checkCudaErrors(MatmulCreate(&p.handle));
+
+    if (kernelName != NULL &&
+            MatmulSetKernel(p.handle, kernelName, block_size) !=
+            cudaSuccess) {
+        printf("Error: no kernel %s with block size %d for this device\n",
+               kernelName, block_size);
+        exit(EXIT_FAILURE);
+    }
+
+    const KernelEntry *kernel = MatmulGetKernel(p.handle);
+
+    if (kernel->inType != MATMUL_FP32 || kernel->outType != MATMUL_FP32) {
+        printf("Error: the graph plan needs an fp32 kernel\n");
+        exit(EXIT_FAILURE);
+    }
+
+    cudaStream_t stream = MatmulGetStream(p.handle);
+    bool allCorrect = true;
+    printf("Graph plan H2D A, %s block %d, bias + relu, D2H C; pipe:"
+           " MatmulMultiplyHostPipelined\n", kernel->name,
+           kernel->block_size);
+    printf("%-6s %6s %6s %6s %12s %12s\n", "mode", "M", "N", "K",
+           "median_us", "synced_us");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        int size_A = size.M * size.K;
+        int size_B = size.K * size.N;
+        int size_C = size.M * size.N;
+        std::vector<float> h_B(size_B), h_bias(size.N);
+        float *d_bias;
+        ConstantInit(&h_B[0], size_B, valB);
+        ConstantInit(&h_bias[0], size.N, valBias);
+
+        p.size = size;
+        p.graph = NULL;
+        checkCudaErrors(cudaMallocHost(&p.h_A, sizeof(float) * size_A));
+        ConstantInit(p.h_A, size_A, 1.0f);
+
+        for (int b = 0; b < 2; b++) {
+            checkCudaErrors(cudaMallocHost(&p.h_C[b], sizeof(float) * size_C));
+            checkCudaErrors(cudaMalloc(&p.d_A[b], sizeof(float) * size_A));
+            checkCudaErrors(cudaMalloc(&p.d_C[b], sizeof(float) * size_C));
+        }
+
+        checkCudaErrors(cudaMalloc(&p.d_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMalloc(&p.d_P, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_bias, sizeof(float) * size.N));
+        checkCudaErrors(cudaMemcpy(p.d_B, &h_B[0], sizeof(float) * size_B,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(d_bias, &h_bias[0],
+                                   sizeof(float) * size.N,
+                                   cudaMemcpyHostToDevice));
+
+        p.epilogue.alpha = 1.0f;
+        p.epilogue.beta = 0.0f;
+        p.epilogue.biasMode = EPILOGUE_BIAS_COL;
+        p.epilogue.bias = d_bias;
+        p.epilogue.activation = EPILOGUE_ACT_RELU;
+        p.epilogue.outType = MATMUL_FP32;
+
+        double captureUs = CapturePlan(&p, 0);
+        p.set = 0;
+
+        for (int m = 0; m < 2; m++) {
+            std::vector<float> times;
+            TimeLaunches(launchers[m], &p, warmup, iters, stream, &times);
+            TimingStats stats = SummarizeTimes(times);
+            double synced = SyncedLatency(launchers[m], &p, iters, stream);
+            printf("%-6s %6d %6d %6d %12.2f %12.2f\n", modes[m], size.M,
+                   size.N, size.K, stats.median_ms * 1000.0, synced);
+        }
+
+        // The same plan on the second buffer set, replayed once
+        double updateUs = CapturePlan(&p, 1);
+        checkCudaErrors(MatmulGraphLaunch(p.graph, stream));
+        checkCudaErrors(cudaStreamSynchronize(stream));
+        printf("capture %.1f us, update to other buffers %.1f us (%s)\n",
+               captureUs, updateUs,
+               MatmulGraphWasUpdated(p.graph) ? "in place" : "rebuilt");
+
+        // The panel pipeline, called eagerly and replayed with its
+        // streams from a graph
+        PipePlan q = {p.handle, NULL, size, p.h_A, NULL, NULL};
+        checkCudaErrors(cudaMallocHost(&q.h_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMallocHost(&q.h_C, sizeof(float) * size_C));
+        memcpy(q.h_B, &h_B[0], sizeof(float) * size_B);
+        checkCudaErrors(MatmulCaptureBegin(p.handle));
+        checkCudaErrors(MatmulMultiplyHostPipelined(p.handle, q.h_C, q.h_A,
+                                                    q.h_B, size.M, size.N,
+                                                    size.K));
+        checkCudaErrors(MatmulCaptureEnd(p.handle, &q.graph));
+        const char *pipeModes[] = {"pipe", "pipe_g"};
+        void (*pipeLaunchers[])(void *, cudaStream_t) = {
+            LaunchEagerPipe, LaunchGraphPipe
+        };
+
+        for (int m = 0; m < 2; m++) {
+            memset(q.h_C, 0xff, sizeof(float) * size_C);
+            double synced = SyncedLatency(pipeLaunchers[m], &q, iters,
+                                          stream);
+            printf("%-6s %6d %6d %6d %12s %12.2f\n", pipeModes[m], size.M,
+                   size.N, size.K, "-", synced);
+        }
+
+        double eps = (size.K + 2) * UnitRoundoff(MATMUL_FP32) +
+                     ComputeRoundoff(kernel->compute);
+
+        for (int b = 0; b < 2; b++) {
+            bool correct = CheckResult(p.h_C[b], size_C,
+                                       size.K * valB + valBias, eps);
+            allCorrect = allCorrect && correct;
+        }
+
+        allCorrect = allCorrect &&
+                     CheckResult(q.h_C, size_C, size.K * valB, eps);
+        checkCudaErrors(MatmulGraphDestroy(q.graph));
+        checkCudaErrors(cudaFreeHost(q.h_B));
+        checkCudaErrors(cudaFreeHost(q.h_C));
+
+        checkCudaErrors(MatmulGraphDestroy(p.graph));
+        checkCudaErrors(cudaFreeHost(p.h_A));
+
+        for (int b = 0; b < 2; b++) {
+            checkCudaErrors(cudaFreeHost(p.h_C[b]));
+            checkCudaErrors(cudaFree(p.d_A[b]));
+            checkCudaErrors(cudaFree(p.d_C[b]));
+        }
+
+        checkCudaErrors(cudaFree(p.d_B));
+        checkCudaErrors(cudaFree(p.d_P));
+        checkCudaErrors(cudaFree(d_bias));
+    }
+
+    checkCudaErrors(MatmulDestroy(p.handle));
+
+    return allCorrect;
+}
+
+bool BenchmarkGraph(const BenchmarkOptions &options) {
+    return RunGraph(options.sizes, FirstKernelName(options),
+                    FirstBlockSize(options), options.warmup, options.iters);
+}
@@ -0,0 +1,182 @@
+/**
+ * Benchmark of the input modes of the library (-inputs) on inputs
+ * that are used once.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+#include "matmulLibrary.h"
+#include "matmulVerify.h"
+
+/**
+ * Host-to-host multiplications of inputs that are used once, in each
+ * input mode of the library: A and B are rewritten on the host before
+ * every call (which also drops the device copies of managed memory), and
+ * the median host time of the calls is compared; returns false if any
+ * result is wrong
+ */
+static bool RunInputModes(const std::vector<ProblemSize> &sizes, int calls,
+                          unsigned int seed) {
+    const MatmulInputMode modes[] = {
+        MATMUL_INPUT_STAGED, MATMUL_INPUT_MAPPED, MATMUL_INPUT_MANAGED
+    };
+    const int count = sizeof(modes) / sizeof(modes[0]);
+    MatmulHandle handle;
+    checkCudaErrors(MatmulCreate(&handle));
+    const KernelEntry *kernel = MatmulGetKernel(handle);
+    bool allCorrect = true;
+
+    // Largest problem at which each mode beats staging, in flops
+    double beats[count] = {0.0, 0.0, 0.0};
+    ProblemSize beatsAt[count];
+    printf("Input modes with %s, block %d, %d calls\n", kernel->name,
+           kernel->block_size, calls);
+    printf("%6s %6s %6s %10s %10s %10s %9s %10s %-8s %s\n", "M", "N", "K",
+           "staged_ms", "mapped_ms", "managed_ms", "x_mapped", "x_managed",
+           "best", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> src_A(size_A), src_B(size_B), h_C(size_C);
+        std::vector<float> ref(size_C), mag(size_C);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_A; i++) {
+            src_A[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            src_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        CpuGemm(size.M, size.N, size.K, &src_A[0], size.K, &src_B[0],
+                size.N, &ref[0], size.N, 0);
+        std::vector<float> abs_A(size_A), abs_B(size_B);
+
+        for (size_t i = 0; i < size_A; i++) {
+            abs_A[i] = fabsf(src_A[i]);
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            abs_B[i] = fabsf(src_B[i]);
+        }
+
+        CpuGemm(size.M, size.N, size.K, &abs_A[0], size.K, &abs_B[0],
+                size.N, &mag[0], size.N, 0);
+        float *d_C = UploadArray(&h_C[0], size_C);
+        float *d_ref = UploadArray(&ref[0], size_C);
+        float *d_mag = UploadArray(&mag[0], size_C);
+        double medians[count];
+        bool correct = true;
+
+        for (int m = 0; m < count; m++) {
+            checkCudaErrors(MatmulSetInputMode(handle, modes[m]));
+            float *h_A, *h_B;
+            checkCudaErrors(MatmulHostAlloc(
+                                handle, reinterpret_cast<void **>(&h_A),
+                                sizeof(float) * size_A));
+            checkCudaErrors(MatmulHostAlloc(
+                                handle, reinterpret_cast<void **>(&h_B),
+                                sizeof(float) * size_B));
+            std::vector<float> times(calls);
+            StopWatchInterface *timer = NULL;
+            sdkCreateTimer(&timer);
+
+            for (int c = 0; c < calls; c++) {
+                memcpy(h_A, &src_A[0], sizeof(float) * size_A);
+                memcpy(h_B, &src_B[0], sizeof(float) * size_B);
+                sdkResetTimer(&timer);
+                sdkStartTimer(&timer);
+                checkCudaErrors(MatmulMultiplyHost(handle, &h_C[0], h_A, h_B,
+                                                   size.M, size.N, size.K));
+                sdkStopTimer(&timer);
+                times[c] = sdkGetTimerValue(&timer);
+            }
+
+            sdkDeleteTimer(&timer);
+            medians[m] = SummarizeTimes(times).median_ms;
+            checkCudaErrors(MatmulHostFree(handle, h_A));
+            checkCudaErrors(MatmulHostFree(handle, h_B));
+
+            VerifyStats error;
+            checkCudaErrors(cudaMemcpy(d_C, &h_C[0], sizeof(float) * size_C,
+                                       cudaMemcpyHostToDevice));
+            checkCudaErrors(CompareOnDevice(d_C, MATMUL_FP32, d_ref, d_mag,
+                                            size_C, &error, 0));
+            correct = correct && error.nonFinite == 0 &&
+                      error.maxRelError <= VerifyTolerance(kernel, size.K);
+
+            double flops = 2.0 * size.M * static_cast<double>(size.N) *
+                           size.K;
+
+            if (m > 0 && medians[m] < medians[0] && flops > beats[m]) {
+                beats[m] = flops;
+                beatsAt[m] = size;
+            }
+        }
+
+        int best = 0;
+
+        for (int m = 1; m < count; m++) {
+            best = medians[m] < medians[best] ? m : best;
+        }
+
+        printf("%6d %6d %6d %10.4f %10.4f %10.4f %9.2f %10.2f %-8s %s\n",
+               size.M, size.N, size.K, medians[0], medians[1], medians[2],
+               medians[0] / medians[1], medians[0] / medians[2],
+               MatmulInputModeName(modes[best]), correct ? "ok" : "FAIL");
+        allCorrect = allCorrect && correct;
+
+        checkCudaErrors(cudaFree(d_C));
+        checkCudaErrors(cudaFree(d_ref));
+        checkCudaErrors(cudaFree(d_mag));
+    }
+
+    for (int m = 1; m < count; m++) {
+        if (beats[m] > 0.0) {
+            printf("%s beats staged up to %dx%dx%d\n",
+                   MatmulInputModeName(modes[m]), beatsAt[m].M,
+                   beatsAt[m].N, beatsAt[m].K);
+        } else {
+            printf("%s never beats staged\n", MatmulInputModeName(modes[m]));
+        }
+    }
+
+    checkCudaErrors(MatmulDestroy(handle));
+    return allCorrect;
+}
+
+bool BenchmarkInputs(const BenchmarkOptions &options) {
+    int calls = 20;
+    char *arg = NULL;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "inputs",
+                                 &arg)) {
+        calls = atoi(arg);
+    }
+
+    if (calls < 1) {
+        printf("Error: need -inputs=calls >= 1\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return RunInputModes(options.sizes, calls, SeedOption(options));
+}
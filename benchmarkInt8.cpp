@@ -0,0 +1,205 @@
+/**
+ * Benchmark of int8 GEMM (-int8) with dequantizing epilogue against
+ * fp32, quantized per tensor and per channel.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+#include "matmulInt8.h"
+#include "matmulVerify.h"
+
+// One GEMM of -int8
+struct Int8Plan {
+    ProblemSize size;
+    void *d_C;
+    const int8_t *d_A;
+    const int8_t *d_B;
+    MatmulQuant quant;
+    Int8Kernel kernel;
+};
+
+static void LaunchInt8Plan(void *context, cudaStream_t stream) {
+    const Int8Plan *p = static_cast<const Int8Plan *>(context);
+    MatrixMulInt8(p->d_C, p->d_A, p->d_B, p->size.M, p->size.N, p->size.K,
+                  p->quant, p->kernel, stream);
+}
+
+/**
+ * int8 GEMM of random matrices, quantized per tensor (A and B asymmetric)
+ * and per channel (A per row and asymmetric, B per column and symmetric),
+ * with every int8 kernel of the device, against the fp32 regTile4 kernel.
+ * The result is checked against a host product of the dequantized inputs;
+ * quant_err is the mean error against the product of the fp32 inputs,
+ * the price of quantization, relative to |A| * |B|.
+ */
+static bool RunInt8(const std::vector<ProblemSize> &sizes, int arch,
+                    unsigned int seed, int warmup, int iters) {
+    const char *configs[] = {"tensor", "channel"};
+    std::vector<Int8Kernel> kernels(1, INT8_KERNEL_DP4A);
+
+    if (ResolveInt8Kernel(INT8_KERNEL_AUTO, arch) == INT8_KERNEL_IMMA) {
+        kernels.push_back(INT8_KERNEL_IMMA);
+    }
+
+    const KernelEntry *fp32 = FindKernel("regTile4", 16);
+    bool allCorrect = true;
+    printf("%-8s %-6s %6s %6s %6s %10s %10s %8s %9s %10s %s\n", "quant",
+           "kernel", "M", "N", "K", "median_ms", "GOp/s", "x_fp32",
+           "max/tol", "quant_err", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        // The fp32 baseline, and its result as the exact product
+        float *d_fA = UploadArray(&h_A[0], size_A);
+        float *d_fB = UploadArray(&h_B[0], size_B);
+        float *d_C, *d_ref, *d_exact, *d_mag;
+        checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_ref, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_mag, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_exact, sizeof(float) * size_C));
+
+        std::vector<float> times;
+        TimeKernelLaunches(fp32, d_exact, d_fA, d_fB, size.M, size.N, size.K,
+                           warmup, iters, 0, &times);
+        checkCudaErrors(cudaGetLastError());
+        double fp32Ms = SummarizeTimes(times).median_ms;
+
+        for (int c = 0; c < 2; c++) {
+            bool channel = c == 1;
+            QuantAxis axisA = channel ? QUANT_PER_ROW : QUANT_PER_TENSOR;
+            QuantAxis axisB = channel ? QUANT_PER_COL : QUANT_PER_TENSOR;
+            int groupsA = channel ? size.M : 1;
+            int groupsB = channel ? size.N : 1;
+            std::vector<float> scaleA(groupsA), scaleB(groupsB);
+            std::vector<int> zeroA(groupsA), zeroB(groupsB);
+            std::vector<int8_t> qA(size_A), qB(size_B);
+            ChooseQuantParams(&h_A[0], size.M, size.K, axisA, false,
+                              &scaleA[0], &zeroA[0]);
+            ChooseQuantParams(&h_B[0], size.K, size.N, axisB, channel,
+                              &scaleB[0], &zeroB[0]);
+            QuantizeHost(&h_A[0], size.M, size.K, axisA, &scaleA[0],
+                         &zeroA[0], &qA[0]);
+            QuantizeHost(&h_B[0], size.K, size.N, axisB, &scaleB[0],
+                         &zeroB[0], &qB[0]);
+
+            // The reference multiplies what the quantized values stand for
+            std::vector<float> a(size_A), b(size_B), ref(size_C);
+            std::vector<float> mag(size_C);
+            DequantizeHost(&qA[0], size.M, size.K, axisA, &scaleA[0],
+                           &zeroA[0], &a[0]);
+            DequantizeHost(&qB[0], size.K, size.N, axisB, &scaleB[0],
+                           &zeroB[0], &b[0]);
+            CpuGemm(size.M, size.N, size.K, &a[0], size.K, &b[0], size.N,
+                    &ref[0], size.N, 0);
+
+            for (size_t i = 0; i < size_A; i++) {
+                a[i] = fabsf(a[i]);
+            }
+
+            for (size_t i = 0; i < size_B; i++) {
+                b[i] = fabsf(b[i]);
+            }
+
+            CpuGemm(size.M, size.N, size.K, &a[0], size.K, &b[0], size.N,
+                    &mag[0], size.N, 0);
+            checkCudaErrors(cudaMemcpy(d_ref, &ref[0], sizeof(float) * size_C,
+                                       cudaMemcpyHostToDevice));
+            checkCudaErrors(cudaMemcpy(d_mag, &mag[0], sizeof(float) * size_C,
+                                       cudaMemcpyHostToDevice));
+
+            Int8Plan p;
+            p.size = size;
+            p.d_C = d_C;
+            p.d_A = UploadArray(&qA[0], size_A);
+            p.d_B = UploadArray(&qB[0], size_B);
+            p.quant.perRowA = channel;
+            p.quant.scaleA = UploadArray(&scaleA[0], groupsA);
+            p.quant.zeroA = UploadArray(&zeroA[0], groupsA);
+            p.quant.perColB = channel;
+            p.quant.scaleB = UploadArray(&scaleB[0], groupsB);
+            p.quant.zeroB = channel ? NULL : UploadArray(&zeroB[0], groupsB);
+            p.quant.bias = NULL;
+            p.quant.outType = MATMUL_FP32;
+
+            for (size_t k = 0; k < kernels.size(); k++) {
+                p.kernel = kernels[k];
+
+                // NaNs in C catch elements that are never written
+                checkCudaErrors(cudaMemset(d_C, 0xff, sizeof(float) * size_C));
+                TimeLaunches(LaunchInt8Plan, &p, warmup, iters, 0, &times);
+                checkCudaErrors(cudaGetLastError());
+                TimingStats stats = SummarizeTimes(times);
+
+                VerifyStats error, quantError;
+                checkCudaErrors(CompareOnDevice(d_C, MATMUL_FP32, d_ref,
+                                                d_mag, size_C, &error, 0));
+                checkCudaErrors(CompareOnDevice(d_C, MATMUL_FP32, d_exact,
+                                                d_mag, size_C, &quantError,
+                                                0));
+                double tolerance = 2.0 * (size.K + 1) *
+                                   UnitRoundoff(MATMUL_FP32) +
+                                   UnitRoundoff(MATMUL_FP32);
+                double ratio = error.maxRelError / tolerance;
+                bool correct = ratio <= 1.0 && error.nonFinite == 0;
+                double ops = 2.0 * size.M * static_cast<double>(size.N) *
+                             size.K;
+                printf("%-8s %-6s %6d %6d %6d %10.4f %10.2f %8.2f %9.3f"
+                       " %10.2e %s\n", configs[c],
+                       Int8KernelName(p.kernel), size.M, size.N, size.K,
+                       stats.median_ms, ops * 1.0e-6 / stats.median_ms,
+                       fp32Ms / stats.median_ms, ratio,
+                       quantError.meanRelError, correct ? "ok" : "FAIL");
+                allCorrect = allCorrect && correct;
+            }
+
+            checkCudaErrors(cudaFree(const_cast<int8_t *>(p.d_A)));
+            checkCudaErrors(cudaFree(const_cast<int8_t *>(p.d_B)));
+            checkCudaErrors(cudaFree(const_cast<float *>(p.quant.scaleA)));
+            checkCudaErrors(cudaFree(const_cast<int *>(p.quant.zeroA)));
+            checkCudaErrors(cudaFree(const_cast<float *>(p.quant.scaleB)));
+            checkCudaErrors(cudaFree(const_cast<int *>(p.quant.zeroB)));
+        }
+
+        checkCudaErrors(cudaFree(d_fA));
+        checkCudaErrors(cudaFree(d_fB));
+        checkCudaErrors(cudaFree(d_C));
+        checkCudaErrors(cudaFree(d_ref));
+        checkCudaErrors(cudaFree(d_mag));
+        checkCudaErrors(cudaFree(d_exact));
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkInt8(const BenchmarkOptions &options) {
+    return RunInt8(options.sizes, options.arch, SeedOption(options),
+                   options.warmup, options.iters);
+}
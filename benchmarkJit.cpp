@@ -0,0 +1,176 @@
+/**
+ * Benchmark of kernels compiled for the exact shape (-jit) against
+ * the sample kernel they are generated from.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+#include "matmulJit.h"
+#include "matmulVerify.h"
+
+// One GEMM of -jit through a JitKernelCache
+struct JitPlan {
+    JitKernelCache *cache;
+    ProblemSize size;
+    float *d_C;
+    const float *d_A;
+    const float *d_B;
+};
+
+static void LaunchJitPlan(void *context, cudaStream_t stream) {
+    const JitPlan *p = static_cast<const JitPlan *>(context);
+    p->cache->Multiply(p->d_C, p->d_A, p->d_B, p->size.M, p->size.N,
+                       p->size.K, stream);
+}
+
+// Host time in milliseconds of the first call of p's shape, until the
+// product is done; lookup receives where its kernel came from
+static double FirstJitCall(JitPlan *p, JitLookup *lookup) {
+    StopWatchInterface *timer = NULL;
+    sdkCreateTimer(&timer);
+    sdkStartTimer(&timer);
+    checkCudaErrors(p->cache->Multiply(p->d_C, p->d_A, p->d_B, p->size.M,
+                                       p->size.N, p->size.K, 0, lookup));
+    checkCudaErrors(cudaDeviceSynchronize());
+    sdkStopTimer(&timer);
+    double ms = sdkGetTimerValue(&timer);
+    sdkDeleteTimer(&timer);
+    return ms;
+}
+
+/**
+ * Each size with a kernel compiled for its exact shape, against the
+ * sample kernel it is generated from: the cost of the first call of the
+ * shape (compiled, or loaded from the cache directory dir if an earlier
+ * run left the cubin there), that of a new process loading the cubin,
+ * and the steady-state speed and error
+ */
+static bool RunJit(const std::vector<ProblemSize> &sizes, const char *dir,
+                   unsigned int seed, int warmup, int iters) {
+    if (!JitKernelCache::Available()) {
+        printf("Waived: built without MATMUL_WITH_NVRTC\n");
+        return true;
+    }
+
+    const KernelEntry *sample = FindKernel("sample", MATMUL_JIT_BLOCK);
+    bool allCorrect = true;
+    printf("%6s %6s %6s %-8s %10s %8s %9s %8s %10s %10s %8s %9s %s\n", "M",
+           "N", "K", "first", "compile_ms", "load_ms", "first_ms",
+           "disk_ms", "median_ms", "GFlop/s", "x_sample", "max/tol",
+           "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B), ref(size_C), mag(size_C);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        float *d_A = UploadArray(&h_A[0], size_A);
+        float *d_B = UploadArray(&h_B[0], size_B);
+        float *d_C, *d_ref, *d_mag;
+        checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_ref, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_mag, sizeof(float) * size_C));
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &ref[0], size.N, 0);
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = fabsf(h_A[i]);
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = fabsf(h_B[i]);
+        }
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &mag[0], size.N, 0);
+        checkCudaErrors(cudaMemcpy(d_ref, &ref[0], sizeof(float) * size_C,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(d_mag, &mag[0], sizeof(float) * size_C,
+                                   cudaMemcpyHostToDevice));
+
+        std::vector<float> times;
+        TimeKernelLaunches(sample, d_C, d_A, d_B, size.M, size.N, size.K,
+                           warmup, iters, 0, &times);
+        checkCudaErrors(cudaGetLastError());
+        double sampleMs = SummarizeTimes(times).median_ms;
+
+        // NaNs in C catch elements that are never written
+        checkCudaErrors(cudaMemset(d_C, 0xff, sizeof(float) * size_C));
+
+        JitKernelCache cache(dir);
+        JitPlan p = {&cache, size, d_C, d_A, d_B};
+        JitLookup first;
+        double firstMs = FirstJitCall(&p, &first);
+
+        // A new cache finds the cubin on disk, as a new process would
+        JitKernelCache reload(dir);
+        JitPlan q = {&reload, size, d_C, d_A, d_B};
+        JitLookup disk;
+        double diskMs = FirstJitCall(&q, &disk);
+
+        TimeLaunches(LaunchJitPlan, &p, warmup, iters, 0, &times);
+        checkCudaErrors(cudaGetLastError());
+        TimingStats stats = SummarizeTimes(times);
+
+        VerifyStats error;
+        checkCudaErrors(CompareOnDevice(d_C, MATMUL_FP32, d_ref, d_mag,
+                                        size_C, &error, 0));
+        double ratio = error.maxRelError / VerifyTolerance(sample, size.K);
+        bool correct = ratio <= 1.0 && error.nonFinite == 0;
+        double flops = 2.0 * size.M * static_cast<double>(size.N) * size.K;
+        printf("%6d %6d %6d %-8s %10.1f %8.2f %9.1f %8.2f %10.4f %10.2f"
+               " %8.2f %9.3f %s\n", size.M, size.N, size.K,
+               JitSourceName(first.source), first.compileMs, first.loadMs,
+               firstMs, disk.source == JIT_SOURCE_DISK ? diskMs : 0.0,
+               stats.median_ms, flops * 1.0e-6 / stats.median_ms,
+               sampleMs / stats.median_ms, ratio,
+               correct ? "ok" : "FAIL");
+        allCorrect = allCorrect && correct;
+
+        checkCudaErrors(cudaFree(d_A));
+        checkCudaErrors(cudaFree(d_B));
+        checkCudaErrors(cudaFree(d_C));
+        checkCudaErrors(cudaFree(d_ref));
+        checkCudaErrors(cudaFree(d_mag));
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkJit(const BenchmarkOptions &options) {
+    const char *dir = BENCHMARK_JIT_CACHE;
+    char *arg = NULL;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "jit", &arg)) {
+        dir = arg;
+    }
+
+    return RunJit(options.sizes, dir, SeedOption(options), options.warmup,
+                  options.iters);
+}
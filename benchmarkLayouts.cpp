@@ -0,0 +1,193 @@
+/**
+ * Benchmark of the transposed operand layouts (-layouts): NN, NT, TN
+ * and TT with padded leading dimensions.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "kernelTiming.h"
+#include "matmulGemm.h"
+
+// Device operands of one RunLayouts problem
+struct LayoutProblem {
+    MatmulOp opA;
+    MatmulOp opB;
+    ProblemSize size;
+    float *d_A;
+    float *d_B;
+    float *d_C;
+    int lda;
+    int ldb;
+    int ldc;
+    int block_size;
+};
+
+static void LaunchLayoutGemm(void *context, cudaStream_t stream) {
+    const LayoutProblem *p = static_cast<const LayoutProblem *>(context);
+    const ProblemSize &s = p->size;
+    MatrixMulGemm(p->opA, p->opB, s.M, s.N, s.K, 1.0f, p->d_A, p->lda,
+                  p->d_B, p->ldb, 0.0f, p->d_C, p->ldc, p->block_size,
+                  stream);
+}
+
+/**
+ * Store the rows x cols matrix with element (r, c) = value(r, c) into
+ * host memory with leading dimension ld, transposed if op is MATMUL_OP_T;
+ * the padding is set to NaN, which shows up in C if it is ever read
+ */
+static std::vector<float> StoreOperand(MatmulOp op, int rows, int cols,
+                                       int ld, float (*value)(int, int)) {
+    int storedRows = op == MATMUL_OP_N ? rows : cols;
+    std::vector<float> stored(static_cast<size_t>(storedRows) * ld, NAN);
+
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            size_t i = op == MATMUL_OP_N ?
+                       static_cast<size_t>(r) * ld + c :
+                       static_cast<size_t>(c) * ld + r;
+            stored[i] = value(r, c);
+        }
+    }
+
+    return stored;
+}
+
+// Operands whose product depends on both indices of C, so that a wrong
+// layout can not be mistaken for the right one
+static float LayoutValueA(int m, int) {
+    return 1.0f + m % 3;
+}
+
+static float LayoutValueB(int, int n) {
+    return 0.01f * (1 + n % 5);
+}
+
+/**
+ * Run C = op(A) * op(B) for the four layouts NN, NT, TN and TT with every
+ * leading dimension pad elements longer than its rows, for every size and
+ * block size; returns false if any result is wrong
+ */
+static bool RunLayouts(const std::vector<ProblemSize> &sizes,
+                       const std::vector<std::string> &blockSizes, int pad,
+                       int warmup, int iters) {
+    const int blocks[] = {16, 32};
+    bool allCorrect = true;
+
+    printf("Layouts with leading dimensions padded by %d\n", pad);
+    printf("%-6s %5s %6s %6s %6s %10s %10s %s\n", "layout", "block", "M",
+           "N", "K", "median_ms", "GFlop/s", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+
+        for (int layout = 0; layout < 4; layout++) {
+            LayoutProblem p;
+            p.opA = layout & 2 ? MATMUL_OP_T : MATMUL_OP_N;
+            p.opB = layout & 1 ? MATMUL_OP_T : MATMUL_OP_N;
+            p.size = size;
+            p.lda = (p.opA == MATMUL_OP_N ? size.K : size.M) + pad;
+            p.ldb = (p.opB == MATMUL_OP_N ? size.N : size.K) + pad;
+            p.ldc = size.N + pad;
+
+            std::vector<float> h_A = StoreOperand(p.opA, size.M, size.K,
+                                                  p.lda, LayoutValueA);
+            std::vector<float> h_B = StoreOperand(p.opB, size.K, size.N,
+                                                  p.ldb, LayoutValueB);
+            std::vector<float> h_C(static_cast<size_t>(size.M) * p.ldc);
+            checkCudaErrors(cudaMalloc(&p.d_A, sizeof(float) * h_A.size()));
+            checkCudaErrors(cudaMalloc(&p.d_B, sizeof(float) * h_B.size()));
+            checkCudaErrors(cudaMalloc(&p.d_C, sizeof(float) * h_C.size()));
+            checkCudaErrors(cudaMemcpy(p.d_A, &h_A[0],
+                                       sizeof(float) * h_A.size(),
+                                       cudaMemcpyHostToDevice));
+            checkCudaErrors(cudaMemcpy(p.d_B, &h_B[0],
+                                       sizeof(float) * h_B.size(),
+                                       cudaMemcpyHostToDevice));
+
+            for (size_t b = 0; b < sizeof(blocks) / sizeof(blocks[0]); b++) {
+                char blockName[16];
+                snprintf(blockName, sizeof(blockName), "%d", blocks[b]);
+
+                if (!InList(blockSizes, blockName)) {
+                    continue;
+                }
+
+                p.block_size = blocks[b];
+                checkCudaErrors(cudaMemset(p.d_C, 0,
+                                           sizeof(float) * h_C.size()));
+
+                std::vector<float> times;
+                TimeLaunches(LaunchLayoutGemm, &p, warmup, iters, 0, &times);
+                TimingStats stats = SummarizeTimes(times);
+                checkCudaErrors(cudaMemcpy(&h_C[0], p.d_C,
+                                           sizeof(float) * h_C.size(),
+                                           cudaMemcpyDeviceToHost));
+
+                // C(m, n) = K * a(m) * b(n); the padding of C stays zero
+                double eps = (size.K + 1) * UnitRoundoff(MATMUL_FP32);
+                bool correct = true;
+
+                for (int m = 0; m < size.M && correct; m++) {
+                    for (int n = 0; n < p.ldc && correct; n++) {
+                        double ref = n < size.N ? size.K *
+                                     LayoutValueA(m, 0) *
+                                     static_cast<double>(
+                                         LayoutValueB(0, n)) : 0.0;
+                        double got = h_C[static_cast<size_t>(m) * p.ldc + n];
+                        correct = n < size.N ?
+                                  fabs(got - ref) <= eps * fabs(ref) :
+                                  got == 0.0;
+                    }
+                }
+
+                allCorrect = allCorrect && correct;
+
+                char layoutName[4];
+                snprintf(layoutName, sizeof(layoutName), "%s%s",
+                         MatmulOpName(p.opA), MatmulOpName(p.opB));
+                double flops = 2.0 * size.M * static_cast<double>(size.N) *
+                               size.K;
+                printf("%-6s %5d %6d %6d %6d %10.4f %10.2f %s\n",
+                       layoutName, blocks[b], size.M, size.N, size.K,
+                       stats.median_ms, flops * 1.0e-6 / stats.median_ms,
+                       correct ? "PASS" : "FAIL");
+            }
+
+            checkCudaErrors(cudaFree(p.d_A));
+            checkCudaErrors(cudaFree(p.d_B));
+            checkCudaErrors(cudaFree(p.d_C));
+        }
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkLayouts(const BenchmarkOptions &options) {
+    int pad = 3;
+
+    if (checkCmdLineFlag(options.argc, options.argv, "pad")) {
+        pad = getCmdLineArgumentInt(options.argc, options.argv, "pad");
+    }
+
+    if (pad < 0) {
+        printf("Error: need -pad >= 0\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return RunLayouts(options.sizes, options.blockSizes, pad, options.warmup,
+                      options.iters);
+}
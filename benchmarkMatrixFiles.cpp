@@ -0,0 +1,214 @@
+/**
+ * Multiplication of operands in matrix files (-load, -save), through
+ * the panel pipeline or the out-of-core mode.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "matmulLibrary.h"
+#include "matrixFile.h"
+
+/**
+ * Host matrix of an operand file for RunMatrixFiles: the mapping itself
+ * if it is packed fp32, else a pinned packed fp32 copy; pinned is set if
+ * it has to be freed
+ */
+static float *MatrixFileOperand(const MatrixFile *file, bool *pinned) {
+    *pinned = !MatrixFileIsPacked(file);
+
+    if (!*pinned) {
+        return static_cast<float *>(file->data);
+    }
+
+    float *copy;
+    size_t elements = file->header.rows * file->header.cols;
+    checkCudaErrors(cudaMallocHost(&copy, sizeof(float) * elements));
+    CopyMatrixFileToFloat(file, copy);
+    return copy;
+}
+
+/**
+ * C = A * B for the operands in matrix files (matrixFile.h), through the
+ * pinned staging of the panel pipeline or with the out-of-core streamer
+ * in deviceBytes (0 for most of the free memory); C goes to the matrix
+ * file pathC if it is not NULL. A sample of the rows is checked against
+ * the host; returns false if one is wrong.
+ */
+static bool RunMatrixFiles(const char *pathA, const char *pathB,
+                           const char *pathC, bool outOfCore,
+                           const char *kernelName, int block_size,
+                           size_t deviceBytes) {
+    MatrixFile file_A, file_B, file_C;
+    StopWatchInterface *timer = NULL;
+    sdkCreateTimer(&timer);
+    sdkStartTimer(&timer);
+
+    if (!OpenMatrixFile(pathA, &file_A) || !OpenMatrixFile(pathB, &file_B)) {
+        exit(EXIT_FAILURE);
+    }
+
+    sdkStopTimer(&timer);
+    double openMs = sdkGetTimerValue(&timer);
+    const MatrixFileHeader &a = file_A.header;
+    const MatrixFileHeader &b = file_B.header;
+
+    if (a.cols != b.rows || a.rows > INT_MAX || a.cols > INT_MAX ||
+            b.cols > INT_MAX) {
+        printf("Error: cannot multiply %llu x %llu by %llu x %llu\n",
+               static_cast<unsigned long long>(a.rows),
+               static_cast<unsigned long long>(a.cols),
+               static_cast<unsigned long long>(b.rows),
+               static_cast<unsigned long long>(b.cols));
+        exit(EXIT_FAILURE);
+    }
+
+    int M = static_cast<int>(a.rows);
+    int N = static_cast<int>(b.cols);
+    int K = static_cast<int>(a.cols);
+    size_t size_C = static_cast<size_t>(M) * N;
+
+    MatmulHandle handle;
+    checkCudaErrors(MatmulCreate(&handle));
+    checkCudaErrors(MatmulSetOutOfCore(handle, deviceBytes));
+
+    if (kernelName != NULL &&
+            MatmulSetKernel(handle, kernelName, block_size) != cudaSuccess) {
+        printf("Error: no kernel %s with block size %d for this device\n",
+               kernelName, block_size);
+        exit(EXIT_FAILURE);
+    }
+
+    const KernelEntry *kernel = MatmulGetKernel(handle);
+    bool pinned_A, pinned_B;
+    float *h_A = MatrixFileOperand(&file_A, &pinned_A);
+    float *h_B = MatrixFileOperand(&file_B, &pinned_B);
+    float *h_C;
+
+    if (pathC != NULL) {
+        if (!CreateMatrixFile(pathC, MATMUL_FP32, MATRIX_ROW_MAJOR, M, N, 0,
+                              0, &file_C)) {
+            exit(EXIT_FAILURE);
+        }
+
+        h_C = static_cast<float *>(file_C.data);
+    } else {
+        h_C = reinterpret_cast<float *>(malloc(sizeof(float) * size_C));
+    }
+
+    printf("Matrix files with %s, block %d, %s\n", kernel->name,
+           kernel->block_size, outOfCore ? "out-of-core" : "pipelined");
+    printf("  A %s: %s %s, ld %llu%s\n", pathA,
+           MatmulTypeName(static_cast<MatmulType>(a.type)),
+           a.layout == MATRIX_ROW_MAJOR ? "row-major" : "col-major",
+           static_cast<unsigned long long>(a.ld),
+           pinned_A ? ", converted" : "");
+    printf("  B %s: %s %s, ld %llu%s\n", pathB,
+           MatmulTypeName(static_cast<MatmulType>(b.type)),
+           b.layout == MATRIX_ROW_MAJOR ? "row-major" : "col-major",
+           static_cast<unsigned long long>(b.ld),
+           pinned_B ? ", converted" : "");
+    printf("%6s %6s %6s %10s %10s %10s %10s %s\n", "M", "N", "K", "open_ms",
+           "GB", "ms", "GFlop/s", "check");
+
+    sdkResetTimer(&timer);
+    sdkStartTimer(&timer);
+    cudaError_t err = outOfCore ?
+                      MatmulMultiplyOutOfCore(handle, h_C, h_A, h_B, M, N,
+                                              K) :
+                      MatmulMultiplyHostPipelined(handle, h_C, h_A, h_B, M,
+                                                  N, K);
+    sdkStopTimer(&timer);
+    checkCudaErrors(err);
+    double ms = sdkGetTimerValue(&timer);
+    sdkDeleteTimer(&timer);
+
+    // Rows of C against double sums on the host, relative to |A| * |B|
+    double tol = VerifyTolerance(kernel, K);
+    int step = M > 64 ? M / 64 : 1;
+    bool correct = true;
+    std::vector<double> ref(N), mag(N);
+
+    for (int r = 0; r < M && correct; r += step) {
+        ref.assign(N, 0.0);
+        mag.assign(N, 0.0);
+
+        for (int k = 0; k < K; k++) {
+            double v = h_A[static_cast<size_t>(r) * K + k];
+            const float *row = h_B + static_cast<size_t>(k) * N;
+
+            for (int j = 0; j < N; j++) {
+                ref[j] += v * row[j];
+                mag[j] += fabs(v * row[j]);
+            }
+        }
+
+        for (int j = 0; j < N && correct; j++) {
+            double c = h_C[static_cast<size_t>(r) * N + j];
+            correct = fabs(c - ref[j]) <= tol * mag[j];
+        }
+    }
+
+    double bytes = sizeof(float) * (static_cast<double>(M) * K +
+                                    static_cast<double>(K) * N + size_C);
+    double flops = 2.0 * M * static_cast<double>(N) * K;
+    printf("%6d %6d %6d %10.3f %10.2f %10.1f %10.2f %s\n", M, N, K, openMs,
+           bytes * 1.0e-9, ms, flops * 1.0e-6 / ms,
+           correct ? "PASS" : "FAIL");
+
+    if (pathC != NULL) {
+        CloseMatrixFile(&file_C);
+        printf("C written to %s\n", pathC);
+    } else {
+        free(h_C);
+    }
+
+    if (pinned_A) {
+        checkCudaErrors(cudaFreeHost(h_A));
+    }
+
+    if (pinned_B) {
+        checkCudaErrors(cudaFreeHost(h_B));
+    }
+
+    CloseMatrixFile(&file_A);
+    CloseMatrixFile(&file_B);
+    checkCudaErrors(MatmulDestroy(handle));
+    return correct;
+}
+
+bool BenchmarkMatrixFiles(const BenchmarkOptions &options) {
+    char *arg = NULL;
+    char *save = NULL;
+    std::vector<std::string> paths;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "load", &arg)) {
+        paths = SplitList(arg);
+    }
+
+    if (paths.size() != 2) {
+        printf("Error: need -load=A,B with two matrix files\n");
+        exit(EXIT_FAILURE);
+    }
+
+    getCmdLineArgumentString(options.argc, options.argv, "save", &save);
+    bool outOfCore = checkCmdLineFlag(options.argc, options.argv,
+                                      "outofcore");
+    return RunMatrixFiles(paths[0].c_str(), paths[1].c_str(), save,
+                          outOfCore, FirstKernelName(options),
+                          FirstBlockSize(options), OutOfCoreBytes(options));
+}
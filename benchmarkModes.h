@@ -0,0 +1,72 @@
+/**
+ * Modes of the matrix multiplication benchmark other than the kernel
+ * sweep, one per benchmark*.cpp file. main picks a mode by its flag (see
+ * the mode table of matmulBenchmark.cpp); the mode reads its other flags
+ * from the options, prints its report and returns false if any result was
+ * wrong.
+ */
+
+#ifndef BENCHMARK_MODES_H_
+#define BENCHMARK_MODES_H_
+
+#include "benchmarkCommon.h"
+
+// Cubin directory of -jit when none is given
+#define BENCHMARK_JIT_CACHE "matmulJitCache"
+
+typedef bool (*BenchmarkModeFn)(const BenchmarkOptions &options);
+
+// -batch=n (benchmarkBatched.cpp)
+bool BenchmarkBatched(const BenchmarkOptions &options);
+
+// -layouts -pad=n (benchmarkLayouts.cpp)
+bool BenchmarkLayouts(const BenchmarkOptions &options);
+
+// -epilogue[=relu|gelu|none] (benchmarkEpilogue.cpp)
+bool BenchmarkEpilogue(const BenchmarkOptions &options);
+
+// -calls=n -streams=n -panel=rows (benchmarkCalls.cpp)
+bool BenchmarkCalls(const BenchmarkOptions &options);
+
+// -graph (benchmarkGraph.cpp)
+bool BenchmarkGraph(const BenchmarkOptions &options);
+
+// -outofcore -oocmem=MB -mmap=dir (benchmarkOutOfCore.cpp)
+bool BenchmarkOutOfCore(const BenchmarkOptions &options);
+
+// -multigpu[=n] -tile=edge (benchmarkMultiGpu.cpp)
+bool BenchmarkMultiGpu(const BenchmarkOptions &options);
+
+// -cpu -threads=n, which needs no CUDA device (benchmarkCpu.cpp)
+bool BenchmarkCpu(const BenchmarkOptions &options);
+
+// -verify[=n] -seed=s (benchmarkVerify.cpp)
+bool BenchmarkVerify(const BenchmarkOptions &options);
+
+// -compute -seed=s (benchmarkCompute.cpp)
+bool BenchmarkCompute(const BenchmarkOptions &options);
+
+// -int8 -seed=s (benchmarkInt8.cpp)
+bool BenchmarkInt8(const BenchmarkOptions &options);
+
+// -sparse[=d,d...] -seed=s (benchmarkSparse.cpp)
+bool BenchmarkSparse(const BenchmarkOptions &options);
+
+// -strassen[=c,c...] -seed=s (benchmarkStrassen.cpp)
+bool BenchmarkStrassen(const BenchmarkOptions &options);
+
+// -jit[=dir] -seed=s (benchmarkJit.cpp)
+bool BenchmarkJit(const BenchmarkOptions &options);
+
+// -inputs[=calls] -seed=s (benchmarkInputs.cpp)
+bool BenchmarkInputs(const BenchmarkOptions &options);
+
+// -server[=threads] -requests=n -streams=n -maxbatch=n -budget=us, and
+// -serverfault (benchmarkServer.cpp)
+bool BenchmarkServer(const BenchmarkOptions &options);
+bool BenchmarkServerFault(const BenchmarkOptions &options);
+
+// -load=A,B -save=C [-outofcore -oocmem=MB] (benchmarkMatrixFiles.cpp)
+bool BenchmarkMatrixFiles(const BenchmarkOptions &options);
+
+#endif  // BENCHMARK_MODES_H_
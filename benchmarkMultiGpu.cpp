@@ -0,0 +1,195 @@
+/**
+ * Benchmark of multi-GPU GEMM (-multigpu): C split
+ * block-cyclically over the devices, against one device.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+
+/**
+ * One multi-GPU call of size on the first count handles, after an untimed
+ * one; prints a line per device and the aggregate, and returns the
+ * aggregate GFlop/s or a negative value if the result is wrong
+ */
+static double MultiplyMultiGpu(MatmulHandle *handles, int count, int tile,
+                               const ProblemSize &size, float *h_C,
+                               const float *h_A, const float *h_B,
+                               float valB, double single) {
+    std::vector<MatmulDeviceStats> stats(count);
+
+    for (int pass = 0; pass < 2; pass++) {
+        StopWatchInterface *timer = NULL;
+        sdkCreateTimer(&timer);
+        sdkStartTimer(&timer);
+        checkCudaErrors(MatmulMultiplyMultiGpu(handles, count, tile, h_C,
+                                               h_A, h_B, size.M, size.N,
+                                               size.K, &stats[0]));
+        sdkStopTimer(&timer);
+        double ms = sdkGetTimerValue(&timer);
+        sdkDeleteTimer(&timer);
+
+        if (pass == 0) {
+            continue;
+        }
+
+        for (int d = 0; d < count; d++) {
+            const MatmulDeviceStats &st = stats[d];
+            double flops = 2.0 * st.rows * static_cast<double>(st.cols) *
+                           size.K;
+            printf("  device %d %6d x %-6d %5d tiles %5d peer %10.3f ms"
+                   " %10.2f GFlop/s\n", st.device, st.rows, st.cols,
+                   st.tiles, st.peerPanels, st.kernelMs,
+                   st.kernelMs > 0.0f ? flops * 1.0e-6 / st.kernelMs : 0.0);
+        }
+
+        // The devices may run kernels of different compute modes
+        double roundoff = 0.0;
+
+        for (int d = 0; d < count; d++) {
+            MatmulCompute compute = MatmulGetComputeMode(handles[d]);
+            roundoff = fmax(roundoff, ComputeRoundoff(compute));
+        }
+
+        double eps = (size.K + 1) * UnitRoundoff(MATMUL_FP32) + roundoff;
+
+        bool correct = CheckResult(h_C, size.M * size.N, size.K * valB, eps);
+        double flops = 2.0 * size.M * static_cast<double>(size.N) * size.K;
+        double gigaFlops = flops * 1.0e-6 / ms;
+        printf("%6d %6d %6d %7d %10.3f %10.2f", size.M, size.N, size.K,
+               count, ms, gigaFlops);
+
+        // Against count times the throughput of a single device
+        if (single > 0.0) {
+            printf(" %9.1f%%", 100.0 * gigaFlops / (count * single));
+        } else {
+            printf(" %10s", "-");
+        }
+
+        printf(" %s\n", correct ? "PASS" : "FAIL");
+        return correct ? gigaFlops : -1.0;
+    }
+
+    return -1.0;
+}
+
+/**
+ * Multiply every size on one device and on devices devices, reporting the
+ * share of each device and the scaling efficiency; returns false if any
+ * result is wrong
+ */
+static bool RunMultiGpu(const std::vector<ProblemSize> &sizes,
+                        const char *kernelName, int block_size, int devices,
+                        int tile) {
+    const float valB = 0.01f;
+    int current;
+    checkCudaErrors(cudaGetDevice(&current));
+    std::vector<MatmulHandle> handles(devices);
+
+    for (int d = 0; d < devices; d++) {
+        cudaDeviceProp deviceProp;
+        checkCudaErrors(cudaSetDevice(d));
+        checkCudaErrors(cudaGetDeviceProperties(&deviceProp, d));
+        checkCudaErrors(MatmulCreate(&handles[d]));
+        printf("Device %d: \"%s\"\n", d, deviceProp.name);
+
+        if (kernelName != NULL &&
+                MatmulSetKernel(handles[d], kernelName, block_size) !=
+                cudaSuccess) {
+            printf("Error: no kernel %s with block size %d for device %d\n",
+                   kernelName, block_size, d);
+            exit(EXIT_FAILURE);
+        }
+
+        const KernelEntry *kernel = MatmulGetKernel(handles[d]);
+
+        if (kernel->inType != MATMUL_FP32 || kernel->outType != MATMUL_FP32) {
+            printf("Error: the multi-GPU mode needs an fp32 kernel\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    checkCudaErrors(cudaSetDevice(current));
+    const KernelEntry *kernel = MatmulGetKernel(handles[0]);
+    bool allCorrect = true;
+    printf("Multi-GPU with %s, block %d, tile %d (0 = auto)\n",
+           kernel->name, kernel->block_size, tile);
+    printf("%6s %6s %6s %7s %10s %10s %10s %s\n", "M", "N", "K", "devices",
+           "ms", "GFlop/s", "efficiency", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        float *h_A, *h_B, *h_C;
+
+        // Portable, so that the copies of every device are asynchronous
+        checkCudaErrors(cudaHostAlloc(&h_A, sizeof(float) * size_A,
+                                      cudaHostAllocPortable));
+        checkCudaErrors(cudaHostAlloc(&h_B, sizeof(float) * size_B,
+                                      cudaHostAllocPortable));
+        checkCudaErrors(cudaHostAlloc(&h_C, sizeof(float) * size_C,
+                                      cudaHostAllocPortable));
+        ConstantInit(h_A, static_cast<int>(size_A), 1.0f);
+        ConstantInit(h_B, static_cast<int>(size_B), valB);
+
+        double single = MultiplyMultiGpu(&handles[0], 1, tile, size, h_C,
+                                         h_A, h_B, valB, 0.0);
+        allCorrect = allCorrect && single > 0.0;
+
+        if (devices > 1) {
+            double all = MultiplyMultiGpu(&handles[0], devices, tile, size,
+                                          h_C, h_A, h_B, valB, single);
+            allCorrect = allCorrect && all > 0.0;
+        }
+
+        checkCudaErrors(cudaFreeHost(h_A));
+        checkCudaErrors(cudaFreeHost(h_B));
+        checkCudaErrors(cudaFreeHost(h_C));
+    }
+
+    for (int d = 0; d < devices; d++) {
+        checkCudaErrors(MatmulDestroy(handles[d]));
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkMultiGpu(const BenchmarkOptions &options) {
+    int available;
+    checkCudaErrors(cudaGetDeviceCount(&available));
+    int devices = getCmdLineArgumentInt(options.argc, options.argv,
+                                        "multigpu");
+    int tile = 0;
+
+    if (devices <= 0 || devices > available) {
+        devices = available;
+    }
+
+    if (checkCmdLineFlag(options.argc, options.argv, "tile")) {
+        tile = getCmdLineArgumentInt(options.argc, options.argv, "tile");
+    }
+
+    if (tile < 0) {
+        printf("Error: need -tile >= 0\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return RunMultiGpu(options.sizes, FirstKernelName(options),
+                       FirstBlockSize(options), devices, tile);
+}
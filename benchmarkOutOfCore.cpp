@@ -0,0 +1,150 @@
+/**
+ * Benchmark of the out-of-core mode (-outofcore): problems tiled
+ * through limited device memory, optionally from mapped files.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "mappedFile.h"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+
+/**
+ * Host storage of one matrix for RunOutOfCore: malloc, or a file in dir
+ * mapped into memory if dir is given
+ */
+static float *AllocHostMatrix(const char *dir, const char *name,
+                              size_t elements, MappedFile *map) {
+    map->data = NULL;
+    map->fd = -1;
+
+    if (dir == NULL) {
+        return reinterpret_cast<float *>(malloc(sizeof(float) * elements));
+    }
+
+    std::string path = std::string(dir) + "/" + name;
+    return MapFile(path.c_str(), sizeof(float) * elements, true, map) ?
+           static_cast<float *>(map->data) : NULL;
+}
+
+static void FreeHostMatrix(float *data, MappedFile *map) {
+    if (map->data != NULL) {
+        UnmapFile(map);
+    } else {
+        free(data);
+    }
+}
+
+/**
+ * One out-of-core multiplication per size within deviceBytes of device
+ * memory (0 for most of the free memory), with the matrices in host
+ * memory or in files in dir; returns false if any result is wrong
+ */
+static bool RunOutOfCore(const std::vector<ProblemSize> &sizes,
+                         const char *kernelName, int block_size,
+                         size_t deviceBytes, const char *dir) {
+    const float valB = 0.01f;
+    MatmulHandle handle;
+    checkCudaErrors(MatmulCreate(&handle));
+    checkCudaErrors(MatmulSetOutOfCore(handle, deviceBytes));
+
+    if (kernelName != NULL &&
+            MatmulSetKernel(handle, kernelName, block_size) != cudaSuccess) {
+        printf("Error: no kernel %s with block size %d for this device\n",
+               kernelName, block_size);
+        exit(EXIT_FAILURE);
+    }
+
+    const KernelEntry *kernel = MatmulGetKernel(handle);
+    bool allCorrect = true;
+    printf("Out-of-core with %s, block %d, %s\n", kernel->name,
+           kernel->block_size, dir == NULL ? "host memory" : dir);
+    printf("%6s %6s %6s %10s %10s %10s %s\n", "M", "N", "K", "GB", "ms",
+           "GFlop/s", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        MappedFile map_A, map_B, map_C;
+        float *h_A = AllocHostMatrix(dir, "A.bin", size_A, &map_A);
+        float *h_B = AllocHostMatrix(dir, "B.bin", size_B, &map_B);
+        float *h_C = AllocHostMatrix(dir, "C.bin", size_C, &map_C);
+
+        if (h_A == NULL || h_B == NULL || h_C == NULL) {
+            fprintf(stderr, "Failed to allocate host matrices!\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = valB;
+        }
+
+        StopWatchInterface *timer = NULL;
+        sdkCreateTimer(&timer);
+        sdkStartTimer(&timer);
+        cudaError_t err = MatmulMultiplyOutOfCore(handle, h_C, h_A, h_B,
+                                                  size.M, size.N, size.K);
+        sdkStopTimer(&timer);
+        checkCudaErrors(err);
+        double ms = sdkGetTimerValue(&timer);
+        sdkDeleteTimer(&timer);
+
+        // Every element of C is K times 1 * valB; check a sample of the
+        // rows so that huge outputs do not have to be read in full
+        double ref = size.K * RoundToType(kernel->inType, valB);
+        double eps = (size.K + 1) * UnitRoundoff(MATMUL_FP32) +
+                     UnitRoundoff(kernel->inType) +
+                     ComputeRoundoff(kernel->compute);
+        bool correct = true;
+        int step = size.M > 64 ? size.M / 64 : 1;
+
+        for (int r = 0; r < size.M && correct; r += step) {
+            correct = CheckResult(h_C + static_cast<size_t>(r) * size.N,
+                                  size.N, static_cast<float>(ref), eps);
+        }
+
+        allCorrect = allCorrect && correct;
+
+        double bytes = sizeof(float) * static_cast<double>(size_A + size_B +
+                                                           size_C);
+        double flops = 2.0 * size.M * static_cast<double>(size.N) * size.K;
+        printf("%6d %6d %6d %10.2f %10.1f %10.2f %s\n", size.M, size.N,
+               size.K, bytes * 1.0e-9, ms, flops * 1.0e-6 / ms,
+               correct ? "PASS" : "FAIL");
+
+        FreeHostMatrix(h_A, &map_A);
+        FreeHostMatrix(h_B, &map_B);
+        FreeHostMatrix(h_C, &map_C);
+    }
+
+    checkCudaErrors(MatmulDestroy(handle));
+
+    return allCorrect;
+}
+
+bool BenchmarkOutOfCore(const BenchmarkOptions &options) {
+    char *dir = NULL;
+    getCmdLineArgumentString(options.argc, options.argv, "mmap", &dir);
+    return RunOutOfCore(options.sizes, FirstKernelName(options),
+                        FirstBlockSize(options), OutOfCoreBytes(options),
+                        dir);
+}
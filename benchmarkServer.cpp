@@ -0,0 +1,486 @@
+/**
+ * Benchmark of the batching GEMM server (-server) against blocking
+ * calls, and its handling of a faulting batch (-serverfault).
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+#include "matmulBatched.h"
+#include "matmulServer.h"
+#include "matmulVerify.h"
+
+// Requests each producer of -server keeps in flight on the server
+#define SERVER_WINDOW 4
+
+static double ServerHostMs() {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One in-flight request of a -server producer, with its own C
+struct ServerTicket {
+    float *d_C;
+    int size;
+    double submitMs;
+    double doneMs;
+    cudaError_t status;
+    std::atomic<bool> done;
+};
+
+static void ServerTicketDone(void *user, cudaError_t status) {
+    ServerTicket *ticket = static_cast<ServerTicket *>(user);
+    ticket->doneMs = ServerHostMs();
+    ticket->status = status;
+    ticket->done.store(true, std::memory_order_release);
+}
+
+// Inputs of one size, shared read-only by all producers
+struct ServerInputs {
+    ProblemSize size;
+    float *d_A;
+    float *d_B;
+    float *d_ref;
+    float *d_mag;
+};
+
+struct ServerLoad {
+    const std::vector<ServerInputs> *inputs;
+    int requests;
+    int block;
+
+    // NULL for the blocking round trips
+    GemmServer *server;
+
+    // Per producer: the window of tickets, and device arrays of the
+    // pointers of its C for each size, for the blocking calls
+    std::vector<std::vector<ServerTicket> > *tickets;
+    std::vector<std::vector<float **> > *pointers;
+    std::vector<std::vector<float> > *latencies;
+    std::vector<cudaError_t> *errors;
+};
+
+/**
+ * Producer t of -server: requests calls over the sizes in turn, either
+ * blocking on each one as MatrixMulBatched of one followed by
+ * cudaDeviceSynchronize, or submitted to the server with at most
+ * SERVER_WINDOW in flight
+ */
+static void ServerProducer(const ServerLoad *load, int t) {
+    const std::vector<ServerInputs> &inputs = *load->inputs;
+    std::vector<ServerTicket> &tickets = (*load->tickets)[t];
+    std::vector<float> &latencies = (*load->latencies)[t];
+    cudaError_t &error = (*load->errors)[t];
+    latencies.reserve(load->requests);
+
+    for (int r = 0; r < load->requests && error == cudaSuccess; r++) {
+        int s = r % static_cast<int>(inputs.size());
+        const ProblemSize &size = inputs[s].size;
+
+        if (load->server == NULL) {
+            float **ptrs = (*load->pointers)[t][s];
+            double startMs = ServerHostMs();
+
+            if (!MatrixMulBatched(ptrs, ptrs + 1, ptrs + 2, size.M, size.N,
+                                  size.K, 1, load->block, 0)) {
+                error = cudaErrorInvalidValue;
+            } else {
+                error = cudaDeviceSynchronize();
+            }
+
+            latencies.push_back(
+                static_cast<float>(ServerHostMs() - startMs));
+            continue;
+        }
+
+        ServerTicket &ticket = tickets[r % SERVER_WINDOW];
+
+        if (r >= SERVER_WINDOW) {
+            while (!ticket.done.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            error = ticket.status;
+            latencies.push_back(
+                static_cast<float>(ticket.doneMs - ticket.submitMs));
+        }
+
+        ticket.size = s;
+        ticket.done.store(false, std::memory_order_relaxed);
+        ticket.submitMs = ServerHostMs();
+        GemmRequest request = {ticket.d_C, inputs[s].d_A, inputs[s].d_B,
+                               size.M, size.N, size.K, ServerTicketDone,
+                               &ticket};
+        load->server->Submit(request);
+    }
+
+    for (int i = 0; load->server != NULL && i < SERVER_WINDOW &&
+         i < load->requests; i++) {
+        while (!tickets[i].done.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+
+        error = error == cudaSuccess ? tickets[i].status : error;
+        latencies.push_back(
+            static_cast<float>(tickets[i].doneMs - tickets[i].submitMs));
+    }
+}
+
+/**
+ * threads host threads each issue requests multiplications over the
+ * sizes, first as blocking round trips, then through a GemmServer with
+ * the given pool, batch limit and latency budget; prints the throughput
+ * and the latency percentiles of both, and returns false if any C of the
+ * server is wrong
+ */
+static bool RunServer(const std::vector<ProblemSize> &sizes, int threads,
+                      int requests, int streams, int maxBatch,
+                      double budgetUs, int block, unsigned int seed) {
+    std::vector<ServerInputs> inputs(sizes.size());
+    size_t maxC = 0;
+    double flops = 0.0;
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B);
+        std::vector<float> ref(size_C), mag(size_C);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &ref[0], size.N, 0);
+        inputs[s].size = size;
+        inputs[s].d_A = UploadArray(&h_A[0], size_A);
+        inputs[s].d_B = UploadArray(&h_B[0], size_B);
+        inputs[s].d_ref = UploadArray(&ref[0], size_C);
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = fabsf(h_A[i]);
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = fabsf(h_B[i]);
+        }
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &mag[0], size.N, 0);
+        inputs[s].d_mag = UploadArray(&mag[0], size_C);
+        maxC = size_C > maxC ? size_C : maxC;
+    }
+
+    for (int r = 0; r < requests; r++) {
+        const ProblemSize &size = sizes[r % sizes.size()];
+        flops += 2.0 * size.M * static_cast<double>(size.N) * size.K;
+    }
+
+    flops *= threads;
+
+    std::vector<std::vector<ServerTicket> > tickets(threads);
+    std::vector<std::vector<float **> > pointers(threads);
+
+    for (int t = 0; t < threads; t++) {
+        tickets[t] = std::vector<ServerTicket>(SERVER_WINDOW);
+
+        for (int i = 0; i < SERVER_WINDOW; i++) {
+            checkCudaErrors(cudaMalloc(
+                                reinterpret_cast<void **>(&tickets[t][i].d_C),
+                                sizeof(float) * maxC));
+            tickets[t][i].size = -1;
+            tickets[t][i].done.store(true);
+        }
+
+        for (size_t s = 0; s < sizes.size(); s++) {
+            const void *h_ptrs[3] = {tickets[t][0].d_C, inputs[s].d_A,
+                                     inputs[s].d_B};
+            float **d_ptrs;
+            checkCudaErrors(cudaMalloc(reinterpret_cast<void **>(&d_ptrs),
+                                       sizeof(h_ptrs)));
+            checkCudaErrors(cudaMemcpy(d_ptrs, h_ptrs, sizeof(h_ptrs),
+                                       cudaMemcpyHostToDevice));
+            pointers[t].push_back(d_ptrs);
+        }
+    }
+
+    printf("Server: %d threads x %d requests over %d sizes, block %d, "
+           "%d streams, batch <= %d, budget %.0f us\n", threads, requests,
+           static_cast<int>(sizes.size()), block, streams, maxBatch,
+           budgetUs);
+    printf("%-9s %10s %10s %9s %9s %9s %9s %9s %7s\n", "mode", "req/s",
+           "GFlop/s", "p50_ms", "p99_ms", "p999_ms", "max_ms", "batches",
+           "mean_b");
+
+    bool correct = true;
+
+    for (int pass = 0; pass < 2; pass++) {
+        GemmServer *server = NULL;
+
+        if (pass == 1) {
+            server = new GemmServer(streams, maxBatch, budgetUs, block);
+            checkCudaErrors(server->Status());
+        }
+
+        std::vector<std::vector<float> > latencies(threads);
+        std::vector<cudaError_t> errors(threads, cudaSuccess);
+        ServerLoad load = {&inputs, requests, block, server, &tickets,
+                           &pointers, &latencies, &errors};
+
+        // Untimed warmup of the kernels of every size
+        for (size_t s = 0; s < sizes.size(); s++) {
+            float **ptrs = pointers[0][s];
+            MatrixMulBatched(ptrs, ptrs + 1, ptrs + 2, sizes[s].M,
+                             sizes[s].N, sizes[s].K, 1, block, 0);
+        }
+
+        checkCudaErrors(cudaDeviceSynchronize());
+        std::vector<std::thread> producers;
+        double startMs = ServerHostMs();
+
+        for (int t = 0; t < threads; t++) {
+            producers.push_back(std::thread(ServerProducer, &load, t));
+        }
+
+        for (int t = 0; t < threads; t++) {
+            producers[t].join();
+        }
+
+        double wallMs = ServerHostMs() - startMs;
+        GemmServerStats stats = {0, 0, 0, 0};
+
+        if (server != NULL) {
+            stats = server->Stats();
+            delete server;
+        }
+
+        std::vector<float> all;
+
+        for (int t = 0; t < threads; t++) {
+            checkCudaErrors(errors[t]);
+            all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+        }
+
+        double calls = static_cast<double>(threads) * requests;
+        printf("%-9s %10.0f %10.2f %9.4f %9.4f %9.4f %9.4f %9ld %7.2f\n",
+               pass == 0 ? "blocking" : "server", calls / (wallMs / 1000.0),
+               flops * 1.0e-9 / (wallMs / 1000.0), Percentile(all, 50.0),
+               Percentile(all, 99.0), Percentile(all, 99.9),
+               Percentile(all, 100.0), pass == 0 ? 0L : stats.batches,
+               stats.batches > 0 ? static_cast<double>(stats.requests) /
+               stats.batches : 1.0);
+
+        if (pass == 1) {
+            printf("%ld of %ld batches full, %ld failed\n", stats.fullBatches,
+                   stats.batches, stats.failed);
+        }
+    }
+
+    // The C of every ticket holds the server's last request of its size
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < SERVER_WINDOW; i++) {
+            const ServerTicket &ticket = tickets[t][i];
+
+            if (ticket.size >= 0) {
+                const ServerInputs &in = inputs[ticket.size];
+                size_t size_C = static_cast<size_t>(in.size.M) * in.size.N;
+                VerifyStats error;
+                checkCudaErrors(CompareOnDevice(ticket.d_C, MATMUL_FP32,
+                                                in.d_ref, in.d_mag, size_C,
+                                                &error, 0));
+                correct = correct && error.nonFinite == 0 &&
+                          error.maxRelError <=
+                          2.0 * (in.size.K + 1) * UnitRoundoff(MATMUL_FP32);
+            }
+
+            checkCudaErrors(cudaFree(ticket.d_C));
+        }
+
+        for (size_t s = 0; s < sizes.size(); s++) {
+            checkCudaErrors(cudaFree(pointers[t][s]));
+        }
+    }
+
+    for (size_t s = 0; s < inputs.size(); s++) {
+        checkCudaErrors(cudaFree(inputs[s].d_A));
+        checkCudaErrors(cudaFree(inputs[s].d_B));
+        checkCudaErrors(cudaFree(inputs[s].d_ref));
+        checkCudaErrors(cudaFree(inputs[s].d_mag));
+    }
+
+    printf("server results %s\n", correct ? "ok" : "FAIL");
+    return correct;
+}
+
+// Status a future of the server received within the timeout, or -1
+static int ServerFutureStatus(std::future<cudaError_t> *future) {
+    if (future->wait_for(std::chrono::seconds(10)) !=
+            std::future_status::ready) {
+        return -1;
+    }
+
+    return future->get();
+}
+
+/**
+ * Submit a request of size, then one whose A is a NULL device pointer,
+ * so that its batch faults on the device and leaves a sticky error,
+ * then more requests behind it. Returns true if the first request
+ * succeeded and every later one was completed with an error rather than
+ * left hanging. The context is unusable afterwards; the process must
+ * exit.
+ */
+static bool RunServerFault(const ProblemSize &size, int streams,
+                           int maxBatch, double budgetUs, int block) {
+    size_t size_A = static_cast<size_t>(size.M) * size.K;
+    size_t size_B = static_cast<size_t>(size.K) * size.N;
+    size_t size_C = static_cast<size_t>(size.M) * size.N;
+    float *d_A, *d_B, *d_C;
+    checkCudaErrors(cudaMalloc(&d_A, sizeof(float) * size_A));
+    checkCudaErrors(cudaMalloc(&d_B, sizeof(float) * size_B));
+    checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+    checkCudaErrors(cudaMemset(d_A, 0, sizeof(float) * size_A));
+    checkCudaErrors(cudaMemset(d_B, 0, sizeof(float) * size_B));
+
+    printf("Server fault: %d x %d x %d, block %d, %d streams, batch <= %d, "
+           "budget %.0f us\n", size.M, size.N, size.K, block, streams,
+           maxBatch, budgetUs);
+
+    GemmServer server(streams, maxBatch, budgetUs, block);
+    checkCudaErrors(server.Status());
+
+    std::future<cudaError_t> first =
+        server.Submit(d_C, d_A, d_B, size.M, size.N, size.K);
+    int firstStatus = ServerFutureStatus(&first);
+
+    std::vector<std::future<cudaError_t> > later;
+    later.push_back(server.Submit(d_C, NULL, d_B, size.M, size.N, size.K));
+
+    for (int i = 0; i < 4 * maxBatch; i++) {
+        later.push_back(server.Submit(d_C, d_A, d_B, size.M, size.N,
+                                      size.K));
+    }
+
+    int hung = 0;
+    int succeeded = 0;
+    int faultStatus = ServerFutureStatus(&later[0]);
+
+    for (size_t i = 1; i < later.size(); i++) {
+        int status = ServerFutureStatus(&later[i]);
+        hung += status < 0 ? 1 : 0;
+        succeeded += status == cudaSuccess ? 1 : 0;
+    }
+
+    printf("first: %s\n", firstStatus < 0 ? "hung" :
+           cudaGetErrorString(static_cast<cudaError_t>(firstStatus)));
+    printf("faulting: %s\n", faultStatus < 0 ? "hung" :
+           cudaGetErrorString(static_cast<cudaError_t>(faultStatus)));
+    printf("after it: %d requests, %d succeeded, %d hung\n",
+           static_cast<int>(later.size()) - 1, succeeded, hung);
+
+    GemmServerStats stats = server.Stats();
+    printf("stats: %ld completed, %ld failed, %ld batches\n",
+           stats.requests, stats.failed, stats.batches);
+
+    // Requests in the batch of the fault fail with it; ones issued
+    // before the fault ran may still have succeeded
+    return firstStatus == cudaSuccess && faultStatus > 0 && hung == 0;
+}
+
+/**
+ * Pool, batch limit and latency budget of the server from -streams,
+ * -maxbatch and -budget
+ */
+static void ServerOptions(const BenchmarkOptions &options, int *streams,
+                          int *maxBatch, double *budgetUs) {
+    *streams = GEMM_SERVER_STREAMS;
+    *maxBatch = GEMM_SERVER_MAX_BATCH;
+    *budgetUs = GEMM_SERVER_BUDGET_US;
+
+    if (checkCmdLineFlag(options.argc, options.argv, "streams")) {
+        *streams = getCmdLineArgumentInt(options.argc, options.argv,
+                                         "streams");
+    }
+
+    if (checkCmdLineFlag(options.argc, options.argv, "maxbatch")) {
+        *maxBatch = getCmdLineArgumentInt(options.argc, options.argv,
+                                          "maxbatch");
+    }
+
+    if (checkCmdLineFlag(options.argc, options.argv, "budget")) {
+        *budgetUs = getCmdLineArgumentFloat(options.argc, options.argv,
+                                            "budget");
+    }
+}
+
+bool BenchmarkServer(const BenchmarkOptions &options) {
+    int threads = 8;
+    int requests = 1000;
+    int streams, maxBatch;
+    double budgetUs;
+    int block = FirstBlockSize(options);
+    char *arg = NULL;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "server",
+                                 &arg)) {
+        threads = atoi(arg);
+    }
+
+    if (checkCmdLineFlag(options.argc, options.argv, "requests")) {
+        requests = getCmdLineArgumentInt(options.argc, options.argv,
+                                         "requests");
+    }
+
+    ServerOptions(options, &streams, &maxBatch, &budgetUs);
+
+    if (threads < 1 || requests < 1 || streams < 1 || maxBatch < 1 ||
+        budgetUs < 0.0 || (block != 16 && block != 32)) {
+        printf("Error: need -server=threads, -requests, -streams and "
+               "-maxbatch >= 1, -budget >= 0 and -block 16 or 32\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return RunServer(options.sizes, threads, requests, streams, maxBatch,
+                     budgetUs, block, SeedOption(options));
+}
+
+bool BenchmarkServerFault(const BenchmarkOptions &options) {
+    int streams, maxBatch;
+    double budgetUs;
+    int block = FirstBlockSize(options);
+    ServerOptions(options, &streams, &maxBatch, &budgetUs);
+
+    if (streams < 1 || maxBatch < 1 || budgetUs < 0.0 ||
+        (block != 16 && block != 32)) {
+        printf("Error: need -streams and -maxbatch >= 1, -budget >= 0 "
+               "and -block 16 or 32\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return RunServerFault(options.sizes[0], streams, maxBatch, budgetUs,
+                          block);
+}
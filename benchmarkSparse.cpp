@@ -0,0 +1,334 @@
+/**
+ * Benchmark of sparse times dense products (-sparse): CSR,
+ * blocked-ELL and 2:4 against the dense kernel.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+#include "matmulSparse.h"
+#include "matmulVerify.h"
+
+// Formats of A in -sparse
+enum SparseFormat {
+    SPARSE_CSR,
+    SPARSE_ELL,
+    SPARSE_24
+};
+
+static const char *SparseFormatName(SparseFormat format) {
+    switch (format) {
+    case SPARSE_ELL:
+        return "ell";
+
+    case SPARSE_24:
+        return "2:4";
+
+    default:
+        return "csr";
+    }
+}
+
+// One SpMM of -sparse, A on the device in one of the formats
+struct SparsePlan {
+    SparseFormat format;
+    ProblemSize size;
+    float *d_C;
+    const float *d_B;
+    int nnz;
+    int ellCols;
+    int *d_index;
+    int *d_rowPtr;
+    float *d_values;
+    unsigned char *d_meta;
+
+    // The kernel of SPARSE_24
+    const Sparse24Kernel *sparse24;
+};
+
+static void LaunchSparsePlan(void *context, cudaStream_t stream) {
+    const SparsePlan *p = static_cast<const SparsePlan *>(context);
+    const ProblemSize &s = p->size;
+
+    if (p->format == SPARSE_CSR) {
+        MatrixMulCsr(p->d_C, p->d_rowPtr, p->d_index, p->d_values, s.M,
+                     p->nnz, p->d_B, s.N, stream);
+    } else if (p->format == SPARSE_ELL) {
+        MatrixMulBlockedEll(p->d_C, p->d_index, p->d_values, s.M, s.K,
+                            p->ellCols, 32, p->d_B, s.N, stream);
+    } else {
+        p->sparse24->launch(p->d_C, p->d_values, p->d_meta, s.M, s.K,
+                            p->d_B, s.N, stream);
+    }
+}
+
+/**
+ * Upload A in format to p, time p, and compare its result with d_ref;
+ * prints a row of the -sparse table and returns whether it is correct
+ */
+static bool TimeSparsePlan(SparsePlan *p, const std::vector<float> &h_A,
+                           const char *pattern, double density,
+                           double denseMs, const float *d_ref,
+                           const float *d_mag, int warmup, int iters) {
+    const ProblemSize &size = p->size;
+    size_t size_C = static_cast<size_t>(size.M) * size.N;
+    p->d_index = NULL;
+    p->d_rowPtr = NULL;
+    p->d_values = NULL;
+    p->d_meta = NULL;
+    double stored;
+
+    if (p->format == SPARSE_CSR) {
+        CsrMatrix csr;
+        DenseToCsr(&h_A[0], size.M, size.K, &csr);
+        p->nnz = static_cast<int>(csr.values.size());
+        p->d_rowPtr = UploadArray(&csr.rowPtr[0], csr.rowPtr.size());
+        p->d_index = UploadArray(csr.colIdx.empty() ? NULL : &csr.colIdx[0],
+                                 csr.colIdx.size());
+        p->d_values = UploadArray(csr.values.empty() ? NULL :
+                                  &csr.values[0], csr.values.size());
+        stored = static_cast<double>(p->nnz);
+    } else if (p->format == SPARSE_ELL) {
+        BlockedEllMatrix ell;
+        DenseToBlockedEll(&h_A[0], size.M, size.K, 32, &ell);
+        p->ellCols = ell.ellCols;
+        p->d_index = UploadArray(&ell.blockCols[0], ell.blockCols.size());
+        p->d_values = UploadArray(&ell.values[0], ell.values.size());
+        stored = static_cast<double>(ell.values.size());
+    } else {
+        Sparse24Matrix sparse;
+
+        if (!DenseToSparse24(&h_A[0], size.M, size.K, &sparse)) {
+            printf("Error: A is not 2:4 sparse\n");
+            exit(EXIT_FAILURE);
+        }
+
+        p->d_values = UploadArray(&sparse.values[0], sparse.values.size());
+        p->d_meta = UploadArray(&sparse.meta[0], sparse.meta.size());
+        stored = static_cast<double>(sparse.values.size());
+    }
+
+    // NaNs in C catch elements that are never written
+    checkCudaErrors(cudaMemset(p->d_C, 0xff, sizeof(float) * size_C));
+    std::vector<float> times;
+    TimeLaunches(LaunchSparsePlan, p, warmup, iters, 0, &times);
+    checkCudaErrors(cudaGetLastError());
+    TimingStats stats = SummarizeTimes(times);
+
+    VerifyStats error;
+    checkCudaErrors(CompareOnDevice(p->d_C, MATMUL_FP32, d_ref, d_mag,
+                                    size_C, &error, 0));
+    // Rounding A and B to a narrower type for the products errs by up to
+    // twice its unit roundoff
+    MatmulType inType = p->format == SPARSE_24 ? p->sparse24->inType :
+                        MATMUL_FP32;
+    double tolerance = 2.0 * (size.K + 1) * UnitRoundoff(MATMUL_FP32) +
+                       UnitRoundoff(MATMUL_FP32) +
+                       (inType != MATMUL_FP32 ? 2.0 * UnitRoundoff(inType) :
+                        0.0);
+    double ratio = error.maxRelError / tolerance;
+    bool correct = ratio <= 1.0 && error.nonFinite == 0;
+    double flops = 2.0 * size.M * static_cast<double>(size.N) * size.K;
+    printf("%-7s %7.3f %-6s %6d %6d %6d %8.2f %10.4f %10.2f %8.2f %9.3f"
+           " %s\n", pattern, density,
+           p->format == SPARSE_24 ? p->sparse24->name :
+           SparseFormatName(p->format), size.M,
+           size.N, size.K,
+           100.0 * stored / (static_cast<double>(size.M) * size.K),
+           stats.median_ms, flops * 1.0e-6 / stats.median_ms,
+           denseMs / stats.median_ms, ratio, correct ? "ok" : "FAIL");
+
+    checkCudaErrors(cudaFree(p->d_index));
+    checkCudaErrors(cudaFree(p->d_rowPtr));
+    checkCudaErrors(cudaFree(p->d_values));
+    checkCudaErrors(cudaFree(p->d_meta));
+    return correct;
+}
+
+/**
+ * Sparse A times dense B against the dense regTile4 kernel, for every
+ * density: A with random non-zeros in CSR, A with random dense 32 x 32
+ * blocks in CSR and blocked-ELL, and once per size A pruned to 2:4 on
+ * each 2:4 kernel that a device of compute capability arch runs.
+ * GFlop/s counts the flops of the dense product, so x_dense is the
+ * speedup over it; stored% is the share of A that the format holds.
+ */
+static bool RunSparse(const std::vector<ProblemSize> &sizes,
+                      const std::vector<double> &densities, int arch,
+                      unsigned int seed, int warmup, int iters) {
+    const KernelEntry *dense = FindKernel("regTile4", 16);
+    int sparse24Count;
+    const Sparse24Kernel *sparse24 = GetSparse24Kernels(&sparse24Count);
+    bool allCorrect = true;
+    printf("%-7s %7s %-6s %6s %6s %6s %8s %10s %10s %8s %9s %s\n",
+           "pattern", "density", "format", "M", "N", "K", "stored%",
+           "median_ms", "GFlop/s", "x_dense", "max/tol", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B), ref(size_C), mag(size_C);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        float *d_A, *d_C, *d_ref, *d_mag;
+        float *d_B = UploadArray(&h_B[0], size_B);
+        checkCudaErrors(cudaMalloc(&d_A, sizeof(float) * size_A));
+        checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_ref, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_mag, sizeof(float) * size_C));
+
+        // The dense kernel does not depend on the values of A
+        checkCudaErrors(cudaMemset(d_A, 0, sizeof(float) * size_A));
+        std::vector<float> times;
+        TimeKernelLaunches(dense, d_C, d_A, d_B, size.M, size.N, size.K,
+                           warmup, iters, 0, &times);
+        checkCudaErrors(cudaGetLastError());
+        double denseMs = SummarizeTimes(times).median_ms;
+        printf("%-7s %7.3f %-6s %6d %6d %6d %8.2f %10.4f %10.2f %8.2f\n",
+               "dense", 1.0, dense->name, size.M, size.N, size.K, 100.0,
+               denseMs, 2.0e-6 * size.M * static_cast<double>(size.N) *
+               size.K / denseMs, 1.0);
+
+        SparsePlan p;
+        p.size = size;
+        p.d_C = d_C;
+        p.d_B = d_B;
+
+        // Pattern 0 scatters the non-zeros, 1 puts them in 32 x 32 blocks
+        // and 2 prunes a dense A to 2:4
+        for (int pattern = 0; pattern < 3; pattern++) {
+            size_t count = pattern == 2 ? 1 : densities.size();
+
+            for (size_t d = 0; d < count; d++) {
+                double density = pattern == 2 ? 0.5 : densities[d];
+                int blockCols = (size.K + 31) / 32;
+                std::vector<char> keep;
+
+                if (pattern == 1) {
+                    int blocks = (size.M + 31) / 32 * blockCols;
+                    keep.resize(blocks);
+
+                    for (int b = 0; b < blocks; b++) {
+                        keep[b] = rand() < density * RAND_MAX;
+                    }
+                }
+
+                for (size_t i = 0; i < size_A; i++) {
+                    int r = static_cast<int>(i / size.K);
+                    int c = static_cast<int>(i % size.K);
+                    bool nonZero = pattern == 0 ?
+                                   rand() < density * RAND_MAX :
+                                   pattern == 2 ||
+                                   keep[r / 32 * blockCols + c / 32];
+                    float v = 2.0f * rand() / RAND_MAX - 1.0f;
+                    h_A[i] = nonZero ? v : 0.0f;
+                }
+
+                if (pattern == 2) {
+                    Prune24(&h_A[0], size.M, size.K);
+                }
+
+                std::vector<float> absA(size_A), absB(size_B);
+                CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0],
+                        size.N, &ref[0], size.N, 0);
+
+                for (size_t i = 0; i < size_A; i++) {
+                    absA[i] = fabsf(h_A[i]);
+                }
+
+                for (size_t i = 0; i < size_B; i++) {
+                    absB[i] = fabsf(h_B[i]);
+                }
+
+                CpuGemm(size.M, size.N, size.K, &absA[0], size.K, &absB[0],
+                        size.N, &mag[0], size.N, 0);
+                checkCudaErrors(cudaMemcpy(d_ref, &ref[0],
+                                           sizeof(float) * size_C,
+                                           cudaMemcpyHostToDevice));
+                checkCudaErrors(cudaMemcpy(d_mag, &mag[0],
+                                           sizeof(float) * size_C,
+                                           cudaMemcpyHostToDevice));
+
+                const char *names[] = {"scatter", "blocks", "2:4"};
+                const SparseFormat formats[][2] = {
+                    {SPARSE_CSR, SPARSE_CSR}, {SPARSE_CSR, SPARSE_ELL},
+                    {SPARSE_24, SPARSE_24}
+                };
+
+                for (int f = 0; f < 2; f++) {
+                    if (f == 1 && formats[pattern][1] == formats[pattern][0]) {
+                        break;
+                    }
+
+                    p.format = formats[pattern][f];
+                    int kernels = p.format == SPARSE_24 ? sparse24Count : 1;
+
+                    for (int k = 0; k < kernels; k++) {
+                        p.sparse24 = &sparse24[k];
+
+                        if (p.format == SPARSE_24 &&
+                                sparse24[k].minArch > arch) {
+                            continue;
+                        }
+
+                        bool correct = TimeSparsePlan(&p, h_A,
+                                                      names[pattern],
+                                                      density, denseMs,
+                                                      d_ref, d_mag, warmup,
+                                                      iters);
+                        allCorrect = allCorrect && correct;
+                    }
+                }
+            }
+        }
+
+        checkCudaErrors(cudaFree(d_A));
+        checkCudaErrors(cudaFree(d_B));
+        checkCudaErrors(cudaFree(d_C));
+        checkCudaErrors(cudaFree(d_ref));
+        checkCudaErrors(cudaFree(d_mag));
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkSparse(const BenchmarkOptions &options) {
+    const double defaultDensities[] = {0.01, 0.05, 0.1, 0.2, 0.3, 0.5};
+    std::vector<double> densities(defaultDensities, defaultDensities +
+                                  sizeof(defaultDensities) /
+                                  sizeof(defaultDensities[0]));
+    char *arg = NULL;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "sparse",
+                                 &arg)) {
+        std::vector<std::string> items = SplitList(arg);
+        densities.clear();
+
+        for (size_t i = 0; i < items.size(); i++) {
+            densities.push_back(atof(items[i].c_str()));
+        }
+    }
+
+    return RunSparse(options.sizes, densities, options.arch,
+                     SeedOption(options), options.warmup, options.iters);
+}
@@ -0,0 +1,210 @@
+/**
+ * Benchmark of Strassen-Winograd (-strassen) at several cutoffs
+ * against the tiled kernel.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "kernelTiming.h"
+#include "matmulLibrary.h"
+#include "matmulVerify.h"
+
+// One GEMM of -strassen through the library
+struct StrassenPlan {
+    MatmulHandle handle;
+    ProblemSize size;
+    float *d_C;
+    const float *d_A;
+    const float *d_B;
+};
+
+static void LaunchStrassenPlan(void *context, cudaStream_t) {
+    const StrassenPlan *p = static_cast<const StrassenPlan *>(context);
+    MatmulMultiplyStrassen(p->handle, p->d_C, p->d_A, p->d_B, p->size.M,
+                           p->size.N, p->size.K);
+}
+
+// Levels of recursion of MatmulMultiplyStrassen at cutoff
+static int StrassenLevels(const ProblemSize &size, int cutoff) {
+    int levels = 0;
+
+    for (int M = size.M, N = size.N, K = size.K;
+            M > cutoff && N > cutoff && K > cutoff; M /= 2, N /= 2, K /= 2) {
+        levels++;
+    }
+
+    return levels;
+}
+
+/**
+ * fp32 GEMM of random matrices with Strassen-Winograd at each cutoff,
+ * against the tiled kernel alone (no recursion): speed, and the growth of
+ * the error against a host reference. The error bound of Winograd's
+ * variant grows by a factor of up to 18 per level (Higham, "Accuracy and
+ * Stability of Numerical Algorithms", 2nd ed., sec. 23.2.2), which scales
+ * the tolerance of the tiled kernel.
+ */
+static bool RunStrassen(const std::vector<ProblemSize> &sizes,
+                        const std::vector<int> &cutoffs, unsigned int seed,
+                        int warmup, int iters) {
+    StrassenPlan p;
+    checkCudaErrors(MatmulCreate(&p.handle));
+    cudaStream_t stream = MatmulGetStream(p.handle);
+    bool allCorrect = true;
+    printf("%6s %6s %6s %6s %6s %10s %10s %8s %10s %10s %8s %s\n", "M", "N",
+           "K", "cutoff", "levels", "median_ms", "GFlop/s", "x_tiled",
+           "max_rel", "mean_rel", "growth", "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B), ref(size_C), mag(size_C);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        float *d_A, *d_B, *d_C, *d_ref, *d_mag;
+        checkCudaErrors(cudaMalloc(&d_A, sizeof(float) * size_A));
+        checkCudaErrors(cudaMalloc(&d_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_ref, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_mag, sizeof(float) * size_C));
+        checkCudaErrors(cudaMemcpy(d_A, &h_A[0], sizeof(float) * size_A,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(d_B, &h_B[0], sizeof(float) * size_B,
+                                   cudaMemcpyHostToDevice));
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &ref[0], size.N, 0);
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = fabsf(h_A[i]);
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = fabsf(h_B[i]);
+        }
+
+        CpuGemm(size.M, size.N, size.K, &h_A[0], size.K, &h_B[0], size.N,
+                &mag[0], size.N, 0);
+        checkCudaErrors(cudaMemcpy(d_ref, &ref[0], sizeof(float) * size_C,
+                                   cudaMemcpyHostToDevice));
+        checkCudaErrors(cudaMemcpy(d_mag, &mag[0], sizeof(float) * size_C,
+                                   cudaMemcpyHostToDevice));
+
+        p.size = size;
+        p.d_C = d_C;
+        p.d_A = d_A;
+        p.d_B = d_B;
+
+        // A cutoff above every dimension first: the tiled kernel alone
+        std::vector<int> runs(1, INT_MAX);
+        runs.insert(runs.end(), cutoffs.begin(), cutoffs.end());
+        double tiledMs = 0.0;
+        double tiledError = 0.0;
+
+        for (size_t c = 0; c < runs.size(); c++) {
+            int levels = StrassenLevels(size, runs[c]);
+
+            if (c > 0 && levels == 0) {
+                continue;
+            }
+
+            checkCudaErrors(MatmulSetStrassenCutoff(p.handle, runs[c]));
+
+            // NaNs in C catch elements that are never written
+            checkCudaErrors(cudaMemsetAsync(d_C, 0xff, sizeof(float) * size_C,
+                                            stream));
+
+            std::vector<float> times;
+            TimeLaunches(LaunchStrassenPlan, &p, warmup, iters, stream,
+                         &times);
+            checkCudaErrors(cudaGetLastError());
+            TimingStats stats = SummarizeTimes(times);
+
+            VerifyStats error;
+            checkCudaErrors(CompareOnDevice(d_C, MATMUL_FP32, d_ref, d_mag,
+                                            size_C, &error, stream));
+
+            if (c == 0) {
+                tiledMs = stats.median_ms;
+                tiledError = error.maxRelError;
+            }
+
+            double tol = (2.0 * (size.K + 1) + 1.0) *
+                         UnitRoundoff(MATMUL_FP32) * pow(18.0, levels);
+            bool correct = error.maxRelError <= tol && error.nonFinite == 0;
+            double flops = 2.0 * size.M * static_cast<double>(size.N) *
+                           size.K;
+            char cutoff[16] = "-";
+
+            if (c > 0) {
+                snprintf(cutoff, sizeof(cutoff), "%d", runs[c]);
+            }
+
+            printf("%6d %6d %6d %6s %6d %10.4f %10.2f %8.2f %10.2e %10.2e"
+                   " %8.2f %s\n", size.M, size.N, size.K, cutoff, levels,
+                   stats.median_ms, flops * 1.0e-6 / stats.median_ms,
+                   tiledMs / stats.median_ms, error.maxRelError,
+                   error.meanRelError, tiledError > 0.0 ?
+                   error.maxRelError / tiledError : 1.0,
+                   correct ? "ok" : "FAIL");
+            allCorrect = allCorrect && correct;
+        }
+
+        checkCudaErrors(cudaFree(d_A));
+        checkCudaErrors(cudaFree(d_B));
+        checkCudaErrors(cudaFree(d_C));
+        checkCudaErrors(cudaFree(d_ref));
+        checkCudaErrors(cudaFree(d_mag));
+    }
+
+    checkCudaErrors(MatmulDestroy(p.handle));
+    return allCorrect;
+}
+
+bool BenchmarkStrassen(const BenchmarkOptions &options) {
+    std::vector<int> cutoffs;
+    cutoffs.push_back(256);
+    cutoffs.push_back(512);
+    cutoffs.push_back(1024);
+    cutoffs.push_back(2048);
+    char *arg = NULL;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "strassen",
+                                 &arg)) {
+        std::vector<std::string> items = SplitList(arg);
+        cutoffs.clear();
+
+        for (size_t i = 0; i < items.size(); i++) {
+            cutoffs.push_back(atoi(items[i].c_str()));
+        }
+    }
+
+    return RunStrassen(options.sizes, cutoffs, SeedOption(options),
+                       options.warmup, options.iters);
+}
@@ -0,0 +1,293 @@
+/**
+ * Verification sweep (-verify): error statistics of every kernel over
+ * fixed and random shapes.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "cpuGemm.h"
+#include "matmulVerify.h"
+#include "matrixUtils.h"
+
+// Shapes of the verification sweep: degenerate, ragged and long-K ones
+static const ProblemSize kVerifyShapes[] = {
+    {1, 1, 1}, {1, 1, 4099}, {7, 13, 5}, {17, 31, 33}, {64, 64, 64},
+    {100, 257, 129}, {255, 1, 511}, {1, 511, 255}, {513, 767, 333},
+    {1024, 1024, 1024}, {1000, 777, 4099}
+};
+
+// Errors of one kernel over all shapes of the sweep
+struct VerifySummary {
+    const KernelEntry *kernel;
+    size_t elements;
+    double sumRel;
+
+    // Largest relative error as a fraction of the tolerance of its shape
+    double worstRatio;
+    ProblemSize worstSize;
+    size_t worstIndex;
+
+    unsigned long long maxUlps;
+    unsigned long long ulps[VERIFY_ULP_BUCKETS];
+    unsigned long long nonFinite;
+};
+
+static void PrintUlpHistogram(const VerifySummary &v) {
+    printf("    ulps:");
+
+    for (int b = 0; b < VERIFY_ULP_BUCKETS; b++) {
+        if (v.ulps[b] == 0) {
+            continue;
+        }
+
+        if (b < 2) {
+            printf(" %d:%llu", b, v.ulps[b]);
+        } else if (b < VERIFY_ULP_BUCKETS - 1) {
+            printf(" %llu-%llu:%llu", 1ull << (b - 1), (1ull << b) - 1,
+                   v.ulps[b]);
+        } else {
+            printf(" >=%llu:%llu", 1ull << (b - 1), v.ulps[b]);
+        }
+    }
+
+    printf("\n");
+}
+
+/**
+ * Run every kernel once on random matrices of every shape and compare it
+ * on the device with CpuGemm on the inputs rounded to the kernel's input
+ * type; prints the error statistics per kernel and returns false if any
+ * kernel exceeds its tolerance
+ */
+static bool RunVerify(const std::vector<const KernelEntry *> &kernels,
+                      const std::vector<ProblemSize> &shapes,
+                      unsigned int seed) {
+    std::vector<VerifySummary> summaries(kernels.size());
+
+    for (size_t k = 0; k < kernels.size(); k++) {
+        memset(&summaries[k], 0, sizeof(VerifySummary));
+        summaries[k].kernel = kernels[k];
+    }
+
+    printf("Verifying %d kernels over %d shapes, seed %u\n",
+           static_cast<int>(kernels.size()), static_cast<int>(shapes.size()),
+           seed);
+
+    for (size_t s = 0; s < shapes.size(); s++) {
+        const ProblemSize &size = shapes[s];
+        size_t size_A = static_cast<size_t>(size.M) * size.K;
+        size_t size_B = static_cast<size_t>(size.K) * size.N;
+        size_t size_C = static_cast<size_t>(size.M) * size.N;
+        std::vector<float> h_A(size_A), h_B(size_B);
+        srand(seed + static_cast<unsigned int>(s));
+
+        for (size_t i = 0; i < size_A; i++) {
+            h_A[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        for (size_t i = 0; i < size_B; i++) {
+            h_B[i] = 2.0f * rand() / RAND_MAX - 1.0f;
+        }
+
+        void *d_A, *d_B, *d_C;
+        float *d_ref, *d_mag;
+        checkCudaErrors(cudaMalloc(&d_A, sizeof(float) * size_A));
+        checkCudaErrors(cudaMalloc(&d_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_ref, sizeof(float) * size_C));
+        checkCudaErrors(cudaMalloc(&d_mag, sizeof(float) * size_C));
+
+        // One reference per input type, computed when a kernel needs it
+        const MatmulType types[] = {MATMUL_FP32, MATMUL_FP16, MATMUL_BF16};
+
+        for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+            bool used = false;
+
+            for (size_t k = 0; k < kernels.size(); k++) {
+                used = used || kernels[k]->inType == types[t];
+            }
+
+            if (!used) {
+                continue;
+            }
+
+            std::vector<float> a(size_A), b(size_B), ref(size_C), mag(size_C);
+            std::vector<char> staging(sizeof(float) *
+                                      (size_A > size_B ? size_A : size_B));
+
+            for (size_t i = 0; i < size_A; i++) {
+                a[i] = RoundToType(types[t], h_A[i]);
+            }
+
+            for (size_t i = 0; i < size_B; i++) {
+                b[i] = RoundToType(types[t], h_B[i]);
+            }
+
+            CpuGemm(size.M, size.N, size.K, &a[0], size.K, &b[0], size.N,
+                    &ref[0], size.N, 0);
+
+            for (size_t i = 0; i < size_A; i++) {
+                a[i] = fabsf(a[i]);
+            }
+
+            for (size_t i = 0; i < size_B; i++) {
+                b[i] = fabsf(b[i]);
+            }
+
+            CpuGemm(size.M, size.N, size.K, &a[0], size.K, &b[0], size.N,
+                    &mag[0], size.N, 0);
+            checkCudaErrors(cudaMemcpy(d_ref, &ref[0], sizeof(float) * size_C,
+                                       cudaMemcpyHostToDevice));
+            checkCudaErrors(cudaMemcpy(d_mag, &mag[0], sizeof(float) * size_C,
+                                       cudaMemcpyHostToDevice));
+
+            int loadedType = -1;
+            UploadInputs(types[t], &h_A[0], &h_B[0], &staging[0], d_A, d_B,
+                         static_cast<int>(size_A), static_cast<int>(size_B),
+                         &loadedType);
+
+            for (size_t k = 0; k < kernels.size(); k++) {
+                const KernelEntry *kernel = kernels[k];
+
+                if (kernel->inType != types[t]) {
+                    continue;
+                }
+
+                // NaNs in C catch elements that are never written
+                checkCudaErrors(cudaMemset(d_C, 0xff,
+                                           sizeof(float) * size_C));
+                void *d_W = NULL;
+                checkCudaErrors(MallocWorkspace(kernel, size, &d_W));
+                kernel->launch(d_C, d_A, d_B, size.M, size.N, size.K, d_W,
+                               0);
+                checkCudaErrors(cudaGetLastError());
+                checkCudaErrors(cudaFree(d_W));
+
+                VerifyStats stats;
+                checkCudaErrors(CompareOnDevice(d_C, kernel->outType, d_ref,
+                                                d_mag, size_C, &stats, 0));
+
+                VerifySummary &v = summaries[k];
+                double ratio = stats.maxRelError /
+                               VerifyTolerance(kernel, size.K);
+
+                if (v.elements == 0 || ratio > v.worstRatio) {
+                    v.worstRatio = ratio;
+                    v.worstSize = size;
+                    v.worstIndex = stats.worst;
+                }
+
+                v.elements += stats.elements;
+                v.sumRel += stats.meanRelError *
+                            (stats.elements - stats.nonFinite);
+                v.maxUlps = stats.maxUlps > v.maxUlps ? stats.maxUlps :
+                            v.maxUlps;
+                v.nonFinite += stats.nonFinite;
+
+                for (int i = 0; i < VERIFY_ULP_BUCKETS; i++) {
+                    v.ulps[i] += stats.ulps[i];
+                }
+            }
+        }
+
+        checkCudaErrors(cudaFree(d_A));
+        checkCudaErrors(cudaFree(d_B));
+        checkCudaErrors(cudaFree(d_C));
+        checkCudaErrors(cudaFree(d_ref));
+        checkCudaErrors(cudaFree(d_mag));
+    }
+
+    bool allCorrect = true;
+    printf("%-20s %5s %9s %10s %10s %10s %8s %s\n", "kernel", "block",
+           "types", "max/tol", "mean_rel", "max_ulps", "<=1ulp", "check");
+
+    for (size_t k = 0; k < summaries.size(); k++) {
+        const VerifySummary &v = summaries[k];
+        bool correct = v.worstRatio <= 1.0 && v.nonFinite == 0;
+        VerifyStats total;
+        memset(&total, 0, sizeof(total));
+        total.elements = v.elements;
+        memcpy(total.ulps, v.ulps, sizeof(total.ulps));
+        char types[16];
+        snprintf(types, sizeof(types), "%s>%s",
+                 MatmulTypeName(v.kernel->inType),
+                 MatmulTypeName(v.kernel->outType));
+
+        printf("%-20s %5d %9s %10.3f %10.2e %10llu %7.2f%% %s\n",
+               v.kernel->name, v.kernel->block_size, types, v.worstRatio,
+               v.sumRel / (v.elements > v.nonFinite ?
+                           v.elements - v.nonFinite : 1),
+               v.maxUlps, 100.0 * FractionWithinUlps(total, 1),
+               correct ? "ok" : "FAIL");
+        PrintUlpHistogram(v);
+
+        if (!correct) {
+            printf("    worst: %dx%dx%d element [%d][%d], %llu non-finite\n",
+                   v.worstSize.M, v.worstSize.N, v.worstSize.K,
+                   static_cast<int>(v.worstIndex / v.worstSize.N),
+                   static_cast<int>(v.worstIndex % v.worstSize.N),
+                   v.nonFinite);
+        }
+
+        allCorrect = allCorrect && correct;
+    }
+
+    return allCorrect;
+}
+
+bool BenchmarkVerify(const BenchmarkOptions &options) {
+    // Random shapes on top of the fixed sweep, unless -sizes is given
+    int random = 8;
+    unsigned int seed = SeedOption(options);
+    std::vector<ProblemSize> shapes;
+    char *arg = NULL;
+
+    if (getCmdLineArgumentString(options.argc, options.argv, "verify",
+                                 &arg)) {
+        random = atoi(arg);
+    }
+
+    if (checkCmdLineFlag(options.argc, options.argv, "sizes")) {
+        shapes = options.sizes;
+    } else {
+        shapes.assign(kVerifyShapes, kVerifyShapes +
+                      sizeof(kVerifyShapes) / sizeof(kVerifyShapes[0]));
+        srand(seed);
+
+        for (int i = 0; i < random; i++) {
+            ProblemSize size = {1 + rand() % 1024, 1 + rand() % 1024,
+                                1 + rand() % 2048};
+            shapes.push_back(size);
+        }
+    }
+
+    int count;
+    const KernelEntry *registry = GetKernelRegistry(&count);
+    std::vector<const KernelEntry *> kernels;
+
+    for (int i = 0; i < count; i++) {
+        char blockName[16];
+        snprintf(blockName, sizeof(blockName), "%d", registry[i].block_size);
+
+        if (InList(options.kernelNames, registry[i].name) &&
+                InList(options.blockSizes, blockName) &&
+                registry[i].minArch <= options.arch) {
+            kernels.push_back(&registry[i]);
+        }
+    }
+
+    return RunVerify(kernels, shapes, seed);
+}
@@ -0,0 +1,342 @@
+/**
+ * Cache-blocked, multithreaded matrix multiplication on the host CPU.
+ * Host code.
+ *
+ * The loops around the micro-kernel are those of BLIS: jc over NC-wide
+ * panels of B and C, pc over KC-deep slices of K, ic over MC-high blocks
+ * of A and C, then jr and ir over the NR-wide and MR-high micro-tiles.
+ * For every (jc, pc) the threads first pack the KC x NC panel of B
+ * together, then each takes its share of (ic block, jr range) units and
+ * packs the blocks of A it needs on its own. The micro-kernel is built for
+ * the instruction set the host compiler targets; with nvcc, pass for
+ * example -Xcompiler -march=native to enable AVX2 or AVX-512.
+ */
+
+// System includes
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// The device pass of nvcc sees the portable micro-kernel
+#if !defined(__CUDA_ARCH__) && defined(__AVX512F__)
+#define CPU_GEMM_AVX512
+#elif !defined(__CUDA_ARCH__) && defined(__AVX2__) && defined(__FMA__)
+#define CPU_GEMM_AVX2
+#endif
+
+#if defined(CPU_GEMM_AVX512) || defined(CPU_GEMM_AVX2)
+#include <immintrin.h>
+#endif
+
+#include "cpuGemm.h"
+#include "threadBarrier.h"
+
+// Register tile of the micro-kernel: MR rows of two vectors of NR / 2
+// columns each, 12 of the 16 vector registers of AVX2 for accumulators
+#if defined(CPU_GEMM_AVX512)
+#define CPU_GEMM_MR 6
+#define CPU_GEMM_NR 32
+#elif defined(CPU_GEMM_AVX2)
+#define CPU_GEMM_MR 6
+#define CPU_GEMM_NR 16
+#else
+#define CPU_GEMM_MR 4
+#define CPU_GEMM_NR 8
+#endif
+
+// Depth of the packed slices: a micro-panel of B stays in L1
+#define CPU_GEMM_KC 256
+
+// Height of the blocks of A, a multiple of both MRs: 96 KB stay in L2
+#define CPU_GEMM_MC 96
+
+// Width of the panels of B, a multiple of all NRs: 2 MB stay in L3
+#define CPU_GEMM_NC 2048
+
+const char *CpuGemmIsa() {
+#if defined(CPU_GEMM_AVX512)
+    return "avx512";
+#elif defined(CPU_GEMM_AVX2)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * tile (MR x NR, row-major) = sum over p < kc of the column a[p * MR + i]
+ * times the row b[p * NR + j] of the packed micro-panels
+ */
+static void MicroKernel(int kc, const float *a, const float *b, float *tile) {
+#if defined(CPU_GEMM_AVX512)
+    __m512 c[CPU_GEMM_MR][2];
+
+    for (int i = 0; i < CPU_GEMM_MR; ++i) {
+        c[i][0] = _mm512_setzero_ps();
+        c[i][1] = _mm512_setzero_ps();
+    }
+
+    for (int p = 0; p < kc; ++p) {
+        __m512 b0 = _mm512_loadu_ps(b);
+        __m512 b1 = _mm512_loadu_ps(b + 16);
+
+        for (int i = 0; i < CPU_GEMM_MR; ++i) {
+            __m512 ai = _mm512_set1_ps(a[i]);
+            c[i][0] = _mm512_fmadd_ps(ai, b0, c[i][0]);
+            c[i][1] = _mm512_fmadd_ps(ai, b1, c[i][1]);
+        }
+
+        a += CPU_GEMM_MR;
+        b += CPU_GEMM_NR;
+    }
+
+    for (int i = 0; i < CPU_GEMM_MR; ++i) {
+        _mm512_storeu_ps(tile + i * CPU_GEMM_NR, c[i][0]);
+        _mm512_storeu_ps(tile + i * CPU_GEMM_NR + 16, c[i][1]);
+    }
+#elif defined(CPU_GEMM_AVX2)
+    __m256 c[CPU_GEMM_MR][2];
+
+    for (int i = 0; i < CPU_GEMM_MR; ++i) {
+        c[i][0] = _mm256_setzero_ps();
+        c[i][1] = _mm256_setzero_ps();
+    }
+
+    for (int p = 0; p < kc; ++p) {
+        __m256 b0 = _mm256_loadu_ps(b);
+        __m256 b1 = _mm256_loadu_ps(b + 8);
+
+        for (int i = 0; i < CPU_GEMM_MR; ++i) {
+            __m256 ai = _mm256_broadcast_ss(a + i);
+            c[i][0] = _mm256_fmadd_ps(ai, b0, c[i][0]);
+            c[i][1] = _mm256_fmadd_ps(ai, b1, c[i][1]);
+        }
+
+        a += CPU_GEMM_MR;
+        b += CPU_GEMM_NR;
+    }
+
+    for (int i = 0; i < CPU_GEMM_MR; ++i) {
+        _mm256_storeu_ps(tile + i * CPU_GEMM_NR, c[i][0]);
+        _mm256_storeu_ps(tile + i * CPU_GEMM_NR + 8, c[i][1]);
+    }
+#else
+    float c[CPU_GEMM_MR][CPU_GEMM_NR] = {};
+
+    for (int p = 0; p < kc; ++p) {
+        for (int i = 0; i < CPU_GEMM_MR; ++i) {
+            for (int j = 0; j < CPU_GEMM_NR; ++j) {
+                c[i][j] += a[i] * b[j];
+            }
+        }
+
+        a += CPU_GEMM_MR;
+        b += CPU_GEMM_NR;
+    }
+
+    memcpy(tile, c, sizeof(c));
+#endif
+}
+
+/**
+ * Pack the mc x kc block of A at A into micro-panels of MR rows, each
+ * stored column by column; rows past mc are zero
+ */
+static void PackA(const float *A, int lda, int mc, int kc, float *packed) {
+    for (int ir = 0; ir < mc; ir += CPU_GEMM_MR) {
+        int rows = std::min(CPU_GEMM_MR, mc - ir);
+
+        for (int p = 0; p < kc; ++p) {
+            for (int i = 0; i < CPU_GEMM_MR; ++i) {
+                *packed++ = i < rows ?
+                            A[static_cast<size_t>(ir + i) * lda + p] : 0.0f;
+            }
+        }
+    }
+}
+
+/**
+ * Pack micro-panel jr (NR columns) of the kc x nc panel of B at B, stored
+ * row by row; columns past nc are zero
+ */
+static void PackB(const float *B, int ldb, int nc, int kc, int jr,
+                  float *packed) {
+    int col0 = jr * CPU_GEMM_NR;
+    int cols = std::min(CPU_GEMM_NR, nc - col0);
+    packed += static_cast<size_t>(jr) * CPU_GEMM_NR * kc;
+
+    for (int p = 0; p < kc; ++p) {
+        const float *row = B + static_cast<size_t>(p) * ldb + col0;
+
+        for (int j = 0; j < CPU_GEMM_NR; ++j) {
+            *packed++ = j < cols ? row[j] : 0.0f;
+        }
+    }
+}
+
+/**
+ * Store (or with accumulate add) the rows x cols corner of a micro-tile
+ * into C
+ */
+static void StoreTile(const float *tile, float *C, int ldc, int rows,
+                      int cols, bool accumulate) {
+    for (int i = 0; i < rows; ++i) {
+        float *c = C + static_cast<size_t>(i) * ldc;
+        const float *t = tile + i * CPU_GEMM_NR;
+
+        if (accumulate) {
+            for (int j = 0; j < cols; ++j) {
+                c[j] += t[j];
+            }
+        } else {
+            memcpy(c, t, sizeof(float) * cols);
+        }
+    }
+}
+
+// One call of CpuGemm, shared by its threads
+struct CpuGemmCall {
+    int M;
+    int N;
+    int K;
+    const float *A;
+    int lda;
+    const float *B;
+    int ldb;
+    float *C;
+    int ldc;
+    int threads;
+
+    // Height of the blocks of A, at most CPU_GEMM_MC
+    int mc;
+
+    // The packed panel of B of the current (jc, pc)
+    std::vector<float> packedB;
+    Barrier *barrier;
+};
+
+static void Worker(CpuGemmCall *call, int thread) {
+    int T = call->threads;
+    std::vector<float> packedA(static_cast<size_t>(call->mc) * CPU_GEMM_KC);
+    float *packedB = call->packedB.data();
+    float tile[CPU_GEMM_MR * CPU_GEMM_NR];
+
+    for (int jc = 0; jc < call->N; jc += CPU_GEMM_NC) {
+        int nc = std::min(CPU_GEMM_NC, call->N - jc);
+        int panels = (nc + CPU_GEMM_NR - 1) / CPU_GEMM_NR;
+
+        for (int pc = 0; pc < call->K; pc += CPU_GEMM_KC) {
+            int kc = std::min(CPU_GEMM_KC, call->K - pc);
+            const float *B = call->B + static_cast<size_t>(pc) * call->ldb +
+                             jc;
+
+            for (int jr = thread; jr < panels; jr += T) {
+                PackB(B, call->ldb, nc, kc, jr, packedB);
+            }
+
+            call->barrier->Wait();
+
+            // Blocks of A times ranges of micro-panels of B; the ranges
+            // only split when there are fewer blocks than threads
+            int blocks = (call->M + call->mc - 1) / call->mc;
+            int split = std::min(panels, std::max(1, (T + blocks - 1) /
+                                                  blocks));
+            int packed = -1;
+
+            for (int u = thread; u < blocks * split; u += T) {
+                int ib = u / split;
+                int ic = ib * call->mc;
+                int mc = std::min(call->mc, call->M - ic);
+
+                if (ib != packed) {
+                    PackA(call->A + static_cast<size_t>(ic) * call->lda + pc,
+                          call->lda, mc, kc, packedA.data());
+                    packed = ib;
+                }
+
+                int jrBegin = panels * (u % split) / split;
+                int jrEnd = panels * (u % split + 1) / split;
+
+                for (int jr = jrBegin; jr < jrEnd; ++jr) {
+                    int col = jr * CPU_GEMM_NR;
+                    int cols = std::min(CPU_GEMM_NR, nc - col);
+                    const float *b = packedB +
+                                     static_cast<size_t>(jr) * CPU_GEMM_NR * kc;
+
+                    for (int ir = 0; ir < mc; ir += CPU_GEMM_MR) {
+                        MicroKernel(kc, packedA.data() +
+                                    static_cast<size_t>(ir) * kc, b, tile);
+                        StoreTile(tile, call->C + static_cast<size_t>(ic + ir) *
+                                  call->ldc + jc + col, call->ldc,
+                                  std::min(CPU_GEMM_MR, mc - ir), cols,
+                                  pc > 0);
+                    }
+                }
+            }
+
+            // The panel of B is repacked by the next iteration
+            call->barrier->Wait();
+        }
+    }
+}
+
+void CpuGemm(int M, int N, int K, const float *A, int lda, const float *B,
+             int ldb, float *C, int ldc, int threads) {
+    if (M <= 0 || N <= 0) {
+        return;
+    }
+
+    if (K <= 0) {
+        for (int i = 0; i < M; ++i) {
+            memset(C + static_cast<size_t>(i) * ldc, 0, sizeof(float) * N);
+        }
+
+        return;
+    }
+
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // No more threads than micro-tiles
+    int tiles = ((M + CPU_GEMM_MR - 1) / CPU_GEMM_MR) *
+                ((N + CPU_GEMM_NR - 1) / CPU_GEMM_NR);
+    threads = std::min(threads, tiles);
+
+    CpuGemmCall call;
+    call.M = M;
+    call.N = N;
+    call.K = K;
+    call.A = A;
+    call.lda = lda;
+    call.B = B;
+    call.ldb = ldb;
+    call.C = C;
+    call.ldc = ldc;
+    call.threads = threads;
+
+    // Lower blocks of A when that gives every thread a block of its own
+    int perThread = (M + threads - 1) / threads;
+    perThread = (perThread + CPU_GEMM_MR - 1) / CPU_GEMM_MR * CPU_GEMM_MR;
+    call.mc = std::min(CPU_GEMM_MC, perThread);
+
+    int nc = std::min(CPU_GEMM_NC, N);
+    int panels = (nc + CPU_GEMM_NR - 1) / CPU_GEMM_NR;
+    call.packedB.resize(static_cast<size_t>(panels) * CPU_GEMM_NR *
+                        CPU_GEMM_KC);
+
+    Barrier barrier(threads);
+    call.barrier = &barrier;
+    std::vector<std::thread> workers;
+
+    for (int t = 1; t < threads; ++t) {
+        workers.push_back(std::thread(Worker, &call, t));
+    }
+
+    Worker(&call, 0);
+
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+}
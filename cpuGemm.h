@@ -0,0 +1,33 @@
+/**
+ * Matrix multiplication on the host CPU: the reference against which the
+ * kernels are verified, and the backend of the benchmark on machines
+ * without a CUDA device.
+ *
+ * The product is blocked for the caches in the manner of BLIS: panels of
+ * B (KC x NC) and blocks of A (MC x KC) are packed into contiguous
+ * micro-panels, and a register-blocked micro-kernel computes MR x NR tiles
+ * of C from them with AVX-512 or AVX2/FMA when the host compiler targets
+ * them (see CpuGemmIsa), else in portable C++. The blocks of A and the
+ * micro-panels of B are shared out over host threads.
+ *
+ * See also:
+ * F. G. Van Zee and R. A. van de Geijn, "BLIS: A Framework for Rapidly
+ * Instantiating BLAS Functionality," ACM Transactions on Mathematical
+ * Software, 41(3), 2015.
+ */
+
+#ifndef CPU_GEMM_H_
+#define CPU_GEMM_H_
+
+/**
+ * C = A * B on host matrices: A is M x K, B is K x N and C is M x N, all
+ * row-major with lda, ldb and ldc elements between the starts of rows.
+ * threads is the number of host threads, 0 for one per hardware thread.
+ */
+void CpuGemm(int M, int N, int K, const float *A, int lda, const float *B,
+             int ldb, float *C, int ldc, int threads);
+
+// Instruction set of the micro-kernel: "avx512", "avx2" or "scalar"
+const char *CpuGemmIsa();
+
+#endif  // CPU_GEMM_H_
@@ -0,0 +1,218 @@
+/**
+ * Caching device memory allocator.
+ */
+
+#include "deviceAllocator.h"
+
+// Size classes step by a quarter of a power of two from 2^kMinShift bytes
+// up to DEVICE_ALLOCATOR_MAX_CACHED, so a block is at most a quarter
+// bigger than its request; bigger requests get exactly their size and are
+// not cached
+static const int kMinShift = 8;
+static const int kStepsPerPower = 4;
+
+// Bytes of the blocks of size class c
+static size_t ClassBytes(int c) {
+    size_t power = size_t(1) << (kMinShift + c / kStepsPerPower);
+    return power + power / kStepsPerPower * (c % kStepsPerPower);
+}
+
+DeviceAllocator::DeviceAllocator(size_t maxCachedBytes)
+    : maxCachedBytes_(maxCachedBytes),
+      cached_(SizeClass(DEVICE_ALLOCATOR_MAX_CACHED) + 1) {
+    stats_.hits = 0;
+    stats_.misses = 0;
+    stats_.liveBytes = 0;
+    stats_.cachedBytes = 0;
+}
+
+DeviceAllocator::~DeviceAllocator() {
+    Trim();
+}
+
+int DeviceAllocator::SizeClass(size_t bytes) {
+    if (bytes > DEVICE_ALLOCATOR_MAX_CACHED) {
+        return -1;
+    }
+
+    int c = 0;
+
+    while (ClassBytes(c) < bytes) {
+        c++;
+    }
+
+    return c;
+}
+
+size_t DeviceAllocator::BlockBytes(size_t bytes) {
+    int c = SizeClass(bytes);
+    return c < 0 ? bytes : ClassBytes(c);
+}
+
+cudaError_t DeviceAllocator::Allocate(void **ptr, size_t bytes,
+                                      cudaStream_t stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int device;
+    cudaError_t err = cudaGetDevice(&device);
+
+    if (err != cudaSuccess) {
+        return err;
+    }
+
+    int c = SizeClass(bytes);
+    Block block;
+    block.bytes = BlockBytes(bytes);
+    block.device = device;
+    block.stream = stream;
+    block.ready = NULL;
+
+    // Prefer a block freed on the same stream, which needs no waiting;
+    // else take one whose pending work has finished
+    if (c >= 0) {
+        std::vector<Block> &bin = cached_[c];
+        int found = -1;
+
+        for (size_t i = 0; i < bin.size() && found < 0; i++) {
+            if (bin[i].device == device && bin[i].stream == stream) {
+                found = static_cast<int>(i);
+            }
+        }
+
+        for (size_t i = 0; i < bin.size() && found < 0; i++) {
+            if (bin[i].device == device &&
+                    cudaEventQuery(bin[i].ready) == cudaSuccess) {
+                found = static_cast<int>(i);
+            }
+        }
+
+        if (found >= 0) {
+            block.ptr = bin[found].ptr;
+            block.ready = bin[found].ready;
+            bin.erase(bin.begin() + found);
+            stats_.cachedBytes -= block.bytes;
+            stats_.liveBytes += block.bytes;
+            stats_.hits++;
+            live_[block.ptr] = block;
+            *ptr = block.ptr;
+            return cudaSuccess;
+        }
+    }
+
+    err = cudaMalloc(&block.ptr, block.bytes);
+
+    // Out of memory: give the cached blocks back and try once more
+    if (err == cudaErrorMemoryAllocation) {
+        cudaGetLastError();
+        err = ReleaseCached();
+
+        if (err == cudaSuccess) {
+            err = cudaMalloc(&block.ptr, block.bytes);
+        }
+    }
+
+    if (err != cudaSuccess) {
+        return err;
+    }
+
+    stats_.liveBytes += block.bytes;
+    stats_.misses++;
+    live_[block.ptr] = block;
+    *ptr = block.ptr;
+
+    return cudaSuccess;
+}
+
+cudaError_t DeviceAllocator::Free(void *ptr) {
+    if (ptr == NULL) {
+        return cudaSuccess;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<void *, Block>::iterator it = live_.find(ptr);
+
+    if (it == live_.end()) {
+        return cudaErrorInvalidValue;
+    }
+
+    Block block = it->second;
+    live_.erase(it);
+    stats_.liveBytes -= block.bytes;
+
+    int c = SizeClass(block.bytes);
+
+    // Blocks beyond the largest class or the cache limit are released;
+    // cudaFree waits for the work that still uses them
+    if (c < 0 || stats_.cachedBytes + block.bytes > maxCachedBytes_) {
+        if (block.ready != NULL) {
+            cudaEventDestroy(block.ready);
+        }
+
+        return cudaFree(block.ptr);
+    }
+
+    cudaError_t err = cudaSuccess;
+
+    if (block.ready == NULL) {
+        err = cudaEventCreateWithFlags(&block.ready, cudaEventDisableTiming);
+    }
+
+    if (err == cudaSuccess) {
+        err = cudaEventRecord(block.ready, block.stream);
+    }
+
+    if (err != cudaSuccess) {
+        return err;
+    }
+
+    cached_[c].push_back(block);
+    stats_.cachedBytes += block.bytes;
+
+    return cudaSuccess;
+}
+
+cudaError_t DeviceAllocator::ReleaseCached() {
+    cudaError_t result = cudaSuccess;
+    int current;
+    cudaGetDevice(&current);
+
+    for (size_t c = 0; c < cached_.size(); c++) {
+        for (size_t i = 0; i < cached_[c].size(); i++) {
+            Block &block = cached_[c][i];
+            cudaError_t err = cudaSetDevice(block.device);
+
+            if (err == cudaSuccess) {
+                err = cudaEventSynchronize(block.ready);
+            }
+
+            if (err == cudaSuccess) {
+                err = cudaEventDestroy(block.ready);
+            }
+
+            if (err == cudaSuccess) {
+                err = cudaFree(block.ptr);
+            }
+
+            if (err != cudaSuccess) {
+                result = err;
+            }
+
+            stats_.cachedBytes -= block.bytes;
+        }
+
+        cached_[c].clear();
+    }
+
+    cudaSetDevice(current);
+
+    return result;
+}
+
+cudaError_t DeviceAllocator::Trim() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ReleaseCached();
+}
+
+DeviceAllocatorStats DeviceAllocator::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
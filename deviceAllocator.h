@@ -0,0 +1,96 @@
+/**
+ * Caching device memory allocator.
+ *
+ * Requests are rounded up to a size class, in quarter steps between powers
+ * of two from 256 bytes, and freed blocks are kept in one list per size
+ * class instead of being returned with cudaFree. Requests beyond
+ * DEVICE_ALLOCATOR_MAX_CACHED get exactly their size and are not cached.
+ * A cached block can be handed out again at once to the stream that freed
+ * it, since work on one stream is ordered; other streams get it only after
+ * the work that was queued before the free has completed, which is tracked
+ * with an event recorded at free time. None of this synchronizes the
+ * device, unlike cudaMalloc and cudaFree.
+ */
+
+#ifndef DEVICE_ALLOCATOR_H_
+#define DEVICE_ALLOCATOR_H_
+
+// System includes
+#include <map>
+#include <mutex>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Default limit on the bytes kept in the cache, and the largest size
+// class
+#define DEVICE_ALLOCATOR_MAX_CACHED (size_t(1) << 30)
+
+struct DeviceAllocatorStats {
+    // Allocations served from the cache, and by cudaMalloc
+    long hits;
+    long misses;
+
+    // Bytes handed out and not freed yet, and bytes held in the cache
+    size_t liveBytes;
+    size_t cachedBytes;
+};
+
+class DeviceAllocator {
+ public:
+    explicit DeviceAllocator(size_t maxCachedBytes =
+                                 DEVICE_ALLOCATOR_MAX_CACHED);
+
+    // Releases the cached blocks; blocks still in use are leaked
+    ~DeviceAllocator();
+
+    /**
+     * *ptr receives at least bytes of device memory of the current
+     * device, to be used in stream
+     */
+    cudaError_t Allocate(void **ptr, size_t bytes, cudaStream_t stream);
+
+    /**
+     * Return ptr, which came from Allocate, to the cache. Work already
+     * queued on its stream may still use it.
+     */
+    cudaError_t Free(void *ptr);
+
+    // Wait for and release all cached blocks
+    cudaError_t Trim();
+
+    DeviceAllocatorStats Stats() const;
+
+    // Device memory that Allocate takes for a request of bytes
+    static size_t BlockBytes(size_t bytes);
+
+ private:
+    struct Block {
+        void *ptr;
+        size_t bytes;
+        int device;
+        cudaStream_t stream;
+
+        // Recorded on stream when the block was freed
+        cudaEvent_t ready;
+    };
+
+    static int SizeClass(size_t bytes);
+    cudaError_t ReleaseCached();
+
+    size_t maxCachedBytes_;
+    DeviceAllocatorStats stats_;
+
+    // Free blocks per size class, and blocks in use by pointer
+    std::vector<std::vector<Block> > cached_;
+    std::map<void *, Block> live_;
+
+    mutable std::mutex mutex_;
+
+    // Not copyable
+    DeviceAllocator(const DeviceAllocator &);
+    DeviceAllocator &operator=(const DeviceAllocator &);
+};
+
+#endif  // DEVICE_ALLOCATOR_H_
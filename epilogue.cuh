@@ -0,0 +1,168 @@
+/**
+ * Epilogues of the matrix multiplication kernels: what happens to an
+ * accumulated element of C in registers before it is stored.
+ *
+ * An epilogue is a functor type given to the kernel as a template
+ * parameter. Output is the element type of C; ReadsC() tells whether the
+ * previous value of C is needed; operator()(acc, row, col, c) maps the
+ * accumulator of element (row, col) and its previous value c (zero if not
+ * read) to the value to store. IdentityEpilogue is the plain C = A * B of
+ * all kernels; LinearEpilogue fuses C = act(alpha * A * B + beta * C +
+ * bias) with an optional conversion of the result, which would otherwise
+ * take separate passes over C.
+ */
+
+#ifndef EPILOGUE_CUH_
+#define EPILOGUE_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "matmulTypes.cuh"
+#include "vectorMemory.cuh"
+
+// Bias added to every element: none, bias[row] or bias[col]
+enum EpilogueBias {
+    EPILOGUE_BIAS_NONE,
+    EPILOGUE_BIAS_ROW,
+    EPILOGUE_BIAS_COL
+};
+
+enum EpilogueActivation {
+    EPILOGUE_ACT_NONE,
+    EPILOGUE_ACT_RELU,
+
+    // The tanh approximation of GELU
+    EPILOGUE_ACT_GELU
+};
+
+/**
+ * Run-time description of a LinearEpilogue, for the type-erased host
+ * interfaces (see matmulEpilogue.h)
+ */
+struct MatmulEpilogue {
+    float alpha;
+    float beta;
+
+    // bias has M elements for EPILOGUE_BIAS_ROW and N for
+    // EPILOGUE_BIAS_COL, in device memory
+    EpilogueBias biasMode;
+    const float *bias;
+
+    EpilogueActivation activation;
+
+    // Element type of C
+    MatmulType outType;
+};
+
+inline const char *EpilogueActivationName(EpilogueActivation activation) {
+    switch (activation) {
+    case EPILOGUE_ACT_RELU:
+        return "relu";
+
+    case EPILOGUE_ACT_GELU:
+        return "gelu";
+
+    default:
+        return "none";
+    }
+}
+
+template <int ACTIVATION> __device__ __forceinline__ float Activate(float v) {
+    if (ACTIVATION == EPILOGUE_ACT_RELU) {
+        return v > 0.0f ? v : 0.0f;
+    }
+
+    if (ACTIVATION == EPILOGUE_ACT_GELU) {
+        const float kSqrt2OverPi = 0.7978845608f;
+        return 0.5f * v * (1.0f + tanhf(kSqrt2OverPi *
+                                        (v + 0.044715f * v * v * v)));
+    }
+
+    return v;
+}
+
+struct IdentityEpilogue {
+    typedef float Output;
+
+    __device__ __forceinline__ bool ReadsC() const {
+        return false;
+    }
+
+    __device__ __forceinline__ float operator()(float acc, int, int,
+                                                float) const {
+        return acc;
+    }
+};
+
+// act(alpha * acc + beta * c + bias), stored as OutT
+template <int BIAS, int ACTIVATION, typename OutT> struct LinearEpilogue {
+    typedef OutT Output;
+
+    float alpha;
+    float beta;
+    const float *bias;
+
+    __device__ __forceinline__ bool ReadsC() const {
+        return beta != 0.0f;
+    }
+
+    __device__ __forceinline__ float operator()(float acc, int row, int col,
+                                                float c) const {
+        float v = alpha * acc + beta * c;
+
+        if (BIAS == EPILOGUE_BIAS_ROW) {
+            v += bias[row];
+        } else if (BIAS == EPILOGUE_BIAS_COL) {
+            v += bias[col];
+        }
+
+        return Activate<ACTIVATION>(v);
+    }
+};
+
+/**
+ * StoreVec for any element type of C: float goes through the vectorized
+ * store, the other types are converted and stored one by one
+ */
+template <int VEC> __device__ inline void
+StoreEpilogue(float *dst, const float *src, int row, int col, int rows,
+              int cols, int ld, bool aligned) {
+    StoreVec<VEC>(dst, src, row, col, rows, cols, ld, aligned);
+}
+
+template <int VEC, typename T> __device__ inline void
+StoreEpilogue(T *dst, const float *src, int row, int col, int rows, int cols,
+              int ld, bool) {
+    T *to = dst + static_cast<size_t>(row) * ld + col;
+
+#pragma unroll
+    for (int v = 0; v < VEC; ++v) {
+        if (row < rows && col + v < cols) {
+            to[v] = FromFloat<T>(src[v]);
+        }
+    }
+}
+
+/**
+ * Stand-alone epilogue pass (CUDA Kernel) on the device: C = epilogue(P)
+ * for the rows x cols accumulators P of a kernel without a fused epilogue,
+ * with a grid-stride loop
+ */
+template <typename EPILOGUE> __global__ void
+MatrixEpilogueCUDA(typename EPILOGUE::Output *C, const float *P, int rows,
+                   int cols, EPILOGUE epilogue) {
+    size_t n = static_cast<size_t>(rows) * cols;
+
+    for (size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) +
+                    threadIdx.x;
+            i < n;
+            i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+        float c = epilogue.ReadsC() ? ToFloat(C[i]) : 0.0f;
+        C[i] = FromFloat<typename EPILOGUE::Output>(
+                   epilogue(P[i], static_cast<int>(i / cols),
+                            static_cast<int>(i % cols), c));
+    }
+}
+
+#endif  // EPILOGUE_CUH_
@@ -0,0 +1,114 @@
+/**
+ * General matrix multiplication kernel: C = epilogue(op(A) * op(B)) on
+ * matrices with leading dimensions, where op(X) is X or its transpose.
+ *
+ * op(A) is M x K, op(B) is K x N and C is M x N, all stored row-major with
+ * lda, ldb and ldc elements between the starts of consecutive rows, so
+ * sub-matrix views and transposed operands are used in place. Each of the
+ * four layouts of a tile has its own load path in which consecutive
+ * threads read consecutive addresses; the transposed paths write the tile
+ * in shared memory transposed, which the extra column of padding keeps
+ * free of bank conflicts.
+ */
+
+#ifndef GEMM_KERNELS_CUH_
+#define GEMM_KERNELS_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "epilogue.cuh"
+
+/**
+ * Load the BLOCK_SIZE x BLOCK_SIZE tile of op(A) at (row0, k0) into
+ * As[m][k], zero outside the M x K matrix op(A)
+ */
+template <int BLOCK_SIZE, bool TRANS> __device__ __forceinline__ void
+LoadTileA(float (*As)[BLOCK_SIZE + 1], const float *A, int lda, int M,
+          int K, int row0, int k0) {
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+
+    if (TRANS) {
+        // A is K x M: tx runs along a row of A, which is a column of op(A)
+        int m = row0 + tx;
+        int k = k0 + ty;
+        As[tx][ty] = (m < M && k < K) ?
+                     A[static_cast<size_t>(k) * lda + m] : 0.0f;
+    } else {
+        int m = row0 + ty;
+        int k = k0 + tx;
+        As[ty][tx] = (m < M && k < K) ?
+                     A[static_cast<size_t>(m) * lda + k] : 0.0f;
+    }
+}
+
+/**
+ * Load the BLOCK_SIZE x BLOCK_SIZE tile of op(B) at (k0, col0) into
+ * Bs[k][n], zero outside the K x N matrix op(B)
+ */
+template <int BLOCK_SIZE, bool TRANS> __device__ __forceinline__ void
+LoadTileB(float (*Bs)[BLOCK_SIZE + 1], const float *B, int ldb, int K,
+          int N, int k0, int col0) {
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+
+    if (TRANS) {
+        // B is N x K: tx runs along a row of B, which is a column of op(B)
+        int k = k0 + tx;
+        int n = col0 + ty;
+        Bs[tx][ty] = (k < K && n < N) ?
+                     B[static_cast<size_t>(n) * ldb + k] : 0.0f;
+    } else {
+        int k = k0 + ty;
+        int n = col0 + tx;
+        Bs[ty][tx] = (k < K && n < N) ?
+                     B[static_cast<size_t>(k) * ldb + n] : 0.0f;
+    }
+}
+
+/**
+ * General matrix multiplication (CUDA Kernel) on the device:
+ * C = epilogue(op(A) * op(B)), one element of C per thread
+ * op(A) is M x K, op(B) is K x N; lda, ldb and ldc are the leading
+ * dimensions of A, B and C as stored
+ */
+template <int BLOCK_SIZE, bool TRANS_A, bool TRANS_B, typename EPILOGUE>
+__global__ void
+MatrixMulGemmCUDA(typename EPILOGUE::Output *C, int ldc, const float *A,
+                  int lda, const float *B, int ldb, int M, int N, int K,
+                  EPILOGUE epilogue) {
+    __shared__ float As[BLOCK_SIZE][BLOCK_SIZE + 1];
+    __shared__ float Bs[BLOCK_SIZE][BLOCK_SIZE + 1];
+
+    int row0 = BLOCK_SIZE * blockIdx.y;
+    int col0 = BLOCK_SIZE * blockIdx.x;
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+    float Csub = 0;
+
+    for (int k0 = 0; k0 < K; k0 += BLOCK_SIZE) {
+        LoadTileA<BLOCK_SIZE, TRANS_A>(As, A, lda, M, K, row0, k0);
+        LoadTileB<BLOCK_SIZE, TRANS_B>(Bs, B, ldb, K, N, k0, col0);
+        __syncthreads();
+
+#pragma unroll
+        for (int k = 0; k < BLOCK_SIZE; ++k) {
+            Csub += As[ty][k] * Bs[k][tx];
+        }
+
+        __syncthreads();
+    }
+
+    int row = row0 + ty;
+    int col = col0 + tx;
+
+    if (row < M && col < N) {
+        size_t c = static_cast<size_t>(row) * ldc + col;
+        float old = epilogue.ReadsC() ? ToFloat(C[c]) : 0.0f;
+        C[c] = FromFloat<typename EPILOGUE::Output>(
+                   epilogue(Csub, row, col, old));
+    }
+}
+
+#endif  // GEMM_KERNELS_CUH_
@@ -0,0 +1,332 @@
+/**
+ * Quantized matrix multiplication: int8 A and B, int32 accumulation, and a
+ * dequantizing epilogue that turns the accumulators into fp32, fp16 or
+ * bf16 elements of C in the store.
+ *
+ * MatrixMulDp4aCUDA keeps the register tiling of MatrixMulRegTileCUDA,
+ * with shared memory words that each pack four consecutive k of a row of A
+ * or a column of B, so that a single dp4a (compute capability 6.1) does
+ * four multiply-adds; older devices unpack the bytes instead.
+ * MatrixMulImmaCUDA keeps the tiling of MatrixMulWmmaCUDA on the int8
+ * tensor cores of compute capability 7.2.
+ *
+ * Quantized values q stand for scale * (q - zeroPoint); with per-channel
+ * quantization A has a scale and zero point per row and B per column. The
+ * zero points are taken out of the accumulator with the sums of the rows
+ * of A and the columns of B:
+ * sum (a - za) (b - zb) = acc - zb * rowSumA - za * colSumB + K * za * zb.
+ * The accumulation is exact as long as K * 255 * 255 fits in an int.
+ */
+
+#ifndef INT8_KERNELS_CUH_
+#define INT8_KERNELS_CUH_
+
+// System includes
+#include <stdint.h>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "matmulTypes.cuh"
+#include "tensorCoreKernels.cuh"
+
+/**
+ * Dequantizing epilogue: scaleA * scaleB * (acc with the zero points taken
+ * out) + bias[col], stored as OutT. PER_ROW and PER_COL select per-channel
+ * parameters of A and B; zeroA and zeroB may be NULL for symmetric
+ * quantization, in which case rowSumA and colSumB are not read.
+ */
+template <bool PER_ROW, bool PER_COL, typename OutT> struct DequantEpilogue {
+    typedef OutT Output;
+
+    const float *scaleA;
+    const int *zeroA;
+    const float *scaleB;
+    const int *zeroB;
+
+    // M sums of the rows of A and N sums of the columns of B
+    const int *rowSumA;
+    const int *colSumB;
+
+    // N elements, or NULL
+    const float *bias;
+    int K;
+
+    __device__ __forceinline__ float operator()(int acc, int row,
+                                                int col) const {
+        int ia = PER_ROW ? row : 0;
+        int ib = PER_COL ? col : 0;
+        int za = zeroA != NULL ? zeroA[ia] : 0;
+        int zb = zeroB != NULL ? zeroB[ib] : 0;
+
+        if (zb != 0) {
+            acc -= zb * rowSumA[row];
+        }
+
+        if (za != 0) {
+            acc -= za * colSumB[col] - K * za * zb;
+        }
+
+        float v = scaleA[ia] * scaleB[ib] * static_cast<float>(acc);
+        return bias != NULL ? v + bias[col] : v;
+    }
+};
+
+// c + the dot product of the four signed bytes of a and b
+__device__ __forceinline__ int Dp4a(int a, int b, int c) {
+#if WMMA_ARCH >= 610
+    return __dp4a(a, b, c);
+#else
+#pragma unroll
+    for (int i = 0; i < 4; ++i) {
+        c += static_cast<int8_t>(a >> (8 * i)) *
+             static_cast<int8_t>(b >> (8 * i));
+    }
+
+    return c;
+#endif
+}
+
+// Byte i of a packed word, zero past the edges
+__device__ __forceinline__ int PackByte(const int8_t *p, bool inside,
+                                        int i) {
+    return inside ? (static_cast<uint8_t>(*p) << (8 * i)) : 0;
+}
+
+/**
+ * dp4a matrix multiplication (CUDA Kernel) on the device:
+ * C = epilogue(A * B), A and B int8
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * Each block of BLOCK_SIZE x BLOCK_SIZE threads computes a
+ * (BLOCK_SIZE * TM) x (BLOCK_SIZE * TN) sub-matrix of C, 4 * BLOCK_SIZE of
+ * K at a time. Word q of row r of As packs A(r, 4q .. 4q + 3) and word c
+ * of row q of Bs packs B(4q .. 4q + 3, c). Thread (tx, ty) owns rows
+ * ty + i * BLOCK_SIZE and columns tx + j * BLOCK_SIZE of the sub-matrix.
+ * Rows of A are read a word at a time when wA is a multiple of 4; the
+ * edges are loaded as zeros.
+ */
+template <int BLOCK_SIZE, int TM, int TN, typename EPILOGUE> __global__ void
+__launch_bounds__(BLOCK_SIZE * BLOCK_SIZE)
+MatrixMulDp4aCUDA(typename EPILOGUE::Output *C, const int8_t *A,
+                  const int8_t *B, int hA, int wA, int wB,
+                  EPILOGUE epilogue) {
+    const int THREADS = BLOCK_SIZE * BLOCK_SIZE;
+    const int TILE_K = 4 * BLOCK_SIZE;
+
+    // Thread index
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+    int tid = ty * BLOCK_SIZE + tx;
+
+    // First row and column of the block sub-matrix of C
+    int row0 = BLOCK_SIZE * TM * blockIdx.y;
+    int col0 = BLOCK_SIZE * TN * blockIdx.x;
+
+    // Word access needs every row of A to start on a word
+    bool wordA = wA % 4 == 0 && reinterpret_cast<size_t>(A) % 4 == 0;
+
+    __shared__ int As[BLOCK_SIZE * TM][BLOCK_SIZE];
+    __shared__ int Bs[BLOCK_SIZE][BLOCK_SIZE * TN];
+
+    // Csub holds the TM x TN accumulators of the thread
+    int Csub[TM][TN];
+
+#pragma unroll
+    for (int i = 0; i < TM; ++i) {
+#pragma unroll
+        for (int j = 0; j < TN; ++j) {
+            Csub[i][j] = 0;
+        }
+    }
+
+    // Loop over all the sub-matrices of A and B
+    // required to compute the block sub-matrix
+    for (int k0 = 0; k0 < wA; k0 += TILE_K) {
+        for (int i = tid; i < BLOCK_SIZE * TM * BLOCK_SIZE; i += THREADS) {
+            int r = i / BLOCK_SIZE;
+            int k = k0 + 4 * (i % BLOCK_SIZE);
+            const int8_t *a = A + static_cast<size_t>(row0 + r) * wA + k;
+            int word = 0;
+
+            if (row0 + r < hA && wordA && k < wA) {
+                word = *reinterpret_cast<const int *>(a);
+            } else if (row0 + r < hA) {
+#pragma unroll
+                for (int b = 0; b < 4; ++b) {
+                    word |= PackByte(a + b, k + b < wA, b);
+                }
+            }
+
+            As[r][i % BLOCK_SIZE] = word;
+        }
+
+        for (int i = tid; i < BLOCK_SIZE * BLOCK_SIZE * TN; i += THREADS) {
+            int q = i / (BLOCK_SIZE * TN);
+            int c = i % (BLOCK_SIZE * TN);
+            int k = k0 + 4 * q;
+            const int8_t *b = B + static_cast<size_t>(k) * wB + col0 + c;
+            int word = 0;
+
+            if (col0 + c < wB) {
+#pragma unroll
+                for (int s = 0; s < 4; ++s) {
+                    word |= PackByte(b + static_cast<size_t>(s) * wB,
+                                     k + s < wA, s);
+                }
+            }
+
+            Bs[q][c] = word;
+        }
+
+        // Synchronize to make sure the matrices are loaded
+        __syncthreads();
+
+#pragma unroll
+        for (int q = 0; q < BLOCK_SIZE; ++q) {
+            int aFrag[TM];
+            int bFrag[TN];
+
+#pragma unroll
+            for (int i = 0; i < TM; ++i) {
+                aFrag[i] = As[ty + i * BLOCK_SIZE][q];
+            }
+
+#pragma unroll
+            for (int j = 0; j < TN; ++j) {
+                bFrag[j] = Bs[q][tx + j * BLOCK_SIZE];
+            }
+
+#pragma unroll
+            for (int i = 0; i < TM; ++i) {
+#pragma unroll
+                for (int j = 0; j < TN; ++j) {
+                    Csub[i][j] = Dp4a(aFrag[i], bFrag[j], Csub[i][j]);
+                }
+            }
+        }
+
+        // Synchronize to make sure that the preceding
+        // computation is done before loading two new
+        // sub-matrices of A and B in the next iteration
+        __syncthreads();
+    }
+
+    // Write the block sub-matrix to device memory
+    // through the epilogue
+#pragma unroll
+    for (int i = 0; i < TM; ++i) {
+#pragma unroll
+        for (int j = 0; j < TN; ++j) {
+            int row = row0 + ty + i * BLOCK_SIZE;
+            int col = col0 + tx + j * BLOCK_SIZE;
+
+            if (row < hA && col < wB) {
+                C[static_cast<size_t>(row) * wB + col] =
+                    FromFloat<typename EPILOGUE::Output>(
+                        epilogue(Csub[i][j], row, col));
+            }
+        }
+    }
+}
+
+/**
+ * Block sub-matrix computation of MatrixMulImmaCUDA; as for WmmaTile, the
+ * primary template is compiled for architectures without int8 WMMA
+ */
+template <int BLOCK_SIZE, typename EPILOGUE, bool Enabled> struct ImmaTile {
+    static __device__ void Run(typename EPILOGUE::Output *C, const int8_t *A,
+                               const int8_t *B, int hA, int wA, int wB,
+                               const EPILOGUE &epilogue) {}
+};
+
+template <int BLOCK_SIZE, typename EPILOGUE>
+struct ImmaTile<BLOCK_SIZE, EPILOGUE, true> {
+    static __device__ void Run(typename EPILOGUE::Output *C, const int8_t *A,
+                               const int8_t *B, int hA, int wA, int wB,
+                               const EPILOGUE &epilogue) {
+        const int TILES = BLOCK_SIZE / WMMA_TILE;
+
+        int tid = threadIdx.x;
+        int warp = tid / warpSize;
+        int wy = warp / TILES;
+        int wx = warp % TILES;
+        int row0 = BLOCK_SIZE * blockIdx.y;
+        int col0 = BLOCK_SIZE * blockIdx.x;
+
+        // Fragments of 8-bit elements must start on 32 bytes, which a row
+        // of 16 pairs of bytes does not; the tiles are therefore kept as
+        // 16-wide strips, As of K and Bs of columns, each row 16 bytes
+        __shared__ __align__(32) int8_t As[TILES][BLOCK_SIZE][WMMA_TILE];
+        __shared__ __align__(32) int8_t Bs[TILES][BLOCK_SIZE][WMMA_TILE];
+        __shared__ __align__(32) int Cs[BLOCK_SIZE][BLOCK_SIZE];
+
+        wmma::fragment<wmma::accumulator, WMMA_TILE, WMMA_TILE, WMMA_TILE,
+                       int> acc;
+        wmma::fill_fragment(acc, 0);
+
+        for (int k0 = 0; k0 < wA; k0 += BLOCK_SIZE) {
+            for (int i = tid; i < BLOCK_SIZE * BLOCK_SIZE; i += blockDim.x) {
+                int r = i / BLOCK_SIZE;
+                int c = i % BLOCK_SIZE;
+                As[c / WMMA_TILE][r][c % WMMA_TILE] =
+                    (row0 + r < hA && k0 + c < wA) ?
+                    A[static_cast<size_t>(row0 + r) * wA + k0 + c] : 0;
+                Bs[c / WMMA_TILE][r][c % WMMA_TILE] =
+                    (k0 + r < wA && col0 + c < wB) ?
+                    B[static_cast<size_t>(k0 + r) * wB + col0 + c] : 0;
+            }
+
+            __syncthreads();
+
+#pragma unroll
+            for (int t = 0; t < TILES; ++t) {
+                wmma::fragment<wmma::matrix_a, WMMA_TILE, WMMA_TILE,
+                               WMMA_TILE, signed char, wmma::row_major> aFrag;
+                wmma::fragment<wmma::matrix_b, WMMA_TILE, WMMA_TILE,
+                               WMMA_TILE, signed char, wmma::row_major> bFrag;
+
+                wmma::load_matrix_sync(aFrag, &As[t][wy * WMMA_TILE][0],
+                                       WMMA_TILE);
+                wmma::load_matrix_sync(bFrag, &Bs[wx][t * WMMA_TILE][0],
+                                       WMMA_TILE);
+                wmma::mma_sync(acc, aFrag, bFrag, acc);
+            }
+
+            __syncthreads();
+        }
+
+        wmma::store_matrix_sync(&Cs[wy * WMMA_TILE][wx * WMMA_TILE], acc,
+                                BLOCK_SIZE, wmma::mem_row_major);
+        __syncthreads();
+
+        for (int i = tid; i < BLOCK_SIZE * BLOCK_SIZE; i += blockDim.x) {
+            int r = i / BLOCK_SIZE;
+            int c = i % BLOCK_SIZE;
+
+            if (row0 + r < hA && col0 + c < wB) {
+                C[static_cast<size_t>(row0 + r) * wB + col0 + c] =
+                    FromFloat<typename EPILOGUE::Output>(
+                        epilogue(Cs[r][c], row0 + r, col0 + c));
+            }
+        }
+    }
+};
+
+/**
+ * int8 Tensor Core matrix multiplication (CUDA Kernel) on the device:
+ * C = epilogue(A * B), A and B int8
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * Launch with (BLOCK_SIZE / 16)^2 warps per block; BLOCK_SIZE must be a
+ * multiple of 16.
+ */
+template <int BLOCK_SIZE, typename EPILOGUE> __global__ void
+MatrixMulImmaCUDA(typename EPILOGUE::Output *C, const int8_t *A,
+                  const int8_t *B, int hA, int wA, int wB,
+                  EPILOGUE epilogue) {
+    ImmaTile<BLOCK_SIZE, EPILOGUE, (WMMA_ARCH >= 720)>::Run(C, A, B, hA, wA,
+                                                            wB, epilogue);
+}
+
+#endif  // INT8_KERNELS_CUH_
@@ -0,0 +1,103 @@
+/**
+ * Compile-time sets of kernel instances and their run-time dispatch.
+ *
+ * A parameter that is a template argument of a kernel is declared once as
+ * an IntSet of the values to instantiate; DispatchInt maps the run-time
+ * value to the instance, or returns false if it is not in the set. The op
+ * is a functor with a template call operator taking IntConstant<V>, so
+ * that one body covers every value:
+ *
+ *     struct Launch {
+ *         template <int BLOCK_SIZE> bool operator()(IntConstant<BLOCK_SIZE>)
+ *             const { ...MatrixMulCUDA<BLOCK_SIZE> <<< ... >>>(...); }
+ *     };
+ *     DispatchInt(TiledBlockSizes(), block_size, &op);
+ *
+ * Several parameters nest: the operator of one op dispatches the next
+ * parameter with an op that carries the values seen so far. Types, such
+ * as those of the epilogues, are dispatched the same way by functions
+ * like DispatchEpilogue (matmulEpilogue.cpp).
+ *
+ * ForEachCombination goes the other way, from the sets to every instance:
+ * it calls the op once per combination of one value of each set, which
+ * is how the kernel registry (kernelRegistry.cpp) is generated.
+ */
+
+#ifndef KERNEL_DISPATCH_H_
+#define KERNEL_DISPATCH_H_
+
+#include "sharedLayout.cuh"
+
+// Value of a template parameter as a type, for overloads and deduction
+template <int V> struct IntConstant {
+    static const int value = V;
+};
+
+template <int V> const int IntConstant<V>::value;
+
+// The values of a template parameter that are instantiated
+template <int... VALUES> struct IntSet {};
+
+// Block sizes of the 2-D thread blocks of the tiled CUDA core kernels
+typedef IntSet<16, 32> TiledBlockSizes;
+
+// Both values of a bool template parameter
+typedef IntSet<0, 1> BoolSet;
+
+// Block sub-matrix edges of the WMMA kernels
+typedef IntSet<32, 64> WmmaBlockSizes;
+
+// Shared memory layouts of the tiles of the multi-block kernels
+typedef IntSet<SMEM_TRANSPOSED, SMEM_PADDED, SMEM_SWIZZLED> SmemLayouts;
+
+template <typename Op>
+inline bool DispatchInt(IntSet<>, int, Op *) {
+    return false;
+}
+
+/**
+ * Return (*op)(IntConstant<V>()) for the V of the set equal to value, or
+ * false if there is none
+ */
+template <int V, int... REST, typename Op>
+inline bool DispatchInt(IntSet<V, REST...>, int value, Op *op) {
+    if (value == V) {
+        return (*op)(IntConstant<V>());
+    }
+
+    return DispatchInt(IntSet<REST...>(), value, op);
+}
+
+// Values CHOSEN picked so far, and the sets still to pick from
+template <typename Chosen, typename... Sets> struct CrossProduct;
+
+template <int... CHOSEN> struct CrossProduct<IntSet<CHOSEN...> > {
+    template <typename Op> static void ForEach(Op *op) {
+        (*op)(IntSet<CHOSEN...>());
+    }
+};
+
+template <int... CHOSEN, typename... REST>
+struct CrossProduct<IntSet<CHOSEN...>, IntSet<>, REST...> {
+    template <typename Op> static void ForEach(Op *) {}
+};
+
+template <int... CHOSEN, int V, int... VALUES, typename... REST>
+struct CrossProduct<IntSet<CHOSEN...>, IntSet<V, VALUES...>, REST...> {
+    template <typename Op> static void ForEach(Op *op) {
+        CrossProduct<IntSet<CHOSEN..., V>, REST...>::ForEach(op);
+        CrossProduct<IntSet<CHOSEN...>, IntSet<VALUES...>, REST...>::
+            ForEach(op);
+    }
+};
+
+/**
+ * (*op)(IntSet<V1, V2, ...>()) for every combination of a value V1 of the
+ * first set, V2 of the second and so on, the first set outermost
+ */
+template <typename... Sets, typename Op>
+inline void ForEachCombination(Op *op) {
+    CrossProduct<IntSet<>, Sets...>::ForEach(op);
+}
+
+#endif  // KERNEL_DISPATCH_H_
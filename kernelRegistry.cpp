@@ -0,0 +1,709 @@
+/**
+ * Launchers and registry entries of all matrix multiplication kernels.
+ */
+
+// System includes
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "kernelDispatch.h"
+#include "kernelRegistry.h"
+#include "matmulKernels.cuh"
+#include "multiblockKernels.cuh"
+#include "persistentKernels.cuh"
+#include "splitKKernels.cuh"
+#include "tensorCoreKernels.cuh"
+
+// Number of blocks needed to cover n elements with tiles of size tile
+static inline int DivUp(int n, int tile) {
+    return (n + tile - 1) / tile;
+}
+
+template <int BLOCK_SIZE> void LaunchSample(void *C, const void *A,
+                                            const void *B, int M, int N,
+                                            int K, void *,
+                                            cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE));
+    MatrixMulCUDA<BLOCK_SIZE> <<< grid, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N);
+}
+
+template <int BLOCK_SIZE, int TILE, int VEC>
+void LaunchRegTile(void *C, const void *A, const void *B, int M, int N, int K,
+                   void *, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    dim3 grid(DivUp(N, BLOCK_SIZE * TILE), DivUp(M, BLOCK_SIZE * TILE));
+    MatrixMulRegTileCUDA<BLOCK_SIZE, TILE, TILE, VEC>
+        <<< grid, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N, IdentityEpilogue());
+}
+
+template <int BLOCK_SIZE> void LaunchGlobal(void *C, const void *A,
+                                            const void *B, int M, int N,
+                                            int K, void *,
+                                            cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE));
+    MatrixMulGlobalCUDA<BLOCK_SIZE> <<< grid, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N);
+}
+
+template <int BLOCK_SIZE, int LAYOUT>
+void LaunchShared(void *C, const void *A, const void *B, int M, int N, int K,
+                  void *, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE));
+    MatrixMulSharedCUDA<BLOCK_SIZE, LAYOUT> <<< grid, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N);
+}
+
+template <int BLOCK_SIZE, int LAYOUT>
+void LaunchDoubleBuffer(void *C, const void *A, const void *B, int M, int N,
+                        int K, void *, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE));
+    MatrixMulDoubleBufferCUDA<BLOCK_SIZE, LAYOUT>
+        <<< grid, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N);
+}
+
+template <int BLOCK_SIZE, int STAGES, int LAYOUT>
+void LaunchStages(void *C, const void *A, const void *B, int M, int N, int K,
+                  void *, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE));
+    MatrixMulStagesCUDA<BLOCK_SIZE, STAGES, LAYOUT>
+        <<< grid, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N);
+}
+
+// Each split-K slice is at least this many K-steps of BLOCK_SIZE deep
+#define SPLIT_K_MIN_STEPS 4
+
+// Largest grid extent in z
+#define SPLIT_K_MAX_SLICES 65535
+
+// Blocks of threads threads of kernel that the current device runs at once
+template <typename Kernel> static int WaveBlocks(Kernel kernel, int threads) {
+    int device, sms, perSm = 0;
+    cudaGetDevice(&device);
+    cudaDeviceGetAttribute(&sms, cudaDevAttrMultiProcessorCount, device);
+    cudaOccupancyMaxActiveBlocksPerMultiprocessor(&perSm, kernel, threads, 0);
+    return sms * (perSm > 0 ? perSm : 1);
+}
+
+/**
+ * Columns of A per split-K slice: enough slices for the tiles of C to
+ * fill one wave of wave blocks, but none shallower than SPLIT_K_MIN_STEPS
+ */
+template <int BLOCK_SIZE> static int SplitKChunk(int M, int N, int K,
+                                                 int wave) {
+    int tiles = DivUp(N, BLOCK_SIZE) * DivUp(M, BLOCK_SIZE);
+    int splits = DivUp(wave, tiles);
+    int deepest = DivUp(K, BLOCK_SIZE * SPLIT_K_MIN_STEPS);
+    splits = splits < deepest ? splits : deepest;
+    splits = splits < SPLIT_K_MAX_SLICES ? splits : SPLIT_K_MAX_SLICES;
+    splits = splits > 1 ? splits : 1;
+    return DivUp(DivUp(K, BLOCK_SIZE), splits) * BLOCK_SIZE;
+}
+
+// Split-K slices of an M x N x K launch
+template <int BLOCK_SIZE, bool ATOMIC> static int SplitKSlices(int M, int N,
+                                                               int K) {
+    int wave = WaveBlocks(MatrixMulSplitKCUDA<BLOCK_SIZE, ATOMIC>,
+                          BLOCK_SIZE * BLOCK_SIZE);
+    return DivUp(K, SplitKChunk<BLOCK_SIZE>(M, N, K, wave));
+}
+
+// splitKReduce writes its slices to the workspace, then sums them into C
+template <int BLOCK_SIZE, bool ATOMIC>
+size_t WorkspaceSplitK(int M, int N, int K) {
+    int splits = SplitKSlices<BLOCK_SIZE, ATOMIC>(M, N, K);
+    return ATOMIC || splits == 1 ? 0 :
+           sizeof(float) * static_cast<size_t>(M) * N * splits;
+}
+
+template <int BLOCK_SIZE, bool ATOMIC>
+void LaunchSplitK(void *C, const void *A, const void *B, int M, int N, int K,
+                  void *workspace, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    int wave = WaveBlocks(MatrixMulSplitKCUDA<BLOCK_SIZE, ATOMIC>,
+                          BLOCK_SIZE * BLOCK_SIZE);
+    int chunk = SplitKChunk<BLOCK_SIZE>(M, N, K, wave);
+    int splits = DivUp(K, chunk);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE), splits);
+    size_t n = static_cast<size_t>(M) * N;
+    float *slices = splits > 1 && !ATOMIC ?
+                    static_cast<float *>(workspace) : NULL;
+
+    if (splits > 1 && ATOMIC) {
+        cudaMemsetAsync(C, 0, sizeof(float) * n, stream);
+    }
+
+    MatrixMulSplitKCUDA<BLOCK_SIZE, ATOMIC> <<< grid, threads, 0, stream >>>(
+        slices != NULL ? slices : static_cast<float *>(C),
+        static_cast<const float *>(A), static_cast<const float *>(B), M, K,
+        N, chunk);
+
+    if (slices != NULL) {
+        int blocks = static_cast<int>((n + 255) / 256);
+        blocks = blocks < 1024 ? blocks : 1024;
+        MatrixSumSlicesCUDA<float> <<< blocks, 256, 0, stream >>>(
+            static_cast<float *>(C), slices, n, splits);
+    }
+}
+
+template <int BLOCK_SIZE>
+void LaunchStreamK(void *C, const void *A, const void *B, int M, int N,
+                   int K, void *, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    long long work = static_cast<long long>(DivUp(N, BLOCK_SIZE)) *
+                     DivUp(M, BLOCK_SIZE) * DivUp(K, BLOCK_SIZE);
+    int blocks = WaveBlocks(MatrixMulStreamKCUDA<BLOCK_SIZE>,
+                            BLOCK_SIZE * BLOCK_SIZE);
+    blocks = work < blocks ? static_cast<int>(work) : blocks;
+
+    // Tiles shared between blocks are accumulated atomically
+    cudaMemsetAsync(C, 0, sizeof(float) * M * N, stream);
+    MatrixMulStreamKCUDA<BLOCK_SIZE> <<< blocks, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N);
+}
+
+// The tile counter
+static size_t WorkspacePersistent(int, int, int) {
+    return sizeof(int);
+}
+
+template <int BLOCK_SIZE, int GROUP>
+void LaunchPersistent(void *C, const void *A, const void *B, int M, int N,
+                      int K, void *workspace, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    int tiles = DivUp(N, BLOCK_SIZE) * DivUp(M, BLOCK_SIZE);
+    int blocks = WaveBlocks(MatrixMulPersistentCUDA<BLOCK_SIZE, GROUP>,
+                            BLOCK_SIZE * BLOCK_SIZE);
+    blocks = tiles < blocks ? tiles : blocks;
+
+    // A counter of this launch only, so concurrent launches and replays
+    // of a graph do not take each other's tiles
+    cudaMemsetAsync(workspace, 0, sizeof(int), stream);
+    MatrixMulPersistentCUDA<BLOCK_SIZE, GROUP>
+        <<< blocks, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N,
+        static_cast<int *>(workspace));
+}
+
+template <int BLOCK_SIZE, typename T, typename OutT>
+void LaunchWmma(void *C, const void *A, const void *B, int M, int N, int K,
+                void *, cudaStream_t stream) {
+    // One warp per 16 x 16 fragment of the block sub-matrix
+    const int tiles = BLOCK_SIZE / WMMA_TILE;
+    dim3 threads(tiles * tiles * 32);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE));
+    MatrixMulWmmaCUDA<BLOCK_SIZE, T, OutT> <<< grid, threads, 0, stream >>>(
+        static_cast<OutT *>(C), static_cast<const T *>(A),
+        static_cast<const T *>(B), M, K, N);
+}
+
+template <int BLOCK_SIZE, bool SPLIT>
+void LaunchTf32(void *C, const void *A, const void *B, int M, int N, int K,
+                void *, cudaStream_t stream) {
+    const int tiles = BLOCK_SIZE / WMMA_TILE;
+    dim3 threads(tiles * tiles * 32);
+    dim3 grid(DivUp(N, BLOCK_SIZE), DivUp(M, BLOCK_SIZE));
+    MatrixMulTf32CUDA<BLOCK_SIZE, SPLIT> <<< grid, threads, 0, stream >>>(
+        static_cast<float *>(C), static_cast<const float *>(A),
+        static_cast<const float *>(B), M, K, N);
+}
+
+/**
+ * info about a launch of kernel with grid and threads on the current
+ * device
+ */
+template <typename Kernel>
+static cudaError_t FillLaunchInfo(Kernel kernel, dim3 grid, dim3 threads,
+                                  KernelLaunchInfo *info) {
+    cudaFuncAttributes attr;
+    cudaError_t err = cudaFuncGetAttributes(&attr, kernel);
+
+    if (err == cudaSuccess) {
+        err = cudaOccupancyMaxActiveBlocksPerMultiprocessor(
+                  &info->blocksPerSm, kernel,
+                  threads.x * threads.y * threads.z, 0);
+    }
+
+    info->grid = grid;
+    info->threads = threads;
+    info->registers = attr.numRegs;
+    info->sharedBytes = attr.sharedSizeBytes;
+    return err;
+}
+
+// Grid of one block per tile x tile sub-matrix of C
+static inline dim3 TileGrid(int M, int N, int tile) {
+    return dim3(DivUp(N, tile), DivUp(M, tile));
+}
+
+template <int BLOCK_SIZE>
+cudaError_t InfoSample(int M, int N, int, KernelLaunchInfo *info) {
+    return FillLaunchInfo(MatrixMulCUDA<BLOCK_SIZE>,
+                          TileGrid(M, N, BLOCK_SIZE),
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE, int TILE, int VEC>
+cudaError_t InfoRegTile(int M, int N, int, KernelLaunchInfo *info) {
+    return FillLaunchInfo(MatrixMulRegTileCUDA<BLOCK_SIZE, TILE, TILE, VEC>,
+                          TileGrid(M, N, BLOCK_SIZE * TILE),
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE>
+cudaError_t InfoGlobal(int M, int N, int, KernelLaunchInfo *info) {
+    return FillLaunchInfo(MatrixMulGlobalCUDA<BLOCK_SIZE>,
+                          TileGrid(M, N, BLOCK_SIZE),
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE, int LAYOUT>
+cudaError_t InfoShared(int M, int N, int, KernelLaunchInfo *info) {
+    return FillLaunchInfo(MatrixMulSharedCUDA<BLOCK_SIZE, LAYOUT>,
+                          TileGrid(M, N, BLOCK_SIZE),
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE, int LAYOUT>
+cudaError_t InfoDoubleBuffer(int M, int N, int, KernelLaunchInfo *info) {
+    return FillLaunchInfo(MatrixMulDoubleBufferCUDA<BLOCK_SIZE, LAYOUT>,
+                          TileGrid(M, N, BLOCK_SIZE),
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE, int STAGES, int LAYOUT>
+cudaError_t InfoStages(int M, int N, int, KernelLaunchInfo *info) {
+    return FillLaunchInfo(MatrixMulStagesCUDA<BLOCK_SIZE, STAGES, LAYOUT>,
+                          TileGrid(M, N, BLOCK_SIZE),
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+// The slice kernel only; the reduction of splitKReduce is not included
+template <int BLOCK_SIZE, bool ATOMIC>
+cudaError_t InfoSplitK(int M, int N, int K, KernelLaunchInfo *info) {
+    dim3 grid = TileGrid(M, N, BLOCK_SIZE);
+    grid.z = SplitKSlices<BLOCK_SIZE, ATOMIC>(M, N, K);
+    return FillLaunchInfo(MatrixMulSplitKCUDA<BLOCK_SIZE, ATOMIC>, grid,
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE>
+cudaError_t InfoStreamK(int M, int N, int K, KernelLaunchInfo *info) {
+    long long work = static_cast<long long>(DivUp(N, BLOCK_SIZE)) *
+                     DivUp(M, BLOCK_SIZE) * DivUp(K, BLOCK_SIZE);
+    int blocks = WaveBlocks(MatrixMulStreamKCUDA<BLOCK_SIZE>,
+                            BLOCK_SIZE * BLOCK_SIZE);
+    blocks = work < blocks ? static_cast<int>(work) : blocks;
+    return FillLaunchInfo(MatrixMulStreamKCUDA<BLOCK_SIZE>, dim3(blocks),
+                          dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE, int GROUP>
+cudaError_t InfoPersistent(int M, int N, int, KernelLaunchInfo *info) {
+    int tiles = DivUp(N, BLOCK_SIZE) * DivUp(M, BLOCK_SIZE);
+    int blocks = WaveBlocks(MatrixMulPersistentCUDA<BLOCK_SIZE, GROUP>,
+                            BLOCK_SIZE * BLOCK_SIZE);
+    blocks = tiles < blocks ? tiles : blocks;
+    return FillLaunchInfo(MatrixMulPersistentCUDA<BLOCK_SIZE, GROUP>,
+                          dim3(blocks), dim3(BLOCK_SIZE, BLOCK_SIZE), info);
+}
+
+template <int BLOCK_SIZE, typename T, typename OutT>
+cudaError_t InfoWmma(int M, int N, int, KernelLaunchInfo *info) {
+    const int tiles = BLOCK_SIZE / WMMA_TILE;
+    return FillLaunchInfo(MatrixMulWmmaCUDA<BLOCK_SIZE, T, OutT>,
+                          TileGrid(M, N, BLOCK_SIZE),
+                          dim3(tiles * tiles * 32), info);
+}
+
+template <int BLOCK_SIZE, bool SPLIT>
+cudaError_t InfoTf32(int M, int N, int, KernelLaunchInfo *info) {
+    const int tiles = BLOCK_SIZE / WMMA_TILE;
+    return FillLaunchInfo(MatrixMulTf32CUDA<BLOCK_SIZE, SPLIT>,
+                          TileGrid(M, N, BLOCK_SIZE),
+                          dim3(tiles * tiles * 32), info);
+}
+
+// Element type of a MatmulType template parameter
+template <int TYPE> struct ElementOf;
+
+template <> struct ElementOf<MATMUL_FP32> {
+    typedef float type;
+};
+
+template <> struct ElementOf<MATMUL_FP16> {
+    typedef half type;
+};
+
+template <> struct ElementOf<MATMUL_BF16> {
+    typedef __nv_bfloat16 type;
+};
+
+// Entries of the registry, and the names and descriptions they point to
+struct Registry {
+    std::vector<KernelEntry> entries;
+    std::deque<std::string> strings;
+
+    // printf into a string that lives as long as the registry
+    const char *Format(const char *format, ...) {
+        char text[128];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        strings.push_back(text);
+        return strings.back().c_str();
+    }
+};
+
+// "", "Padded" or "Swizzled", the suffix of a family name for layout
+static const char *LayoutSuffix(int layout) {
+    return layout == SMEM_PADDED ? "Padded" :
+           layout == SMEM_SWIZZLED ? "Swizzled" : "";
+}
+
+// "", ", padded" or ", swizzled", the suffix of a description for layout
+static const char *LayoutNote(int layout) {
+    return layout == SMEM_PADDED ? ", padded" :
+           layout == SMEM_SWIZZLED ? ", swizzled" : "";
+}
+
+/**
+ * A kernel family is a struct with the parameter sets to expand, a
+ * constexpr Valid that says which of their combinations to instantiate,
+ * and a Row template that describes one instance. Its Rows op receives
+ * every combination from ForEachCombination and adds the valid ones.
+ */
+template <typename Family> struct Rows {
+    Registry *registry;
+
+    template <int... V> void operator()(IntSet<V...>) const {
+        Add(IntSet<V...>(), IntConstant<Family::Valid(V...) ? 1 : 0>());
+    }
+
+    template <int... V> void Add(IntSet<V...>, IntConstant<1>) const {
+        registry->entries.push_back(Family::template Row<V...>(registry));
+    }
+
+    template <int... V> void Add(IntSet<V...>, IntConstant<0>) const {}
+};
+
+template <typename Family, typename... Sets>
+static void AddFamily(Registry *registry) {
+    Rows<Family> rows = {registry};
+    ForEachCombination<Sets...>(&rows);
+}
+
+struct SampleFamily {
+    static constexpr bool Valid(int) { return true; }
+
+    template <int BLOCK_SIZE> static KernelEntry Row(Registry *) {
+        KernelEntry e = {"sample", BLOCK_SIZE, 1, 1, 1, SMEM_FIXED,
+                         MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+                         LaunchSample<BLOCK_SIZE>, InfoSample<BLOCK_SIZE>, NULL,
+                         "matrixMul sample, one element per thread"};
+        return e;
+    }
+};
+
+// Vector loads need whole vectors in the columns of a thread's tile
+struct RegTileFamily {
+    static constexpr bool Valid(int vec, int tile, int) {
+        return vec == 1 || vec == tile;
+    }
+
+    template <int VEC, int TILE, int BLOCK_SIZE>
+    static KernelEntry Row(Registry *r) {
+        KernelEntry e = {
+            VEC == 1 ? r->Format("regTile%d", TILE) :
+                       r->Format("regTile%dVec%d", TILE, VEC),
+            BLOCK_SIZE, TILE, 1, VEC, SMEM_FIXED,
+            MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+            LaunchRegTile<BLOCK_SIZE, TILE, VEC>,
+            InfoRegTile<BLOCK_SIZE, TILE, VEC>, NULL,
+            VEC == 1 ?
+                r->Format("register blocked, %dx%d elements per thread",
+                          TILE, TILE) :
+                r->Format("register blocked %dx%d, float%d loads/stores",
+                          TILE, TILE, VEC)
+        };
+        return e;
+    }
+};
+
+struct GlobalFamily {
+    static constexpr bool Valid(int) { return true; }
+
+    template <int BLOCK_SIZE> static KernelEntry Row(Registry *) {
+        KernelEntry e = {"global", BLOCK_SIZE, 1, 0, 1, SMEM_FIXED,
+                         MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+                         LaunchGlobal<BLOCK_SIZE>, InfoGlobal<BLOCK_SIZE>, NULL,
+                         "global memory only"};
+        return e;
+    }
+};
+
+struct SharedFamily {
+    static constexpr bool Valid(int, int) { return true; }
+
+    template <int BLOCK_SIZE, int LAYOUT> static KernelEntry Row(Registry *r) {
+        KernelEntry e = {
+            r->Format("shared%s", LayoutSuffix(LAYOUT)), BLOCK_SIZE, 1, 1,
+            1, static_cast<SmemLayout>(LAYOUT),
+            MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+            LaunchShared<BLOCK_SIZE, LAYOUT>, InfoShared<BLOCK_SIZE, LAYOUT>,
+            NULL,
+            r->Format("shared memory tiles%s", LayoutNote(LAYOUT))
+        };
+        return e;
+    }
+};
+
+struct DoubleBufferFamily {
+    static constexpr bool Valid(int, int) { return true; }
+
+    template <int BLOCK_SIZE, int LAYOUT> static KernelEntry Row(Registry *r) {
+        KernelEntry e = {
+            r->Format("doubleBuffer%s", LayoutSuffix(LAYOUT)), BLOCK_SIZE, 1,
+            2, 1, static_cast<SmemLayout>(LAYOUT),
+            MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+            LaunchDoubleBuffer<BLOCK_SIZE, LAYOUT>,
+            InfoDoubleBuffer<BLOCK_SIZE, LAYOUT>, NULL,
+            r->Format("double buffered shared memory tiles%s",
+                      LayoutNote(LAYOUT))
+        };
+        return e;
+    }
+};
+
+// The ring of A and B tiles fits the 48 KiB of static shared memory
+struct StagesFamily {
+    static constexpr bool Valid(int stages, int block, int layout) {
+        return 2 * stages * block *
+               (layout == SMEM_PADDED ? block + 1 : block) *
+               static_cast<int>(sizeof(float)) <= 48 * 1024;
+    }
+
+    template <int STAGES, int BLOCK_SIZE, int LAYOUT>
+    static KernelEntry Row(Registry *r) {
+        KernelEntry e = {
+            r->Format("stages%d%s", STAGES, LayoutSuffix(LAYOUT)),
+            BLOCK_SIZE, 1, STAGES, 1, static_cast<SmemLayout>(LAYOUT),
+            MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+            LaunchStages<BLOCK_SIZE, STAGES, LAYOUT>,
+            InfoStages<BLOCK_SIZE, STAGES, LAYOUT>, NULL,
+            r->Format("%d-stage ring of shared memory tiles%s", STAGES,
+                      LayoutNote(LAYOUT))
+        };
+        return e;
+    }
+};
+
+struct SplitKFamily {
+    static constexpr bool Valid(int, int) { return true; }
+
+    template <int ATOMIC, int BLOCK_SIZE> static KernelEntry Row(Registry *) {
+        KernelEntry e = {
+            ATOMIC ? "splitK" : "splitKReduce", BLOCK_SIZE, 1, 1, 1,
+            SMEM_FIXED, MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+            LaunchSplitK<BLOCK_SIZE, ATOMIC != 0>,
+            InfoSplitK<BLOCK_SIZE, ATOMIC != 0>,
+            WorkspaceSplitK<BLOCK_SIZE, ATOMIC != 0>,
+            ATOMIC ? "split-K, slices added with atomics" :
+                     "split-K, slices summed by a second kernel"
+        };
+        return e;
+    }
+};
+
+struct StreamKFamily {
+    static constexpr bool Valid(int) { return true; }
+
+    template <int BLOCK_SIZE> static KernelEntry Row(Registry *) {
+        KernelEntry e = {"streamK", BLOCK_SIZE, 1, 1, 1, SMEM_FIXED,
+                         MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32, 0,
+                         LaunchStreamK<BLOCK_SIZE>, InfoStreamK<BLOCK_SIZE>,
+                         NULL,
+                         "stream-K, one wave sharing tiles x K-steps"};
+        return e;
+    }
+};
+
+// GROUP rows of tiles per group; 1 walks the tiles row-major
+struct PersistentFamily {
+    static constexpr bool Valid(int, int) { return true; }
+
+    template <int GROUP, int BLOCK_SIZE> static KernelEntry Row(Registry *r) {
+        KernelEntry e = {
+            GROUP == 1 ? "persistentRowMajor" : "persistent", BLOCK_SIZE, 1,
+            1, 1, SMEM_FIXED, MATMUL_FP32, MATMUL_FP32, MATMUL_COMPUTE_FP32,
+            0, LaunchPersistent<BLOCK_SIZE, GROUP>,
+            InfoPersistent<BLOCK_SIZE, GROUP>,
+            WorkspacePersistent,
+            GROUP == 1 ?
+                "persistent, atomic tile counter, row-major tiles" :
+                r->Format("persistent, atomic tile counter, groups of %d "
+                          "rows", GROUP)
+        };
+        return e;
+    }
+};
+
+// Tensor core inputs are fp16 or bf16, which needs sm_80; C is fp32 or
+// fp16
+struct WmmaFamily {
+    static constexpr bool Valid(int in, int out, int) {
+        return in != MATMUL_FP32 && out != MATMUL_BF16;
+    }
+
+    template <int IN, int OUT, int BLOCK_SIZE>
+    static KernelEntry Row(Registry *r) {
+        typedef typename ElementOf<IN>::type T;
+        typedef typename ElementOf<OUT>::type OutT;
+        const char *in = IN == MATMUL_FP16 ? "Half" : "Bf16";
+        KernelEntry e = {
+            r->Format("wmma%s%s", in, OUT == MATMUL_FP16 ? "OutHalf" : ""),
+            BLOCK_SIZE, 1, 1, 1, SMEM_FIXED, static_cast<MatmulType>(IN),
+            static_cast<MatmulType>(OUT), MATMUL_COMPUTE_FP32,
+            IN == MATMUL_BF16 ? 80 : 70,
+            LaunchWmma<BLOCK_SIZE, T, OutT>, InfoWmma<BLOCK_SIZE, T, OutT>,
+            NULL,
+            r->Format("WMMA, %s inputs, %s output",
+                      MatmulTypeName(static_cast<MatmulType>(IN)),
+                      MatmulTypeName(static_cast<MatmulType>(OUT)))
+        };
+        return e;
+    }
+};
+
+struct Tf32Family {
+    static constexpr bool Valid(int, int) { return true; }
+
+    template <int SPLIT, int BLOCK_SIZE> static KernelEntry Row(Registry *) {
+        KernelEntry e = {
+            SPLIT ? "tf32x3" : "tf32", BLOCK_SIZE, 1, 1, 1, SMEM_FIXED,
+            MATMUL_FP32, MATMUL_FP32,
+            SPLIT ? MATMUL_COMPUTE_3XTF32 : MATMUL_COMPUTE_TF32, 80,
+            LaunchTf32<BLOCK_SIZE, SPLIT != 0>,
+            InfoTf32<BLOCK_SIZE, SPLIT != 0>, NULL,
+            SPLIT ? "WMMA, fp32 split into 3xTF32" :
+                    "WMMA, fp32 rounded to TF32"
+        };
+        return e;
+    }
+};
+
+/**
+ * Every family over its parameter sets, in the order the benchmark lists
+ * them; the first set of a family varies slowest
+ */
+static Registry *BuildRegistry() {
+    Registry *registry = new Registry;
+    AddFamily<SampleFamily, TiledBlockSizes>(registry);
+    AddFamily<RegTileFamily, IntSet<1, 2, 4>, IntSet<2, 4>,
+              TiledBlockSizes>(registry);
+    AddFamily<GlobalFamily, TiledBlockSizes>(registry);
+    AddFamily<SharedFamily, TiledBlockSizes, SmemLayouts>(registry);
+    AddFamily<DoubleBufferFamily, TiledBlockSizes, SmemLayouts>(registry);
+    AddFamily<StagesFamily, IntSet<2, 3, 4>, TiledBlockSizes,
+              SmemLayouts>(registry);
+    AddFamily<SplitKFamily, IntSet<1, 0>, TiledBlockSizes>(registry);
+    AddFamily<StreamKFamily, TiledBlockSizes>(registry);
+    AddFamily<PersistentFamily, IntSet<8, 1>, TiledBlockSizes>(registry);
+    AddFamily<WmmaFamily, IntSet<MATMUL_FP16, MATMUL_BF16>,
+              IntSet<MATMUL_FP32, MATMUL_FP16>, WmmaBlockSizes>(registry);
+    AddFamily<Tf32Family, BoolSet, WmmaBlockSizes>(registry);
+    return registry;
+}
+
+const KernelEntry *GetKernelRegistry(int *count) {
+    // Built on first use, once even with several threads; never freed
+    static const Registry *registry = BuildRegistry();
+    *count = static_cast<int>(registry->entries.size());
+    return &registry->entries[0];
+}
+
+const KernelEntry *FindKernel(const char *name, int block_size) {
+    int count;
+    const KernelEntry *entries = GetKernelRegistry(&count);
+
+    for (int i = 0; i < count; ++i) {
+        if (strcmp(entries[i].name, name) == 0 &&
+                entries[i].block_size == block_size) {
+            return &entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+cudaError_t GetKernelImage(KernelImage *image) {
+    image->builtCount = 0;
+
+#ifdef __CUDA_ARCH_LIST__
+    const int built[] = {__CUDA_ARCH_LIST__};
+    int count = static_cast<int>(sizeof(built) / sizeof(built[0]));
+
+    for (int i = 0; i < count && i < 16; i++) {
+        image->builtArchs[image->builtCount++] = built[i] / 10;
+    }
+#endif
+
+    // Any kernel: they are all in the same fat binary
+    cudaFuncAttributes attr;
+    cudaError_t err = cudaFuncGetAttributes(&attr, MatrixMulCUDA<16>);
+    image->binaryArch = err == cudaSuccess ? attr.binaryVersion : 0;
+    image->ptxArch = err == cudaSuccess ? attr.ptxVersion : 0;
+    image->deviceArch = 0;
+    image->jit = false;
+
+    int device, major, minor;
+
+    if (err == cudaSuccess) {
+        err = cudaGetDevice(&device);
+    }
+
+    if (err == cudaSuccess) {
+        err = cudaDeviceGetAttribute(&major,
+                                     cudaDevAttrComputeCapabilityMajor,
+                                     device);
+    }
+
+    if (err == cudaSuccess) {
+        err = cudaDeviceGetAttribute(&minor,
+                                     cudaDevAttrComputeCapabilityMinor,
+                                     device);
+    }
+
+    // The driver prefers SASS of the same major and an equal or lower
+    // minor, as sm_80 code on sm_86, which binaryVersion then names.
+    // Only machine code compiled from PTX at load time has the device's
+    // own architecture with PTX of an older one.
+    if (err == cudaSuccess) {
+        image->deviceArch = major * 10 + minor;
+        image->jit = image->binaryArch == image->deviceArch &&
+                     image->ptxArch < image->binaryArch;
+    }
+
+    return err;
+}
@@ -0,0 +1,115 @@
+/**
+ * Registry of the matrix multiplication kernels.
+ *
+ * Every template instance that can be benchmarked is listed once, with a
+ * type-erased launcher that sizes the grid for an M x N x K problem
+ * (C is M x N, A is M x K, B is K x N, all row-major). The list is
+ * generated from the parameter sets of each kernel family
+ * (kernelRegistry.cpp).
+ */
+
+#ifndef KERNEL_REGISTRY_H_
+#define KERNEL_REGISTRY_H_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "matmulTypes.cuh"
+#include "sharedLayout.cuh"
+
+// workspace is the device memory that the entry's workspace asks for
+typedef void (*MatmulLaunchFn)(void *C, const void *A, const void *B,
+                               int M, int N, int K, void *workspace,
+                               cudaStream_t stream);
+
+// Geometry and resources of the main kernel of a launch
+struct KernelLaunchInfo {
+    dim3 grid;
+    dim3 threads;
+
+    // Theoretical resident blocks per SM on the current device
+    int blocksPerSm;
+
+    int registers;
+    size_t sharedBytes;
+};
+
+typedef cudaError_t (*MatmulInfoFn)(int M, int N, int K,
+                                    KernelLaunchInfo *info);
+
+typedef size_t (*MatmulWorkspaceFn)(int M, int N, int K);
+
+struct KernelEntry {
+    // Kernel family, e.g. "shared" or "regTile4"
+    const char *name;
+
+    // Edge of the thread block (or of the block sub-matrix for WMMA)
+    int block_size;
+
+    // Tuning parameters: elements of C per thread along each side,
+    // depth of the shared memory pipeline and width of the global loads
+    int thread_tile;
+    int stages;
+    int vec_width;
+
+    // Layout of the shared memory tiles (SMEM_FIXED if it cannot be chosen)
+    SmemLayout layout;
+
+    // Element types of A and B, and of C
+    MatmulType inType;
+    MatmulType outType;
+
+    // Arithmetic on the elements of A and B
+    MatmulCompute compute;
+
+    // Lowest compute capability that can run the kernel, as major * 10 + minor
+    int minArch;
+
+    MatmulLaunchFn launch;
+
+    // What launch would run for an M x N x K problem
+    MatmulInfoFn info;
+
+    // Bytes of device memory that launch needs for an M x N x K problem,
+    // which the caller allocates and does not touch until the launch is
+    // done; NULL if it needs none
+    MatmulWorkspaceFn workspace;
+
+    const char *description;
+};
+
+/**
+ * All registered kernels; count receives the number of entries
+ */
+const KernelEntry *GetKernelRegistry(int *count);
+
+/**
+ * The entry of the given family and block size, or NULL
+ */
+const KernelEntry *FindKernel(const char *name, int block_size);
+
+// Device code of the kernels as loaded for the current device
+struct KernelImage {
+    // Architecture of the machine code and of the PTX it came from, as
+    // major * 10 + minor
+    int binaryArch;
+    int ptxArch;
+
+    // Virtual architectures the binary was built for (__CUDA_ARCH_LIST__),
+    // none if the compiler does not say
+    int builtArchs[16];
+    int builtCount;
+
+    // Architecture of the device, and whether the driver had no SASS it
+    // could run there and compiled the PTX of an older architecture
+    int deviceArch;
+    bool jit;
+};
+
+/**
+ * Load the kernels for the current device and describe them; returns
+ * cudaErrorNoKernelImageForDevice if the binary has no code it can run
+ */
+cudaError_t GetKernelImage(KernelImage *image);
+
+#endif  // KERNEL_REGISTRY_H_
@@ -0,0 +1,129 @@
+/**
+ * Per-launch timing of kernels with CUDA events.
+ */
+
+// System includes
+#include <algorithm>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_cuda.h>
+
+#include "kernelTiming.h"
+
+void TimeLaunches(void (*launch)(void *context, cudaStream_t stream),
+                  void *context, int warmup, int iters, cudaStream_t stream,
+                  std::vector<float> *times) {
+    for (int j = 0; j < warmup; j++) {
+        launch(context, stream);
+    }
+
+    getLastCudaError("Kernel launch failed");
+
+    // One event pair per launch, so that warm-up effects, clock changes
+    // and outliers show up in the distribution instead of in the mean.
+    // The pairs rotate through a ring: before a pair is recorded again,
+    // the launch it timed last is waited for and its time read, which
+    // keeps up to KERNEL_TIMING_RING launches queued.
+    int ring = iters < KERNEL_TIMING_RING ? iters : KERNEL_TIMING_RING;
+    std::vector<cudaEvent_t> events(2 * ring);
+
+    for (size_t i = 0; i < events.size(); i++) {
+        checkCudaErrors(cudaEventCreate(&events[i]));
+    }
+
+    times->resize(iters);
+
+    for (int j = 0; j < iters + ring; j++) {
+        int slot = j % ring;
+
+        if (j >= ring) {
+            checkCudaErrors(cudaEventSynchronize(events[2 * slot + 1]));
+            checkCudaErrors(cudaEventElapsedTime(&(*times)[j - ring],
+                                                 events[2 * slot],
+                                                 events[2 * slot + 1]));
+        }
+
+        if (j < iters) {
+            checkCudaErrors(cudaEventRecord(events[2 * slot], stream));
+            launch(context, stream);
+            checkCudaErrors(cudaEventRecord(events[2 * slot + 1], stream));
+        }
+    }
+
+    getLastCudaError("Kernel execution failed");
+
+    for (size_t i = 0; i < events.size(); i++) {
+        checkCudaErrors(cudaEventDestroy(events[i]));
+    }
+}
+
+// Arguments of one registered kernel launch, for TimeLaunches
+struct KernelLaunch {
+    const KernelEntry *kernel;
+    void *d_C;
+    const void *d_A;
+    const void *d_B;
+    int M;
+    int N;
+    int K;
+    void *workspace;
+};
+
+static void LaunchRegistered(void *context, cudaStream_t stream) {
+    const KernelLaunch *l = static_cast<const KernelLaunch *>(context);
+    l->kernel->launch(l->d_C, l->d_A, l->d_B, l->M, l->N, l->K,
+                      l->workspace, stream);
+}
+
+void TimeKernelLaunches(const KernelEntry *kernel, void *d_C, const void *d_A,
+                        const void *d_B, int M, int N, int K, int warmup,
+                        int iters, cudaStream_t stream,
+                        std::vector<float> *times) {
+    KernelLaunch l = {kernel, d_C, d_A, d_B, M, N, K, NULL};
+    size_t bytes = kernel->workspace != NULL ? kernel->workspace(M, N, K) : 0;
+
+    // One workspace for all launches, which are ordered on stream
+    if (bytes > 0) {
+        checkCudaErrors(cudaMalloc(&l.workspace, bytes));
+    }
+
+    TimeLaunches(LaunchRegistered, &l, warmup, iters, stream, times);
+
+    if (bytes > 0) {
+        checkCudaErrors(cudaFree(l.workspace));
+    }
+}
+
+double Percentile(std::vector<float> times, double p) {
+    if (times.empty()) {
+        return 0.0;
+    }
+
+    std::sort(times.begin(), times.end());
+
+    double rank = p / 100.0 * (times.size() - 1);
+    size_t lo = static_cast<size_t>(rank);
+    size_t hi = std::min(lo + 1, times.size() - 1);
+    double frac = rank - lo;
+
+    return times[lo] * (1.0 - frac) + times[hi] * frac;
+}
+
+TimingStats SummarizeTimes(const std::vector<float> &times) {
+    TimingStats stats;
+    stats.iters = static_cast<int>(times.size());
+    stats.median_ms = Percentile(times, 50.0);
+    stats.p5_ms = Percentile(times, 5.0);
+    stats.p95_ms = Percentile(times, 95.0);
+    stats.min_ms = Percentile(times, 0.0);
+
+    double sum = 0.0;
+
+    for (size_t i = 0; i < times.size(); i++) {
+        sum += times[i];
+    }
+
+    stats.mean_ms = times.empty() ? 0.0 : sum / times.size();
+
+    return stats;
+}
@@ -0,0 +1,53 @@
+/**
+ * Per-launch timing of kernels with CUDA events.
+ */
+
+#ifndef KERNEL_TIMING_H_
+#define KERNEL_TIMING_H_
+
+// System includes
+#include <vector>
+
+#include "kernelRegistry.h"
+
+// Event pairs of TimeLaunches in flight before the oldest is read back
+#define KERNEL_TIMING_RING 64
+
+// Summary of the per-launch times of one kernel on one problem
+struct TimingStats {
+    int iters;
+    double median_ms;
+    double p5_ms;
+    double p95_ms;
+    double min_ms;
+    double mean_ms;
+};
+
+/**
+ * Call launch(context, stream) warmup times, then iters times with an event
+ * pair around every call; times receives the iters per-call times in
+ * milliseconds. launch may issue any number of kernels into stream. Event
+ * pairs are reused after KERNEL_TIMING_RING calls.
+ */
+void TimeLaunches(void (*launch)(void *context, cudaStream_t stream),
+                  void *context, int warmup, int iters, cudaStream_t stream,
+                  std::vector<float> *times);
+
+/**
+ * Launch kernel warmup times, then iters times with an event pair around
+ * every launch; times receives the iters per-launch times in milliseconds
+ */
+void TimeKernelLaunches(const KernelEntry *kernel, void *d_C, const void *d_A,
+                        const void *d_B, int M, int N, int K, int warmup,
+                        int iters, cudaStream_t stream,
+                        std::vector<float> *times);
+
+/**
+ * The p-th percentile (0 <= p <= 100) of times, interpolating linearly
+ * between the closest ranks
+ */
+double Percentile(std::vector<float> times, double p);
+
+TimingStats SummarizeTimes(const std::vector<float> &times);
+
+#endif  // KERNEL_TIMING_H_
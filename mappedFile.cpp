@@ -0,0 +1,68 @@
+/**
+ * Memory-mapped files for matrices that do not fit in host memory.
+ */
+
+// System includes
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mappedFile.h"
+
+bool MapFile(const char *path, size_t bytes, bool writable, MappedFile *map) {
+    map->data = NULL;
+    map->bytes = 0;
+    map->fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+
+    if (map->fd < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(map->fd, &st) != 0 ||
+            (writable && ftruncate(map->fd, bytes) != 0) ||
+            (!writable && static_cast<size_t>(st.st_size) < bytes)) {
+        fprintf(stderr, "%s does not hold %zu bytes\n", path, bytes);
+        close(map->fd);
+        map->fd = -1;
+        return false;
+    }
+
+    void *data = mmap(NULL, bytes, writable ? PROT_READ | PROT_WRITE :
+                      PROT_READ, MAP_SHARED, map->fd, 0);
+
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Failed to map %s: %s\n", path, strerror(errno));
+        close(map->fd);
+        map->fd = -1;
+        return false;
+    }
+
+    // No madvise: the out-of-core mode reads the blocks of A and B again
+    // for every tile of C, which MADV_SEQUENTIAL would evict early
+
+    map->data = data;
+    map->bytes = bytes;
+    return true;
+}
+
+void UnmapFile(MappedFile *map) {
+    if (map->data != NULL) {
+        msync(map->data, map->bytes, MS_SYNC);
+        munmap(map->data, map->bytes);
+    }
+
+    if (map->fd >= 0) {
+        close(map->fd);
+    }
+
+    map->data = NULL;
+    map->bytes = 0;
+    map->fd = -1;
+}
@@ -0,0 +1,34 @@
+/**
+ * Memory-mapped files for matrices that do not fit in host memory.
+ *
+ * The mapping is a plain host pointer, so it can be passed wherever the
+ * library takes host matrices; pages are read from or written back to the
+ * file on demand by the operating system.
+ */
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+// System includes
+#include <stddef.h>
+
+struct MappedFile {
+    void *data;
+    size_t bytes;
+    int fd;
+};
+
+/**
+ * Map bytes of the file at path into memory. With writable the file is
+ * created or resized to bytes and changes go back to it; otherwise it is
+ * mapped read-only and must hold at least bytes. Returns false and prints
+ * the reason on failure.
+ */
+bool MapFile(const char *path, size_t bytes, bool writable, MappedFile *map);
+
+/**
+ * Flush a writable mapping and release it
+ */
+void UnmapFile(MappedFile *map);
+
+#endif  // MAPPED_FILE_H_
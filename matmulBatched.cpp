@@ -0,0 +1,85 @@
+/**
+ * Batched matrix multiplication: many independent problems of the same
+ * shape in one launch.
+ */
+
+#include "kernelDispatch.h"
+#include "matmulBatched.h"
+#include "matmulKernels.cuh"
+
+// Grid covering one M x N problem per z-slice, for up to batch problems
+static dim3 BatchedGrid(int M, int N, int batch, int block_size) {
+    int z = batch < MATMUL_MAX_GRID_Z ? batch : MATMUL_MAX_GRID_Z;
+    return dim3((N + block_size - 1) / block_size,
+                (M + block_size - 1) / block_size, z);
+}
+
+// Launch of the strided batched kernel
+struct StridedBatchedLaunch {
+    float *C;
+    const float *A;
+    const float *B;
+    int M;
+    int N;
+    int K;
+    long long strideA;
+    long long strideB;
+    long long strideC;
+    int batch;
+    cudaStream_t stream;
+
+    template <int BLOCK_SIZE>
+    bool operator()(IntConstant<BLOCK_SIZE>) const {
+        dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+        dim3 grid = BatchedGrid(M, N, batch, BLOCK_SIZE);
+        MatrixMulStridedBatchedCUDA<BLOCK_SIZE>
+            <<< grid, threads, 0, stream >>>(
+            C, A, B, M, K, N, strideA, strideB, strideC, batch);
+        return true;
+    }
+};
+
+// Launch of the pointer-array batched kernel
+struct PointerBatchedLaunch {
+    float *const *C;
+    const float *const *A;
+    const float *const *B;
+    int M;
+    int N;
+    int K;
+    int batch;
+    cudaStream_t stream;
+
+    template <int BLOCK_SIZE>
+    bool operator()(IntConstant<BLOCK_SIZE>) const {
+        dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+        dim3 grid = BatchedGrid(M, N, batch, BLOCK_SIZE);
+        MatrixMulBatchedCUDA<BLOCK_SIZE> <<< grid, threads, 0, stream >>>(
+            C, A, B, M, K, N, batch);
+        return true;
+    }
+};
+
+bool MatrixMulStridedBatched(float *C, const float *A, const float *B,
+                             int M, int N, int K, long long strideA,
+                             long long strideB, long long strideC, int batch,
+                             int block_size, cudaStream_t stream) {
+    if (batch <= 0) {
+        return true;
+    }
+
+    StridedBatchedLaunch op = {C, A, B, M, N, K, strideA, strideB, strideC,
+                               batch, stream};
+    return DispatchInt(TiledBlockSizes(), block_size, &op);
+}
+
+bool MatrixMulBatched(float *const *C, const float *const *A,
+                      const float *const *B, int M, int N, int K, int batch,
+                      int block_size, cudaStream_t stream) {
+    if (batch <= 0) {
+        return true;
+    }
+
+    PointerBatchedLaunch op = {C, A, B, M, N, K, batch, stream};
+    return DispatchInt(TiledBlockSizes(), block_size, &op);
+}
@@ -0,0 +1,37 @@
+/**
+ * Batched matrix multiplication: many independent problems of the same
+ * shape in one launch.
+ *
+ * All matrices are row-major; C[i] is M x N, A[i] is M x K and B[i] is
+ * K x N. The kernels are the MatrixMulCUDA tiling with the batch index in
+ * blockIdx.z, so small problems are not dominated by launch overhead.
+ */
+
+#ifndef MATMUL_BATCHED_H_
+#define MATMUL_BATCHED_H_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Largest grid extent in z; bigger batches are covered in several passes
+#define MATMUL_MAX_GRID_Z 65535
+
+/**
+ * C + i * strideC = (A + i * strideA) * (B + i * strideB) for i < batch,
+ * with block_size 16 or 32. Returns false for any other block_size.
+ */
+bool MatrixMulStridedBatched(float *C, const float *A, const float *B,
+                             int M, int N, int K, long long strideA,
+                             long long strideB, long long strideC, int batch,
+                             int block_size, cudaStream_t stream);
+
+/**
+ * C[i] = A[i] * B[i] for i < batch, where C, A and B are device arrays of
+ * device pointers, with block_size 16 or 32. Returns false for any other
+ * block_size.
+ */
+bool MatrixMulBatched(float *const *C, const float *const *A,
+                      const float *const *B, int M, int N, int K, int batch,
+                      int block_size, cudaStream_t stream);
+
+#endif  // MATMUL_BATCHED_H_
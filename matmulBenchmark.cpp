@@ -0,0 +1,843 @@
+/**
+ * Matrix multiplication benchmark: C = A * B.
+ * Host code.
+ *
+ * Runs every registered kernel (see kernelRegistry.cpp) over a sweep of
+ * problem sizes and block sizes, checks the result and reports the median,
+ * 5th and 95th percentile of the per-launch time together with GFlop/s and
+ * effective bandwidth. Results can also be written as CSV or JSON so that
+ * runs of different driver versions or GPUs can be diffed.
+ *
+ * With -autotune only the fastest of the selected kernels is benchmarked
+ * for every problem size and pair of element types; winners are cached
+ * per device (see autotune.h).
+ *
+ * The other modes (-verify, -batch, -server, ...) live in their own
+ * benchmark*.cpp files and are looked up by flag in kModes below.
+ */
+
+// System includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Helper functions and utilities to work with CUDA
+#include <helper_functions.h>
+#include <helper_cuda.h>
+
+#include "autotune.h"
+#include "bankConflicts.h"
+#include "benchmarkCommon.h"
+#include "benchmarkModes.h"
+#include "kernelRegistry.h"
+#include "kernelTiming.h"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+#include "phaseTimer.h"
+
+struct BenchmarkResult {
+    const KernelEntry *kernel;
+    ProblemSize size;
+    TimingStats stats;
+    double gigaFlops;
+    double gigaBytes;
+    bool correct;
+
+    // Modelled shared memory bank conflicts per block and k-step,
+    // -1 if the kernel has no layout to model
+    long bankConflicts;
+
+    // Resident warps per SM as a fraction of the most the SM holds: the
+    // limit of the kernel's resources, and that limit averaged over the
+    // waves of its grid (a partial last wave leaves SMs idle)
+    double theoreticalOccupancy;
+    double waveOccupancy;
+
+    // Flops per byte of the minimum traffic, and GFlop/s as a fraction of
+    // what the roofline allows at that intensity
+    double intensity;
+    double rooflineFraction;
+};
+
+struct DeviceInfo {
+    char name[256];
+    int major;
+    int minor;
+    int multiProcessorCount;
+
+    // Roofline of the device: fp32 CUDA core peak and DRAM bandwidth
+    int maxThreadsPerSm;
+    double peakGigaFlops;
+    double peakGigaBytes;
+};
+
+/**
+ * Parse "n" (square) or "MxNxK" items of a comma separated list
+ */
+static bool ParseSizes(const char *list, std::vector<ProblemSize> *sizes) {
+    std::vector<std::string> items = SplitList(list);
+
+    for (size_t i = 0; i < items.size(); i++) {
+        ProblemSize size;
+        int n = sscanf(items[i].c_str(), "%dx%dx%d", &size.M, &size.N,
+                       &size.K);
+
+        if (n == 1) {
+            size.N = size.K = size.M;
+        } else if (n != 3) {
+            return false;
+        }
+
+        if (size.M <= 0 || size.N <= 0 || size.K <= 0) {
+            return false;
+        }
+
+        sizes->push_back(size);
+    }
+
+    return !sizes->empty();
+}
+
+/**
+ * Replace kernels by the fastest kernel of every pair of element types
+ * among them, from the cache if it has the problem, else by searching
+ */
+static void AutotuneKernels(const DeviceInfo &device, const ProblemSize &size,
+                            const char *cachePath,
+                            std::vector<TuneRecord> *cache,
+                            std::vector<const KernelEntry *> *kernels,
+                            void *d_C, void *d_A, void *d_B, const float *h_A,
+                            const float *h_B, void *h_staging,
+                            int *loadedType) {
+    std::vector<const KernelEntry *> winners;
+    std::vector<bool> done(kernels->size(), false);
+    std::string fingerprint = RegistryFingerprint();
+    int arch = device.major * 10 + device.minor;
+    int count;
+    const KernelEntry *registry = GetKernelRegistry(&count);
+
+    for (size_t i = 0; i < kernels->size(); i++) {
+        if (done[i]) {
+            continue;
+        }
+
+        TuneRecord key;
+        key.device = device.name;
+        key.major = device.major;
+        key.minor = device.minor;
+        key.M = size.M;
+        key.N = size.N;
+        key.K = size.K;
+        key.inType = (*kernels)[i]->inType;
+        key.outType = (*kernels)[i]->outType;
+        key.registry = fingerprint;
+
+        std::vector<const KernelEntry *> candidates;
+
+        for (size_t j = i; j < kernels->size(); j++) {
+            if ((*kernels)[j]->inType == key.inType &&
+                    (*kernels)[j]->outType == key.outType) {
+                candidates.push_back((*kernels)[j]);
+                done[j] = true;
+            }
+        }
+
+        // -kernel and -block may have left out some of the kernels that
+        // run on the device
+        size_t runnable = 0;
+
+        for (int j = 0; j < count; j++) {
+            if (registry[j].inType == key.inType &&
+                    registry[j].outType == key.outType &&
+                    registry[j].minArch <= arch) {
+                runnable++;
+            }
+        }
+
+        bool narrowed = candidates.size() < runnable;
+
+        // A cached winner is only used if it is among the candidates, so
+        // that -kernel and -block still restrict the choice
+        const TuneRecord *hit = FindTuneRecord(*cache, key);
+        const KernelEntry *best = NULL;
+
+        if (hit != NULL) {
+            const KernelEntry *cached = FindKernel(hit->kernel.c_str(),
+                                                   hit->block_size);
+
+            for (size_t j = 0; j < candidates.size(); j++) {
+                if (candidates[j] == cached) {
+                    best = cached;
+                }
+            }
+        }
+
+        if (best != NULL) {
+            printf("autotune %s -> %s: %s block %d (cached, %.4f ms)\n",
+                   MatmulTypeName(key.inType), MatmulTypeName(key.outType),
+                   best->name, best->block_size, hit->median_ms);
+        } else {
+            UploadInputs(key.inType, h_A, h_B, h_staging, d_A, d_B,
+                         size.M * size.K, size.K * size.N, loadedType);
+
+            StopWatchInterface *timer = NULL;
+            sdkCreateTimer(&timer);
+            sdkStartTimer(&timer);
+            best = AutotuneSearch(candidates, d_C, d_A, d_B, size.M, size.N,
+                                  size.K, &key.median_ms);
+            sdkStopTimer(&timer);
+
+            printf("autotune %s -> %s: %s block %d (searched %d kernels in"
+                   " %.1f ms%s)\n", MatmulTypeName(key.inType),
+                   MatmulTypeName(key.outType), best->name, best->block_size,
+                   static_cast<int>(candidates.size()),
+                   sdkGetTimerValue(&timer), narrowed ? ", not cached" : "");
+            sdkDeleteTimer(&timer);
+
+            // The winner of a narrowed search need not be the best kernel
+            // for the problem, so only full searches are cached
+            if (!narrowed) {
+                key.kernel = best->name;
+                key.block_size = best->block_size;
+                cache->push_back(key);
+                AppendTuneRecord(cachePath, key);
+            }
+        }
+
+        winners.push_back(best);
+    }
+
+    kernels->swap(winners);
+}
+
+/**
+ * Fill in the occupancy and roofline position of result, whose GFlop/s and
+ * GB/s are known
+ */
+static void ModelLaunch(const DeviceInfo &device, const KernelEntry *kernel,
+                        BenchmarkResult *result) {
+    const ProblemSize &size = result->size;
+    KernelLaunchInfo info;
+    result->theoreticalOccupancy = 0.0;
+    result->waveOccupancy = 0.0;
+
+    if (kernel->info(size.M, size.N, size.K, &info) == cudaSuccess &&
+            info.blocksPerSm > 0) {
+        int threads = info.threads.x * info.threads.y * info.threads.z;
+        int warps = (threads + 31) / 32;
+        double blocks = static_cast<double>(info.grid.x) * info.grid.y *
+                        info.grid.z;
+        double wave = static_cast<double>(info.blocksPerSm) *
+                      device.multiProcessorCount;
+        double waves = ceil(blocks / wave);
+        result->theoreticalOccupancy = info.blocksPerSm * warps * 32.0 /
+                                       device.maxThreadsPerSm;
+        result->waveOccupancy = result->theoreticalOccupancy * blocks /
+                                (waves * wave);
+    }
+
+    // The gigaFlops over gigaBytes ratio is flops per byte moved
+    result->intensity = result->gigaFlops / result->gigaBytes;
+    double roof = result->intensity * device.peakGigaBytes;
+    roof = roof < device.peakGigaFlops ? roof : device.peakGigaFlops;
+    result->rooflineFraction = roof > 0.0 ? result->gigaFlops / roof : 0.0;
+}
+
+/**
+ * Benchmark one kernel on one problem; d_A and d_B already hold the inputs
+ * converted to kernel->inType. The launches, the copy of C and the check
+ * are timed as phases of phases.
+ */
+static BenchmarkResult RunKernel(const DeviceInfo &device,
+                                 const KernelEntry *kernel,
+                                 const ProblemSize &size, void *d_C,
+                                 const void *d_A, const void *d_B,
+                                 float *h_C, void *h_staging, float valB,
+                                 int warmup, int iters, PhaseTimer *phases) {
+    BenchmarkResult result;
+    result.kernel = kernel;
+    result.size = size;
+
+    // Named after the kernel, so that Nsight can pick out its launches
+    char range[64];
+    snprintf(range, sizeof(range), "%s/%d/%dx%dx%d", kernel->name,
+             kernel->block_size, size.M, size.N, size.K);
+
+    std::vector<float> times;
+    checkCudaErrors(PhaseBegin(phases, PHASE_KERNEL, range));
+    TimeKernelLaunches(kernel, d_C, d_A, d_B, size.M, size.N, size.K,
+                       warmup, iters, 0, &times);
+    checkCudaErrors(PhaseEnd(phases));
+    result.stats = SummarizeTimes(times);
+
+    // Flops and the minimum traffic of one read of A and B and one write of C
+    double flopsPerMatrixMul = 2.0 * static_cast<double>(size.M) *
+                               static_cast<double>(size.N) *
+                               static_cast<double>(size.K);
+    double bytesPerMatrixMul =
+        (static_cast<double>(size.M) * size.K +
+         static_cast<double>(size.K) * size.N) *
+        MatmulTypeSize(kernel->inType) +
+        static_cast<double>(size.M) * size.N * MatmulTypeSize(kernel->outType);
+    double seconds = result.stats.median_ms / 1000.0;
+    result.gigaFlops = flopsPerMatrixMul * 1.0e-9 / seconds;
+    result.gigaBytes = bytesPerMatrixMul * 1.0e-9 / seconds;
+
+    // Every element of C is the dot product of K rounded ones and valBs
+    int size_C = size.M * size.N;
+    checkCudaErrors(PhaseBegin(phases, PHASE_D2H));
+    checkCudaErrors(cudaMemcpyAsync(h_staging, d_C,
+                                    size_C * MatmulTypeSize(kernel->outType),
+                                    cudaMemcpyDeviceToHost, 0));
+    checkCudaErrors(PhaseEnd(phases));
+    checkCudaErrors(cudaStreamSynchronize(0));
+
+    checkCudaErrors(PhaseBegin(phases, PHASE_VERIFY));
+    ConvertToFloat(kernel->outType, h_staging, h_C, size_C);
+
+    double ref = static_cast<double>(size.K) *
+                 RoundToType(kernel->inType, 1.0f) *
+                 RoundToType(kernel->inType, valB);
+    double eps = UnitRoundoff(kernel->outType) +
+                 (size.K + 1) * UnitRoundoff(MATMUL_FP32) +
+                 ComputeRoundoff(kernel->compute);
+    result.correct = CheckResult(h_C, size_C, static_cast<float>(ref), eps);
+    checkCudaErrors(PhaseEnd(phases));
+
+    BankConflictStats banks;
+    result.bankConflicts = SimulateBankConflicts(kernel, &banks) ?
+                           banks.wavefronts - banks.requests : -1;
+    ModelLaunch(device, kernel, &result);
+
+    return result;
+}
+
+static void WriteCsv(FILE *f, const DeviceInfo &device,
+                     const std::vector<BenchmarkResult> &results) {
+    fprintf(f, "device,cc,kernel,block,in,out,M,N,K,iters,median_ms,p5_ms,"
+               "p95_ms,gflops,gbps,correct,layout,bank_conflicts,"
+               "occupancy,wave_occupancy,intensity,roofline\n");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult &r = results[i];
+        fprintf(f, "\"%s\",%d.%d,%s,%d,%s,%s,%d,%d,%d,%d,%.6f,%.6f,%.6f,"
+                   "%.3f,%.3f,%d,%s,%ld,%.3f,%.3f,%.3f,%.3f\n",
+                device.name, device.major, device.minor, r.kernel->name,
+                r.kernel->block_size, MatmulTypeName(r.kernel->inType),
+                MatmulTypeName(r.kernel->outType), r.size.M, r.size.N,
+                r.size.K, r.stats.iters, r.stats.median_ms, r.stats.p5_ms,
+                r.stats.p95_ms, r.gigaFlops, r.gigaBytes, r.correct ? 1 : 0,
+                SmemLayoutName(r.kernel->layout), r.bankConflicts,
+                r.theoreticalOccupancy, r.waveOccupancy, r.intensity,
+                r.rooflineFraction);
+    }
+}
+
+static void WriteJson(FILE *f, const DeviceInfo &device,
+                      const std::vector<BenchmarkResult> &results) {
+    fprintf(f, "{\n  \"device\": {\"name\": \"%s\", \"cc\": \"%d.%d\", "
+               "\"sms\": %d},\n  \"results\": [",
+            device.name, device.major, device.minor,
+            device.multiProcessorCount);
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult &r = results[i];
+        fprintf(f, "%s\n    {\"kernel\": \"%s\", \"block\": %d, "
+                   "\"in\": \"%s\", \"out\": \"%s\", "
+                   "\"M\": %d, \"N\": %d, \"K\": %d, \"iters\": %d, "
+                   "\"median_ms\": %.6f, \"p5_ms\": %.6f, \"p95_ms\": %.6f, "
+                   "\"gflops\": %.3f, \"gbps\": %.3f, \"correct\": %s, "
+                   "\"layout\": \"%s\", \"bank_conflicts\": %ld, "
+                   "\"occupancy\": %.3f, \"wave_occupancy\": %.3f, "
+                   "\"intensity\": %.3f, \"roofline\": %.3f}",
+                i == 0 ? "" : ",", r.kernel->name, r.kernel->block_size,
+                MatmulTypeName(r.kernel->inType),
+                MatmulTypeName(r.kernel->outType), r.size.M, r.size.N,
+                r.size.K, r.stats.iters, r.stats.median_ms, r.stats.p5_ms,
+                r.stats.p95_ms, r.gigaFlops, r.gigaBytes,
+                r.correct ? "true" : "false",
+                SmemLayoutName(r.kernel->layout), r.bankConflicts,
+                r.theoreticalOccupancy, r.waveOccupancy, r.intensity,
+                r.rooflineFraction);
+    }
+
+    fprintf(f, "\n  ]\n}\n");
+}
+
+/**
+ * Write the results with writer to the file named by the command line
+ * option flag, if it is given
+ */
+static void WriteReport(int argc, char **argv, const char *flag,
+                        void (*writer)(FILE *, const DeviceInfo &,
+                                       const std::vector<BenchmarkResult> &),
+                        const DeviceInfo &device,
+                        const std::vector<BenchmarkResult> &results) {
+    char *path = NULL;
+
+    if (!getCmdLineArgumentString(argc, (const char **)argv, flag, &path)) {
+        return;
+    }
+
+    FILE *f = fopen(path, "w");
+
+    if (f == NULL) {
+        fprintf(stderr, "Failed to open %s for writing!\n", path);
+        return;
+    }
+
+    writer(f, device, results);
+    fclose(f);
+    printf("Wrote %s\n", path);
+}
+
+/**
+ * Shared memory bank conflicts of every kernel selected by -kernel and
+ * -block that has a layout to model, per block and k-step
+ */
+static void PrintBankConflicts(int argc, char **argv,
+                               const KernelEntry *registry, int count) {
+    char *arg = NULL;
+    std::vector<std::string> kernelNames;
+    std::vector<std::string> blockSizes;
+
+    if (getCmdLineArgumentString(argc, (const char **)argv, "kernel", &arg)) {
+        kernelNames = SplitList(arg);
+    }
+
+    if (getCmdLineArgumentString(argc, (const char **)argv, "block", &arg)) {
+        blockSizes = SplitList(arg);
+    }
+
+    printf("%-22s %5s %-10s %9s %10s %9s\n", "kernel", "block", "layout",
+           "requests", "wavefronts", "conflicts");
+
+    for (int i = 0; i < count; i++) {
+        const KernelEntry *kernel = &registry[i];
+        char blockName[16];
+        snprintf(blockName, sizeof(blockName), "%d", kernel->block_size);
+        BankConflictStats banks;
+
+        if (!InList(kernelNames, kernel->name) ||
+                !InList(blockSizes, blockName) ||
+                !SimulateBankConflicts(kernel, &banks)) {
+            continue;
+        }
+
+        printf("%-22s %5d %-10s %9ld %10ld %9ld\n", kernel->name,
+               kernel->block_size, SmemLayoutName(kernel->layout),
+               banks.requests, banks.wavefronts,
+               banks.wavefronts - banks.requests);
+    }
+}
+
+// Modes that replace the kernel sweep, looked up by flag in this order
+struct BenchmarkMode {
+    const char *flag;
+    BenchmarkModeFn run;
+};
+
+static const BenchmarkMode kModes[] = {
+    {"verify", BenchmarkVerify},
+    {"compute", BenchmarkCompute},
+    {"int8", BenchmarkInt8},
+    {"sparse", BenchmarkSparse},
+    {"strassen", BenchmarkStrassen},
+    {"jit", BenchmarkJit},
+    {"batch", BenchmarkBatched},
+    {"layouts", BenchmarkLayouts},
+    {"epilogue", BenchmarkEpilogue},
+    {"calls", BenchmarkCalls},
+    {"serverfault", BenchmarkServerFault},
+    {"server", BenchmarkServer},
+    {"inputs", BenchmarkInputs},
+    {"graph", BenchmarkGraph},
+    {"load", BenchmarkMatrixFiles},
+    {"outofcore", BenchmarkOutOfCore},
+    {"multigpu", BenchmarkMultiGpu},
+};
+
+// Cache of the autotuner when -tunecache is not given
+static const char *kDefaultTuneCache = "matmulAutotune.tsv";
+
+static void PrintUsage() {
+    printf("Usage -device=n (n >= 0 for deviceID)\n");
+    printf("      -list (print the registered kernels and exit)\n");
+    printf("      -kernel=name[,name...] (default: all kernels)\n");
+    printf("      -block=n[,n...] (block sizes to run, default: all)\n");
+    printf("      -sizes=s[,s...] (s is n for a square problem or MxNxK)\n");
+    printf("      -wA=WidthA -hA=HeightA -wB=WidthB (single problem,"
+           " instead of -sizes)\n");
+    printf("      -iters=n (timed launches per kernel, default 300)\n");
+    printf("      -warmup=n (untimed launches per kernel, default 3)\n");
+    printf("      -csv=file -json=file (write the results)\n");
+    printf("      -banks (print the modelled shared memory bank conflicts"
+           " and exit)\n");
+    printf("      -batch=n (compare n single launches of the sample kernel"
+           " with batched ones)\n");
+    printf("      -epilogue[=relu|gelu|none] (fused vs. separate"
+           " alpha/beta, bias and activation)\n");
+    printf("      -layouts -pad=n (NN/NT/TN/TT with leading dimensions n"
+           " longer than the rows)\n");
+    printf("      -calls=n (n host-to-host calls per size, per-call"
+           " allocation vs. library handle)\n");
+    printf("      -streams=n -panel=rows (pipeline of -calls, default %d"
+           " streams)\n", MATMUL_PIPELINE_STREAMS);
+    printf("      -server[=threads] -requests=n -streams=n -maxbatch=n"
+           " -budget=us (blocking calls vs. batching server)\n");
+    printf("      -serverfault (a server batch that faults on the device"
+           " fails its requests)\n");
+    printf("      -inputs[=calls] -seed=s (host inputs used once: staged"
+           " vs. mapped vs. managed)\n");
+    printf("      -graph (eager launches vs. CUDA graph replay of a"
+           " copy/GEMM/epilogue plan)\n");
+    printf("      -outofcore (tile the problem through limited device"
+           " memory)\n");
+    printf("      -oocmem=MB -mmap=dir (device memory of -outofcore, and"
+           " files for A, B, C)\n");
+    printf("      -load=A,B -save=C (operands from matrix files, C to one;"
+           " with -outofcore)\n");
+    printf("      -multigpu[=n] -tile=edge (split C block-cyclically over"
+           " n devices, default all)\n");
+    printf("      -cpu -threads=n (multithreaded SIMD GEMM on the host, also"
+           " used without a device)\n");
+    printf("      -verify[=n] -seed=s (error statistics of every kernel"
+           " over a sweep and n random shapes)\n");
+    printf("      -compute -seed=s (fp32 GEMM in the fp32, TF32 and 3xTF32"
+           " compute modes)\n");
+    printf("      -int8 -seed=s (int8 GEMM with dequantizing epilogue vs."
+           " fp32, per tensor and channel)\n");
+    printf("      -sparse[=d,d...] -seed=s (CSR, blocked-ELL and 2:4 SpMM"
+           " vs. dense at densities d)\n");
+    printf("      -strassen[=c,c...] -seed=s (Strassen-Winograd at cutoffs"
+           " c vs. the tiled kernel)\n");
+    printf("      -jit[=dir] -seed=s (kernels compiled for the exact shape,"
+           " cubins cached in dir, default %s)\n", BENCHMARK_JIT_CACHE);
+    printf("      -autotune (only run the fastest selected kernel per size"
+           " and types)\n");
+    printf("      -tunecache=file (autotune cache, default %s)\n",
+           kDefaultTuneCache);
+}
+
+/**
+ * Program main
+ */
+int main(int argc, char **argv) {
+    printf("[Matrix Multiply Benchmark Using CUDA] - Starting...\n");
+
+    if (checkCmdLineFlag(argc, (const char **)argv, "help") ||
+            checkCmdLineFlag(argc, (const char **)argv, "?")) {
+        PrintUsage();
+        exit(EXIT_SUCCESS);
+    }
+
+    int count;
+    const KernelEntry *registry = GetKernelRegistry(&count);
+
+    if (checkCmdLineFlag(argc, (const char **)argv, "list")) {
+        for (int i = 0; i < count; i++) {
+            printf("%-20s block %2d tile %d stages %d vec %d  %s -> %s  %s\n",
+                   registry[i].name, registry[i].block_size,
+                   registry[i].thread_tile, registry[i].stages,
+                   registry[i].vec_width, MatmulTypeName(registry[i].inType),
+                   MatmulTypeName(registry[i].outType),
+                   registry[i].description);
+        }
+
+        exit(EXIT_SUCCESS);
+    }
+
+    if (checkCmdLineFlag(argc, (const char **)argv, "banks")) {
+        PrintBankConflicts(argc, argv, registry, count);
+        exit(EXIT_SUCCESS);
+    }
+
+    char *arg = NULL;
+    std::vector<std::string> kernelNames;
+    std::vector<std::string> blockSizes;
+
+    if (getCmdLineArgumentString(argc, (const char **)argv, "kernel", &arg)) {
+        kernelNames = SplitList(arg);
+    }
+
+    if (getCmdLineArgumentString(argc, (const char **)argv, "block", &arg)) {
+        blockSizes = SplitList(arg);
+    }
+
+    // The default problem of the matrixMul sample
+    std::vector<ProblemSize> sizes;
+    ProblemSize single = {320, 640, 320};
+
+    if (getCmdLineArgumentString(argc, (const char **)argv, "sizes", &arg)) {
+        if (!ParseSizes(arg, &sizes)) {
+            printf("Error: cannot parse -sizes=%s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        // height of Matrix A
+        if (checkCmdLineFlag(argc, (const char **)argv, "hA")) {
+            single.M = getCmdLineArgumentInt(argc, (const char **)argv, "hA");
+        }
+
+        // width of Matrix B
+        if (checkCmdLineFlag(argc, (const char **)argv, "wB")) {
+            single.N = getCmdLineArgumentInt(argc, (const char **)argv, "wB");
+        }
+
+        // width of Matrix A
+        if (checkCmdLineFlag(argc, (const char **)argv, "wA")) {
+            single.K = getCmdLineArgumentInt(argc, (const char **)argv, "wA");
+        }
+
+        sizes.push_back(single);
+    }
+
+    int iters = 300;
+    int warmup = 3;
+
+    if (checkCmdLineFlag(argc, (const char **)argv, "iters")) {
+        iters = getCmdLineArgumentInt(argc, (const char **)argv, "iters");
+    }
+
+    if (checkCmdLineFlag(argc, (const char **)argv, "warmup")) {
+        warmup = getCmdLineArgumentInt(argc, (const char **)argv, "warmup");
+    }
+
+    if (iters < 1 || warmup < 0) {
+        printf("Error: need -iters >= 1 and -warmup >= 0\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bool autotune = checkCmdLineFlag(argc, (const char **)argv, "autotune");
+    const char *tuneCachePath = kDefaultTuneCache;
+    std::vector<TuneRecord> tuneCache;
+
+    if (getCmdLineArgumentString(argc, (const char **)argv, "tunecache",
+                                 &arg)) {
+        tuneCachePath = arg;
+    }
+
+    if (autotune) {
+        LoadTuneCache(tuneCachePath, &tuneCache);
+    }
+
+    BenchmarkOptions options;
+    options.argc = argc;
+    options.argv = (const char **)argv;
+    options.sizes = sizes;
+    options.kernelNames = kernelNames;
+    options.blockSizes = blockSizes;
+    options.warmup = warmup;
+    options.iters = iters;
+    options.arch = 0;
+
+    // Without a CUDA device the host GEMM is the only backend
+    int deviceCount = 0;
+    bool noDevice = cudaGetDeviceCount(&deviceCount) != cudaSuccess ||
+                    deviceCount == 0;
+
+    if (noDevice || checkCmdLineFlag(argc, (const char **)argv, "cpu")) {
+        if (noDevice) {
+            printf("No CUDA device found, running the CPU GEMM\n");
+        }
+
+        bool correct = BenchmarkCpu(options);
+        printf("%s\n", correct ? "Result = PASS" : "Result = FAIL");
+        exit(correct ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    // This will pick the best possible CUDA capable device, otherwise
+    // override the device ID based on input provided at the command line
+    int dev = findCudaDevice(argc, (const char **)argv);
+
+    cudaDeviceProp deviceProp;
+    checkCudaErrors(cudaGetDeviceProperties(&deviceProp, dev));
+
+    DeviceInfo device;
+    snprintf(device.name, sizeof(device.name), "%s", deviceProp.name);
+    device.major = deviceProp.major;
+    device.minor = deviceProp.minor;
+    device.multiProcessorCount = deviceProp.multiProcessorCount;
+    int arch = device.major * 10 + device.minor;
+
+    // Clocks in kHz; DDR memory moves data on both edges
+    // (attributes, as cudaDeviceProp no longer has them in CUDA 13)
+    int clockKhz, memClockKhz, busBits;
+    device.maxThreadsPerSm = deviceProp.maxThreadsPerMultiProcessor;
+    checkCudaErrors(cudaDeviceGetAttribute(
+                        &clockKhz, cudaDevAttrClockRate, dev));
+    checkCudaErrors(cudaDeviceGetAttribute(
+                        &memClockKhz, cudaDevAttrMemoryClockRate, dev));
+    checkCudaErrors(cudaDeviceGetAttribute(
+                        &busBits, cudaDevAttrGlobalMemoryBusWidth, dev));
+    device.peakGigaFlops = 2.0 * device.multiProcessorCount *
+                           _ConvertSMVer2Cores(device.major, device.minor) *
+                           clockKhz * 1.0e-6;
+    device.peakGigaBytes = 2.0 * memClockKhz * (busBits / 8) * 1.0e-6;
+
+    printf("Device \"%s\" with compute capability %d.%d, %d SMs\n",
+           device.name, device.major, device.minor,
+           device.multiProcessorCount);
+    printf("Roofline: %.0f GFlop/s fp32, %.0f GB/s, ridge at %.1f"
+           " flop/byte\n", device.peakGigaFlops, device.peakGigaBytes,
+           device.peakGigaFlops / device.peakGigaBytes);
+
+    // A device without SASS it can run in the fat binary JIT-compiles the
+    // PTX of every kernel on first use, which is then in the timings
+    KernelImage image;
+    checkCudaErrors(GetKernelImage(&image));
+    printf("Kernels: sm_%d code (PTX %d), built for", image.binaryArch,
+           image.ptxArch);
+
+    for (int i = 0; i < image.builtCount; i++) {
+        printf(" %d", image.builtArchs[i]);
+    }
+
+    printf(image.builtCount == 0 ? " unknown\n" : "\n");
+
+    if (image.jit) {
+        printf("Warning: sm_%d code was JIT-compiled from PTX %d; build"
+               " with -gencode arch=compute_%d,code=sm_%d to avoid it\n",
+               image.deviceArch, image.ptxArch, image.deviceArch,
+               image.deviceArch);
+    }
+
+    options.arch = arch;
+
+    for (size_t i = 0; i < sizeof(kModes) / sizeof(kModes[0]); i++) {
+        if (checkCmdLineFlag(argc, (const char **)argv, kModes[i].flag)) {
+            bool correct = kModes[i].run(options);
+            printf("%s\n", correct ? "Result = PASS" : "Result = FAIL");
+            exit(correct ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    const float valB = 0.01f;
+    bool allCorrect = true;
+
+    PhaseTimer phases;
+    checkCudaErrors(PhaseTimerCreate(&phases, 0));
+
+    printf("%-20s %5s %6s %6s %6s %10s %10s %10s %10s %10s %5s %5s %6s %5s"
+           " %s\n", "kernel", "block", "M", "N", "K", "median_ms", "p5_ms",
+           "p95_ms", "GFlop/s", "GB/s", "occ%", "wave%", "flop/B", "roof%",
+           "check");
+
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const ProblemSize &size = sizes[s];
+        int size_A = size.M * size.K;
+        int size_B = size.K * size.N;
+        int size_C = size.M * size.N;
+
+        // Host matrices in fp32, and a staging buffer large enough for
+        // any of them in any element type
+        checkCudaErrors(PhaseBegin(&phases, PHASE_ALLOC));
+        int size_max = size_A > size_B ? size_A : size_B;
+        size_max = size_max > size_C ? size_max : size_C;
+        float *h_A = reinterpret_cast<float *>(malloc(sizeof(float) * size_A));
+        float *h_B = reinterpret_cast<float *>(malloc(sizeof(float) * size_B));
+        float *h_C = reinterpret_cast<float *>(malloc(sizeof(float) * size_C));
+        void *h_staging = malloc(sizeof(float) * size_max);
+
+        if (h_A == NULL || h_B == NULL || h_C == NULL || h_staging == NULL) {
+            fprintf(stderr, "Failed to allocate host matrices!\n");
+            exit(EXIT_FAILURE);
+        }
+
+        ConstantInit(h_A, size_A, 1.0f);
+        ConstantInit(h_B, size_B, valB);
+
+        void *d_A, *d_B, *d_C;
+        checkCudaErrors(cudaMalloc(&d_A, sizeof(float) * size_A));
+        checkCudaErrors(cudaMalloc(&d_B, sizeof(float) * size_B));
+        checkCudaErrors(cudaMalloc(&d_C, sizeof(float) * size_C));
+        checkCudaErrors(PhaseEnd(&phases));
+
+        // Inputs are only converted and copied again when the element
+        // type changes; -1 means nothing has been copied yet
+        int loadedType = -1;
+
+        std::vector<const KernelEntry *> kernels;
+
+        for (int i = 0; i < count; i++) {
+            const KernelEntry *kernel = &registry[i];
+            char blockName[16];
+            snprintf(blockName, sizeof(blockName), "%d", kernel->block_size);
+
+            if (!InList(kernelNames, kernel->name) ||
+                    !InList(blockSizes, blockName)) {
+                continue;
+            }
+
+            if (kernel->minArch > arch) {
+                printf("%-20s %5d skipped, needs compute capability %d.%d\n",
+                       kernel->name, kernel->block_size, kernel->minArch / 10,
+                       kernel->minArch % 10);
+                continue;
+            }
+
+            kernels.push_back(kernel);
+        }
+
+        if (autotune) {
+            AutotuneKernels(device, size, tuneCachePath, &tuneCache,
+                            &kernels, d_C, d_A, d_B, h_A, h_B, h_staging,
+                            &loadedType);
+        }
+
+        for (size_t i = 0; i < kernels.size(); i++) {
+            const KernelEntry *kernel = kernels[i];
+
+            if (loadedType != kernel->inType) {
+                checkCudaErrors(PhaseBegin(&phases, PHASE_H2D));
+                UploadInputs(kernel->inType, h_A, h_B, h_staging, d_A, d_B,
+                             size_A, size_B, &loadedType);
+                checkCudaErrors(PhaseEnd(&phases));
+            }
+
+            BenchmarkResult r = RunKernel(device, kernel, size, d_C, d_A,
+                                          d_B, h_C, h_staging, valB, warmup,
+                                          iters, &phases);
+            results.push_back(r);
+            allCorrect = allCorrect && r.correct;
+
+            printf("%-20s %5d %6d %6d %6d %10.4f %10.4f %10.4f %10.2f %10.2f"
+                   " %5.1f %5.1f %6.1f %5.1f %s\n", kernel->name,
+                   kernel->block_size, size.M, size.N, size.K,
+                   r.stats.median_ms, r.stats.p5_ms, r.stats.p95_ms,
+                   r.gigaFlops, r.gigaBytes, 100.0 * r.theoreticalOccupancy,
+                   100.0 * r.waveOccupancy, r.intensity,
+                   100.0 * r.rooflineFraction, r.correct ? "PASS" : "FAIL");
+        }
+
+        // Clean up memory
+        free(h_A);
+        free(h_B);
+        free(h_C);
+        free(h_staging);
+        checkCudaErrors(cudaFree(d_A));
+        checkCudaErrors(cudaFree(d_B));
+        checkCudaErrors(cudaFree(d_C));
+    }
+
+    checkCudaErrors(PhaseTimerFlush(&phases));
+    printf("\n");
+    PrintPhases(phases);
+    checkCudaErrors(PhaseTimerDestroy(&phases));
+
+    WriteReport(argc, argv, "csv", WriteCsv, device, results);
+    WriteReport(argc, argv, "json", WriteJson, device, results);
+
+    printf("%s\n", allCorrect ? "Result = PASS" : "Result = FAIL");
+
+    printf("\nNOTE: The CUDA Samples are not meant for performance"\
+           "measurements. Results may vary when GPU Boost is enabled.\n");
+
+    exit(allCorrect ? EXIT_SUCCESS : EXIT_FAILURE);
+}
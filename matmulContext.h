@@ -0,0 +1,104 @@
+/**
+ * State behind a MatmulHandle, shared by the translation units of the
+ * library. Not part of the public interface (see matmulLibrary.h).
+ */
+
+#ifndef MATMUL_CONTEXT_H_
+#define MATMUL_CONTEXT_H_
+
+// System includes
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "deviceAllocator.h"
+#include "kernelRegistry.h"
+#include "matmulLibrary.h"
+
+// Pinned host buffer that only ever grows
+struct PinnedBuffer {
+    void *ptr;
+    size_t bytes;
+};
+
+// Indices into MatmulContext::pinned: the staging buffer of
+// MatmulMultiplyHost, all of B, and per pipeline slot s the current
+// panels or blocks of A, C and B
+#define MATMUL_PINNED_STAGING 0
+#define MATMUL_PINNED_B 1
+#define MATMUL_PINNED_A_PANEL(s) (2 + 3 * (s))
+#define MATMUL_PINNED_C_PANEL(s) (3 + 3 * (s))
+#define MATMUL_PINNED_B_PANEL(s) (4 + 3 * (s))
+
+struct MatmulContext {
+    int device;
+    int arch;
+
+    // The handle's own stream, and the one work is issued into
+    cudaStream_t ownStream;
+    cudaStream_t stream;
+
+    const KernelEntry *kernel;
+    DeviceAllocator pool;
+
+    // Pinned buffers for conversions and for the panel pipeline
+    std::vector<PinnedBuffer> pinned;
+
+    // Panel pipeline: number of streams and rows of C per panel (0 picks
+    // a size from M), the streams and an event per stream marking the
+    // completion of its last panel
+    int pipelineStreams;
+    int panelRows;
+    std::vector<cudaStream_t> pipeStreams;
+    std::vector<cudaEvent_t> pipeEvents;
+
+    // Device buffers of pipelines and kernel workspaces recorded in the
+    // capture under way; MatmulCaptureEnd hands them to the graph, which
+    // replays them
+    std::vector<void *> graphBuffers;
+
+    // Device memory the out-of-core mode may use, 0 for most of the
+    // free memory
+    size_t outOfCoreBytes;
+
+    // Largest dimension MatmulMultiplyStrassen hands to the tiled kernel
+    int strassenCutoff;
+
+    // Where MatmulMultiplyHost reads A and B from
+    MatmulInputMode inputMode;
+};
+
+// Return the error of call from the enclosing function, if any
+#define MATMUL_TRY(call)                        \
+    do {                                        \
+        cudaError_t err_ = (call);              \
+        if (err_ != cudaSuccess) return err_;   \
+    } while (0)
+
+/**
+ * Grow pinned buffer index of ctx to at least bytes, waiting for all work
+ * of ctx first if it has to be reallocated
+ */
+cudaError_t ReservePinned(MatmulContext *ctx, size_t index, size_t bytes);
+
+/**
+ * Create pipeline streams (and their events) of ctx up to streams
+ */
+cudaError_t ReservePipelineStreams(MatmulContext *ctx, int streams);
+
+/**
+ * Wait for the work of ctx on its stream and its pipeline streams
+ */
+cudaError_t SynchronizeContext(MatmulContext *ctx);
+
+/**
+ * Queue kernel on an M x N x K problem in stream, with the workspace it
+ * needs from the pool of ctx. In a capture the graph keeps the workspace
+ * (see graphBuffers), otherwise it goes back to the pool once queued.
+ */
+cudaError_t LaunchKernel(MatmulContext *ctx, const KernelEntry *kernel,
+                         void *d_C, const void *d_A, const void *d_B, int M,
+                         int N, int K, cudaStream_t stream);
+
+#endif  // MATMUL_CONTEXT_H_
@@ -0,0 +1,160 @@
+/**
+ * Matrix multiplication with a fused epilogue.
+ *
+ * The run-time MatmulEpilogue is turned into one of the LinearEpilogue
+ * types by DispatchEpilogue, which then hands it to a launch functor; all
+ * combinations of output type, bias mode and activation are instantiated.
+ */
+
+#include "kernelDispatch.h"
+#include "matmulEpilogue.h"
+#include "matmulKernels.cuh"
+
+// Elements of C per thread along each side, and width of the accesses
+#define EPILOGUE_TILE 4
+#define EPILOGUE_VEC 4
+
+template <int BIAS, typename OutT, typename Op>
+static bool DispatchActivation(const MatmulEpilogue &e, Op *op) {
+    switch (e.activation) {
+    case EPILOGUE_ACT_NONE: {
+        LinearEpilogue<BIAS, EPILOGUE_ACT_NONE, OutT> ep = {
+            e.alpha, e.beta, e.bias
+        };
+        return (*op)(ep);
+    }
+
+    case EPILOGUE_ACT_RELU: {
+        LinearEpilogue<BIAS, EPILOGUE_ACT_RELU, OutT> ep = {
+            e.alpha, e.beta, e.bias
+        };
+        return (*op)(ep);
+    }
+
+    case EPILOGUE_ACT_GELU: {
+        LinearEpilogue<BIAS, EPILOGUE_ACT_GELU, OutT> ep = {
+            e.alpha, e.beta, e.bias
+        };
+        return (*op)(ep);
+    }
+
+    default:
+        return false;
+    }
+}
+
+template <typename OutT, typename Op>
+static bool DispatchBias(const MatmulEpilogue &e, Op *op) {
+    if (e.biasMode != EPILOGUE_BIAS_NONE && e.bias == NULL) {
+        return false;
+    }
+
+    switch (e.biasMode) {
+    case EPILOGUE_BIAS_NONE:
+        return DispatchActivation<EPILOGUE_BIAS_NONE, OutT>(e, op);
+
+    case EPILOGUE_BIAS_ROW:
+        return DispatchActivation<EPILOGUE_BIAS_ROW, OutT>(e, op);
+
+    case EPILOGUE_BIAS_COL:
+        return DispatchActivation<EPILOGUE_BIAS_COL, OutT>(e, op);
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Call (*op)(ep) with the LinearEpilogue ep described by e; returns what
+ * op returns, or false if e is invalid
+ */
+template <typename Op>
+static bool DispatchEpilogue(const MatmulEpilogue &e, Op *op) {
+    switch (e.outType) {
+    case MATMUL_FP32:
+        return DispatchBias<float>(e, op);
+
+    case MATMUL_FP16:
+        return DispatchBias<half>(e, op);
+
+    case MATMUL_BF16:
+        return DispatchBias<__nv_bfloat16>(e, op);
+
+    default:
+        return false;
+    }
+}
+
+template <typename EPILOGUE> struct FusedBlockLaunch;
+
+// Launch of the register-blocked kernel with a fused epilogue
+struct FusedLaunch {
+    void *C;
+    const float *A;
+    const float *B;
+    int M;
+    int N;
+    int K;
+    int block_size;
+    cudaStream_t stream;
+
+    template <int BLOCK_SIZE, typename EPILOGUE>
+    void Launch(const EPILOGUE &ep) const {
+        const int edge = BLOCK_SIZE * EPILOGUE_TILE;
+        dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+        dim3 grid((N + edge - 1) / edge, (M + edge - 1) / edge);
+        MatrixMulRegTileCUDA<BLOCK_SIZE, EPILOGUE_TILE, EPILOGUE_TILE,
+                             EPILOGUE_VEC, EPILOGUE>
+            <<< grid, threads, 0, stream >>>(
+            static_cast<typename EPILOGUE::Output *>(C), A, B, M, K, N, ep);
+    }
+
+    template <typename EPILOGUE> bool operator()(const EPILOGUE &ep) const {
+        FusedBlockLaunch<EPILOGUE> op = {this, &ep};
+        return DispatchInt(TiledBlockSizes(), block_size, &op);
+    }
+};
+
+// FusedLaunch of the epilogue ep for one block size
+template <typename EPILOGUE> struct FusedBlockLaunch {
+    const FusedLaunch *launch;
+    const EPILOGUE *ep;
+
+    template <int BLOCK_SIZE>
+    bool operator()(IntConstant<BLOCK_SIZE>) const {
+        launch->Launch<BLOCK_SIZE>(*ep);
+        return true;
+    }
+};
+
+// Launch of the stand-alone epilogue pass
+struct ApplyLaunch {
+    void *C;
+    const float *P;
+    int M;
+    int N;
+    cudaStream_t stream;
+
+    template <typename EPILOGUE> bool operator()(const EPILOGUE &ep) const {
+        size_t n = static_cast<size_t>(M) * N;
+        int blocks = static_cast<int>((n + 255) / 256);
+        blocks = blocks < 1024 ? blocks : 1024;
+        MatrixEpilogueCUDA<EPILOGUE> <<< blocks, 256, 0, stream >>>(
+            static_cast<typename EPILOGUE::Output *>(C), P, M, N, ep);
+        return true;
+    }
+};
+
+bool MatrixMulEpilogue(void *C, const float *A, const float *B, int M, int N,
+                       int K, const MatmulEpilogue &epilogue, int block_size,
+                       cudaStream_t stream) {
+    FusedLaunch op = {C, A, B, M, N, K, block_size, stream};
+    return DispatchEpilogue(epilogue, &op);
+}
+
+bool MatrixApplyEpilogue(void *C, const float *P, int M, int N,
+                         const MatmulEpilogue &epilogue,
+                         cudaStream_t stream) {
+    ApplyLaunch op = {C, P, M, N, stream};
+    return DispatchEpilogue(epilogue, &op);
+}
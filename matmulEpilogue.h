@@ -0,0 +1,35 @@
+/**
+ * Matrix multiplication with a fused epilogue:
+ * C = act(alpha * A * B + beta * C + bias), optionally converted to fp16 or
+ * bf16, in the store of the register-blocked kernel (regTile4, float4
+ * accesses where the matrices allow them).
+ *
+ * All matrices are row-major and in device memory; C is M x N, A is M x K
+ * and B is K x N, A and B in fp32.
+ */
+
+#ifndef MATMUL_EPILOGUE_H_
+#define MATMUL_EPILOGUE_H_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "epilogue.cuh"
+
+/**
+ * C = epilogue(A * B) with block_size 16 or 32, C of epilogue.outType.
+ * Returns false for any other block_size, or a bias mode without bias.
+ */
+bool MatrixMulEpilogue(void *C, const float *A, const float *B, int M, int N,
+                       int K, const MatmulEpilogue &epilogue, int block_size,
+                       cudaStream_t stream);
+
+/**
+ * C = epilogue(P) as a separate pass over the M x N fp32 accumulators P,
+ * for kernels without a fused epilogue. Returns false for a bias mode
+ * without bias.
+ */
+bool MatrixApplyEpilogue(void *C, const float *P, int M, int N,
+                         const MatmulEpilogue &epilogue, cudaStream_t stream);
+
+#endif  // MATMUL_EPILOGUE_H_
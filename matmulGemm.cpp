@@ -0,0 +1,77 @@
+/**
+ * General matrix multiplication on strided and transposed operands.
+ */
+
+#include "gemmKernels.cuh"
+#include "kernelDispatch.h"
+#include "matmulGemm.h"
+
+typedef LinearEpilogue<EPILOGUE_BIAS_NONE, EPILOGUE_ACT_NONE, float>
+    ScaleEpilogue;
+
+template <int BLOCK_SIZE, bool TRANS_A, bool TRANS_B>
+static void LaunchGemm(int M, int N, int K, const float *A, int lda,
+                       const float *B, int ldb, float *C, int ldc,
+                       const ScaleEpilogue &ep, cudaStream_t stream) {
+    dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+    dim3 grid((N + BLOCK_SIZE - 1) / BLOCK_SIZE,
+              (M + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    MatrixMulGemmCUDA<BLOCK_SIZE, TRANS_A, TRANS_B, ScaleEpilogue>
+        <<< grid, threads, 0, stream >>>(C, ldc, A, lda, B, ldb, M, N, K,
+                                         ep);
+}
+
+// Launch of the instance of the layout, for one block size
+struct GemmLaunch {
+    MatmulOp opA;
+    MatmulOp opB;
+    int M;
+    int N;
+    int K;
+    const float *A;
+    int lda;
+    const float *B;
+    int ldb;
+    float *C;
+    int ldc;
+    ScaleEpilogue ep;
+    cudaStream_t stream;
+
+    template <int BLOCK_SIZE>
+    bool operator()(IntConstant<BLOCK_SIZE>) const {
+        if (opA == MATMUL_OP_N && opB == MATMUL_OP_N) {
+            LaunchGemm<BLOCK_SIZE, false, false>(M, N, K, A, lda, B, ldb, C,
+                                                 ldc, ep, stream);
+        } else if (opA == MATMUL_OP_N) {
+            LaunchGemm<BLOCK_SIZE, false, true>(M, N, K, A, lda, B, ldb, C,
+                                                ldc, ep, stream);
+        } else if (opB == MATMUL_OP_N) {
+            LaunchGemm<BLOCK_SIZE, true, false>(M, N, K, A, lda, B, ldb, C,
+                                                ldc, ep, stream);
+        } else {
+            LaunchGemm<BLOCK_SIZE, true, true>(M, N, K, A, lda, B, ldb, C,
+                                               ldc, ep, stream);
+        }
+
+        return true;
+    }
+};
+
+bool MatrixMulGemm(MatmulOp opA, MatmulOp opB, int M, int N, int K,
+                   float alpha, const float *A, int lda, const float *B,
+                   int ldb, float beta, float *C, int ldc, int block_size,
+                   cudaStream_t stream) {
+    // Stored rows are K (or M) elements of A and N (or K) elements of B
+    if (lda < (opA == MATMUL_OP_N ? K : M) ||
+            ldb < (opB == MATMUL_OP_N ? N : K) || ldc < N) {
+        return false;
+    }
+
+    if (M <= 0 || N <= 0) {
+        return true;
+    }
+
+    ScaleEpilogue ep = {alpha, beta, NULL};
+    GemmLaunch op = {opA, opB, M, N, K, A, lda, B, ldb, C, ldc, ep, stream};
+    return DispatchInt(TiledBlockSizes(), block_size, &op);
+}
@@ -0,0 +1,37 @@
+/**
+ * General matrix multiplication on strided and transposed operands, in the
+ * style of BLAS sgemm but row-major:
+ * C = alpha * op(A) * op(B) + beta * C.
+ *
+ * op(A) is M x K, op(B) is K x N and C is M x N. A is stored as M x K
+ * (MATMUL_OP_N) or K x M (MATMUL_OP_T), B as K x N or N x K, each row-major
+ * with its leading dimension (elements between the starts of rows), so
+ * views into larger matrices and transposes need no packed copy.
+ */
+
+#ifndef MATMUL_GEMM_H_
+#define MATMUL_GEMM_H_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+enum MatmulOp {
+    MATMUL_OP_N,
+    MATMUL_OP_T
+};
+
+inline const char *MatmulOpName(MatmulOp op) {
+    return op == MATMUL_OP_T ? "T" : "N";
+}
+
+/**
+ * C = alpha * op(A) * op(B) + beta * C on device matrices, with block_size
+ * 16 or 32; C is only read if beta is not zero. Returns false for any
+ * other block_size, or a leading dimension shorter than a stored row.
+ */
+bool MatrixMulGemm(MatmulOp opA, MatmulOp opB, int M, int N, int K,
+                   float alpha, const float *A, int lda, const float *B,
+                   int ldb, float beta, float *C, int ldc, int block_size,
+                   cudaStream_t stream);
+
+#endif  // MATMUL_GEMM_H_
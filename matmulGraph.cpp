@@ -0,0 +1,153 @@
+/**
+ * CUDA Graph capture of the library's work: a fixed sequence of copies,
+ * multiplications and epilogues issued into a handle's stream is recorded
+ * once and replayed with a single cudaGraphLaunch, which takes the CPU
+ * launch cost of every node out of the loop.
+ */
+
+// System includes
+#include <vector>
+
+#include "matmulContext.h"
+#include "matmulLibrary.h"
+
+struct MatmulGraphState {
+    cudaGraph_t graph;
+    cudaGraphExec_t exec;
+
+    // Whether the last capture was applied to exec in place
+    bool updated;
+
+    // Device buffers from the pool of handle that exec uses
+    MatmulHandle handle;
+    std::vector<void *> buffers;
+};
+
+// Return buffers to the pool of handle and clear them
+static void ReleaseBuffers(MatmulHandle handle, std::vector<void *> *buffers) {
+    for (size_t i = 0; i < buffers->size(); i++) {
+        handle->pool.Free((*buffers)[i]);
+    }
+
+    buffers->clear();
+}
+
+// The recorded buffers of handle now belong to the work of state
+static void AdoptBuffers(MatmulGraphState *state, MatmulHandle handle) {
+    if (state->handle != NULL) {
+        ReleaseBuffers(state->handle, &state->buffers);
+    }
+
+    state->handle = handle;
+    state->buffers.swap(handle->graphBuffers);
+}
+
+cudaError_t MatmulCaptureBegin(MatmulHandle handle) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    // Thread-local, so that other threads of the process may keep on
+    // calling the runtime while the plan is recorded
+    return cudaStreamBeginCapture(handle->stream,
+                                  cudaStreamCaptureModeThreadLocal);
+}
+
+// Update the parameters of exec to those of graph, if the topology matches
+static bool UpdateInPlace(cudaGraphExec_t exec, cudaGraph_t graph) {
+#if CUDART_VERSION >= 12000
+    cudaGraphExecUpdateResultInfo info;
+    cudaError_t err = cudaGraphExecUpdate(exec, graph, &info);
+#else
+    cudaGraphNode_t errorNode;
+    cudaGraphExecUpdateResult result;
+    cudaError_t err = cudaGraphExecUpdate(exec, graph, &errorNode, &result);
+#endif
+
+    if (err != cudaSuccess) {
+        // Not sticky; clear it so that it does not surface later on
+        cudaGetLastError();
+        return false;
+    }
+
+    return true;
+}
+
+cudaError_t MatmulCaptureEnd(MatmulHandle handle, MatmulGraph *graph) {
+    if (handle == NULL || graph == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    cudaGraph_t captured;
+    cudaError_t err = cudaStreamEndCapture(handle->stream, &captured);
+
+    // Nothing will replay the buffers of a failed capture
+    if (err != cudaSuccess) {
+        ReleaseBuffers(handle, &handle->graphBuffers);
+        return err;
+    }
+
+    MatmulGraphState *state = *graph;
+
+    if (state != NULL && UpdateInPlace(state->exec, captured)) {
+        cudaGraphDestroy(state->graph);
+        state->graph = captured;
+        state->updated = true;
+        AdoptBuffers(state, handle);
+        return cudaSuccess;
+    }
+
+    cudaGraphExec_t exec;
+    err = cudaGraphInstantiateWithFlags(&exec, captured, 0);
+
+    if (err != cudaSuccess) {
+        cudaGraphDestroy(captured);
+        ReleaseBuffers(handle, &handle->graphBuffers);
+        return err;
+    }
+
+    if (state == NULL) {
+        state = new MatmulGraphState;
+        state->handle = NULL;
+        *graph = state;
+    } else {
+        cudaGraphExecDestroy(state->exec);
+        cudaGraphDestroy(state->graph);
+    }
+
+    state->graph = captured;
+    state->exec = exec;
+    state->updated = false;
+    AdoptBuffers(state, handle);
+
+    return cudaSuccess;
+}
+
+bool MatmulGraphWasUpdated(MatmulGraph graph) {
+    return graph != NULL && graph->updated;
+}
+
+cudaError_t MatmulGraphLaunch(MatmulGraph graph, cudaStream_t stream) {
+    if (graph == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    return cudaGraphLaunch(graph->exec, stream);
+}
+
+cudaError_t MatmulGraphDestroy(MatmulGraph graph) {
+    if (graph == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    cudaError_t err = cudaGraphExecDestroy(graph->exec);
+    cudaGraphDestroy(graph->graph);
+
+    if (graph->handle != NULL) {
+        ReleaseBuffers(graph->handle, &graph->buffers);
+    }
+
+    delete graph;
+
+    return err;
+}
@@ -0,0 +1,290 @@
+/**
+ * Quantized matrix multiplication.
+ *
+ * The run-time MatmulQuant is turned into one of the DequantEpilogue types
+ * by DispatchQuant, which hands it to the launch functor, as for the fused
+ * epilogue in matmulEpilogue.cpp. The sums of A and B that asymmetric
+ * quantization needs are computed in a pass before the kernel, into
+ * stream-ordered scratch memory.
+ */
+
+// System includes
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "int8Kernels.cuh"
+#include "matmulInt8.h"
+
+// Tiling of the dp4a kernel: 64 x 64 elements of C per block of 16 x 16
+#define INT8_DP4A_BLOCK 16
+#define INT8_DP4A_TILE 4
+
+// Block size of the int8 Tensor Core kernel: 4 warps
+#define INT8_IMMA_BLOCK 32
+
+/**
+ * Sums of the rows of the rows x cols int8 matrix X (CUDA Kernel) on the
+ * device, one warp per row
+ */
+__global__ void Int8RowSumsCUDA(int *sums, const int8_t *X, int rows,
+                                int cols) {
+    int lane = threadIdx.x % warpSize;
+    int row = (blockIdx.x * blockDim.x + threadIdx.x) / warpSize;
+
+    if (row >= rows) {
+        return;
+    }
+
+    const int8_t *x = X + static_cast<size_t>(row) * cols;
+    int sum = 0;
+
+    for (int c = lane; c < cols; c += warpSize) {
+        sum += x[c];
+    }
+
+    for (int offset = warpSize / 2; offset > 0; offset /= 2) {
+        sum += __shfl_down_sync(0xffffffff, sum, offset);
+    }
+
+    if (lane == 0) {
+        sums[row] = sum;
+    }
+}
+
+/**
+ * Sums of the columns of the rows x cols int8 matrix X (CUDA Kernel) on
+ * the device, one thread per column
+ */
+__global__ void Int8ColSumsCUDA(int *sums, const int8_t *X, int rows,
+                                int cols) {
+    int col = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (col >= cols) {
+        return;
+    }
+
+    int sum = 0;
+
+    for (int r = 0; r < rows; r++) {
+        sum += X[static_cast<size_t>(r) * cols + col];
+    }
+
+    sums[col] = sum;
+}
+
+template <bool PER_ROW, bool PER_COL, typename OutT, typename Op>
+static bool DispatchQuantEpilogue(const MatmulQuant &q, const int *rowSumA,
+                                  const int *colSumB, int K, Op *op) {
+    DequantEpilogue<PER_ROW, PER_COL, OutT> ep = {
+        q.scaleA, q.zeroA, q.scaleB, q.zeroB, rowSumA, colSumB, q.bias, K
+    };
+    return (*op)(ep);
+}
+
+template <typename OutT, typename Op>
+static bool DispatchQuantAxes(const MatmulQuant &q, const int *rowSumA,
+                              const int *colSumB, int K, Op *op) {
+    if (q.perRowA && q.perColB) {
+        return DispatchQuantEpilogue<true, true, OutT>(q, rowSumA, colSumB,
+                                                       K, op);
+    }
+
+    if (q.perRowA) {
+        return DispatchQuantEpilogue<true, false, OutT>(q, rowSumA, colSumB,
+                                                        K, op);
+    }
+
+    if (q.perColB) {
+        return DispatchQuantEpilogue<false, true, OutT>(q, rowSumA, colSumB,
+                                                        K, op);
+    }
+
+    return DispatchQuantEpilogue<false, false, OutT>(q, rowSumA, colSumB, K,
+                                                     op);
+}
+
+/**
+ * Call (*op)(ep) with the DequantEpilogue ep described by q and the sums;
+ * returns what op returns, or false if q is invalid
+ */
+template <typename Op>
+static bool DispatchQuant(const MatmulQuant &q, const int *rowSumA,
+                          const int *colSumB, int K, Op *op) {
+    if (q.scaleA == NULL || q.scaleB == NULL) {
+        return false;
+    }
+
+    switch (q.outType) {
+    case MATMUL_FP32:
+        return DispatchQuantAxes<float>(q, rowSumA, colSumB, K, op);
+
+    case MATMUL_FP16:
+        return DispatchQuantAxes<half>(q, rowSumA, colSumB, K, op);
+
+    case MATMUL_BF16:
+        return DispatchQuantAxes<__nv_bfloat16>(q, rowSumA, colSumB, K, op);
+
+    default:
+        return false;
+    }
+}
+
+// Launch of one of the int8 kernels with a dequantizing epilogue
+struct Int8Launch {
+    void *C;
+    const int8_t *A;
+    const int8_t *B;
+    int M;
+    int N;
+    int K;
+    Int8Kernel kernel;
+    cudaStream_t stream;
+
+    template <typename EPILOGUE> bool operator()(const EPILOGUE &ep) const {
+        typedef typename EPILOGUE::Output OutT;
+
+        if (kernel == INT8_KERNEL_IMMA) {
+            const int tiles = INT8_IMMA_BLOCK / WMMA_TILE;
+            dim3 threads(32 * tiles * tiles);
+            dim3 grid((N + INT8_IMMA_BLOCK - 1) / INT8_IMMA_BLOCK,
+                      (M + INT8_IMMA_BLOCK - 1) / INT8_IMMA_BLOCK);
+            MatrixMulImmaCUDA<INT8_IMMA_BLOCK, EPILOGUE>
+                <<< grid, threads, 0, stream >>>(
+                static_cast<OutT *>(C), A, B, M, K, N, ep);
+        } else {
+            const int edge = INT8_DP4A_BLOCK * INT8_DP4A_TILE;
+            dim3 threads(INT8_DP4A_BLOCK, INT8_DP4A_BLOCK);
+            dim3 grid((N + edge - 1) / edge, (M + edge - 1) / edge);
+            MatrixMulDp4aCUDA<INT8_DP4A_BLOCK, INT8_DP4A_TILE,
+                              INT8_DP4A_TILE, EPILOGUE>
+                <<< grid, threads, 0, stream >>>(
+                static_cast<OutT *>(C), A, B, M, K, N, ep);
+        }
+
+        return true;
+    }
+};
+
+Int8Kernel ResolveInt8Kernel(Int8Kernel kernel, int arch) {
+    if (kernel == INT8_KERNEL_AUTO) {
+        return arch >= 72 ? INT8_KERNEL_IMMA : INT8_KERNEL_DP4A;
+    }
+
+    return kernel;
+}
+
+bool MatrixMulInt8(void *C, const int8_t *A, const int8_t *B, int M, int N,
+                   int K, const MatmulQuant &quant, Int8Kernel kernel,
+                   cudaStream_t stream) {
+    int device, major, minor;
+    cudaGetDevice(&device);
+    cudaDeviceGetAttribute(&major, cudaDevAttrComputeCapabilityMajor,
+                           device);
+    cudaDeviceGetAttribute(&minor, cudaDevAttrComputeCapabilityMinor,
+                           device);
+    kernel = ResolveInt8Kernel(kernel, major * 10 + minor);
+
+    // |a - za| and |b - zb| are at most 255
+    if ((kernel == INT8_KERNEL_IMMA && major * 10 + minor < 72) ||
+            static_cast<long long>(K) * 255 * 255 > 0x7fffffff) {
+        return false;
+    }
+
+    // rowSumA is only read with zero points of B, colSumB with those of A
+    int *sums = NULL;
+    int *rowSumA = NULL;
+    int *colSumB = NULL;
+    size_t count = (quant.zeroB != NULL ? M : 0) +
+                   (quant.zeroA != NULL ? N : 0);
+
+    if (count > 0) {
+        if (cudaMallocAsync(reinterpret_cast<void **>(&sums),
+                            sizeof(int) * count, stream) != cudaSuccess) {
+            return false;
+        }
+
+        int *next = sums;
+
+        if (quant.zeroB != NULL) {
+            rowSumA = next;
+            next += M;
+            int blocks = (M + 7) / 8;
+            Int8RowSumsCUDA <<< blocks, 256, 0, stream >>>(rowSumA, A, M, K);
+        }
+
+        if (quant.zeroA != NULL) {
+            colSumB = next;
+            Int8ColSumsCUDA <<< (N + 255) / 256, 256, 0, stream >>>(
+                colSumB, B, K, N);
+        }
+    }
+
+    Int8Launch op = {C, A, B, M, N, K, kernel, stream};
+    bool ok = DispatchQuant(quant, rowSumA, colSumB, K, &op);
+
+    if (sums != NULL) {
+        cudaFreeAsync(sums, stream);
+    }
+
+    return ok;
+}
+
+// Index of the group of axis that element (r, c) belongs to
+static int QuantGroup(QuantAxis axis, int r, int c) {
+    return axis == QUANT_PER_ROW ? r : axis == QUANT_PER_COL ? c : 0;
+}
+
+void ChooseQuantParams(const float *x, int rows, int cols, QuantAxis axis,
+                       bool symmetric, float *scale, int *zeroPoint) {
+    int groups = axis == QUANT_PER_ROW ? rows :
+                 axis == QUANT_PER_COL ? cols : 1;
+
+    // The range of every group always includes 0, which so stays exact
+    std::vector<float> lo(groups, 0.0f), hi(groups, 0.0f);
+
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int g = QuantGroup(axis, r, c);
+            float v = x[static_cast<size_t>(r) * cols + c];
+            lo[g] = std::min(lo[g], v);
+            hi[g] = std::max(hi[g], v);
+        }
+    }
+
+    for (int g = 0; g < groups; g++) {
+        if (symmetric) {
+            float m = std::max(-lo[g], hi[g]);
+            scale[g] = m > 0.0f ? m / 127.0f : 1.0f;
+            zeroPoint[g] = 0;
+        } else {
+            float range = hi[g] - lo[g];
+            scale[g] = range > 0.0f ? range / 255.0f : 1.0f;
+            int z = static_cast<int>(lrintf(-128.0f - lo[g] / scale[g]));
+            zeroPoint[g] = std::max(-128, std::min(127, z));
+        }
+    }
+}
+
+void QuantizeHost(const float *x, int rows, int cols, QuantAxis axis,
+                  const float *scale, const int *zeroPoint, int8_t *q) {
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int g = QuantGroup(axis, r, c);
+            size_t i = static_cast<size_t>(r) * cols + c;
+            long v = lrintf(x[i] / scale[g]) + zeroPoint[g];
+            q[i] = static_cast<int8_t>(std::max(-128L, std::min(127L, v)));
+        }
+    }
+}
+
+void DequantizeHost(const int8_t *q, int rows, int cols, QuantAxis axis,
+                    const float *scale, const int *zeroPoint, float *x) {
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            int g = QuantGroup(axis, r, c);
+            size_t i = static_cast<size_t>(r) * cols + c;
+            x[i] = scale[g] * (q[i] - zeroPoint[g]);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/**
+ * Quantized matrix multiplication: C = dequantize(A * B) for int8 A and B
+ * with int32 accumulation (see int8Kernels.cuh), C in fp32, fp16 or bf16.
+ * The device picks the kernel: int8 tensor cores from compute capability
+ * 7.2, dp4a from 6.1 and byte arithmetic below that.
+ *
+ * Also host helpers to choose quantization parameters and to quantize and
+ * dequantize matrices, per tensor or per channel.
+ *
+ * All matrices are row-major; C is M x N, A is M x K and B is K x N.
+ */
+
+#ifndef MATMUL_INT8_H_
+#define MATMUL_INT8_H_
+
+// System includes
+#include <stdint.h>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "matmulTypes.cuh"
+
+// Which elements share a scale and zero point
+enum QuantAxis {
+    QUANT_PER_TENSOR,
+    QUANT_PER_ROW,
+    QUANT_PER_COL
+};
+
+// Kernel of MatrixMulInt8
+enum Int8Kernel {
+    INT8_KERNEL_AUTO,
+    INT8_KERNEL_DP4A,
+    INT8_KERNEL_IMMA
+};
+
+inline const char *Int8KernelName(Int8Kernel kernel) {
+    switch (kernel) {
+    case INT8_KERNEL_DP4A:
+        return "dp4a";
+
+    case INT8_KERNEL_IMMA:
+        return "imma";
+
+    default:
+        return "auto";
+    }
+}
+
+/**
+ * Run-time description of the dequantizing epilogue. All pointers are to
+ * device memory. A is quantized per tensor or per row (M parameters), B
+ * per tensor or per column (N parameters); a NULL zero point means
+ * symmetric quantization.
+ */
+struct MatmulQuant {
+    bool perRowA;
+    const float *scaleA;
+    const int *zeroA;
+
+    bool perColB;
+    const float *scaleB;
+    const int *zeroB;
+
+    // N elements added to every row of C, or NULL
+    const float *bias;
+
+    // Element type of C
+    MatmulType outType;
+};
+
+/**
+ * C = quant(A * B) on stream with kernel, INT8_KERNEL_AUTO for the
+ * fastest one of the current device. Returns false for a kernel the device
+ * cannot run, K too large for exact int32 accumulation, or if the scratch
+ * memory for the sums of A and B that asymmetric quantization needs cannot
+ * be allocated.
+ */
+bool MatrixMulInt8(void *C, const int8_t *A, const int8_t *B, int M, int N,
+                   int K, const MatmulQuant &quant, Int8Kernel kernel,
+                   cudaStream_t stream);
+
+// The kernel MatrixMulInt8 runs for kernel on devices of compute arch
+Int8Kernel ResolveInt8Kernel(Int8Kernel kernel, int arch);
+
+/**
+ * Scale and zero point of every group of axis of the rows x cols host
+ * matrix x, so that its range (widened to include 0) maps onto
+ * [-128, 127]; symmetric quantization maps [-max |x|, max |x|] onto
+ * [-127, 127] with zero points of 0. scale and zeroPoint receive 1, rows
+ * or cols values.
+ */
+void ChooseQuantParams(const float *x, int rows, int cols, QuantAxis axis,
+                       bool symmetric, float *scale, int *zeroPoint);
+
+// q = round(x / scale) + zeroPoint, saturated to int8
+void QuantizeHost(const float *x, int rows, int cols, QuantAxis axis,
+                  const float *scale, const int *zeroPoint, int8_t *q);
+
+// x = scale * (q - zeroPoint)
+void DequantizeHost(const int8_t *q, int rows, int cols, QuantAxis axis,
+                    const float *scale, const int *zeroPoint, float *x);
+
+#endif  // MATMUL_INT8_H_
@@ -0,0 +1,384 @@
+/**
+ * Shape-specialized kernels from NVRTC, loaded with the driver API.
+ */
+
+// System includes
+#include <stdio.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(MATMUL_WITH_NVRTC)
+#include <cuda.h>
+#include <nvrtc.h>
+#endif
+
+#include "matmulJit.h"
+
+// The loop over K is unrolled completely up to this many tiles, by 8 above
+#define JIT_MAX_UNROLL 64
+
+// Name of the generated kernel
+#define JIT_KERNEL_NAME "MatrixMulJitCUDA"
+
+// MatrixMulCUDA with BLOCK_SIZE, M, N and K prepended as macros; the
+// bounds checks fold away for the dimensions that are multiples of
+// BLOCK_SIZE. NVRTC has no size_t without headers.
+static const char *kJitKernel =
+    "extern \"C\" __global__ void\n"
+    "__launch_bounds__(BLOCK_SIZE * BLOCK_SIZE)\n"
+    JIT_KERNEL_NAME "(float *__restrict__ C, const float *__restrict__ A,\n"
+    "                 const float *__restrict__ B) {\n"
+    "    int tx = threadIdx.x;\n"
+    "    int ty = threadIdx.y;\n"
+    "    int row = BLOCK_SIZE * blockIdx.y + ty;\n"
+    "    int col = BLOCK_SIZE * blockIdx.x + tx;\n"
+    "    bool rowIn = M % BLOCK_SIZE == 0 || row < M;\n"
+    "    bool colIn = N % BLOCK_SIZE == 0 || col < N;\n"
+    "    __shared__ float As[BLOCK_SIZE][BLOCK_SIZE];\n"
+    "    __shared__ float Bs[BLOCK_SIZE][BLOCK_SIZE];\n"
+    "    float Csub = 0;\n"
+    "\n"
+    "#pragma unroll UNROLL_K\n"
+    "    for (int k0 = 0; k0 < K; k0 += BLOCK_SIZE) {\n"
+    "        bool aIn = K % BLOCK_SIZE == 0 || k0 + tx < K;\n"
+    "        bool bIn = K % BLOCK_SIZE == 0 || k0 + ty < K;\n"
+    "        As[ty][tx] = rowIn && aIn ?\n"
+    "            A[(unsigned long long)row * K + k0 + tx] : 0.0f;\n"
+    "        Bs[ty][tx] = bIn && colIn ?\n"
+    "            B[(unsigned long long)(k0 + ty) * N + col] : 0.0f;\n"
+    "        __syncthreads();\n"
+    "\n"
+    "#pragma unroll\n"
+    "        for (int k = 0; k < BLOCK_SIZE; ++k) {\n"
+    "            Csub += As[ty][k] * Bs[k][tx];\n"
+    "        }\n"
+    "\n"
+    "        __syncthreads();\n"
+    "    }\n"
+    "\n"
+    "    if (rowIn && colIn) {\n"
+    "        C[(unsigned long long)row * N + col] = Csub;\n"
+    "    }\n"
+    "}\n";
+
+static double HostMs() {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool JitKernelCache::Key::operator<(const Key &other) const {
+    if (device != other.device) {
+        return device < other.device;
+    }
+
+    if (M != other.M) {
+        return M < other.M;
+    }
+
+    if (N != other.N) {
+        return N < other.N;
+    }
+
+    return K < other.K;
+}
+
+JitKernelCache::JitKernelCache(const char *dir, int blockSize)
+    : dir_(dir != NULL ? dir : ""), blockSize_(blockSize) {
+    if (!dir_.empty() && mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "Warning: cannot create %s, JIT cache in memory"
+                " only\n", dir_.c_str());
+        dir_.clear();
+    }
+}
+
+JitKernelCache::~JitKernelCache() {
+#if defined(MATMUL_WITH_NVRTC)
+    int current;
+
+    if (cudaGetDevice(&current) != cudaSuccess) {
+        return;
+    }
+
+    // A module is unloaded from the context it was loaded into
+    std::map<Key, Module>::iterator it;
+
+    for (it = modules_.begin(); it != modules_.end(); ++it) {
+        if (cudaSetDevice(it->first.device) == cudaSuccess &&
+                cudaFree(NULL) == cudaSuccess) {
+            cuModuleUnload(static_cast<CUmodule>(it->second.module));
+        }
+    }
+
+    cudaSetDevice(current);
+#endif
+}
+
+bool JitKernelCache::Available() {
+#if defined(MATMUL_WITH_NVRTC)
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string JitKernelCache::Source(int M, int N, int K, int blockSize) {
+    int tiles = (K + blockSize - 1) / blockSize;
+    char defines[256];
+    snprintf(defines, sizeof(defines),
+             "#define BLOCK_SIZE %d\n#define M %d\n#define N %d\n"
+             "#define K %d\n#define UNROLL_K %s\n\n", blockSize, M, N, K,
+             tiles <= JIT_MAX_UNROLL ? "" : "8");
+    return std::string(defines) + kJitKernel;
+}
+
+#if defined(MATMUL_WITH_NVRTC)
+
+// FNV-1a, to tell the sources of different generator versions apart
+static unsigned long long HashString(const std::string &s) {
+    unsigned long long h = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < s.size(); i++) {
+        h = (h ^ static_cast<unsigned char>(s[i])) * 1099511628211ULL;
+    }
+
+    return h;
+}
+
+static bool ReadFile(const std::string &path, std::vector<char> *data) {
+    FILE *f = fopen(path.c_str(), "rb");
+
+    if (f == NULL) {
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data->resize(size > 0 ? size : 0);
+    bool ok = size > 0 && fread(&(*data)[0], 1, size, f) ==
+              static_cast<size_t>(size);
+    fclose(f);
+    return ok;
+}
+
+// Write to a file of its own first, so that a process that reads path
+// concurrently sees all of the cubin or none of it
+static void WriteFile(const std::string &path, const std::vector<char> &data) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%ld.tmp", static_cast<long>(getpid()));
+    std::string tmp = path + suffix;
+    FILE *f = fopen(tmp.c_str(), "wb");
+
+    if (f == NULL) {
+        return;
+    }
+
+    bool ok = fwrite(&data[0], 1, data.size(), f) == data.size();
+    ok = fclose(f) == 0 && ok;
+
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        fprintf(stderr, "Warning: failed to write %s\n", path.c_str());
+        remove(tmp.c_str());
+    }
+}
+
+// Compile source to a cubin for sm_arch; prints the log on failure
+static cudaError_t CompileCubin(const std::string &source, int arch,
+                                std::vector<char> *cubin) {
+    nvrtcProgram program;
+
+    if (nvrtcCreateProgram(&program, source.c_str(), "matmulJit.cu", 0, NULL,
+                           NULL) != NVRTC_SUCCESS) {
+        return cudaErrorInvalidSource;
+    }
+
+    char target[32];
+    snprintf(target, sizeof(target), "--gpu-architecture=sm_%d", arch);
+    const char *options[] = {target};
+    nvrtcResult result = nvrtcCompileProgram(program, 1, options);
+    size_t size = 0;
+
+    if (result != NVRTC_SUCCESS) {
+        nvrtcGetProgramLogSize(program, &size);
+        std::vector<char> log(size + 1, '\0');
+        nvrtcGetProgramLog(program, &log[0]);
+        fprintf(stderr, "NVRTC failed for sm_%d: %s\n%s\n", arch,
+                nvrtcGetErrorString(result), &log[0]);
+    } else {
+        result = nvrtcGetCUBINSize(program, &size);
+
+        if (result == NVRTC_SUCCESS) {
+            cubin->resize(size);
+            result = nvrtcGetCUBIN(program, &(*cubin)[0]);
+        }
+    }
+
+    nvrtcDestroyProgram(&program);
+    return result == NVRTC_SUCCESS ? cudaSuccess : cudaErrorInvalidSource;
+}
+
+// Load cubin into the current context
+static cudaError_t LoadCubin(const std::vector<char> &cubin, CUmodule *module,
+                             CUfunction *function) {
+    if (cubin.empty() ||
+            cuModuleLoadData(module, &cubin[0]) != CUDA_SUCCESS) {
+        return cudaErrorInvalidKernelImage;
+    }
+
+    if (cuModuleGetFunction(function, *module, JIT_KERNEL_NAME) !=
+            CUDA_SUCCESS) {
+        cuModuleUnload(*module);
+        return cudaErrorSymbolNotFound;
+    }
+
+    return cudaSuccess;
+}
+
+#endif  // MATMUL_WITH_NVRTC
+
+cudaError_t JitKernelCache::Get(const Key &key, Module *module,
+                                JitLookup *lookup) {
+    lookup->source = JIT_SOURCE_LOADED;
+    lookup->compileMs = 0.0;
+    lookup->loadMs = 0.0;
+
+    std::map<Key, Module>::iterator it = modules_.find(key);
+
+    if (it != modules_.end()) {
+        *module = it->second;
+        return cudaSuccess;
+    }
+
+#if defined(MATMUL_WITH_NVRTC)
+    int major, minor, driver, nvrtcMajor, nvrtcMinor;
+    cudaError_t err = cudaDeviceGetAttribute(
+                          &major, cudaDevAttrComputeCapabilityMajor,
+                          key.device);
+
+    if (err == cudaSuccess) {
+        err = cudaDeviceGetAttribute(
+                  &minor, cudaDevAttrComputeCapabilityMinor, key.device);
+    }
+
+    if (err == cudaSuccess) {
+        err = cudaDriverGetVersion(&driver);
+    }
+
+    // Makes the device's primary context current for the driver API
+    if (err == cudaSuccess) {
+        err = cudaFree(NULL);
+    }
+
+    if (err != cudaSuccess) {
+        return err;
+    }
+
+    nvrtcVersion(&nvrtcMajor, &nvrtcMinor);
+    int arch = major * 10 + minor;
+    std::string source = Source(key.M, key.N, key.K, blockSize_);
+    char version[32];
+    snprintf(version, sizeof(version), "nvrtc %d.%d", nvrtcMajor,
+             nvrtcMinor);
+    std::string path;
+
+    if (!dir_.empty()) {
+        char name[128];
+        snprintf(name, sizeof(name),
+                 "/matmulJit_%dx%dx%d_b%d_sm%d_drv%d_%016llx.cubin", key.M,
+                 key.N, key.K, blockSize_, arch, driver,
+                 HashString(source + version));
+        path = dir_ + name;
+    }
+
+    std::vector<char> cubin;
+    CUmodule cuModule;
+    CUfunction cuFunction;
+    double start = HostMs();
+
+    // A cubin on disk that does not load is compiled over
+    if (!path.empty() && ReadFile(path, &cubin) &&
+            LoadCubin(cubin, &cuModule, &cuFunction) == cudaSuccess) {
+        lookup->source = JIT_SOURCE_DISK;
+        lookup->loadMs = HostMs() - start;
+    } else {
+        cubin.clear();
+        err = CompileCubin(source, arch, &cubin);
+
+        if (err != cudaSuccess) {
+            return err;
+        }
+
+        lookup->source = JIT_SOURCE_COMPILED;
+        lookup->compileMs = HostMs() - start;
+        start = HostMs();
+
+        if (!path.empty()) {
+            WriteFile(path, cubin);
+        }
+
+        err = LoadCubin(cubin, &cuModule, &cuFunction);
+
+        if (err != cudaSuccess) {
+            return err;
+        }
+
+        lookup->loadMs = HostMs() - start;
+    }
+
+    module->module = cuModule;
+    module->function = cuFunction;
+    modules_[key] = *module;
+    return cudaSuccess;
+#else
+    (void)key;
+    return cudaErrorNotSupported;
+#endif
+}
+
+cudaError_t JitKernelCache::Multiply(float *C, const float *A,
+                                     const float *B, int M, int N, int K,
+                                     cudaStream_t stream, JitLookup *lookup) {
+    if (C == NULL || A == NULL || B == NULL || M < 0 || N < 0 || K < 0 ||
+            (blockSize_ != 16 && blockSize_ != 32)) {
+        return cudaErrorInvalidValue;
+    }
+
+    JitLookup local;
+    lookup = lookup != NULL ? lookup : &local;
+
+    if (M == 0 || N == 0) {
+        lookup->source = JIT_SOURCE_LOADED;
+        lookup->compileMs = 0.0;
+        lookup->loadMs = 0.0;
+        return cudaSuccess;
+    }
+
+    Key key = {0, M, N, K};
+    cudaError_t err = cudaGetDevice(&key.device);
+    Module module;
+
+    if (err == cudaSuccess) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        err = Get(key, &module, lookup);
+    }
+
+    if (err != cudaSuccess) {
+        return err;
+    }
+
+#if defined(MATMUL_WITH_NVRTC)
+    void *args[] = {&C, &A, &B};
+    unsigned int bs = blockSize_;
+    CUresult result = cuLaunchKernel(
+                          static_cast<CUfunction>(module.function),
+                          (N + bs - 1) / bs, (M + bs - 1) / bs, 1, bs, bs, 1,
+                          0, stream, args, NULL);
+    return result == CUDA_SUCCESS ? cudaSuccess : cudaErrorLaunchFailure;
+#else
+    return cudaErrorNotSupported;
+#endif
+}
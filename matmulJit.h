@@ -0,0 +1,116 @@
+/**
+ * Matrix multiplication kernels compiled at run time for one exact shape.
+ *
+ * The kernel is the MatrixMulCUDA tiling with M, N and K as constants, so
+ * that NVRTC unrolls the loop over K and drops the bounds checks of every
+ * dimension that is a multiple of the block size. It is generated and
+ * compiled the first time a shape is multiplied on a device, and kept
+ * loaded for later calls. With a cache directory the cubin is also stored
+ * on disk, under a name made of the shape, the architecture, the driver
+ * version and a hash of the source, so that later processes load it
+ * instead of compiling it; an upgraded driver or generator compiles anew.
+ *
+ * Optional: build with -DMATMUL_WITH_NVRTC and link -lnvrtc -lcuda.
+ * Without it Multiply returns cudaErrorNotSupported.
+ */
+
+#ifndef MATMUL_JIT_H_
+#define MATMUL_JIT_H_
+
+// System includes
+#include <map>
+#include <mutex>
+#include <string>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Block size of the generated kernels unless given to JitKernelCache
+#define MATMUL_JIT_BLOCK 32
+
+// Where the kernel of a JitKernelCache::Multiply call came from
+enum JitSource {
+    JIT_SOURCE_LOADED,
+    JIT_SOURCE_DISK,
+    JIT_SOURCE_COMPILED
+};
+
+inline const char *JitSourceName(JitSource source) {
+    switch (source) {
+    case JIT_SOURCE_LOADED:
+        return "loaded";
+
+    case JIT_SOURCE_DISK:
+        return "disk";
+
+    case JIT_SOURCE_COMPILED:
+        return "compiled";
+    }
+
+    return "unknown";
+}
+
+// Cost of getting the kernel of a call, in host milliseconds
+struct JitLookup {
+    JitSource source;
+
+    // NVRTC compilation, and reading or writing the cubin and loading it
+    double compileMs;
+    double loadMs;
+};
+
+class JitKernelCache {
+ public:
+    /**
+     * Keep cubins in the directory dir, which is created if needed, or
+     * only in memory if dir is NULL; blockSize is the edge of the thread
+     * block, 16 or 32
+     */
+    explicit JitKernelCache(const char *dir = NULL,
+                            int blockSize = MATMUL_JIT_BLOCK);
+    ~JitKernelCache();
+
+    /**
+     * C = A * B on the current device with the kernel of M x N x K,
+     * getting it first if this is the first call of the shape; lookup
+     * (if not NULL) receives how it was got
+     */
+    cudaError_t Multiply(float *C, const float *A, const float *B, int M,
+                         int N, int K, cudaStream_t stream,
+                         JitLookup *lookup = NULL);
+
+    // Whether the library was built with NVRTC
+    static bool Available();
+
+    // CUDA C++ source of the kernel of M x N x K
+    static std::string Source(int M, int N, int K, int blockSize);
+
+ private:
+    struct Key {
+        int device;
+        int M;
+        int N;
+        int K;
+
+        bool operator<(const Key &other) const;
+    };
+
+    // CUmodule and CUfunction, kept opaque to stay free of cuda.h here
+    struct Module {
+        void *module;
+        void *function;
+    };
+
+    cudaError_t Get(const Key &key, Module *module, JitLookup *lookup);
+
+    std::string dir_;
+    int blockSize_;
+    std::map<Key, Module> modules_;
+    std::mutex mutex_;
+
+    // Not copyable
+    JitKernelCache(const JitKernelCache &);
+    JitKernelCache &operator=(const JitKernelCache &);
+};
+
+#endif  // MATMUL_JIT_H_
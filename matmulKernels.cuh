@@ -0,0 +1,334 @@
+/**
+ * Tiled matrix multiplication kernels of the original matrixMul sample:
+ * one element of C per thread (MatrixMulCUDA, and its batched variants
+ * MatrixMulStridedBatchedCUDA and MatrixMulBatchedCUDA) and a
+ * register-blocked micro-tile of C per thread (MatrixMulRegTileCUDA), the
+ * latter with optionally vectorized loads and stores and a fused epilogue
+ * (see epilogue.cuh).
+ *
+ * See also:
+ * V. Volkov and J. Demmel, "Benchmarking GPUs to tune dense linear algebra,"
+ * in Proc. 2008 ACM/IEEE Conf. on Supercomputing (SC '08),
+ * Piscataway, NJ: IEEE Press, 2008, pp. Art. 31:1-11.
+ */
+
+#ifndef MATMUL_KERNELS_CUH_
+#define MATMUL_KERNELS_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "epilogue.cuh"
+#include "vectorMemory.cuh"
+
+/**
+ * Block sub-matrix (blockIdx.x, blockIdx.y) of C = A * B, computed by the
+ * BLOCK_SIZE x BLOCK_SIZE threads of the block
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * The dimensions need not be multiples of BLOCK_SIZE: loads outside A or B
+ * are replaced by zeros and threads outside C skip their store.
+ */
+template <int BLOCK_SIZE> __device__ __forceinline__ void
+MatrixMulBlock(float *C, const float *A, const float *B, int hA, int wA,
+               int wB) {
+    // Block index
+    int bx = blockIdx.x;
+    int by = blockIdx.y;
+
+    // Thread index
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+
+    // Index of the first sub-matrix of A processed by the block
+    size_t aBegin = static_cast<size_t>(wA) * BLOCK_SIZE * by;
+
+    // Index of the last sub-matrix of A processed by the block
+    size_t aEnd   = aBegin + wA - 1;
+
+    // Step size used to iterate through the sub-matrices of A
+    size_t aStep  = BLOCK_SIZE;
+
+    // Index of the first sub-matrix of B processed by the block
+    size_t bBegin = BLOCK_SIZE * bx;
+
+    // Step size used to iterate through the sub-matrices of B
+    size_t bStep  = static_cast<size_t>(BLOCK_SIZE) * wB;
+
+    // Row and column of C computed by the thread
+    int row = BLOCK_SIZE * by + ty;
+    int col = BLOCK_SIZE * bx + tx;
+
+    // Csub is used to store the element of the block sub-matrix
+    // that is computed by the thread
+    float Csub = 0;
+
+    // Loop over all the sub-matrices of A and B
+    // required to compute the block sub-matrix
+    for (size_t a = aBegin, b = bBegin;
+            a <= aEnd;
+            a += aStep, b += bStep) {
+        // Declaration of the shared memory array As used to
+        // store the sub-matrix of A
+        __shared__ float As[BLOCK_SIZE][BLOCK_SIZE];
+
+        // Declaration of the shared memory array Bs used to
+        // store the sub-matrix of B
+        __shared__ float Bs[BLOCK_SIZE][BLOCK_SIZE];
+
+        // First column of A and row of B in the sub-matrices
+        int k0 = static_cast<int>(a - aBegin);
+
+        // Load the matrices from device memory
+        // to shared memory; each thread loads
+        // one element of each matrix, or zero past the edges
+        As[ty][tx] = (row < hA && k0 + tx < wA) ? A[a + wA * ty + tx] : 0.0f;
+        Bs[ty][tx] = (k0 + ty < wA && col < wB) ? B[b + wB * ty + tx] : 0.0f;
+
+        // Synchronize to make sure the matrices are loaded
+        __syncthreads();
+
+        // Multiply the two matrices together;
+        // each thread computes one element
+        // of the block sub-matrix
+#pragma unroll
+        for (int k = 0; k < BLOCK_SIZE; ++k) {
+            Csub += As[ty][k] * Bs[k][tx];
+        }
+
+        // Synchronize to make sure that the preceding
+        // computation is done before loading two new
+        // sub-matrices of A and B in the next iteration
+        __syncthreads();
+    }
+
+    // Write the block sub-matrix to device memory;
+    // each thread writes one element
+    size_t c = static_cast<size_t>(wB) * BLOCK_SIZE * by + BLOCK_SIZE * bx;
+
+    if (row < hA && col < wB) {
+        C[c + wB * ty + tx] = Csub;
+    }
+}
+
+/**
+ * Matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ */
+template <int BLOCK_SIZE> __global__ void MatrixMulCUDA(float *C,
+                                                        const float *A,
+                                                        const float *B, int hA,
+                                                        int wA, int wB) {
+    MatrixMulBlock<BLOCK_SIZE>(C, A, B, hA, wA, wB);
+}
+
+/**
+ * Strided-batched matrix multiplication (CUDA Kernel) on the device:
+ * C[i] = A[i] * B[i] for i < batch, where matrix i of X starts at
+ * X + i * strideX
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * blockIdx.z selects the problem; a grid smaller than batch in z covers
+ * the remaining problems in further passes.
+ */
+template <int BLOCK_SIZE> __global__ void
+MatrixMulStridedBatchedCUDA(float *C, const float *A, const float *B,
+                            int hA, int wA, int wB, long long strideA,
+                            long long strideB, long long strideC,
+                            int batch) {
+    for (int i = blockIdx.z; i < batch; i += gridDim.z) {
+        MatrixMulBlock<BLOCK_SIZE>(C + i * strideC, A + i * strideA,
+                                   B + i * strideB, hA, wA, wB);
+    }
+}
+
+/**
+ * Batched matrix multiplication (CUDA Kernel) on the device:
+ * C[i] = A[i] * B[i] for i < batch, with device arrays of the matrices
+ * hA is A's height, wA is A's width and wB is B's width
+ */
+template <int BLOCK_SIZE> __global__ void
+MatrixMulBatchedCUDA(float *const *C, const float *const *A,
+                     const float *const *B, int hA, int wA, int wB,
+                     int batch) {
+    for (int i = blockIdx.z; i < batch; i += gridDim.z) {
+        MatrixMulBlock<BLOCK_SIZE>(C[i], A[i], B[i], hA, wA, wB);
+    }
+}
+
+/**
+ * Element-wise accumulation (CUDA Kernel) on the device: C += P for the
+ * n elements of C, with a grid-stride loop
+ */
+template <typename T> __global__ void MatrixAccumulateCUDA(T *C, const T *P,
+                                                           size_t n) {
+    for (size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) +
+                    threadIdx.x;
+            i < n;
+            i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+        C[i] += P[i];
+    }
+}
+
+/**
+ * Register-blocked matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * The block has BLOCK_SIZE x BLOCK_SIZE threads like MatrixMulCUDA, but every
+ * thread accumulates a TM x TN micro-tile of C in registers, so one block
+ * computes a (BLOCK_SIZE * TM) x (BLOCK_SIZE * TN) sub-matrix of C. On each
+ * k-step a thread reads TM values of A and TN values of B from shared memory
+ * and performs TM * TN FMAs on their outer product.
+ * Thread (tx, ty) owns rows ty + i * BLOCK_SIZE of the block sub-matrix and
+ * TN / VEC runs of VEC adjacent columns, run g starting at column
+ * (g * BLOCK_SIZE + tx) * VEC, so shared memory reads of B and global writes
+ * of C stay contiguous across a warp.
+ * The tiles are loaded and C is stored VEC floats at a time (see
+ * vectorMemory.cuh) when A, B and C allow it; unaligned matrices and the
+ * edges fall back to predicated scalar accesses as in MatrixMulCUDA.
+ * epilogue maps every element in registers before the store, so scaling,
+ * bias, activation and conversion of C cost no extra pass over it.
+ */
+template <int BLOCK_SIZE, int TM, int TN, int VEC,
+          typename EPILOGUE = IdentityEpilogue> __global__ void
+__launch_bounds__(BLOCK_SIZE * BLOCK_SIZE)
+MatrixMulRegTileCUDA(typename EPILOGUE::Output *C, const float *A,
+                     const float *B, int hA, int wA, int wB,
+                     EPILOGUE epilogue) {
+    static_assert(TN % VEC == 0, "column runs must be whole vectors");
+    const int THREADS = BLOCK_SIZE * BLOCK_SIZE;
+
+    // Block index
+    int bx = blockIdx.x;
+    int by = blockIdx.y;
+
+    // Thread index
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+    int tid = ty * BLOCK_SIZE + tx;
+
+    // Index of the first sub-matrix of A processed by the block
+    size_t aBegin = static_cast<size_t>(wA) * BLOCK_SIZE * TM * by;
+
+    // Index of the last sub-matrix of A processed by the block
+    size_t aEnd   = aBegin + wA - 1;
+
+    // Step size used to iterate through the sub-matrices of A
+    size_t aStep  = BLOCK_SIZE;
+
+    // Index of the first sub-matrix of B processed by the block
+    size_t bBegin = BLOCK_SIZE * TN * bx;
+
+    // Step size used to iterate through the sub-matrices of B
+    size_t bStep  = static_cast<size_t>(BLOCK_SIZE) * wB;
+
+    // First row and column of the block sub-matrix of C
+    int row0 = BLOCK_SIZE * TM * by;
+    int col0 = BLOCK_SIZE * TN * bx;
+
+    // Vector access needs every row of the matrix to be aligned
+    bool vecA = IsVecAligned<VEC>(A, wA);
+    bool vecB = IsVecAligned<VEC>(B, wB);
+    bool vecC = IsVecAligned<VEC>(C, wB);
+
+    // Csub holds the TM x TN elements of the block sub-matrix
+    // that are computed by the thread
+    float Csub[TM][TN];
+
+#pragma unroll
+    for (int i = 0; i < TM; ++i) {
+#pragma unroll
+        for (int j = 0; j < TN; ++j) {
+            Csub[i][j] = 0;
+        }
+    }
+
+    // Loop over all the sub-matrices of A and B
+    // required to compute the block sub-matrix
+    for (size_t a = aBegin, b = bBegin;
+            a <= aEnd;
+            a += aStep, b += bStep) {
+        // Sub-matrix of A: BLOCK_SIZE * TM rows, BLOCK_SIZE columns
+        __shared__ __align__(16) float As[BLOCK_SIZE * TM][BLOCK_SIZE];
+
+        // Sub-matrix of B: BLOCK_SIZE rows, BLOCK_SIZE * TN columns
+        __shared__ __align__(16) float Bs[BLOCK_SIZE][BLOCK_SIZE * TN];
+
+        // First column of A and row of B in the sub-matrices
+        int k0 = static_cast<int>(a - aBegin);
+
+        // Load the matrices from device memory
+        // to shared memory; all threads of the block
+        // share the work, or load zero past the edges
+        LoadTileVec<BLOCK_SIZE * TM, BLOCK_SIZE, VEC, THREADS>(
+            &As[0][0], A + a, wA, hA - row0, wA - k0, tid, vecA);
+        LoadTileVec<BLOCK_SIZE, BLOCK_SIZE * TN, VEC, THREADS>(
+            &Bs[0][0], B + b, wB, wA - k0, wB - col0, tid, vecB);
+
+        // Synchronize to make sure the matrices are loaded
+        __syncthreads();
+
+        // Accumulate the outer product of a column fragment of As
+        // and a row fragment of Bs for every k of the sub-matrices
+#pragma unroll
+        for (int k = 0; k < BLOCK_SIZE; ++k) {
+            float aFrag[TM];
+            float bFrag[TN];
+
+#pragma unroll
+            for (int i = 0; i < TM; ++i) {
+                aFrag[i] = As[ty + i * BLOCK_SIZE][k];
+            }
+
+#pragma unroll
+            for (int j = 0; j < TN; ++j) {
+                bFrag[j] = Bs[k][((j / VEC) * BLOCK_SIZE + tx) * VEC +
+                                 j % VEC];
+            }
+
+#pragma unroll
+            for (int i = 0; i < TM; ++i) {
+#pragma unroll
+                for (int j = 0; j < TN; ++j) {
+                    Csub[i][j] += aFrag[i] * bFrag[j];
+                }
+            }
+        }
+
+        // Synchronize to make sure that the preceding
+        // computation is done before loading two new
+        // sub-matrices of A and B in the next iteration
+        __syncthreads();
+    }
+
+    // Write the block sub-matrix to device memory;
+    // each thread writes its TM x TN elements, VEC at a time,
+    // after passing them through the epilogue
+    size_t c = static_cast<size_t>(wB) * BLOCK_SIZE * TM * by +
+               BLOCK_SIZE * TN * bx;
+
+#pragma unroll
+    for (int i = 0; i < TM; ++i) {
+#pragma unroll
+        for (int g = 0; g < TN / VEC; ++g) {
+            int r = ty + i * BLOCK_SIZE;
+            int cc = (g * BLOCK_SIZE + tx) * VEC;
+
+#pragma unroll
+            for (int v = 0; v < VEC; ++v) {
+                if (row0 + r < hA && col0 + cc + v < wB) {
+                    float old = epilogue.ReadsC() ?
+                                ToFloat(C[c + r * wB + cc + v]) : 0.0f;
+                    Csub[i][g * VEC + v] = epilogue(Csub[i][g * VEC + v],
+                                                    row0 + r,
+                                                    col0 + cc + v, old);
+                }
+            }
+
+            StoreEpilogue<VEC>(C + c, &Csub[i][g * VEC], r, cc, hA - row0,
+                               wB - col0, wB, vecC);
+        }
+    }
+}
+
+#endif  // MATMUL_KERNELS_CUH_
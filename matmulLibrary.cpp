@@ -0,0 +1,507 @@
+/**
+ * Library interface to the matrix multiplication kernels.
+ */
+
+// System includes
+#include <stdlib.h>
+
+#include "matmulContext.h"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+#include "nvtxRange.h"
+
+cudaError_t MatmulCreate(MatmulHandle *handle) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    int device;
+    cudaDeviceProp deviceProp;
+    MATMUL_TRY(cudaGetDevice(&device));
+    MATMUL_TRY(cudaGetDeviceProperties(&deviceProp, device));
+
+    MatmulContext *ctx = new MatmulContext;
+    ctx->device = device;
+    ctx->arch = deviceProp.major * 10 + deviceProp.minor;
+    ctx->kernel = FindKernel("regTile4", 16);
+    ctx->pipelineStreams = MATMUL_PIPELINE_STREAMS;
+    ctx->panelRows = 0;
+    ctx->outOfCoreBytes = 0;
+    ctx->strassenCutoff = MATMUL_STRASSEN_CUTOFF;
+    ctx->inputMode = MATMUL_INPUT_STAGED;
+
+    cudaError_t err = cudaStreamCreateWithFlags(&ctx->ownStream,
+                                                cudaStreamNonBlocking);
+
+    if (err != cudaSuccess) {
+        delete ctx;
+        return err;
+    }
+
+    ctx->stream = ctx->ownStream;
+    *handle = ctx;
+
+    return cudaSuccess;
+}
+
+cudaError_t MatmulDestroy(MatmulHandle handle) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    cudaError_t err = SynchronizeContext(handle);
+
+    // Those of a capture that was never ended
+    for (size_t i = 0; i < handle->graphBuffers.size(); i++) {
+        handle->pool.Free(handle->graphBuffers[i]);
+    }
+
+    handle->pool.Trim();
+
+    for (size_t i = 0; i < handle->pinned.size(); i++) {
+        cudaFreeHost(handle->pinned[i].ptr);
+    }
+
+    for (size_t i = 0; i < handle->pipeStreams.size(); i++) {
+        cudaEventDestroy(handle->pipeEvents[i]);
+        cudaStreamDestroy(handle->pipeStreams[i]);
+    }
+
+    cudaStreamDestroy(handle->ownStream);
+    delete handle;
+
+    return err;
+}
+
+cudaError_t MatmulSetStream(MatmulHandle handle, cudaStream_t stream) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    handle->stream = stream;
+    return cudaSuccess;
+}
+
+cudaStream_t MatmulGetStream(MatmulHandle handle) {
+    return handle->stream;
+}
+
+cudaError_t MatmulSetKernel(MatmulHandle handle, const char *name,
+                            int block_size) {
+    if (handle == NULL || name == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    const KernelEntry *kernel = FindKernel(name, block_size);
+
+    if (kernel == NULL || kernel->minArch > handle->arch) {
+        return cudaErrorInvalidValue;
+    }
+
+    handle->kernel = kernel;
+    return cudaSuccess;
+}
+
+const KernelEntry *MatmulGetKernel(MatmulHandle handle) {
+    return handle->kernel;
+}
+
+cudaError_t MatmulSetComputeMode(MatmulHandle handle, MatmulCompute mode) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    const KernelEntry *kernel;
+
+    if (mode == MATMUL_COMPUTE_TF32) {
+        kernel = FindKernel("tf32", 32);
+    } else if (mode == MATMUL_COMPUTE_3XTF32) {
+        kernel = FindKernel("tf32x3", 32);
+    } else if (mode == MATMUL_COMPUTE_FP32) {
+        kernel = FindKernel("regTile4", 16);
+    } else {
+        return cudaErrorInvalidValue;
+    }
+
+    // Devices without TF32 tensor cores fall back to fp32 FMAs
+    if (kernel == NULL || kernel->minArch > handle->arch) {
+        mode = MATMUL_COMPUTE_FP32;
+        kernel = FindKernel("regTile4", 16);
+    }
+
+    const KernelEntry *current = handle->kernel;
+
+    if (current->compute != mode || current->inType != MATMUL_FP32) {
+        handle->kernel = kernel;
+    }
+
+    return cudaSuccess;
+}
+
+MatmulCompute MatmulGetComputeMode(MatmulHandle handle) {
+    return handle->kernel->compute;
+}
+
+cudaError_t MatmulMalloc(MatmulHandle handle, void **ptr, size_t bytes) {
+    if (handle == NULL || ptr == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    return handle->pool.Allocate(ptr, bytes, handle->stream);
+}
+
+cudaError_t MatmulFree(MatmulHandle handle, void *ptr) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    return handle->pool.Free(ptr);
+}
+
+DeviceAllocatorStats MatmulGetPoolStats(MatmulHandle handle) {
+    return handle->pool.Stats();
+}
+
+cudaError_t MatmulMultiplyDevice(MatmulHandle handle, void *d_C,
+                                 const void *d_A, const void *d_B, int M,
+                                 int N, int K) {
+    if (handle == NULL || M <= 0 || N <= 0 || K <= 0) {
+        return cudaErrorInvalidValue;
+    }
+
+    return LaunchKernel(handle, handle->kernel, d_C, d_A, d_B, M, N, K,
+                        handle->stream);
+}
+
+cudaError_t SynchronizeContext(MatmulContext *ctx) {
+    MATMUL_TRY(cudaStreamSynchronize(ctx->stream));
+
+    for (size_t i = 0; i < ctx->pipeStreams.size(); i++) {
+        MATMUL_TRY(cudaStreamSynchronize(ctx->pipeStreams[i]));
+    }
+
+    return cudaSuccess;
+}
+
+cudaError_t LaunchKernel(MatmulContext *ctx, const KernelEntry *kernel,
+                         void *d_C, const void *d_A, const void *d_B, int M,
+                         int N, int K, cudaStream_t stream) {
+    size_t bytes = kernel->workspace != NULL ? kernel->workspace(M, N, K) : 0;
+    void *workspace = NULL;
+    cudaStreamCaptureStatus status;
+    MATMUL_TRY(cudaStreamIsCapturing(stream, &status));
+    bool capturing = status == cudaStreamCaptureStatusActive;
+
+    if (bytes > 0) {
+        // Allocating is not allowed in a capture; the pool does not touch
+        // the captured stream
+        cudaStreamCaptureMode mode = cudaStreamCaptureModeRelaxed;
+
+        if (capturing) {
+            MATMUL_TRY(cudaThreadExchangeStreamCaptureMode(&mode));
+        }
+
+        cudaError_t err = ctx->pool.Allocate(&workspace, bytes, stream);
+
+        if (capturing) {
+            cudaThreadExchangeStreamCaptureMode(&mode);
+        }
+
+        MATMUL_TRY(err);
+    }
+
+    kernel->launch(d_C, d_A, d_B, M, N, K, workspace, stream);
+    cudaError_t err = cudaGetLastError();
+
+    if (workspace != NULL && capturing && err == cudaSuccess) {
+        ctx->graphBuffers.push_back(workspace);
+    } else if (workspace != NULL) {
+        ctx->pool.Free(workspace);
+    }
+
+    return err;
+}
+
+cudaError_t ReservePipelineStreams(MatmulContext *ctx, int streams) {
+    while (static_cast<int>(ctx->pipeStreams.size()) < streams) {
+        cudaStream_t stream;
+        cudaEvent_t event;
+        MATMUL_TRY(cudaStreamCreateWithFlags(&stream,
+                                             cudaStreamNonBlocking));
+        MATMUL_TRY(cudaEventCreateWithFlags(&event,
+                                            cudaEventDisableTiming));
+        ctx->pipeStreams.push_back(stream);
+        ctx->pipeEvents.push_back(event);
+    }
+
+    return cudaSuccess;
+}
+
+cudaError_t ReservePinned(MatmulContext *ctx, size_t index, size_t bytes) {
+    if (ctx->pinned.size() <= index) {
+        PinnedBuffer empty = {NULL, 0};
+        ctx->pinned.resize(index + 1, empty);
+    }
+
+    PinnedBuffer &buffer = ctx->pinned[index];
+
+    if (buffer.bytes >= bytes) {
+        return cudaSuccess;
+    }
+
+    // The old buffer may still be the source or target of queued copies
+    MATMUL_TRY(SynchronizeContext(ctx));
+
+    if (buffer.ptr != NULL) {
+        MATMUL_TRY(cudaFreeHost(buffer.ptr));
+        buffer.ptr = NULL;
+        buffer.bytes = 0;
+    }
+
+    MATMUL_TRY(cudaHostAlloc(&buffer.ptr, bytes, cudaHostAllocDefault));
+    buffer.bytes = bytes;
+
+    return cudaSuccess;
+}
+
+/**
+ * Queue the copies and the launch of one multiplication on d_A, d_B, d_C;
+ * with copyIn false the kernel reads d_A and d_B, fp32 pointers that the
+ * device can access, and h_A and h_B are not used
+ */
+static cudaError_t MultiplyHostOn(MatmulHandle handle, float *h_C,
+                                  const float *h_A, const float *h_B, int M,
+                                  int N, int K, void *d_C, void *d_A,
+                                  void *d_B, bool copyIn) {
+    const KernelEntry *kernel = handle->kernel;
+    size_t size_A = static_cast<size_t>(M) * K;
+    size_t size_B = static_cast<size_t>(K) * N;
+    size_t size_C = static_cast<size_t>(M) * N;
+    size_t bytes_A = size_A * MatmulTypeSize(kernel->inType);
+    size_t bytes_B = size_B * MatmulTypeSize(kernel->inType);
+    size_t bytes_C = size_C * MatmulTypeSize(kernel->outType);
+    bool convertIn = copyIn && kernel->inType != MATMUL_FP32;
+    bool convertOut = kernel->outType != MATMUL_FP32;
+    cudaStream_t stream = handle->stream;
+
+    // A and B are staged side by side, C reuses the front afterwards
+    if (convertIn || convertOut) {
+        size_t in = convertIn ? bytes_A + bytes_B : 0;
+        MATMUL_TRY(ReservePinned(handle, MATMUL_PINNED_STAGING,
+                                 in > bytes_C ? in : bytes_C));
+    }
+
+    char *staging = convertIn || convertOut ?
+                    static_cast<char *>(
+                        handle->pinned[MATMUL_PINNED_STAGING].ptr) : NULL;
+    const void *src_A = h_A;
+    const void *src_B = h_B;
+
+    if (convertIn) {
+        ConvertFromFloat(kernel->inType, h_A, staging, size_A);
+        ConvertFromFloat(kernel->inType, h_B, staging + bytes_A, size_B);
+        src_A = staging;
+        src_B = staging + bytes_A;
+    }
+
+    if (copyIn) {
+        MATMUL_TRY(cudaMemcpyAsync(d_A, src_A, bytes_A,
+                                   cudaMemcpyHostToDevice, stream));
+        MATMUL_TRY(cudaMemcpyAsync(d_B, src_B, bytes_B,
+                                   cudaMemcpyHostToDevice, stream));
+    }
+
+    MATMUL_TRY(LaunchKernel(handle, kernel, d_C, d_A, d_B, M, N, K, stream));
+
+    void *dst_C = convertOut ? static_cast<void *>(staging) : h_C;
+    MATMUL_TRY(cudaMemcpyAsync(dst_C, d_C, bytes_C, cudaMemcpyDeviceToHost,
+                               stream));
+    MATMUL_TRY(cudaStreamSynchronize(stream));
+
+    if (convertOut) {
+        ConvertToFloat(kernel->outType, staging, h_C, size_C);
+    }
+
+    return cudaSuccess;
+}
+
+// Read-mostly copies of managed p on the handle's device, prefetched
+// on its stream; ignored by devices that cannot migrate concurrently
+static cudaError_t PrefetchManaged(MatmulHandle handle, const void *p,
+                                   size_t bytes) {
+    int concurrent = 0;
+    MATMUL_TRY(cudaDeviceGetAttribute(
+                   &concurrent, cudaDevAttrConcurrentManagedAccess,
+                   handle->device));
+
+    if (!concurrent) {
+        return cudaSuccess;
+    }
+
+#if CUDART_VERSION >= 13000
+    cudaMemLocation location = {cudaMemLocationTypeDevice, handle->device};
+    MATMUL_TRY(cudaMemAdvise(p, bytes, cudaMemAdviseSetReadMostly,
+                             location));
+    return cudaMemPrefetchAsync(p, bytes, location, 0, handle->stream);
+#else
+    MATMUL_TRY(cudaMemAdvise(p, bytes, cudaMemAdviseSetReadMostly,
+                             handle->device));
+    return cudaMemPrefetchAsync(p, bytes, handle->device, handle->stream);
+#endif
+}
+
+// MatmulMultiplyHost with inputs that the kernel reads where they are
+static cudaError_t MultiplyHostDirect(MatmulHandle handle, float *h_C,
+                                      const float *h_A, const float *h_B,
+                                      int M, int N, int K) {
+    const KernelEntry *kernel = handle->kernel;
+
+    if (kernel->inType != MATMUL_FP32) {
+        return cudaErrorInvalidValue;
+    }
+
+    size_t bytes_A = sizeof(float) * static_cast<size_t>(M) * K;
+    size_t bytes_B = sizeof(float) * static_cast<size_t>(K) * N;
+    void *d_A = const_cast<float *>(h_A);
+    void *d_B = const_cast<float *>(h_B);
+
+    if (handle->inputMode == MATMUL_INPUT_MAPPED) {
+        // Fails for memory that is not mapped pinned memory
+        MATMUL_TRY(cudaHostGetDevicePointer(&d_A, d_A, 0));
+        MATMUL_TRY(cudaHostGetDevicePointer(&d_B, d_B, 0));
+    } else {
+        cudaPointerAttributes attr_A, attr_B;
+        MATMUL_TRY(cudaPointerGetAttributes(&attr_A, h_A));
+        MATMUL_TRY(cudaPointerGetAttributes(&attr_B, h_B));
+
+        if (attr_A.type != cudaMemoryTypeManaged ||
+                attr_B.type != cudaMemoryTypeManaged) {
+            return cudaErrorInvalidValue;
+        }
+
+        MATMUL_TRY(PrefetchManaged(handle, h_A, bytes_A));
+        MATMUL_TRY(PrefetchManaged(handle, h_B, bytes_B));
+    }
+
+    void *d_C = NULL;
+    cudaError_t err = MatmulMalloc(handle, &d_C,
+                                   MatmulTypeSize(kernel->outType) *
+                                   static_cast<size_t>(M) * N);
+
+    if (err == cudaSuccess) {
+        err = MultiplyHostOn(handle, h_C, h_A, h_B, M, N, K, d_C, d_A, d_B,
+                             false);
+    }
+
+    MatmulFree(handle, d_C);
+    return err;
+}
+
+cudaError_t MatmulMultiplyHost(MatmulHandle handle, float *h_C,
+                               const float *h_A, const float *h_B, int M,
+                               int N, int K) {
+    NvtxRange range("MatmulMultiplyHost");
+
+    if (handle == NULL || h_C == NULL || h_A == NULL || h_B == NULL ||
+            M <= 0 || N <= 0 || K <= 0) {
+        return cudaErrorInvalidValue;
+    }
+
+    if (handle->inputMode != MATMUL_INPUT_STAGED) {
+        return MultiplyHostDirect(handle, h_C, h_A, h_B, M, N, K);
+    }
+
+    const KernelEntry *kernel = handle->kernel;
+    size_t in = MatmulTypeSize(kernel->inType);
+    size_t out = MatmulTypeSize(kernel->outType);
+    void *d_A = NULL;
+    void *d_B = NULL;
+    void *d_C = NULL;
+
+    cudaError_t err = MatmulMalloc(handle, &d_A,
+                                   in * static_cast<size_t>(M) * K);
+
+    if (err == cudaSuccess) {
+        err = MatmulMalloc(handle, &d_B, in * static_cast<size_t>(K) * N);
+    }
+
+    if (err == cudaSuccess) {
+        err = MatmulMalloc(handle, &d_C, out * static_cast<size_t>(M) * N);
+    }
+
+    if (err == cudaSuccess) {
+        err = MultiplyHostOn(handle, h_C, h_A, h_B, M, N, K, d_C, d_A, d_B,
+                             true);
+    }
+
+    // The buffers go back to the pool even if the call failed
+    MatmulFree(handle, d_A);
+    MatmulFree(handle, d_B);
+    MatmulFree(handle, d_C);
+
+    return err;
+}
+
+cudaError_t MatmulSetInputMode(MatmulHandle handle, MatmulInputMode mode) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    int supported = 1;
+
+    if (mode == MATMUL_INPUT_MAPPED) {
+        MATMUL_TRY(cudaDeviceGetAttribute(
+                       &supported, cudaDevAttrCanMapHostMemory,
+                       handle->device));
+    } else if (mode == MATMUL_INPUT_MANAGED) {
+        MATMUL_TRY(cudaDeviceGetAttribute(
+                       &supported, cudaDevAttrManagedMemory,
+                       handle->device));
+    } else if (mode != MATMUL_INPUT_STAGED) {
+        return cudaErrorInvalidValue;
+    }
+
+    if (!supported) {
+        return cudaErrorNotSupported;
+    }
+
+    handle->inputMode = mode;
+    return cudaSuccess;
+}
+
+MatmulInputMode MatmulGetInputMode(MatmulHandle handle) {
+    return handle->inputMode;
+}
+
+cudaError_t MatmulHostAlloc(MatmulHandle handle, void **ptr, size_t bytes) {
+    if (handle == NULL || ptr == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    switch (handle->inputMode) {
+    case MATMUL_INPUT_MAPPED:
+        return cudaHostAlloc(ptr, bytes, cudaHostAllocMapped);
+
+    case MATMUL_INPUT_MANAGED:
+        return cudaMallocManaged(ptr, bytes, cudaMemAttachGlobal);
+
+    default:
+        return cudaHostAlloc(ptr, bytes, cudaHostAllocDefault);
+    }
+}
+
+cudaError_t MatmulHostFree(MatmulHandle handle, void *ptr) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    if (ptr == NULL) {
+        return cudaSuccess;
+    }
+
+    // Whatever the mode is now, ptr may come from an earlier one
+    cudaPointerAttributes attr;
+    MATMUL_TRY(cudaPointerGetAttributes(&attr, ptr));
+    return attr.type == cudaMemoryTypeManaged ? cudaFree(ptr) :
+           cudaFreeHost(ptr);
+}
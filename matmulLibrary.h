@@ -0,0 +1,273 @@
+/**
+ * Library interface to the matrix multiplication kernels.
+ *
+ * A handle binds a device, a stream, a registered kernel and a caching
+ * device allocator (deviceAllocator.h). Device buffers needed by a call
+ * come from the allocator and go back to it afterwards, so a loop of calls
+ * does not pay for cudaMalloc and cudaFree, nor for the device-wide
+ * synchronization they imply. All functions return cudaSuccess or the
+ * first error; cudaErrorInvalidValue flags bad arguments.
+ *
+ * C is M x N, A is M x K and B is K x N, all row-major.
+ */
+
+#ifndef MATMUL_LIBRARY_H_
+#define MATMUL_LIBRARY_H_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "deviceAllocator.h"
+#include "kernelRegistry.h"
+
+typedef struct MatmulContext *MatmulHandle;
+typedef struct MatmulGraphState *MatmulGraph;
+
+// Streams of the panel pipeline unless set with MatmulSetPipeline
+#define MATMUL_PIPELINE_STREAMS 3
+
+// Cutoff of MatmulMultiplyStrassen unless set with MatmulSetStrassenCutoff
+#define MATMUL_STRASSEN_CUTOFF 1024
+
+/**
+ * Create a handle on the current device, with a stream of its own and the
+ * default kernel (regTile4, block size 16)
+ */
+cudaError_t MatmulCreate(MatmulHandle *handle);
+
+/**
+ * Wait for the handle's work, then release its stream and cached memory
+ */
+cudaError_t MatmulDestroy(MatmulHandle handle);
+
+/**
+ * Issue all further work into stream instead of the handle's own stream
+ */
+cudaError_t MatmulSetStream(MatmulHandle handle, cudaStream_t stream);
+
+cudaStream_t MatmulGetStream(MatmulHandle handle);
+
+/**
+ * Use the registered kernel of the given family and block size; fails if
+ * it does not exist or needs a newer device
+ */
+cudaError_t MatmulSetKernel(MatmulHandle handle, const char *name,
+                            int block_size);
+
+const KernelEntry *MatmulGetKernel(MatmulHandle handle);
+
+/**
+ * Use the default kernel of an arithmetic mode: regTile4 for
+ * MATMUL_COMPUTE_FP32, tf32 and tf32x3 (block size 32) for TF32 and
+ * 3xTF32. The current kernel is kept if it already has the mode. Modes
+ * the device cannot run fall back to fp32, which keeps the current
+ * kernel if it is an fp32 one; MatmulGetComputeMode tells which mode is
+ * in effect.
+ */
+cudaError_t MatmulSetComputeMode(MatmulHandle handle, MatmulCompute mode);
+
+MatmulCompute MatmulGetComputeMode(MatmulHandle handle);
+
+/**
+ * Device memory from the handle's allocator, ordered on its stream
+ */
+cudaError_t MatmulMalloc(MatmulHandle handle, void **ptr, size_t bytes);
+cudaError_t MatmulFree(MatmulHandle handle, void *ptr);
+
+DeviceAllocatorStats MatmulGetPoolStats(MatmulHandle handle);
+
+/**
+ * d_C = d_A * d_B with the handle's kernel, for device matrices in the
+ * kernel's element types. Returns once the launch is queued.
+ */
+cudaError_t MatmulMultiplyDevice(MatmulHandle handle, void *d_C,
+                                 const void *d_A, const void *d_B, int M,
+                                 int N, int K);
+
+/**
+ * h_C = h_A * h_B for fp32 host matrices, converted to and from the
+ * kernel's element types as needed. Returns once h_C holds the result.
+ */
+cudaError_t MatmulMultiplyHost(MatmulHandle handle, float *h_C,
+                               const float *h_A, const float *h_B, int M,
+                               int N, int K);
+
+// Where MatmulMultiplyHost reads h_A and h_B from
+enum MatmulInputMode {
+    // Copied into device buffers first (the default); any host memory
+    MATMUL_INPUT_STAGED,
+
+    // Read by the kernel over the bus; mapped pinned memory, from
+    // MatmulHostAlloc or cudaHostRegister with cudaHostRegisterMapped
+    MATMUL_INPUT_MAPPED,
+
+    // Migrated on demand, with read-mostly and prefetch hints for the
+    // handle's device; managed memory, from MatmulHostAlloc or
+    // cudaMallocManaged
+    MATMUL_INPUT_MANAGED
+};
+
+inline const char *MatmulInputModeName(MatmulInputMode mode) {
+    switch (mode) {
+    case MATMUL_INPUT_STAGED:
+        return "staged";
+
+    case MATMUL_INPUT_MAPPED:
+        return "mapped";
+
+    case MATMUL_INPUT_MANAGED:
+        return "managed";
+    }
+
+    return "unknown";
+}
+
+/**
+ * Set how MatmulMultiplyHost reads its inputs. The mapped and managed
+ * modes skip the copy of A and B, which pays for inputs used only once,
+ * but need a kernel with fp32 inputs and memory of the mode; other memory
+ * makes MatmulMultiplyHost return cudaErrorInvalidValue. Returns
+ * cudaErrorNotSupported if the device cannot map host memory, or has no
+ * managed memory.
+ */
+cudaError_t MatmulSetInputMode(MatmulHandle handle, MatmulInputMode mode);
+MatmulInputMode MatmulGetInputMode(MatmulHandle handle);
+
+/**
+ * Host memory for inputs of MatmulMultiplyHost in the handle's input mode:
+ * pinned, mapped pinned or managed. Free it with MatmulHostFree.
+ */
+cudaError_t MatmulHostAlloc(MatmulHandle handle, void **ptr, size_t bytes);
+cudaError_t MatmulHostFree(MatmulHandle handle, void *ptr);
+
+/**
+ * Use streams streams (1 to 16) and panels of panelRows rows of C for
+ * MatmulMultiplyHostPipelined; panelRows = 0 derives the panel height
+ * from M
+ */
+cudaError_t MatmulSetPipeline(MatmulHandle handle, int streams,
+                              int panelRows);
+
+/**
+ * h_C = h_A * h_B like MatmulMultiplyHost, but C is split into row panels
+ * that rotate over the pipeline streams, so that the copy of the next
+ * panel of A, the kernel of the current one and the copy back of the
+ * previous panel of C overlap. Host matrices that are not pinned, or not
+ * in the kernel's element types, are staged through pinned buffers of
+ * the handle panel by panel.
+ *
+ * Between MatmulCaptureBegin and MatmulCaptureEnd the whole pipeline is
+ * recorded: the pipeline streams fork from the handle's stream and join
+ * it again, and nothing waits on the host. This needs an fp32 kernel and
+ * pinned h_A, h_B and h_C (else cudaErrorStreamCaptureUnsupported). The
+ * device buffers of a recorded pipeline belong to the graph that
+ * MatmulCaptureEnd makes of it: they are released when a later capture
+ * replaces the graph's work and by MatmulGraphDestroy.
+ */
+cudaError_t MatmulMultiplyHostPipelined(MatmulHandle handle, float *h_C,
+                                        const float *h_A, const float *h_B,
+                                        int M, int N, int K);
+
+/**
+ * Limit the device memory of MatmulMultiplyOutOfCore to deviceBytes;
+ * 0 (the default) uses most of the free memory at the time of the call
+ */
+cudaError_t MatmulSetOutOfCore(MatmulHandle handle, size_t deviceBytes);
+
+/**
+ * h_C = h_A * h_B for fp32 host matrices of any size: only square tiles of
+ * C and the matching blocks of A and B are on the device at a time, and
+ * the partial products of the K-slices are accumulated there. The host
+ * matrices may be memory-mapped files (mappedFile.h). Needs a kernel with
+ * fp32 output; returns cudaErrorMemoryAllocation if not even the smallest
+ * tiles fit.
+ */
+cudaError_t MatmulMultiplyOutOfCore(MatmulHandle handle, float *h_C,
+                                    const float *h_A, const float *h_B,
+                                    int M, int N, int K);
+
+/**
+ * Stop the recursion of MatmulMultiplyStrassen once M, N or K is at most
+ * cutoff (MATMUL_STRASSEN_CUTOFF by default)
+ */
+cudaError_t MatmulSetStrassenCutoff(MatmulHandle handle, int cutoff);
+
+/**
+ * d_C = d_A * d_B for fp32 device matrices with Strassen-Winograd: 7
+ * products of half the size per level in place of 8, with the fp32 tiled
+ * kernel below the cutoff whatever the handle's kernel. Needs two
+ * temporaries of a quarter of a level's operands per level, from the
+ * allocator. Each level costs some accuracy: the error bound grows by a
+ * factor of about 12 per level instead of 2.
+ */
+cudaError_t MatmulMultiplyStrassen(MatmulHandle handle, float *d_C,
+                                   const float *d_A, const float *d_B, int M,
+                                   int N, int K);
+
+// Share of one device in MatmulMultiplyMultiGpu
+struct MatmulDeviceStats {
+    int device;
+
+    // Rows and columns of C the device computed, the tiles of C they are
+    // made of, and the panels of A and B it received from a peer device
+    // instead of the host
+    int rows;
+    int cols;
+    int tiles;
+    int peerPanels;
+
+    // Time of its kernel, and of all its work from the first copy on
+    float kernelMs;
+    float totalMs;
+};
+
+/**
+ * h_C = h_A * h_B for fp32 host matrices over count handles, one per
+ * device, each with an fp32 kernel. The devices form a grid and square
+ * tiles of C with edge tile (0 picks one from M and N) are distributed
+ * 2D block-cyclically over it; A and B panels are broadcast along the
+ * grid rows and columns with peer-to-peer copies where supported. Each
+ * device runs in a worker thread on the stream of its handle. stats, if
+ * not NULL, receives count entries. Host matrices should be pinned with
+ * cudaHostAllocPortable for the copies of the devices to overlap.
+ */
+cudaError_t MatmulMultiplyMultiGpu(MatmulHandle *handles, int count,
+                                   int tile, float *h_C, const float *h_A,
+                                   const float *h_B, int M, int N, int K,
+                                   MatmulDeviceStats *stats);
+
+/**
+ * Record instead of run the work issued into the handle's stream from now
+ * on, until MatmulCaptureEnd. Only asynchronous work can be recorded:
+ * MatmulMultiplyDevice, the kernels and cudaMemcpyAsync calls on the
+ * stream, and MatmulMultiplyHostPipelined with its streams on pinned fp32
+ * matrices, but not the other host multiplications, which wait for their
+ * results, nor MatmulMalloc; allocate the buffers before the capture.
+ */
+cudaError_t MatmulCaptureBegin(MatmulHandle handle);
+
+/**
+ * Stop recording and make the recorded work replayable. If *graph is NULL
+ * a new graph is created; otherwise the existing one is updated in place
+ * when the recording has the same structure (typically the same plan on
+ * other buffers), and rebuilt when it has not. Device buffers that the
+ * previous recording held (see MatmulMultiplyHostPipelined) are released,
+ * so its replays must have finished.
+ */
+cudaError_t MatmulCaptureEnd(MatmulHandle handle, MatmulGraph *graph);
+
+// Whether the last MatmulCaptureEnd into graph updated it in place
+bool MatmulGraphWasUpdated(MatmulGraph graph);
+
+/**
+ * Replay the recorded work into stream with a single launch
+ */
+cudaError_t MatmulGraphLaunch(MatmulGraph graph, cudaStream_t stream);
+
+/**
+ * Release graph and the device buffers it holds; its replays must have
+ * finished, and the handle it was captured from must still exist
+ */
+cudaError_t MatmulGraphDestroy(MatmulGraph graph);
+
+#endif  // MATMUL_LIBRARY_H_
@@ -0,0 +1,317 @@
+/**
+ * Panel pipeline of the library: overlapped host-to-device copies,
+ * kernels and device-to-host copies over several streams.
+ */
+
+// System includes
+#include <string.h>
+
+#include "matmulContext.h"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+#include "nvtxRange.h"
+
+// Upper limit of MatmulSetPipeline
+#define MATMUL_MAX_PIPELINE_STREAMS 16
+
+// Panels are a multiple of this many rows, which covers the block
+// sub-matrix of every registered kernel
+#define MATMUL_PANEL_ALIGN 64
+
+// Panel height for M rows on streams streams: about four panels per
+// stream, so that the pipeline fills quickly
+static int PanelRows(int M, int streams) {
+    int target = (M + 4 * streams - 1) / (4 * streams);
+    int rows = (target + MATMUL_PANEL_ALIGN - 1) / MATMUL_PANEL_ALIGN *
+               MATMUL_PANEL_ALIGN;
+    return rows < M ? rows : M;
+}
+
+// True if p points to page-locked host memory
+static bool IsPinned(const void *p) {
+    cudaPointerAttributes attributes;
+
+    if (cudaPointerGetAttributes(&attributes, p) != cudaSuccess) {
+        // Older runtimes report unregistered host memory as an error
+        cudaGetLastError();
+        return false;
+    }
+
+    return attributes.type == cudaMemoryTypeHost;
+}
+
+cudaError_t MatmulSetPipeline(MatmulHandle handle, int streams,
+                              int panelRows) {
+    if (handle == NULL || streams < 1 ||
+            streams > MATMUL_MAX_PIPELINE_STREAMS || panelRows < 0) {
+        return cudaErrorInvalidValue;
+    }
+
+    handle->pipelineStreams = streams;
+    handle->panelRows = panelRows;
+    return cudaSuccess;
+}
+
+// Panel of the pipeline a stream slot last worked on
+struct PanelSlot {
+    void *d_A;
+    void *d_C;
+
+    // First row and number of rows of the panel, rows = 0 if none
+    int row;
+    int rows;
+};
+
+// Move the finished panel of slot s from its pinned buffer to h_C
+static cudaError_t DrainSlot(MatmulHandle handle, int s, PanelSlot *slot,
+                             float *h_C, int N, bool stagedC) {
+    if (slot->rows == 0) {
+        return cudaSuccess;
+    }
+
+    MATMUL_TRY(cudaEventSynchronize(handle->pipeEvents[s]));
+
+    if (stagedC) {
+        ConvertToFloat(handle->kernel->outType,
+                       handle->pinned[MATMUL_PINNED_C_PANEL(s)].ptr,
+                       h_C + static_cast<size_t>(slot->row) * N,
+                       static_cast<size_t>(slot->rows) * N);
+    }
+
+    slot->rows = 0;
+    return cudaSuccess;
+}
+
+/**
+ * Issue the panels over the slots; while capturing nothing is staged and
+ * nothing waits on the host, and the pipeline streams join the handle's
+ * stream at the end
+ */
+static cudaError_t RunPipeline(MatmulHandle handle, float *h_C,
+                               const float *h_A, const float *h_B, int M,
+                               int N, int K, void *d_B,
+                               std::vector<PanelSlot> *slots,
+                               bool capturing) {
+    const KernelEntry *kernel = handle->kernel;
+    int streams = static_cast<int>(slots->size());
+    int panelRows = handle->panelRows > 0 ? handle->panelRows :
+                    PanelRows(M, streams);
+    size_t in = MatmulTypeSize(kernel->inType);
+    size_t out = MatmulTypeSize(kernel->outType);
+
+    // Matrices in the kernel's types in pinned memory are copied directly
+    bool stagedA = kernel->inType != MATMUL_FP32 || !IsPinned(h_A);
+    bool stagedB = kernel->inType != MATMUL_FP32 || !IsPinned(h_B);
+    bool stagedC = kernel->outType != MATMUL_FP32 || !IsPinned(h_C);
+
+    // B is needed by every panel: copy it once on the first stream and
+    // make the others wait for it
+    const void *src_B = h_B;
+    size_t bytes_B = in * K * N;
+
+    if (stagedB) {
+        MATMUL_TRY(ReservePinned(handle, MATMUL_PINNED_B, bytes_B));
+        ConvertFromFloat(kernel->inType, h_B,
+                         handle->pinned[MATMUL_PINNED_B].ptr,
+                         static_cast<size_t>(K) * N);
+        src_B = handle->pinned[MATMUL_PINNED_B].ptr;
+    }
+
+    MATMUL_TRY(cudaMemcpyAsync(d_B, src_B, bytes_B, cudaMemcpyHostToDevice,
+                               handle->pipeStreams[0]));
+    MATMUL_TRY(cudaEventRecord(handle->pipeEvents[0],
+                               handle->pipeStreams[0]));
+
+    for (int s = 1; s < streams; s++) {
+        MATMUL_TRY(cudaStreamWaitEvent(handle->pipeStreams[s],
+                                       handle->pipeEvents[0], 0));
+    }
+
+    for (int s = 0; s < streams; s++) {
+        if (stagedA) {
+            MATMUL_TRY(ReservePinned(handle, MATMUL_PINNED_A_PANEL(s),
+                                     in * panelRows * K));
+        }
+
+        if (stagedC) {
+            MATMUL_TRY(ReservePinned(handle, MATMUL_PINNED_C_PANEL(s),
+                                     out * panelRows * N));
+        }
+    }
+
+    for (int p = 0, row = 0; row < M; p++, row += panelRows) {
+        int s = p % streams;
+        int rows = M - row < panelRows ? M - row : panelRows;
+        PanelSlot &slot = (*slots)[s];
+        cudaStream_t stream = handle->pipeStreams[s];
+
+        // The slot's buffers are free once its previous panel is back;
+        // unstaged panels need no wait, their copies are stream-ordered
+        if (!capturing) {
+            MATMUL_TRY(DrainSlot(handle, s, &slot, h_C, N, stagedC));
+        }
+
+        const float *panel_A = h_A + static_cast<size_t>(row) * K;
+        const void *src_A = panel_A;
+
+        if (stagedA) {
+            void *pinned_A = handle->pinned[MATMUL_PINNED_A_PANEL(s)].ptr;
+            ConvertFromFloat(kernel->inType, panel_A, pinned_A,
+                             static_cast<size_t>(rows) * K);
+            src_A = pinned_A;
+        }
+
+        MATMUL_TRY(cudaMemcpyAsync(slot.d_A, src_A, in * rows * K,
+                                   cudaMemcpyHostToDevice, stream));
+
+        MATMUL_TRY(LaunchKernel(handle, kernel, slot.d_C, slot.d_A, d_B,
+                                rows, N, K, stream));
+
+        void *dst_C = stagedC ?
+                      handle->pinned[MATMUL_PINNED_C_PANEL(s)].ptr :
+                      static_cast<void *>(h_C +
+                                          static_cast<size_t>(row) * N);
+        MATMUL_TRY(cudaMemcpyAsync(dst_C, slot.d_C, out * rows * N,
+                                   cudaMemcpyDeviceToHost, stream));
+        MATMUL_TRY(cudaEventRecord(handle->pipeEvents[s], stream));
+
+        slot.row = row;
+        slot.rows = rows;
+    }
+
+    for (int s = 0; s < streams; s++) {
+        if (capturing) {
+            MATMUL_TRY(cudaEventRecord(handle->pipeEvents[s],
+                                       handle->pipeStreams[s]));
+            MATMUL_TRY(cudaStreamWaitEvent(handle->stream,
+                                           handle->pipeEvents[s], 0));
+        } else {
+            MATMUL_TRY(DrainSlot(handle, s, &(*slots)[s], h_C, N,
+                                 stagedC));
+        }
+    }
+
+    return cudaSuccess;
+}
+
+cudaError_t MatmulMultiplyHostPipelined(MatmulHandle handle, float *h_C,
+                                        const float *h_A, const float *h_B,
+                                        int M, int N, int K) {
+    NvtxRange range("MatmulMultiplyHostPipelined");
+
+    if (handle == NULL || h_C == NULL || h_A == NULL || h_B == NULL ||
+            M <= 0 || N <= 0 || K <= 0) {
+        return cudaErrorInvalidValue;
+    }
+
+    const KernelEntry *kernel = handle->kernel;
+    int panelRows = handle->panelRows > 0 ? handle->panelRows :
+                    PanelRows(M, handle->pipelineStreams);
+
+    // No more streams than panels
+    int panels = (M + panelRows - 1) / panelRows;
+    int streams = handle->pipelineStreams < panels ?
+                  handle->pipelineStreams : panels;
+    cudaStreamCaptureStatus capture;
+    MATMUL_TRY(cudaStreamIsCapturing(handle->stream, &capture));
+    bool capturing = capture == cudaStreamCaptureStatusActive;
+
+    // A recorded pipeline copies the host matrices as they are when the
+    // graph is replayed, so they must need no staging
+    if (capturing && (kernel->inType != MATMUL_FP32 ||
+                      kernel->outType != MATMUL_FP32 || !IsPinned(h_A) ||
+                      !IsPinned(h_B) || !IsPinned(h_C))) {
+        return cudaErrorStreamCaptureUnsupported;
+    }
+
+    // Creating streams and allocating are not allowed in a capture; the
+    // calls below do not touch the captured streams
+    cudaStreamCaptureMode mode = cudaStreamCaptureModeRelaxed;
+
+    if (capturing) {
+        MATMUL_TRY(cudaThreadExchangeStreamCaptureMode(&mode));
+    }
+
+    cudaError_t err = ReservePipelineStreams(handle, streams);
+
+    if (capturing) {
+        cudaThreadExchangeStreamCaptureMode(&mode);
+    }
+
+    MATMUL_TRY(err);
+
+    if (capturing) {
+        // Fork: the pipeline streams join the capture after the work
+        // recorded so far
+        MATMUL_TRY(cudaEventRecord(handle->pipeEvents[0], handle->stream));
+
+        for (int s = 0; s < streams; s++) {
+            MATMUL_TRY(cudaStreamWaitEvent(handle->pipeStreams[s],
+                                           handle->pipeEvents[0], 0));
+        }
+    } else {
+        // Work queued on the handle's stream comes first
+        MATMUL_TRY(cudaStreamSynchronize(handle->stream));
+    }
+
+    size_t in = MatmulTypeSize(kernel->inType);
+    size_t out = MatmulTypeSize(kernel->outType);
+    std::vector<PanelSlot> slots(streams);
+    void *d_B = NULL;
+
+    if (capturing) {
+        MATMUL_TRY(cudaThreadExchangeStreamCaptureMode(&mode));
+    }
+
+    err = handle->pool.Allocate(&d_B, in * K * N, handle->pipeStreams[0]);
+
+    for (int s = 0; s < streams; s++) {
+        slots[s].d_A = NULL;
+        slots[s].d_C = NULL;
+        slots[s].row = 0;
+        slots[s].rows = 0;
+
+        if (err == cudaSuccess) {
+            err = handle->pool.Allocate(&slots[s].d_A, in * panelRows * K,
+                                        handle->pipeStreams[s]);
+        }
+
+        if (err == cudaSuccess) {
+            err = handle->pool.Allocate(&slots[s].d_C, out * panelRows * N,
+                                        handle->pipeStreams[s]);
+        }
+    }
+
+    if (capturing) {
+        cudaThreadExchangeStreamCaptureMode(&mode);
+    }
+
+    if (err == cudaSuccess) {
+        err = RunPipeline(handle, h_C, h_A, h_B, M, N, K, d_B, &slots,
+                          capturing);
+    }
+
+    // On failure work may still be queued on the buffers; a failed
+    // capture is invalidated, and nothing of it runs
+    if (err != cudaSuccess && !capturing) {
+        SynchronizeContext(handle);
+    }
+
+    // The graph replays the buffers; MatmulCaptureEnd gives them to it
+    std::vector<void *> buffers(1, d_B);
+
+    for (int s = 0; s < streams; s++) {
+        buffers.push_back(slots[s].d_A);
+        buffers.push_back(slots[s].d_C);
+    }
+
+    for (size_t i = 0; i < buffers.size(); i++) {
+        if (capturing && err == cudaSuccess) {
+            handle->graphBuffers.push_back(buffers[i]);
+        } else {
+            handle->pool.Free(buffers[i]);
+        }
+    }
+
+    return err;
+}
@@ -0,0 +1,455 @@
+/**
+ * Request queue, shape batching and stream pool of GemmServer.
+ */
+
+// System includes
+#include <chrono>
+
+#include "matmulBatched.h"
+#include "matmulServer.h"
+
+// Pointer arrays in flight per stream before the dispatcher waits
+#define SERVER_SLOTS_PER_STREAM 4
+
+// Longest sleep of an idle dispatcher between checks of the queue
+#define SERVER_IDLE_MS 10.0
+
+static double HostMs() {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool GemmServer::Shape::operator<(const Shape &other) const {
+    if (M != other.M) {
+        return M < other.M;
+    }
+
+    if (N != other.N) {
+        return N < other.N;
+    }
+
+    return K < other.K;
+}
+
+GemmServer::GemmServer(int streams, int maxBatch, double budgetUs,
+                       int blockSize)
+    : device_(0), maxBatch_(maxBatch), budgetMs_(budgetUs / 1000.0),
+      blockSize_(blockSize), status_(cudaSuccess), nextSlot_(0),
+      head_(&stub_), tail_(&stub_), queued_(0), sleeping_(false),
+      stopping_(false), requests_(0), batches_(0), fullBatches_(0),
+      failed_(0) {
+    stub_.next.store(NULL);
+
+    if (streams < 1 || maxBatch < 1 || budgetUs < 0.0 ||
+        (blockSize != 16 && blockSize != 32)) {
+        status_ = cudaErrorInvalidValue;
+    }
+
+    if (status_ == cudaSuccess) {
+        status_ = cudaGetDevice(&device_);
+    }
+
+    for (int i = 0; status_ == cudaSuccess && i < streams; i++) {
+        cudaStream_t stream;
+        status_ = cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking);
+
+        if (status_ == cudaSuccess) {
+            streams_.push_back(stream);
+        }
+    }
+
+    // C, A and B pointers of a batch, pinned so that the copy is async
+    size_t bytes = 3 * sizeof(void *) * maxBatch;
+
+    for (size_t i = 0; status_ == cudaSuccess &&
+         i < streams_.size() * SERVER_SLOTS_PER_STREAM; i++) {
+        Slot slot = {NULL, NULL, NULL};
+        status_ = cudaMallocHost(reinterpret_cast<void **>(&slot.h_ptrs),
+                                 bytes);
+
+        if (status_ == cudaSuccess) {
+            status_ = cudaMalloc(reinterpret_cast<void **>(&slot.d_ptrs),
+                                 bytes);
+        }
+
+        if (status_ == cudaSuccess) {
+            status_ = cudaEventCreateWithFlags(&slot.copied,
+                                               cudaEventDisableTiming);
+        }
+
+        slots_.push_back(slot);
+    }
+
+    dispatcher_ = std::thread(&GemmServer::Dispatch, this);
+}
+
+GemmServer::~GemmServer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_.store(true);
+        wake_.notify_one();
+    }
+
+    dispatcher_.join();
+
+    // Also waits for the host functions of abandoned launches, which use
+    // this
+    for (size_t i = 0; i < streams_.size(); i++) {
+        cudaStreamSynchronize(streams_[i]);
+    }
+
+    for (size_t i = 0; i < abandoned_.size(); i++) {
+        events_.push_back(abandoned_[i]->done);
+        delete abandoned_[i];
+    }
+
+    for (size_t i = 0; i < events_.size(); i++) {
+        cudaEventDestroy(events_[i]);
+    }
+
+    for (size_t i = 0; i < slots_.size(); i++) {
+        cudaFreeHost(slots_[i].h_ptrs);
+        cudaFree(slots_[i].d_ptrs);
+
+        if (slots_[i].copied != NULL) {
+            cudaEventDestroy(slots_[i].copied);
+        }
+    }
+
+    for (size_t i = 0; i < streams_.size(); i++) {
+        cudaStreamDestroy(streams_[i]);
+    }
+}
+
+void GemmServer::Submit(const GemmRequest &request) {
+    Node *node = new Node;
+    node->request = request;
+    Push(node);
+
+    // Seen by the dispatcher before it sleeps, or it is woken; both
+    // atomics are sequentially consistent
+    queued_.fetch_add(1);
+
+    if (sleeping_.load()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_.notify_one();
+    }
+}
+
+static void SetPromise(void *user, cudaError_t status) {
+    std::promise<cudaError_t> *promise =
+        static_cast<std::promise<cudaError_t> *>(user);
+    promise->set_value(status);
+    delete promise;
+}
+
+std::future<cudaError_t> GemmServer::Submit(float *C, const float *A,
+                                            const float *B, int M, int N,
+                                            int K) {
+    std::promise<cudaError_t> *promise = new std::promise<cudaError_t>;
+    std::future<cudaError_t> future = promise->get_future();
+    GemmRequest request = {C, A, B, M, N, K, SetPromise, promise};
+    Submit(request);
+    return future;
+}
+
+GemmServerStats GemmServer::Stats() const {
+    GemmServerStats stats;
+    stats.requests = requests_.load();
+    stats.batches = batches_.load();
+    stats.fullBatches = fullBatches_.load();
+    stats.failed = failed_.load();
+    return stats;
+}
+
+/**
+ * Append node: one exchange, after which the node is linked behind the
+ * previous head. Until that store the queue looks empty from there on.
+ */
+void GemmServer::Push(Node *node) {
+    node->next.store(NULL, std::memory_order_relaxed);
+    Node *prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+/**
+ * Oldest node, or NULL if the queue is empty or a producer is between
+ * the two steps of Push; dispatcher thread only
+ */
+GemmServer::Node *GemmServer::Pop() {
+    Node *tail = tail_;
+    Node *next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &stub_) {
+        if (next == NULL) {
+            return NULL;
+        }
+
+        tail_ = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != NULL) {
+        tail_ = next;
+        return tail;
+    }
+
+    if (tail != head_.load(std::memory_order_acquire)) {
+        return NULL;
+    }
+
+    // tail is the last node: put the stub behind it to take it out
+    Push(&stub_);
+    next = tail->next.load(std::memory_order_acquire);
+
+    if (next != NULL) {
+        tail_ = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+void GemmServer::Dispatch() {
+    if (status_ == cudaSuccess) {
+        status_ = cudaSetDevice(device_);
+    }
+
+    while (true) {
+        Reap();
+        Node *node;
+
+        while ((node = Pop()) != NULL) {
+            queued_.fetch_sub(1);
+            Shape shape = {node->request.M, node->request.N,
+                           node->request.K};
+            Group &group = groups_[shape];
+
+            if (group.nodes.empty()) {
+                group.firstMs = HostMs();
+            }
+
+            group.nodes.push_back(node);
+
+            if (static_cast<int>(group.nodes.size()) == maxBatch_) {
+                fullBatches_.fetch_add(1);
+                Launch(shape, &group.nodes);
+            }
+        }
+
+        // Issue the groups whose oldest request is out of budget, and
+        // everything when stopping
+        bool stopping = stopping_.load();
+        double now = HostMs();
+        double waitMs = SERVER_IDLE_MS;
+
+        for (std::map<Shape, Group>::iterator it = groups_.begin();
+             it != groups_.end(); ++it) {
+            Group &group = it->second;
+
+            if (group.nodes.empty()) {
+                continue;
+            }
+
+            double leftMs = group.firstMs + budgetMs_ - now;
+
+            if (stopping || leftMs <= 0.0) {
+                Launch(it->first, &group.nodes);
+            } else if (leftMs < waitMs) {
+                waitMs = leftMs;
+            }
+        }
+
+        if (stopping && queued_.load() == 0 && inflight_.empty()) {
+            break;
+        }
+
+        // Sleep until a request arrives, a launch finishes or the next
+        // group is due; at most SERVER_IDLE_MS with launches in flight,
+        // which bounds the wait for a sticky error
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.store(true);
+
+        if (queued_.load() == 0 && finished_.empty() &&
+                (!stopping_.load() || !inflight_.empty())) {
+            wake_.wait_for(lock, std::chrono::duration<double, std::milli>(
+                                     waitMs));
+        }
+
+        sleeping_.store(false);
+    }
+}
+
+/**
+ * Issue nodes as one batched launch on the next slot and clear it; the
+ * requests complete from the stream or fail here
+ */
+void GemmServer::Launch(const Shape &shape, std::vector<Node *> *nodes) {
+    if (status_ != cudaSuccess) {
+        Fail(nodes, status_);
+        return;
+    }
+
+    Slot &slot = slots_[nextSlot_];
+    cudaStream_t stream = streams_[nextSlot_ % streams_.size()];
+    nextSlot_ = (nextSlot_ + 1) % slots_.size();
+    int batch = static_cast<int>(nodes->size());
+
+    // The previous copy out of this slot must be done before it is
+    // rewritten; this is where a backed-up pool slows the dispatcher
+    cudaError_t status = cudaEventSynchronize(slot.copied);
+
+    for (int i = 0; i < batch; i++) {
+        const GemmRequest &request = (*nodes)[i]->request;
+        slot.h_ptrs[i] = request.C;
+        slot.h_ptrs[batch + i] = const_cast<float *>(request.A);
+        slot.h_ptrs[2 * batch + i] = const_cast<float *>(request.B);
+    }
+
+    if (status == cudaSuccess) {
+        status = cudaMemcpyAsync(slot.d_ptrs, slot.h_ptrs,
+                                 3 * sizeof(void *) * batch,
+                                 cudaMemcpyHostToDevice, stream);
+    }
+
+    if (status == cudaSuccess) {
+        status = cudaEventRecord(slot.copied, stream);
+    }
+
+    cudaEvent_t done = NULL;
+
+    if (status == cudaSuccess && events_.empty()) {
+        status = cudaEventCreateWithFlags(&done, cudaEventDisableTiming);
+    } else if (status == cudaSuccess) {
+        done = events_.back();
+        events_.pop_back();
+    }
+
+    if (status == cudaSuccess) {
+        float *const *C = reinterpret_cast<float *const *>(slot.d_ptrs);
+        const float *const *A =
+            reinterpret_cast<const float *const *>(slot.d_ptrs + batch);
+        const float *const *B =
+            reinterpret_cast<const float *const *>(slot.d_ptrs + 2 * batch);
+        status = MatrixMulBatched(C, A, B, shape.M, shape.N, shape.K,
+                                  batch, blockSize_, stream) ?
+                 cudaGetLastError() : cudaErrorInvalidValue;
+    }
+
+    if (status == cudaSuccess) {
+        status = cudaEventRecord(done, stream);
+    }
+
+    if (status != cudaSuccess) {
+        if (done != NULL) {
+            events_.push_back(done);
+        }
+
+        Fail(nodes, status);
+        return;
+    }
+
+    // In flight before the host function can hand it back
+    Completion *completion = new Completion;
+    completion->server = this;
+    completion->nodes.swap(*nodes);
+    completion->done = done;
+    completion->abandoned = false;
+    completion->position = inflight_.insert(inflight_.end(), completion);
+    status = cudaLaunchHostFunc(stream, Finished, completion);
+
+    if (status != cudaSuccess) {
+        inflight_.erase(completion->position);
+        events_.push_back(done);
+        Fail(&completion->nodes, status);
+        delete completion;
+        return;
+    }
+
+    batches_.fetch_add(1);
+}
+
+void GemmServer::Fail(std::vector<Node *> *nodes, cudaError_t status) {
+    for (size_t i = 0; i < nodes->size(); i++) {
+        Node *node = (*nodes)[i];
+        node->request.callback(node->request.user, status);
+        delete node;
+    }
+
+    failed_.fetch_add(static_cast<long>(nodes->size()));
+    nodes->clear();
+}
+
+/**
+ * Complete the launches handed back by their host functions with the
+ * status of their events, then fail everything in flight if the oldest
+ * launch hit an error; dispatcher thread only
+ */
+void GemmServer::Reap() {
+    std::vector<Completion *> finished;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished.swap(finished_);
+    }
+
+    for (size_t i = 0; i < finished.size(); i++) {
+        Completion *completion = finished[i];
+
+        // Kept in abandoned_ until the destructor
+        if (completion->abandoned) {
+            continue;
+        }
+
+        // Behind the host function the event is done, unless the launch
+        // or an earlier one on the device failed
+        cudaError_t status = cudaEventQuery(completion->done);
+
+        if (status == cudaSuccess) {
+            std::vector<Node *> &nodes = completion->nodes;
+
+            for (size_t j = 0; j < nodes.size(); j++) {
+                nodes[j]->request.callback(nodes[j]->request.user,
+                                           cudaSuccess);
+                delete nodes[j];
+            }
+
+            requests_.fetch_add(static_cast<long>(nodes.size()));
+        } else {
+            Fail(&completion->nodes, status);
+        }
+
+        inflight_.erase(completion->position);
+        events_.push_back(completion->done);
+        delete completion;
+    }
+
+    if (inflight_.empty()) {
+        return;
+    }
+
+    cudaError_t status = cudaEventQuery(inflight_.front()->done);
+
+    if (status == cudaSuccess || status == cudaErrorNotReady) {
+        return;
+    }
+
+    // A sticky error: the host functions may never run
+    for (std::list<Completion *>::iterator it = inflight_.begin();
+         it != inflight_.end(); ++it) {
+        Fail(&(*it)->nodes, status);
+        (*it)->abandoned = true;
+        abandoned_.push_back(*it);
+    }
+
+    inflight_.clear();
+}
+
+void CUDART_CB GemmServer::Finished(void *data) {
+    Completion *completion = static_cast<Completion *>(data);
+    GemmServer *server = completion->server;
+    std::lock_guard<std::mutex> lock(server->mutex_);
+    server->finished_.push_back(completion);
+    server->wake_.notify_one();
+}
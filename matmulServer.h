@@ -0,0 +1,190 @@
+/**
+ * Asynchronous matrix multiplication service for many host threads.
+ *
+ * Producers Submit requests on device matrices and return at once; the
+ * requests go into a lock-free multi-producer queue. One dispatcher
+ * thread drains it, groups the requests by shape and issues each group
+ * as one MatrixMulBatched launch (matmulBatched.h) when it is full or
+ * when its oldest request has waited for the latency budget. The
+ * launches go round-robin to a pool of streams, and no thread
+ * synchronizes the device: an event is recorded after every launch, and
+ * a cudaLaunchHostFunc behind it hands the launch back to the
+ * dispatcher, which completes its requests with the status of the event.
+ * After a sticky error the host functions may never run; the dispatcher
+ * also queries the oldest launch in flight while it waits, and fails
+ * every launch in flight with the error it finds.
+ *
+ * Callbacks run on the dispatcher thread: they must be short, and must
+ * not destroy the server.
+ */
+
+#ifndef MATMUL_SERVER_H_
+#define MATMUL_SERVER_H_
+
+// System includes
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Defaults of the GemmServer constructor
+#define GEMM_SERVER_STREAMS 4
+#define GEMM_SERVER_MAX_BATCH 64
+#define GEMM_SERVER_BUDGET_US 100.0
+
+typedef void (*GemmCallback)(void *user, cudaError_t status);
+
+// C = A * B, with C M x N, A M x K and B K x N, row-major on the device
+struct GemmRequest {
+    float *C;
+    const float *A;
+    const float *B;
+    int M;
+    int N;
+    int K;
+
+    // Called once with user when C is written or the request failed
+    GemmCallback callback;
+    void *user;
+};
+
+struct GemmServerStats {
+    // Requests completed, and batched launches issued
+    long requests;
+    long batches;
+
+    // Launches issued because they reached the size limit, and requests
+    // that failed
+    long fullBatches;
+    long failed;
+};
+
+class GemmServer {
+ public:
+    /**
+     * Serve the current device with streams streams, launching at most
+     * maxBatch requests together and holding a request back for at most
+     * budgetUs microseconds to batch it; blockSize is 16 or 32
+     */
+    explicit GemmServer(int streams = GEMM_SERVER_STREAMS,
+                        int maxBatch = GEMM_SERVER_MAX_BATCH,
+                        double budgetUs = GEMM_SERVER_BUDGET_US,
+                        int blockSize = 16);
+
+    // Completes every submitted request first; must not race Submit
+    ~GemmServer();
+
+    // Queue a request; thread-safe and lock-free
+    void Submit(const GemmRequest &request);
+
+    // Queue C = A * B; the future receives the status of the request
+    std::future<cudaError_t> Submit(float *C, const float *A,
+                                    const float *B, int M, int N, int K);
+
+    // Error of setting the server up; its requests fail with it
+    cudaError_t Status() const { return status_; }
+
+    GemmServerStats Stats() const;
+
+ private:
+    struct Node {
+        GemmRequest request;
+        std::atomic<Node *> next;
+    };
+
+    struct Shape {
+        int M;
+        int N;
+        int K;
+
+        bool operator<(const Shape &other) const;
+    };
+
+    // Requests of one shape waiting for a launch
+    struct Group {
+        std::vector<Node *> nodes;
+        double firstMs;
+    };
+
+    // Pointer arrays of one launch; reused once copied is done
+    struct Slot {
+        void **h_ptrs;
+        void **d_ptrs;
+        cudaEvent_t copied;
+    };
+
+    // Requests of a launch in flight, and the event recorded after it
+    struct Completion {
+        GemmServer *server;
+        std::vector<Node *> nodes;
+        cudaEvent_t done;
+        std::list<Completion *>::iterator position;
+
+        // Failed by the dispatcher before its host function ran
+        bool abandoned;
+    };
+
+    void Push(Node *node);
+    Node *Pop();
+    void Dispatch();
+    void Launch(const Shape &shape, std::vector<Node *> *nodes);
+    void Fail(std::vector<Node *> *nodes, cudaError_t status);
+    void Reap();
+    static void CUDART_CB Finished(void *completion);
+
+    int device_;
+    int maxBatch_;
+    double budgetMs_;
+    int blockSize_;
+    cudaError_t status_;
+
+    std::vector<cudaStream_t> streams_;
+    std::vector<Slot> slots_;
+    size_t nextSlot_;
+
+    // Producers swap themselves into head_; only the dispatcher reads
+    // tail_. stub_ keeps the queue non-empty.
+    std::atomic<Node *> head_;
+    Node *tail_;
+    Node stub_;
+    std::atomic<long> queued_;
+
+    std::map<Shape, Group> groups_;
+
+    // Launches in flight in issue order, events to record after launches,
+    // and launches failed by a sticky error whose host functions may still
+    // run; dispatcher thread only
+    std::list<Completion *> inflight_;
+    std::vector<cudaEvent_t> events_;
+    std::vector<Completion *> abandoned_;
+
+    // Launches whose host function ran, for the dispatcher to complete
+    std::vector<Completion *> finished_;
+
+    // Taken to wake the dispatcher when it sleeps, and to hand it
+    // finished_
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> sleeping_;
+    std::atomic<bool> stopping_;
+
+    std::atomic<long> requests_;
+    std::atomic<long> batches_;
+    std::atomic<long> fullBatches_;
+    std::atomic<long> failed_;
+
+    std::thread dispatcher_;
+
+    // Not copyable
+    GemmServer(const GemmServer &);
+    GemmServer &operator=(const GemmServer &);
+};
+
+#endif  // MATMUL_SERVER_H_
@@ -0,0 +1,439 @@
+/**
+ * Sparse-times-dense matrix multiplication.
+ *
+ * The CSR kernel follows merge-path SpMV: the row ends of A and its
+ * non-zeros form one sorted list of M + nnz items, and every warp takes
+ * CSR_ITEMS_PER_WARP of them, found by a binary search along its diagonal.
+ * A warp stores the rows it covers entirely and adds the rows it shares
+ * with its neighbours atomically; those rows are zeroed by a pass before.
+ * Each warp covers a slab of 32 * CSR_COLS_PER_LANE columns of C, one
+ * slab per blockIdx.y, and reads 32 non-zeros at a time, passing them
+ * around the warp with shuffles.
+ */
+
+// System includes
+#include <math.h>
+#include <algorithm>
+
+#include "kernelDispatch.h"
+#include "matmulSparse.h"
+#include "sparseKernels.cuh"
+
+// Rows and non-zeros of A per warp
+#define CSR_ITEMS_PER_WARP 128
+
+// Columns of C per lane, a warp's width apart
+#define CSR_COLS_PER_LANE 4
+
+#define CSR_WARPS_PER_BLOCK 4
+
+/**
+ * Number of row ends of A that come before the diagonal-th item of the
+ * merged list, where row end r (rowEnd[r] = rowPtr[r + 1]) comes before
+ * non-zero j if rowEnd[r] <= j
+ */
+__device__ int MergePathSearch(int diagonal, const int *rowEnd, int rows,
+                               int nnz) {
+    int lo = diagonal > nnz ? diagonal - nnz : 0;
+    int hi = diagonal < rows ? diagonal : rows;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (rowEnd[mid] <= diagonal - mid - 1) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * Zero the rows of C that are split between warps (CUDA Kernel) on the
+ * device, one block per boundary between warps
+ */
+__global__ void CsrZeroSplitRowsCUDA(float *C, const int *rowPtr, int M,
+                                     int nnz, int N) {
+    int diagonal = (blockIdx.x + 1) * CSR_ITEMS_PER_WARP;
+    int row = MergePathSearch(diagonal, rowPtr + 1, M, nnz);
+
+    if (row >= M || diagonal - row <= rowPtr[row]) {
+        return;
+    }
+
+    for (int c = threadIdx.x; c < N; c += blockDim.x) {
+        C[static_cast<size_t>(row) * N + c] = 0.0f;
+    }
+}
+
+/**
+ * acc += the product of the non-zeros begin to end - 1 of a row of A with
+ * the columns col + v * warpSize of B
+ */
+__device__ __forceinline__ void
+CsrAccumulate(float *acc, const int *colIdx, const float *values, int begin,
+              int end, const float *B, int N, int col, int lane) {
+    for (int base = begin; base < end; base += warpSize) {
+        int n = end - base < warpSize ? end - base : warpSize;
+        int myCol = 0;
+        float myValue = 0.0f;
+
+        if (lane < n) {
+            myCol = colIdx[base + lane];
+            myValue = values[base + lane];
+        }
+
+        for (int t = 0; t < n; ++t) {
+            int k = __shfl_sync(0xffffffff, myCol, t);
+            float a = __shfl_sync(0xffffffff, myValue, t);
+            const float *b = B + static_cast<size_t>(k) * N;
+
+#pragma unroll
+            for (int v = 0; v < CSR_COLS_PER_LANE; ++v) {
+                if (col + v * warpSize < N) {
+                    acc[v] += a * b[col + v * warpSize];
+                }
+            }
+        }
+    }
+}
+
+// Store acc into row of C, or add it atomically
+__device__ __forceinline__ void
+CsrStore(float *C, float *acc, int row, int N, int col, bool whole) {
+    float *c = C + static_cast<size_t>(row) * N;
+
+#pragma unroll
+    for (int v = 0; v < CSR_COLS_PER_LANE; ++v) {
+        if (col + v * warpSize < N) {
+            if (whole) {
+                c[col + v * warpSize] = acc[v];
+            } else {
+                atomicAdd(&c[col + v * warpSize], acc[v]);
+            }
+        }
+
+        acc[v] = 0.0f;
+    }
+}
+
+/**
+ * Merge-path CSR matrix multiplication (CUDA Kernel) on the device:
+ * C = A * B for the M x K CSR matrix A with nnz non-zeros
+ */
+__global__ void MatrixMulCsrCUDA(float *C, const int *rowPtr,
+                                 const int *colIdx, const float *values,
+                                 int M, int nnz, const float *B, int N) {
+    int lane = threadIdx.x % warpSize;
+    int warp = (blockIdx.x * blockDim.x + threadIdx.x) / warpSize;
+    int total = M + nnz;
+    int d0 = warp * CSR_ITEMS_PER_WARP;
+
+    if (d0 >= total) {
+        return;
+    }
+
+    int d1 = d0 + CSR_ITEMS_PER_WARP < total ? d0 + CSR_ITEMS_PER_WARP :
+             total;
+    int x0 = MergePathSearch(d0, rowPtr + 1, M, nnz);
+    int x1 = MergePathSearch(d1, rowPtr + 1, M, nnz);
+    int y0 = d0 - x0;
+    int y1 = d1 - x1;
+    int col = blockIdx.y * warpSize * CSR_COLS_PER_LANE + lane;
+    float acc[CSR_COLS_PER_LANE] = {};
+    int nz = y0;
+
+    // The rows whose end is in the warp's share; only the first one may
+    // have begun in the share of the previous warp
+    for (int row = x0; row < x1; ++row) {
+        int end = rowPtr[row + 1];
+        CsrAccumulate(acc, colIdx, values, nz, end, B, N, col, lane);
+        CsrStore(C, acc, row, N, col, row > x0 || y0 == rowPtr[row]);
+        nz = end;
+    }
+
+    // The beginning of a row that a later warp finishes
+    if (x1 < M && nz < y1) {
+        CsrAccumulate(acc, colIdx, values, nz, y1, B, N, col, lane);
+        CsrStore(C, acc, x1, N, col, false);
+    }
+}
+
+void DenseToCsr(const float *A, int M, int K, CsrMatrix *csr) {
+    csr->rows = M;
+    csr->cols = K;
+    csr->rowPtr.assign(1, 0);
+    csr->colIdx.clear();
+    csr->values.clear();
+
+    for (int r = 0; r < M; r++) {
+        const float *a = A + static_cast<size_t>(r) * K;
+
+        for (int c = 0; c < K; c++) {
+            if (a[c] != 0.0f) {
+                csr->colIdx.push_back(c);
+                csr->values.push_back(a[c]);
+            }
+        }
+
+        csr->rowPtr.push_back(static_cast<int>(csr->colIdx.size()));
+    }
+}
+
+void DenseToBlockedEll(const float *A, int M, int K, int blockSize,
+                       BlockedEllMatrix *ell) {
+    int blockRows = (M + blockSize - 1) / blockSize;
+    int blockCols = (K + blockSize - 1) / blockSize;
+    std::vector<std::vector<int> > stored(blockRows);
+
+    for (int br = 0; br < blockRows; br++) {
+        for (int bc = 0; bc < blockCols; bc++) {
+            int rowEnd = std::min(M, (br + 1) * blockSize);
+            int colEnd = std::min(K, (bc + 1) * blockSize);
+            bool nonZero = false;
+
+            for (int r = br * blockSize; r < rowEnd && !nonZero; r++) {
+                for (int c = bc * blockSize; c < colEnd && !nonZero; c++) {
+                    nonZero = A[static_cast<size_t>(r) * K + c] != 0.0f;
+                }
+            }
+
+            if (nonZero) {
+                stored[br].push_back(bc);
+            }
+        }
+    }
+
+    // At least one slot, so that the arrays are never empty
+    int ellCols = 1;
+
+    for (int br = 0; br < blockRows; br++) {
+        ellCols = std::max(ellCols, static_cast<int>(stored[br].size()));
+    }
+
+    size_t blockElements = static_cast<size_t>(blockSize) * blockSize;
+    ell->rows = M;
+    ell->cols = K;
+    ell->blockSize = blockSize;
+    ell->ellCols = ellCols;
+    ell->blockCols.assign(static_cast<size_t>(blockRows) * ellCols, -1);
+    ell->values.assign(static_cast<size_t>(blockRows) * ellCols *
+                       blockElements, 0.0f);
+
+    for (int br = 0; br < blockRows; br++) {
+        for (size_t s = 0; s < stored[br].size(); s++) {
+            int bc = stored[br][s];
+            size_t slot = static_cast<size_t>(br) * ellCols + s;
+            ell->blockCols[slot] = bc;
+
+            for (int i = 0; i < blockSize; i++) {
+                for (int j = 0; j < blockSize; j++) {
+                    int r = br * blockSize + i;
+                    int c = bc * blockSize + j;
+
+                    if (r < M && c < K) {
+                        ell->values[slot * blockElements + i * blockSize +
+                                    j] = A[static_cast<size_t>(r) * K + c];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void Prune24(float *A, int M, int K) {
+    for (int r = 0; r < M; r++) {
+        float *a = A + static_cast<size_t>(r) * K;
+
+        for (int g = 0; g < K; g += 4) {
+            int n = std::min(4, K - g);
+
+            // Zero the smallest magnitudes until two are left
+            for (int kept = n; kept > 2; kept--) {
+                int smallest = -1;
+
+                for (int i = 0; i < n; i++) {
+                    if (a[g + i] != 0.0f && (smallest < 0 ||
+                            fabsf(a[g + i]) < fabsf(a[g + smallest]))) {
+                        smallest = i;
+                    }
+                }
+
+                if (smallest < 0) {
+                    break;
+                }
+
+                a[g + smallest] = 0.0f;
+            }
+        }
+    }
+}
+
+bool DenseToSparse24(const float *A, int M, int K, Sparse24Matrix *sparse) {
+    int K4 = (K + 3) / 4 * 4;
+    sparse->rows = M;
+    sparse->cols = K;
+    sparse->values.assign(static_cast<size_t>(M) * (K4 / 2), 0.0f);
+    sparse->meta.assign(static_cast<size_t>(M) * (K4 / 4), 0);
+
+    for (int r = 0; r < M; r++) {
+        const float *a = A + static_cast<size_t>(r) * K;
+
+        for (int g = 0; g < K4 / 4; g++) {
+            int pos[2];
+            int n = 0;
+
+            for (int i = 0; i < 4 && 4 * g + i < K; i++) {
+                if (a[4 * g + i] != 0.0f) {
+                    if (n == 2) {
+                        return false;
+                    }
+
+                    pos[n++] = i;
+                }
+            }
+
+            // Groups with fewer non-zeros are filled with zeros at other
+            // positions, in increasing order
+            if (n == 0) {
+                pos[n++] = 0;
+            }
+
+            if (n == 1) {
+                pos[1] = pos[0] == 3 ? 3 : pos[0] + 1;
+                pos[0] = pos[0] == 3 ? 2 : pos[0];
+            }
+
+            size_t v = static_cast<size_t>(r) * (K4 / 2) + 2 * g;
+
+            for (int i = 0; i < 2; i++) {
+                int c = 4 * g + pos[i];
+                sparse->values[v + i] = c < K ? a[c] : 0.0f;
+            }
+
+            sparse->meta[static_cast<size_t>(r) * (K4 / 4) + g] =
+                static_cast<unsigned char>(pos[0] | pos[1] << 2);
+        }
+    }
+
+    return true;
+}
+
+bool MatrixMulCsr(float *C, const int *rowPtr, const int *colIdx,
+                  const float *values, int M, int nnz, const float *B, int N,
+                  cudaStream_t stream) {
+    if (M <= 0 || N <= 0) {
+        return true;
+    }
+
+    long long total = static_cast<long long>(M) + nnz;
+    int warps = static_cast<int>((total + CSR_ITEMS_PER_WARP - 1) /
+                                 CSR_ITEMS_PER_WARP);
+    const int slab = 32 * CSR_COLS_PER_LANE;
+
+    if (warps > 1) {
+        CsrZeroSplitRowsCUDA <<< warps - 1, 256, 0, stream >>>(
+            C, rowPtr, M, nnz, N);
+    }
+
+    dim3 threads(32 * CSR_WARPS_PER_BLOCK);
+    dim3 grid((warps + CSR_WARPS_PER_BLOCK - 1) / CSR_WARPS_PER_BLOCK,
+              (N + slab - 1) / slab);
+    MatrixMulCsrCUDA <<< grid, threads, 0, stream >>>(
+        C, rowPtr, colIdx, values, M, nnz, B, N);
+    return true;
+}
+
+// Launch of the blocked-ELL kernel
+struct BlockedEllLaunch {
+    float *C;
+    const int *blockCols;
+    const float *values;
+    int M;
+    int K;
+    int ellCols;
+    const float *B;
+    int N;
+    cudaStream_t stream;
+
+    template <int BLOCK_SIZE>
+    bool operator()(IntConstant<BLOCK_SIZE>) const {
+        dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+        dim3 grid((N + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                  (M + BLOCK_SIZE - 1) / BLOCK_SIZE);
+        MatrixMulBlockedEllCUDA<BLOCK_SIZE> <<< grid, threads, 0, stream >>>(
+            C, blockCols, values, B, M, K, N, ellCols);
+        return true;
+    }
+};
+
+// Launch of the 2:4 kernel
+struct Sparse24Launch {
+    float *C;
+    const float *values;
+    const unsigned char *meta;
+    int M;
+    int K;
+    const float *B;
+    int N;
+    cudaStream_t stream;
+
+    template <int BLOCK_SIZE>
+    bool operator()(IntConstant<BLOCK_SIZE>) const {
+        dim3 threads(BLOCK_SIZE, BLOCK_SIZE);
+        dim3 grid((N + BLOCK_SIZE - 1) / BLOCK_SIZE,
+                  (M + BLOCK_SIZE - 1) / BLOCK_SIZE);
+        MatrixMulSparse24CUDA<BLOCK_SIZE> <<< grid, threads, 0, stream >>>(
+            C, values, meta, B, M, K, N);
+        return true;
+    }
+};
+
+bool MatrixMulBlockedEll(float *C, const int *blockCols, const float *values,
+                         int M, int K, int ellCols, int blockSize,
+                         const float *B, int N, cudaStream_t stream) {
+    BlockedEllLaunch op = {C, blockCols, values, M, K, ellCols, B, N,
+                           stream};
+    return DispatchInt(TiledBlockSizes(), blockSize, &op);
+}
+
+bool MatrixMulSparse24(float *C, const float *values,
+                       const unsigned char *meta, int M, int K,
+                       const float *B, int N, int block_size,
+                       cudaStream_t stream) {
+    Sparse24Launch op = {C, values, meta, M, K, B, N, stream};
+    return DispatchInt(TiledBlockSizes(), block_size, &op);
+}
+
+bool MatrixMulSparse24Mma(float *C, const float *values,
+                          const unsigned char *meta, int M, int K,
+                          const float *B, int N, cudaStream_t stream) {
+    dim3 threads(SPARSE_MMA_THREADS);
+    dim3 grid((N + SPARSE_MMA_TILE - 1) / SPARSE_MMA_TILE,
+              (M + SPARSE_MMA_TILE - 1) / SPARSE_MMA_TILE);
+    MatrixMulSparse24MmaCUDA <<< grid, threads, 0, stream >>>(
+        C, values, meta, B, M, K, N);
+    return true;
+}
+
+// MatrixMulSparse24 with the larger block
+static bool LaunchSparse24Cores(float *C, const float *values,
+                                const unsigned char *meta, int M, int K,
+                                const float *B, int N, cudaStream_t stream) {
+    return MatrixMulSparse24(C, values, meta, M, K, B, N, 32, stream);
+}
+
+static const Sparse24Kernel kSparse24Kernels[] = {
+    {"2:4", MATMUL_FP32, 0, LaunchSparse24Cores,
+     "CUDA cores, fp32, block 32"},
+    {"2:4mma", MATMUL_FP16, 80, MatrixMulSparse24Mma,
+     "sparse tensor cores, mma.sp m16n8k32, fp16 inputs"},
+};
+
+const Sparse24Kernel *GetSparse24Kernels(int *count) {
+    *count = static_cast<int>(sizeof(kSparse24Kernels) /
+                              sizeof(kSparse24Kernels[0]));
+    return kSparse24Kernels;
+}
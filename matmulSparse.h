@@ -0,0 +1,140 @@
+/**
+ * Sparse-times-dense matrix multiplication, C = A * B with sparse A and
+ * dense row-major B and C:
+ *
+ * - CSR A of any sparsity. The rows and non-zeros of A are merged into one
+ *   list that is cut into equal shares, one per warp (merge-path SpMM), so
+ *   that a few long rows do not leave the other warps idle.
+ * - Blocked-ELL A, whose non-zeros cluster in dense blocks, with the
+ *   tiling of MatrixMulCUDA over the stored blocks only.
+ * - A with 2:4 structured sparsity, compressed to half its width, on the
+ *   CUDA cores or, from compute capability 8.0, the sparse tensor cores.
+ *
+ * The host converts the sparse formats from a dense row-major A.
+ *
+ * See also:
+ * D. Merrill and M. Garland, "Merge-Based Parallel Sparse Matrix-Vector
+ * Multiplication," in Proc. SC '16, IEEE Press, 2016, pp. 678-689.
+ */
+
+#ifndef MATMUL_SPARSE_H_
+#define MATMUL_SPARSE_H_
+
+// System includes
+#include <vector>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "matmulTypes.cuh"
+
+// Compressed sparse rows: the non-zeros of row r are rowPtr[r] to
+// rowPtr[r + 1] - 1 of colIdx and values
+struct CsrMatrix {
+    int rows;
+    int cols;
+    std::vector<int> rowPtr;
+    std::vector<int> colIdx;
+    std::vector<float> values;
+};
+
+// Blocked-ELL: ellCols blocks of blockSize x blockSize per block row,
+// block columns in blockCols (-1 after the last stored one) and the
+// row-major blocks, zero-padded past the edges of A, in values
+struct BlockedEllMatrix {
+    int rows;
+    int cols;
+    int blockSize;
+    int ellCols;
+    std::vector<int> blockCols;
+    std::vector<float> values;
+};
+
+// 2:4 compressed rows: two values and a byte of positions per group of
+// four columns (see MatrixMulSparse24CUDA)
+struct Sparse24Matrix {
+    int rows;
+    int cols;
+    std::vector<float> values;
+    std::vector<unsigned char> meta;
+};
+
+// The exact non-zeros of the M x K matrix A
+void DenseToCsr(const float *A, int M, int K, CsrMatrix *csr);
+
+// The blocks of the M x K matrix A with a non-zero in them
+void DenseToBlockedEll(const float *A, int M, int K, int blockSize,
+                       BlockedEllMatrix *ell);
+
+/**
+ * Zero all but the two largest magnitudes of every group of four columns
+ * of the M x K matrix A, which makes it 2:4 sparse
+ */
+void Prune24(float *A, int M, int K);
+
+/**
+ * Compress the M x K matrix A; returns false if a group of four holds
+ * more than two non-zeros
+ */
+bool DenseToSparse24(const float *A, int M, int K, Sparse24Matrix *sparse);
+
+/**
+ * C = A * B for CSR A in device memory (rowPtr of M + 1 and colIdx and
+ * values of nnz elements) and the N-column B
+ */
+bool MatrixMulCsr(float *C, const int *rowPtr, const int *colIdx,
+                  const float *values, int M, int nnz, const float *B, int N,
+                  cudaStream_t stream);
+
+/**
+ * C = A * B for blocked-ELL A in device memory with blockSize 16 or 32.
+ * Returns false for any other blockSize.
+ */
+bool MatrixMulBlockedEll(float *C, const int *blockCols, const float *values,
+                         int M, int K, int ellCols, int blockSize,
+                         const float *B, int N, cudaStream_t stream);
+
+/**
+ * C = A * B for 2:4 compressed A in device memory with block_size 16 or
+ * 32. Returns false for any other block_size.
+ */
+bool MatrixMulSparse24(float *C, const float *values,
+                       const unsigned char *meta, int M, int K,
+                       const float *B, int N, int block_size,
+                       cudaStream_t stream);
+
+/**
+ * C = A * B for 2:4 compressed A in device memory on the sparse tensor
+ * cores (mma.sp), with A and B rounded to fp16 and fp32 accumulation.
+ * Needs compute capability 8.0; see GetSparse24Kernels.
+ */
+bool MatrixMulSparse24Mma(float *C, const float *values,
+                          const unsigned char *meta, int M, int K,
+                          const float *B, int N, cudaStream_t stream);
+
+typedef bool (*Sparse24LaunchFn)(float *C, const float *values,
+                                 const unsigned char *meta, int M, int K,
+                                 const float *B, int N, cudaStream_t stream);
+
+// A kernel for 2:4 compressed A
+struct Sparse24Kernel {
+    const char *name;
+
+    // Element type A and B are rounded to for the products
+    MatmulType inType;
+
+    // Lowest compute capability that can run the kernel, as major * 10 + minor
+    int minArch;
+
+    Sparse24LaunchFn launch;
+    const char *description;
+};
+
+/**
+ * The 2:4 kernels, the CUDA core fallback first; count receives the
+ * number of entries. A kernel may only be launched on a device of at
+ * least its minArch.
+ */
+const Sparse24Kernel *GetSparse24Kernels(int *count);
+
+#endif  // MATMUL_SPARSE_H_
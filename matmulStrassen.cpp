@@ -0,0 +1,195 @@
+/**
+ * Strassen-Winograd mode of the library: C = A * B in 7 products of
+ * quadrants per level instead of 8.
+ *
+ * Every level splits the even part of A, B and C into quadrants, which
+ * are views with the leading dimension of the parent, and forms the seven
+ * products and fifteen additions of Winograd's variant in the order of
+ * Boyer et al., which needs only two temporaries per level: X of the size
+ * of a quadrant of A (or C, whichever is larger) and Y of a quadrant of B,
+ * both from the handle's caching allocator. Odd rows, columns and
+ * depths are peeled off and handled with the tiled kernel (dynamic
+ * peeling), as are the products below the cutoff.
+ *
+ * See also:
+ * B. Boyer, J.-G. Dumas, C. Pernet and W. Zhou, "Memory efficient
+ * scheduling of Strassen-Winograd's matrix multiplication algorithm," in
+ * Proc. ISSAC '09, ACM, 2009, pp. 55-62.
+ */
+
+#include "matmulContext.h"
+#include "matmulGemm.h"
+#include "matmulLibrary.h"
+#include "nvtxRange.h"
+
+// Block size of the tiled kernel of the products below the cutoff
+#define STRASSEN_BLOCK 32
+
+/**
+ * C = A + sign * B on rows x cols views (CUDA Kernel) on the device, with
+ * a grid-stride loop over the rows in y and the columns in x
+ */
+__global__ void MatrixAddCUDA(float *C, int ldc, const float *A, int lda,
+                              const float *B, int ldb, float sign, int rows,
+                              int cols) {
+    for (int r = blockIdx.y * blockDim.y + threadIdx.y; r < rows;
+            r += gridDim.y * blockDim.y) {
+        for (int c = blockIdx.x * blockDim.x + threadIdx.x; c < cols;
+                c += gridDim.x * blockDim.x) {
+            C[static_cast<size_t>(r) * ldc + c] =
+                A[static_cast<size_t>(r) * lda + c] +
+                sign * B[static_cast<size_t>(r) * ldb + c];
+        }
+    }
+}
+
+static void Add(float *C, int ldc, const float *A, int lda, const float *B,
+                int ldb, float sign, int rows, int cols,
+                cudaStream_t stream) {
+    dim3 threads(32, 8);
+    int gx = (cols + 31) / 32;
+    int gy = (rows + 7) / 8;
+    dim3 grid(gx < 64 ? gx : 64, gy < 1024 ? gy : 1024);
+    MatrixAddCUDA <<< grid, threads, 0, stream >>>(C, ldc, A, lda, B, ldb,
+                                                   sign, rows, cols);
+}
+
+// C = A * B (beta 0) or C += A * B (beta 1) with the tiled kernel
+static cudaError_t Gemm(int M, int N, int K, const float *A, int lda,
+                        const float *B, int ldb, float beta, float *C,
+                        int ldc, cudaStream_t stream) {
+    if (!MatrixMulGemm(MATMUL_OP_N, MATMUL_OP_N, M, N, K, 1.0f, A, lda, B,
+                       ldb, beta, C, ldc, STRASSEN_BLOCK, stream)) {
+        return cudaErrorInvalidValue;
+    }
+
+    return cudaGetLastError();
+}
+
+/**
+ * C = A * B for the M x K view A and K x N view B, recursing while all
+ * three dimensions are above cutoff
+ */
+static cudaError_t Strassen(MatmulContext *ctx, int M, int N, int K,
+                            const float *A, int lda, const float *B,
+                            int ldb, float *C, int ldc, int cutoff) {
+    cudaStream_t stream = ctx->stream;
+
+    if (M <= cutoff || N <= cutoff || K <= cutoff) {
+        return Gemm(M, N, K, A, lda, B, ldb, 0.0f, C, ldc, stream);
+    }
+
+    // Quadrants of the even part
+    int m = M / 2;
+    int n = N / 2;
+    int k = K / 2;
+    const float *A11 = A;
+    const float *A12 = A + k;
+    const float *A21 = A + static_cast<size_t>(m) * lda;
+    const float *A22 = A21 + k;
+    const float *B11 = B;
+    const float *B12 = B + n;
+    const float *B21 = B + static_cast<size_t>(k) * ldb;
+    const float *B22 = B21 + n;
+    float *C11 = C;
+    float *C12 = C + n;
+    float *C21 = C + static_cast<size_t>(m) * ldc;
+    float *C22 = C21 + n;
+
+    size_t sizeX = static_cast<size_t>(m) * (k > n ? k : n);
+    size_t sizeY = static_cast<size_t>(k) * n;
+    float *X, *Y;
+    MATMUL_TRY(ctx->pool.Allocate(reinterpret_cast<void **>(&X),
+                                  sizeof(float) * sizeX, stream));
+    cudaError_t err = ctx->pool.Allocate(reinterpret_cast<void **>(&Y),
+                                         sizeof(float) * sizeY, stream);
+
+    if (err != cudaSuccess) {
+        ctx->pool.Free(X);
+        return err;
+    }
+
+    // The schedule of Boyer et al.: products land in quadrants of C that
+    // are free at that point, S in X and T in Y; X then holds P1 (ld n)
+#define STRASSEN_STEP(call) \
+    if (err == cudaSuccess) err = (call)
+
+    Add(X, k, A11, lda, A21, lda, -1.0f, m, k, stream);         // S3
+    Add(Y, n, B22, ldb, B12, ldb, -1.0f, k, n, stream);         // T3
+    STRASSEN_STEP(Strassen(ctx, m, n, k, X, k, Y, n, C21, ldc,  // P7
+                           cutoff));
+    Add(X, k, A21, lda, A22, lda, 1.0f, m, k, stream);          // S1
+    Add(Y, n, B12, ldb, B11, ldb, -1.0f, k, n, stream);         // T1
+    STRASSEN_STEP(Strassen(ctx, m, n, k, X, k, Y, n, C22, ldc,  // P5
+                           cutoff));
+    Add(X, k, X, k, A11, lda, -1.0f, m, k, stream);             // S2
+    Add(Y, n, B22, ldb, Y, n, -1.0f, k, n, stream);             // T2
+    STRASSEN_STEP(Strassen(ctx, m, n, k, X, k, Y, n, C12, ldc,  // P6
+                           cutoff));
+    Add(X, k, A12, lda, X, k, -1.0f, m, k, stream);             // S4
+    STRASSEN_STEP(Strassen(ctx, m, n, k, X, k, B22, ldb, C11,   // P3
+                           ldc, cutoff));
+    STRASSEN_STEP(Strassen(ctx, m, n, k, A11, lda, B11, ldb, X, // P1
+                           n, cutoff));
+    Add(C12, ldc, X, n, C12, ldc, 1.0f, m, n, stream);          // U2
+    Add(C21, ldc, C12, ldc, C21, ldc, 1.0f, m, n, stream);      // U3
+    Add(C12, ldc, C12, ldc, C22, ldc, 1.0f, m, n, stream);      // U4
+    Add(C22, ldc, C21, ldc, C22, ldc, 1.0f, m, n, stream);      // U7
+    Add(C12, ldc, C12, ldc, C11, ldc, 1.0f, m, n, stream);      // U5
+    Add(Y, n, Y, n, B21, ldb, -1.0f, k, n, stream);             // T4
+    STRASSEN_STEP(Strassen(ctx, m, n, k, A22, lda, Y, n, C11,   // P4
+                           ldc, cutoff));
+    Add(C21, ldc, C21, ldc, C11, ldc, -1.0f, m, n, stream);     // U6
+    STRASSEN_STEP(Strassen(ctx, m, n, k, A12, lda, B21, ldb,    // P2
+                           C11, ldc, cutoff));
+    Add(C11, ldc, X, n, C11, ldc, 1.0f, m, n, stream);          // U1
+
+#undef STRASSEN_STEP
+
+    // Work queued on the stream may still use them
+    ctx->pool.Free(X);
+    ctx->pool.Free(Y);
+    MATMUL_TRY(err);
+
+    // Dynamic peeling of the odd depth, column and row
+    if (2 * k < K) {
+        MATMUL_TRY(Gemm(2 * m, 2 * n, 1, A + 2 * k, lda,
+                        B + static_cast<size_t>(2 * k) * ldb, ldb, 1.0f, C,
+                        ldc, stream));
+    }
+
+    if (2 * n < N) {
+        MATMUL_TRY(Gemm(2 * m, 1, K, A, lda, B + 2 * n, ldb, 0.0f, C + 2 * n,
+                        ldc, stream));
+    }
+
+    if (2 * m < M) {
+        MATMUL_TRY(Gemm(1, N, K, A + static_cast<size_t>(2 * m) * lda, lda,
+                        B, ldb, 0.0f, C + static_cast<size_t>(2 * m) * ldc,
+                        ldc, stream));
+    }
+
+    return cudaGetLastError();
+}
+
+cudaError_t MatmulSetStrassenCutoff(MatmulHandle handle, int cutoff) {
+    if (handle == NULL || cutoff < 1) {
+        return cudaErrorInvalidValue;
+    }
+
+    handle->strassenCutoff = cutoff;
+    return cudaSuccess;
+}
+
+cudaError_t MatmulMultiplyStrassen(MatmulHandle handle, float *d_C,
+                                   const float *d_A, const float *d_B, int M,
+                                   int N, int K) {
+    if (handle == NULL || d_C == NULL || d_A == NULL || d_B == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    NvtxRange range("MatmulMultiplyStrassen");
+    MATMUL_TRY(cudaSetDevice(handle->device));
+    return Strassen(handle, M, N, K, d_A, K, d_B, N, d_C, N,
+                    handle->strassenCutoff);
+}
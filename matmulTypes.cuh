@@ -0,0 +1,136 @@
+/**
+ * Element types of the matrix multiplication kernels and conversions
+ * between them, usable on the host and on the device.
+ */
+
+#ifndef MATMUL_TYPES_CUH_
+#define MATMUL_TYPES_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+#include <cuda_fp16.h>
+#include <cuda_bf16.h>
+
+// Element type of a matrix, for the type-erased host interfaces
+enum MatmulType {
+    MATMUL_FP32,
+    MATMUL_FP16,
+    MATMUL_BF16
+};
+
+/**
+ * Arithmetic of a kernel: FMAs on the elements as stored with fp32
+ * accumulation; tensor cores on fp32 operands rounded to TF32 (10 bits of
+ * mantissa); or 3xTF32, which splits every operand into a TF32 high part
+ * and a TF32 remainder and sums three of the four partial products,
+ * recovering about fp32 accuracy at a third of the TF32 rate
+ */
+enum MatmulCompute {
+    MATMUL_COMPUTE_FP32,
+    MATMUL_COMPUTE_TF32,
+    MATMUL_COMPUTE_3XTF32
+};
+
+inline const char *MatmulComputeName(MatmulCompute compute) {
+    switch (compute) {
+    case MATMUL_COMPUTE_TF32:
+        return "tf32";
+
+    case MATMUL_COMPUTE_3XTF32:
+        return "3xtf32";
+
+    default:
+        return "fp32";
+    }
+}
+
+inline size_t MatmulTypeSize(MatmulType type) {
+    return type == MATMUL_FP32 ? sizeof(float) : sizeof(half);
+}
+
+inline const char *MatmulTypeName(MatmulType type) {
+    switch (type) {
+    case MATMUL_FP16:
+        return "fp16";
+
+    case MATMUL_BF16:
+        return "bf16";
+
+    default:
+        return "fp32";
+    }
+}
+
+/**
+ * Conversions between float and the storage types, usable on both sides
+ */
+template <typename T> __host__ __device__ inline T FromFloat(float v);
+
+template <> __host__ __device__ inline float FromFloat<float>(float v) {
+    return v;
+}
+
+template <> __host__ __device__ inline half FromFloat<half>(float v) {
+    return __float2half(v);
+}
+
+template <> __host__ __device__ inline __nv_bfloat16
+FromFloat<__nv_bfloat16>(float v) {
+    return __float2bfloat16(v);
+}
+
+__host__ __device__ inline float ToFloat(float v) {
+    return v;
+}
+
+__host__ __device__ inline float ToFloat(half v) {
+    return __half2float(v);
+}
+
+__host__ __device__ inline float ToFloat(__nv_bfloat16 v) {
+    return __bfloat162float(v);
+}
+
+// Unit roundoff of the storage types, used for the correctness tolerance
+template <typename T> inline double UnitRoundoff();
+template <> inline double UnitRoundoff<float>() { return 1.0 / (1 << 24); }
+template <> inline double UnitRoundoff<half>() { return 1.0 / (1 << 11); }
+template <> inline double UnitRoundoff<__nv_bfloat16>() {
+    return 1.0 / (1 << 8);
+}
+
+inline double UnitRoundoff(MatmulType type) {
+    switch (type) {
+    case MATMUL_FP16:
+        return UnitRoundoff<half>();
+
+    case MATMUL_BF16:
+        return UnitRoundoff<__nv_bfloat16>();
+
+    default:
+        return UnitRoundoff<float>();
+    }
+}
+
+/**
+ * Bound of the error that compute adds to a product a * b, relative to
+ * |a * b|, on top of the rounding of the inputs to their storage type: 0
+ * for FMAs, two TF32 unit roundoffs for TF32, and for 3xTF32 the dropped
+ * product of remainders plus the rounding of the two remainders
+ */
+inline double ComputeRoundoff(MatmulCompute compute) {
+    const double tf32 = 1.0 / (1 << 11);
+
+    switch (compute) {
+    case MATMUL_COMPUTE_TF32:
+        return 2.0 * tf32;
+
+    case MATMUL_COMPUTE_3XTF32:
+        return 3.0 * tf32 * tf32;
+
+    default:
+        return 0.0;
+    }
+}
+
+#endif  // MATMUL_TYPES_CUH_
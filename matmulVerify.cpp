@@ -0,0 +1,248 @@
+/**
+ * Error statistics of a computed C against a reference, reduced on the
+ * device: every block folds its share of the elements into a partial
+ * (largest and summed relative error, largest ulp distance) and a shared
+ * memory histogram, and the host only combines the partials of the blocks.
+ */
+
+// System includes
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "matmulContext.h"
+#include "matmulVerify.h"
+
+#define VERIFY_THREADS 256
+#define VERIFY_MAX_BLOCKS 1024
+
+// What one block found in its elements
+struct VerifyPartial {
+    double sumRel;
+    double maxRel;
+    unsigned long long worst;
+    unsigned long long maxUlps;
+};
+
+/**
+ * The bits of v as an integer that orders like v, with both zeros at 0,
+ * so that the difference of two of them is their distance in ulps
+ */
+__device__ __forceinline__ long long OrderedBits(float v) {
+    long long bits = __float_as_int(v);
+    return bits < 0 ? -(bits & 0x7fffffff) : bits;
+}
+
+__device__ __forceinline__ int UlpBucket(unsigned long long ulps) {
+    int bucket = 64 - __clzll(ulps);
+    return bucket < VERIFY_ULP_BUCKETS ? bucket : VERIFY_ULP_BUCKETS - 1;
+}
+
+/**
+ * Compare C with ref and mag (CUDA Kernel) on the device, with a
+ * grid-stride loop; ulpShift turns fp32 ulps into ulps of T. hist has
+ * VERIFY_ULP_BUCKETS buckets and then the count of non-finite elements,
+ * and must be zero at launch.
+ */
+template <typename T> __global__ void
+CompareCUDA(const T *C, const float *ref, const float *mag, size_t n,
+            int ulpShift, VerifyPartial *partials, unsigned long long *hist) {
+    __shared__ unsigned int sHist[VERIFY_ULP_BUCKETS + 1];
+    __shared__ double sSum[VERIFY_THREADS];
+    __shared__ double sMax[VERIFY_THREADS];
+    __shared__ unsigned long long sWorst[VERIFY_THREADS];
+    __shared__ unsigned long long sUlps[VERIFY_THREADS];
+
+    int tid = threadIdx.x;
+
+    if (tid <= VERIFY_ULP_BUCKETS) {
+        sHist[tid] = 0;
+    }
+
+    __syncthreads();
+
+    double sumRel = 0.0;
+    double maxRel = 0.0;
+    unsigned long long worst = 0;
+    unsigned long long maxUlps = 0;
+
+    for (size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + tid;
+            i < n; i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+        float c = ToFloat(C[i]);
+        float r = ref[i];
+        double rel;
+        unsigned long long ulps;
+
+        if (!isfinite(c) && isfinite(r)) {
+            rel = INFINITY;
+            ulps = ~0ull;
+            atomicAdd(&sHist[VERIFY_ULP_BUCKETS], 1u);
+        } else {
+            // An error where all products are zero is as large as it gets
+            float m = mag[i] > 0.0f ? mag[i] : FLT_MIN;
+            rel = fabs(static_cast<double>(c) - r) / m;
+            long long d = OrderedBits(c) - OrderedBits(r);
+            ulps = static_cast<unsigned long long>(d < 0 ? -d : d) >>
+                   ulpShift;
+            sumRel += rel;
+        }
+
+        atomicAdd(&sHist[UlpBucket(ulps)], 1u);
+
+        if (rel > maxRel || (rel == maxRel && ulps > maxUlps)) {
+            maxRel = rel;
+            worst = i;
+        }
+
+        maxUlps = ulps > maxUlps ? ulps : maxUlps;
+    }
+
+    sSum[tid] = sumRel;
+    sMax[tid] = maxRel;
+    sWorst[tid] = worst;
+    sUlps[tid] = maxUlps;
+    __syncthreads();
+
+    for (int s = VERIFY_THREADS / 2; s > 0; s >>= 1) {
+        if (tid < s) {
+            sSum[tid] += sSum[tid + s];
+
+            if (sMax[tid + s] > sMax[tid]) {
+                sMax[tid] = sMax[tid + s];
+                sWorst[tid] = sWorst[tid + s];
+            }
+
+            if (sUlps[tid + s] > sUlps[tid]) {
+                sUlps[tid] = sUlps[tid + s];
+            }
+        }
+
+        __syncthreads();
+    }
+
+    if (tid == 0) {
+        VerifyPartial p = {sSum[0], sMax[0], sWorst[0], sUlps[0]};
+        partials[blockIdx.x] = p;
+    }
+
+    if (tid <= VERIFY_ULP_BUCKETS && sHist[tid] != 0) {
+        atomicAdd(&hist[tid], static_cast<unsigned long long>(sHist[tid]));
+    }
+}
+
+template <typename T>
+static void LaunchCompare(const void *C, const float *ref, const float *mag,
+                          size_t n, int ulpShift, int blocks,
+                          VerifyPartial *partials, unsigned long long *hist,
+                          cudaStream_t stream) {
+    CompareCUDA<T> <<< blocks, VERIFY_THREADS, 0, stream >>>(
+        static_cast<const T *>(C), ref, mag, n, ulpShift, partials, hist);
+}
+
+cudaError_t CompareOnDevice(const void *C, MatmulType type, const float *ref,
+                            const float *mag, size_t n, VerifyStats *stats,
+                            cudaStream_t stream) {
+    memset(stats, 0, sizeof(*stats));
+    stats->elements = n;
+
+    if (n == 0) {
+        return cudaSuccess;
+    }
+
+    size_t wanted = (n + VERIFY_THREADS - 1) / VERIFY_THREADS;
+    int blocks = wanted < VERIFY_MAX_BLOCKS ? static_cast<int>(wanted) :
+                 VERIFY_MAX_BLOCKS;
+    size_t histBytes = sizeof(unsigned long long) * (VERIFY_ULP_BUCKETS + 1);
+    size_t partialBytes = sizeof(VerifyPartial) * blocks;
+    char *d_scratch;
+    MATMUL_TRY(cudaMalloc(&d_scratch, histBytes + partialBytes));
+
+    unsigned long long *d_hist =
+        reinterpret_cast<unsigned long long *>(d_scratch);
+    VerifyPartial *d_partials =
+        reinterpret_cast<VerifyPartial *>(d_scratch + histBytes);
+    cudaError_t err = cudaMemsetAsync(d_hist, 0, histBytes, stream);
+
+    // fp16 and bf16 keep 10 and 7 of the 23 bits of the fp32 mantissa
+    if (err == cudaSuccess) {
+        switch (type) {
+        case MATMUL_FP16:
+            LaunchCompare<half>(C, ref, mag, n, 13, blocks, d_partials,
+                                d_hist, stream);
+            break;
+
+        case MATMUL_BF16:
+            LaunchCompare<__nv_bfloat16>(C, ref, mag, n, 16, blocks,
+                                         d_partials, d_hist, stream);
+            break;
+
+        default:
+            LaunchCompare<float>(C, ref, mag, n, 0, blocks, d_partials,
+                                 d_hist, stream);
+            break;
+        }
+
+        err = cudaGetLastError();
+    }
+
+    std::vector<unsigned long long> hist(VERIFY_ULP_BUCKETS + 1);
+    std::vector<VerifyPartial> partials(blocks);
+
+    if (err == cudaSuccess) {
+        err = cudaMemcpyAsync(&hist[0], d_hist, histBytes,
+                              cudaMemcpyDeviceToHost, stream);
+    }
+
+    if (err == cudaSuccess) {
+        err = cudaMemcpyAsync(&partials[0], d_partials, partialBytes,
+                              cudaMemcpyDeviceToHost, stream);
+    }
+
+    if (err == cudaSuccess) {
+        err = cudaStreamSynchronize(stream);
+    }
+
+    cudaFree(d_scratch);
+    MATMUL_TRY(err);
+
+    double sumRel = 0.0;
+
+    for (int b = 0; b < blocks; b++) {
+        sumRel += partials[b].sumRel;
+
+        if (b == 0 || partials[b].maxRel > stats->maxRelError) {
+            stats->maxRelError = partials[b].maxRel;
+            stats->worst = partials[b].worst;
+        }
+
+        if (partials[b].maxUlps > stats->maxUlps) {
+            stats->maxUlps = partials[b].maxUlps;
+        }
+    }
+
+    memcpy(stats->ulps, &hist[0], sizeof(stats->ulps));
+    stats->nonFinite = hist[VERIFY_ULP_BUCKETS];
+    stats->meanRelError = n > stats->nonFinite ?
+                          sumRel / (n - stats->nonFinite) : INFINITY;
+    return cudaSuccess;
+}
+
+double FractionWithinUlps(const VerifyStats &stats, unsigned long long ulps) {
+    if (stats.elements == 0) {
+        return 1.0;
+    }
+
+    // Bucket b holds up to 2^b - 1 ulps
+    unsigned long long within = stats.ulps[0];
+
+    for (int b = 1; b < VERIFY_ULP_BUCKETS - 1; b++) {
+        if ((1ull << b) - 1 > ulps) {
+            break;
+        }
+
+        within += stats.ulps[b];
+    }
+
+    return static_cast<double>(within) / stats.elements;
+}
@@ -0,0 +1,57 @@
+/**
+ * Comparison of a computed C with a reference on the device, summarized as
+ * error statistics instead of a list of mismatching elements.
+ *
+ * The error of element i is measured twice: relative to mag[i], the sum of
+ * the magnitudes of the products that make up ref[i] (that is |A| * |B|),
+ * which stays meaningful where cancellation makes ref[i] itself tiny, and
+ * in units in the last place of the element type of C. The first bounds
+ * what the kernel may get wrong, (K + 1) unit roundoffs for an fp32
+ * accumulation; the histogram of the second shows how far a fast kernel
+ * (TF32, fp16, a different summation order) is from that bound.
+ */
+
+#ifndef MATMUL_VERIFY_H_
+#define MATMUL_VERIFY_H_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "matmulTypes.cuh"
+
+// Bucket 0 counts exact elements, bucket b > 0 errors of [2^(b-1), 2^b)
+// ulps; the last one also holds everything larger
+#define VERIFY_ULP_BUCKETS 24
+
+struct VerifyStats {
+    size_t elements;
+
+    // |C - ref| / mag over all elements, and the index of the largest
+    double maxRelError;
+    double meanRelError;
+    size_t worst;
+
+    unsigned long long maxUlps;
+    unsigned long long ulps[VERIFY_ULP_BUCKETS];
+
+    // Elements of C that are NaN or infinite where ref is finite; they
+    // count as the largest error
+    unsigned long long nonFinite;
+};
+
+/**
+ * Compare the n elements of C, of element type type, with the fp32 ref
+ * and mag, all in device memory, on stream. stats is filled when the call
+ * returns; the device memory it needs is allocated and released here.
+ */
+cudaError_t CompareOnDevice(const void *C, MatmulType type, const float *ref,
+                            const float *mag, size_t n, VerifyStats *stats,
+                            cudaStream_t stream);
+
+/**
+ * Lower bound of the fraction of elements within ulps units in the last
+ * place, from the histogram of stats
+ */
+double FractionWithinUlps(const VerifyStats &stats, unsigned long long ulps);
+
+#endif  // MATMUL_VERIFY_H_
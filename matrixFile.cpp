@@ -0,0 +1,156 @@
+/**
+ * Headered binary matrix files on top of mapped files.
+ */
+
+// System includes
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "matrixFile.h"
+
+// Elements of the file from the first to the last, padding included
+static bool DataBytes(const MatrixFileHeader &h, uint64_t *bytes) {
+    uint64_t major = h.layout == MATRIX_ROW_MAJOR ? h.rows : h.cols;
+    uint64_t minor = h.layout == MATRIX_ROW_MAJOR ? h.cols : h.rows;
+    uint64_t size = MatmulTypeSize(static_cast<MatmulType>(h.type));
+
+    if (major == 0 || minor == 0 || h.ld < minor ||
+            (major - 1) > (UINT64_MAX / size - minor) / h.ld) {
+        return false;
+    }
+
+    *bytes = ((major - 1) * h.ld + minor) * size;
+    return true;
+}
+
+static bool ValidAlignment(uint64_t alignment) {
+    return alignment >= 64 && (alignment & (alignment - 1)) == 0;
+}
+
+bool OpenMatrixFile(const char *path, MatrixFile *file) {
+    file->data = NULL;
+    file->map.data = NULL;
+    file->map.bytes = 0;
+    file->map.fd = -1;
+
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    MatrixFileHeader &h = file->header;
+    size_t read = fread(&h, sizeof(h), 1, f);
+    fclose(f);
+    uint64_t bytes = 0;
+
+    if (read != 1 || h.magic != MATRIX_FILE_MAGIC) {
+        fprintf(stderr, "%s is not a matrix file\n", path);
+        return false;
+    }
+
+    if (h.version != MATRIX_FILE_VERSION || h.type > MATMUL_BF16 ||
+            h.layout > MATRIX_COL_MAJOR || !ValidAlignment(h.alignment) ||
+            h.dataOffset < sizeof(h) || h.dataOffset % h.alignment != 0 ||
+            !DataBytes(h, &bytes) || h.dataBytes != bytes ||
+            h.dataOffset > SIZE_MAX - bytes) {
+        fprintf(stderr, "%s has an unsupported or corrupt header\n", path);
+        return false;
+    }
+
+    if (!MapFile(path, h.dataOffset + h.dataBytes, false, &file->map)) {
+        return false;
+    }
+
+    file->data = static_cast<char *>(file->map.data) + h.dataOffset;
+    return true;
+}
+
+bool CreateMatrixFile(const char *path, MatmulType type, MatrixLayout layout,
+                      size_t rows, size_t cols, size_t ld, size_t alignment,
+                      MatrixFile *file) {
+    file->data = NULL;
+    MatrixFileHeader &h = file->header;
+    memset(&h, 0, sizeof(h));
+    h.magic = MATRIX_FILE_MAGIC;
+    h.version = MATRIX_FILE_VERSION;
+    h.type = type;
+    h.layout = layout;
+    h.rows = rows;
+    h.cols = cols;
+    h.ld = ld != 0 ? ld : (layout == MATRIX_ROW_MAJOR ? cols : rows);
+    h.alignment = alignment != 0 ? alignment : MATRIX_FILE_ALIGN;
+    h.dataOffset = (sizeof(h) + h.alignment - 1) / h.alignment *
+                   h.alignment;
+
+    if (!ValidAlignment(h.alignment) || !DataBytes(h, &h.dataBytes)) {
+        fprintf(stderr, "Invalid shape or alignment for %s\n", path);
+        return false;
+    }
+
+    if (!MapFile(path, h.dataOffset + h.dataBytes, true, &file->map)) {
+        return false;
+    }
+
+    memcpy(file->map.data, &h, sizeof(h));
+    file->data = static_cast<char *>(file->map.data) + h.dataOffset;
+    return true;
+}
+
+void CloseMatrixFile(MatrixFile *file) {
+    UnmapFile(&file->map);
+    file->data = NULL;
+}
+
+bool WriteMatrixFile(const char *path, const float *data, size_t rows,
+                     size_t cols) {
+    MatrixFile file;
+
+    if (!CreateMatrixFile(path, MATMUL_FP32, MATRIX_ROW_MAJOR, rows, cols, 0,
+                          0, &file)) {
+        return false;
+    }
+
+    memcpy(file.data, data, sizeof(float) * rows * cols);
+    CloseMatrixFile(&file);
+    return true;
+}
+
+bool MatrixFileIsPacked(const MatrixFile *file) {
+    const MatrixFileHeader &h = file->header;
+    return h.type == MATMUL_FP32 && h.layout == MATRIX_ROW_MAJOR &&
+           h.ld == h.cols;
+}
+
+template <typename T>
+static void CopyToFloat(const MatrixFileHeader &h, const T *src,
+                        float *dst) {
+    bool rowMajor = h.layout == MATRIX_ROW_MAJOR;
+
+    for (uint64_t r = 0; r < h.rows; r++) {
+        for (uint64_t c = 0; c < h.cols; c++) {
+            dst[r * h.cols + c] = ToFloat(rowMajor ? src[r * h.ld + c] :
+                                          src[c * h.ld + r]);
+        }
+    }
+}
+
+void CopyMatrixFileToFloat(const MatrixFile *file, float *dst) {
+    const MatrixFileHeader &h = file->header;
+
+    switch (h.type) {
+    case MATMUL_FP16:
+        CopyToFloat(h, static_cast<const half *>(file->data), dst);
+        break;
+
+    case MATMUL_BF16:
+        CopyToFloat(h, static_cast<const __nv_bfloat16 *>(file->data), dst);
+        break;
+
+    default:
+        CopyToFloat(h, static_cast<const float *>(file->data), dst);
+        break;
+    }
+}
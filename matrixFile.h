@@ -0,0 +1,105 @@
+/**
+ * Binary matrix files, loaded by mapping them into memory.
+ *
+ * A file is a 64-byte header followed, at dataOffset, by the elements as
+ * they are laid out in memory: rows x cols of one MatmulType, row- or
+ * column-major with a leading dimension of ld elements. Nothing is
+ * parsed, so opening a file costs a read of the header and an mmap
+ * (mappedFile.h) however large it is, and the pages are read on demand.
+ * dataOffset is a multiple of the alignment in the header, by default a
+ * page, so the data can be read with vector loads or registered with
+ * cudaHostRegister. All fields are little-endian.
+ *
+ * A packed row-major fp32 file is a host matrix as the library takes it:
+ * its data can go straight to MatmulMultiplyHostPipelined, which stages
+ * it through pinned buffers, or to MatmulMultiplyOutOfCore, which streams
+ * it tile by tile. CopyMatrixFileToFloat converts any other file.
+ */
+
+#ifndef MATRIX_FILE_H_
+#define MATRIX_FILE_H_
+
+// System includes
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mappedFile.h"
+#include "matmulTypes.cuh"
+
+// "MTX1" in the first four bytes of the file
+#define MATRIX_FILE_MAGIC 0x3158544du
+#define MATRIX_FILE_VERSION 1
+
+// Alignment of the data unless given to CreateMatrixFile
+#define MATRIX_FILE_ALIGN 4096
+
+enum MatrixLayout {
+    MATRIX_ROW_MAJOR,
+    MATRIX_COL_MAJOR
+};
+
+struct MatrixFileHeader {
+    uint32_t magic;
+    uint32_t version;
+
+    // MatmulType and MatrixLayout
+    uint32_t type;
+    uint32_t layout;
+
+    uint64_t rows;
+    uint64_t cols;
+
+    // Elements between the starts of two rows (row-major) or columns
+    uint64_t ld;
+
+    uint64_t alignment;
+    uint64_t dataOffset;
+    uint64_t dataBytes;
+};
+
+struct MatrixFile {
+    MatrixFileHeader header;
+    MappedFile map;
+
+    // The first element, within map
+    void *data;
+};
+
+/**
+ * Map the matrix file at path read-only; returns false and prints the
+ * reason if it cannot be read or its header is not valid
+ */
+bool OpenMatrixFile(const char *path, MatrixFile *file);
+
+/**
+ * Create or overwrite the file at path for a rows x cols matrix and map it
+ * writable, for the caller to fill file->data. ld = 0 packs the matrix,
+ * alignment = 0 uses MATRIX_FILE_ALIGN; otherwise alignment is a power of
+ * two of at least 64.
+ */
+bool CreateMatrixFile(const char *path, MatmulType type, MatrixLayout layout,
+                      size_t rows, size_t cols, size_t ld, size_t alignment,
+                      MatrixFile *file);
+
+/**
+ * Flush a writable file and release the mapping
+ */
+void CloseMatrixFile(MatrixFile *file);
+
+/**
+ * Write a packed row-major fp32 host matrix, such as a C of the library,
+ * to a new matrix file at path
+ */
+bool WriteMatrixFile(const char *path, const float *data, size_t rows,
+                     size_t cols);
+
+// Whether the data is a packed row-major fp32 matrix
+bool MatrixFileIsPacked(const MatrixFile *file);
+
+/**
+ * Convert the matrix of file to packed row-major fp32 in dst, which holds
+ * rows * cols elements
+ */
+void CopyMatrixFileToFloat(const MatrixFile *file, float *dst);
+
+#endif  // MATRIX_FILE_H_
@@ -0,0 +1,132 @@
+/**
+ * Host-side matrix helpers: initialization, conversion between the element
+ * types and the correctness check against a known constant result.
+ */
+
+#ifndef MATRIX_UTILS_H_
+#define MATRIX_UTILS_H_
+
+// System includes
+#include <stdio.h>
+#include <math.h>
+
+#include "matmulTypes.cuh"
+
+inline void ConstantInit(float *data, int size, float val) {
+    for (int i = 0; i < size; ++i) {
+        data[i] = val;
+    }
+}
+
+/**
+ * Convert size floats to the storage type T
+ */
+template <typename T> void ConvertFromFloat(const float *src, T *dst,
+                                            size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        dst[i] = FromFloat<T>(src[i]);
+    }
+}
+
+/**
+ * Convert size elements of the storage type T to float
+ */
+template <typename T> void ConvertToFloat(const T *src, float *dst,
+                                          size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        dst[i] = ToFloat(src[i]);
+    }
+}
+
+/**
+ * Convert size floats to the element type given at run time
+ */
+inline void ConvertFromFloat(MatmulType type, const float *src, void *dst,
+                             size_t size) {
+    switch (type) {
+    case MATMUL_FP16:
+        ConvertFromFloat(src, static_cast<half *>(dst), size);
+        break;
+
+    case MATMUL_BF16:
+        ConvertFromFloat(src, static_cast<__nv_bfloat16 *>(dst), size);
+        break;
+
+    default:
+        ConvertFromFloat(src, static_cast<float *>(dst), size);
+        break;
+    }
+}
+
+/**
+ * Convert size elements of the type given at run time to float
+ */
+inline void ConvertToFloat(MatmulType type, const void *src, float *dst,
+                           size_t size) {
+    switch (type) {
+    case MATMUL_FP16:
+        ConvertToFloat(static_cast<const half *>(src), dst, size);
+        break;
+
+    case MATMUL_BF16:
+        ConvertToFloat(static_cast<const __nv_bfloat16 *>(src), dst, size);
+        break;
+
+    default:
+        ConvertToFloat(static_cast<const float *>(src), dst, size);
+        break;
+    }
+}
+
+/**
+ * Round val to the element type given at run time and back
+ */
+inline float RoundToType(MatmulType type, float val) {
+    float rounded;
+
+    switch (type) {
+    case MATMUL_FP16:
+        rounded = ToFloat(FromFloat<half>(val));
+        break;
+
+    case MATMUL_BF16:
+        rounded = ToFloat(FromFloat<__nv_bfloat16>(val));
+        break;
+
+    default:
+        rounded = val;
+        break;
+    }
+
+    return rounded;
+}
+
+/**
+ * Check C against the constant ref with relative tolerance eps, printing
+ * at most a few of the mismatching elements
+ */
+inline bool CheckResult(const float *C, int size, float ref, double eps) {
+    const int maxReported = 10;
+    int errors = 0;
+
+    for (int i = 0; i < size; i++) {
+        double rel_err = fabs(C[i] - ref) / fabs(ref);
+
+        if (rel_err > eps) {
+            if (errors < maxReported) {
+                printf("Error! Matrix[%05d]=%.8f, ref=%.8f error term is > %E\n",
+                       i, C[i], ref, eps);
+            }
+
+            errors++;
+        }
+    }
+
+    if (errors > maxReported) {
+        printf("... %d mismatching elements in total\n", errors);
+    }
+
+    return errors == 0;
+}
+
+#endif  // MATRIX_UTILS_H_
@@ -0,0 +1,429 @@
+/**
+ * Multi-GPU mode of the library: one call spread over several handles.
+ *
+ * The devices form a rows x cols grid and C is cut into square tiles that
+ * are dealt out 2D block-cyclically: tile (i, j) belongs to the device at
+ * (i % rows, j % cols). A device therefore needs the row panels i of A of
+ * its grid row and the column panels j of B of its grid column. Packed
+ * side by side they make a dense local problem, so every device runs a
+ * single kernel on its share of the tiles.
+ *
+ * The first device of each grid row uploads the panels of A of that row
+ * and the first device of each grid column those of B; the other devices
+ * copy them from there peer-to-peer where the hardware allows it, and
+ * from the host otherwise. Every device is driven by a worker thread of
+ * its own, on the stream of its handle.
+ */
+
+// System includes
+#include <math.h>
+#include <thread>
+#include <vector>
+
+#include "matmulContext.h"
+#include "matmulLibrary.h"
+#include "nvtxRange.h"
+#include "threadBarrier.h"
+
+// Tile edges are a multiple of this, like the panels of the pipeline
+#define MULTI_GPU_ALIGN 64
+
+// Tiles per device and dimension when no tile edge is given
+#define MULTI_GPU_CYCLES 4
+
+// Panels of one dimension that a grid coordinate owns
+struct CyclicPanels {
+    std::vector<int> start;
+    std::vector<int> length;
+
+    // Sum of the lengths, the extent of the packed local matrix
+    int total;
+};
+
+// State of one call shared by its workers
+struct MultiGpuCall {
+    MatmulHandle *handles;
+    int gridRows;
+    int gridCols;
+    int edge;
+
+    float *h_C;
+    const float *h_A;
+    const float *h_B;
+    int M;
+    int N;
+    int K;
+
+    // Per device: its packed panels of A and B, an event recorded once
+    // the roots have uploaded theirs, and the result of its worker
+    std::vector<float *> d_A;
+    std::vector<float *> d_B;
+    std::vector<cudaEvent_t> uploaded;
+    std::vector<cudaError_t> errors;
+
+    MatmulDeviceStats *stats;
+    Barrier *barrier;
+};
+
+/**
+ * Panels of edge elements of a dimension of size n that coordinate p of
+ * a grid of P owns: p, p + P, p + 2 P, ...
+ */
+static void OwnedPanels(int n, int edge, int p, int P, CyclicPanels *panels) {
+    panels->total = 0;
+
+    for (int s = p * edge; s < n; s += P * edge) {
+        int length = n - s < edge ? n - s : edge;
+        panels->start.push_back(s);
+        panels->length.push_back(length);
+        panels->total += length;
+    }
+}
+
+// Split count devices into a grid as close to square as possible
+static void DeviceGrid(int count, int *rows, int *cols) {
+    int r = static_cast<int>(sqrt(static_cast<double>(count)));
+
+    while (count % r != 0) {
+        r--;
+    }
+
+    *rows = r;
+    *cols = count / r;
+}
+
+// Upload the packed row panels of A from the host
+static cudaError_t UploadA(const MultiGpuCall &call,
+                           const CyclicPanels &rows, float *d_A,
+                           cudaStream_t stream) {
+    for (size_t p = 0, offset = 0; p < rows.start.size(); p++) {
+        size_t elements = static_cast<size_t>(rows.length[p]) * call.K;
+        MATMUL_TRY(cudaMemcpyAsync(
+            d_A + offset,
+            call.h_A + static_cast<size_t>(rows.start[p]) * call.K,
+            sizeof(float) * elements, cudaMemcpyHostToDevice, stream));
+        offset += elements;
+    }
+
+    return cudaSuccess;
+}
+
+// Upload the packed column panels of B from the host
+static cudaError_t UploadB(const MultiGpuCall &call,
+                           const CyclicPanels &cols, float *d_B,
+                           cudaStream_t stream) {
+    for (size_t p = 0, offset = 0; p < cols.start.size(); p++) {
+        MATMUL_TRY(cudaMemcpy2DAsync(
+            d_B + offset, sizeof(float) * cols.total,
+            call.h_B + cols.start[p], sizeof(float) * call.N,
+            sizeof(float) * cols.length[p], call.K, cudaMemcpyHostToDevice,
+            stream));
+        offset += cols.length[p];
+    }
+
+    return cudaSuccess;
+}
+
+/**
+ * Whether device may read the memory of peer directly; enables the access
+ * the first time
+ */
+static bool UsePeer(int device, int peer) {
+    int canAccess = 0;
+
+    if (device == peer ||
+            cudaDeviceCanAccessPeer(&canAccess, device, peer) !=
+            cudaSuccess || !canAccess) {
+        return false;
+    }
+
+    cudaError_t err = cudaDeviceEnablePeerAccess(peer, 0);
+
+    if (err == cudaErrorPeerAccessAlreadyEnabled) {
+        // Not sticky; clear it so that it does not surface later on
+        cudaGetLastError();
+        return true;
+    }
+
+    return err == cudaSuccess;
+}
+
+/**
+ * Second phase of worker i: fetch the panels the roots uploaded, multiply
+ * and copy the tiles of C back
+ */
+static cudaError_t ComputeShare(const MultiGpuCall &call, int i,
+                                const CyclicPanels &rows,
+                                const CyclicPanels &cols, float *d_C,
+                                cudaEvent_t kernelStart,
+                                cudaEvent_t kernelStop) {
+    MatmulHandle handle = call.handles[i];
+    MatmulDeviceStats &stats = call.stats[i];
+    cudaStream_t stream = handle->stream;
+    int rowRoot = i / call.gridCols * call.gridCols;
+    int colRoot = i % call.gridCols;
+    size_t bytes_A = sizeof(float) * rows.total * call.K;
+    size_t bytes_B = sizeof(float) * call.K * cols.total;
+
+    if (rowRoot != i) {
+        int peer = call.handles[rowRoot]->device;
+
+        if (UsePeer(handle->device, peer)) {
+            MATMUL_TRY(cudaStreamWaitEvent(stream, call.uploaded[rowRoot],
+                                           0));
+            MATMUL_TRY(cudaMemcpyPeerAsync(call.d_A[i], handle->device,
+                                           call.d_A[rowRoot], peer, bytes_A,
+                                           stream));
+            stats.peerPanels += static_cast<int>(rows.start.size());
+        } else {
+            MATMUL_TRY(UploadA(call, rows, call.d_A[i], stream));
+        }
+    }
+
+    if (colRoot != i) {
+        int peer = call.handles[colRoot]->device;
+
+        if (UsePeer(handle->device, peer)) {
+            MATMUL_TRY(cudaStreamWaitEvent(stream, call.uploaded[colRoot],
+                                           0));
+            MATMUL_TRY(cudaMemcpyPeerAsync(call.d_B[i], handle->device,
+                                           call.d_B[colRoot], peer, bytes_B,
+                                           stream));
+            stats.peerPanels += static_cast<int>(cols.start.size());
+        } else {
+            MATMUL_TRY(UploadB(call, cols, call.d_B[i], stream));
+        }
+    }
+
+    MATMUL_TRY(cudaEventRecord(kernelStart, stream));
+    MATMUL_TRY(MatmulMultiplyDevice(handle, d_C, call.d_A[i], call.d_B[i],
+                                    rows.total, cols.total, call.K));
+    MATMUL_TRY(cudaEventRecord(kernelStop, stream));
+
+    // Tile (a, b) of the local C goes back to its place in h_C
+    for (size_t a = 0, row = 0; a < rows.start.size(); a++) {
+        for (size_t b = 0, col = 0; b < cols.start.size(); b++) {
+            MATMUL_TRY(cudaMemcpy2DAsync(
+                call.h_C + static_cast<size_t>(rows.start[a]) * call.N +
+                cols.start[b], sizeof(float) * call.N,
+                d_C + row * cols.total + col, sizeof(float) * cols.total,
+                sizeof(float) * cols.length[b], rows.length[a],
+                cudaMemcpyDeviceToHost, stream));
+            col += cols.length[b];
+        }
+
+        row += rows.length[a];
+    }
+
+    return cudaSuccess;
+}
+
+/**
+ * Share of device i: upload the panels it is the root for, wait for the
+ * other roots, compute, and wait again before the panels are released
+ */
+static void Worker(MultiGpuCall *call, int i) {
+    MatmulHandle handle = call->handles[i];
+    MatmulDeviceStats &stats = call->stats[i];
+    cudaStream_t stream = handle->stream;
+    CyclicPanels rows, cols;
+    OwnedPanels(call->M, call->edge, i / call->gridCols, call->gridRows,
+                &rows);
+    OwnedPanels(call->N, call->edge, i % call->gridCols, call->gridCols,
+                &cols);
+
+    stats.device = handle->device;
+    stats.rows = rows.total;
+    stats.cols = cols.total;
+    stats.tiles = static_cast<int>(rows.start.size() * cols.start.size());
+    stats.peerPanels = 0;
+    stats.kernelMs = 0.0f;
+    stats.totalMs = 0.0f;
+
+    // A device of a grid larger than the tiles of C may have no share;
+    // it then only takes part in the barriers
+    bool active = rows.total > 0 && cols.total > 0;
+    float *d_C = NULL;
+    cudaEvent_t start = NULL, stop = NULL, kernelStart = NULL,
+                kernelStop = NULL;
+    cudaError_t err = cudaSetDevice(handle->device);
+
+    if (err == cudaSuccess && active) {
+        void *p_A = NULL, *p_B = NULL, *p_C = NULL;
+        size_t elements_A = static_cast<size_t>(rows.total) * call->K;
+        size_t elements_B = static_cast<size_t>(call->K) * cols.total;
+        size_t elements_C = static_cast<size_t>(rows.total) * cols.total;
+
+        err = MatmulMalloc(handle, &p_A, sizeof(float) * elements_A);
+
+        if (err == cudaSuccess) {
+            err = MatmulMalloc(handle, &p_B, sizeof(float) * elements_B);
+        }
+
+        if (err == cudaSuccess) {
+            err = MatmulMalloc(handle, &p_C, sizeof(float) * elements_C);
+        }
+
+        call->d_A[i] = static_cast<float *>(p_A);
+        call->d_B[i] = static_cast<float *>(p_B);
+        d_C = static_cast<float *>(p_C);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventCreateWithFlags(&call->uploaded[i],
+                                       cudaEventDisableTiming);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventCreate(&start);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventCreate(&stop);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventCreate(&kernelStart);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventCreate(&kernelStop);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventRecord(start, stream);
+    }
+
+    // Grid column 0 holds the roots of the rows, grid row 0 those of the
+    // columns
+    if (err == cudaSuccess && active && i % call->gridCols == 0) {
+        err = UploadA(*call, rows, call->d_A[i], stream);
+    }
+
+    if (err == cudaSuccess && active && i < call->gridCols) {
+        err = UploadB(*call, cols, call->d_B[i], stream);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventRecord(call->uploaded[i], stream);
+    }
+
+    call->errors[i] = err;
+    call->barrier->Wait();
+
+    // If some root has not uploaded its panels, give up quietly; the
+    // failing worker reports the error
+    for (size_t d = 0; d < call->errors.size(); d++) {
+        active = active && call->errors[d] == cudaSuccess;
+    }
+
+    if (err == cudaSuccess && active) {
+        err = ComputeShare(*call, i, rows, cols, d_C, kernelStart,
+                           kernelStop);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaEventRecord(stop, stream);
+    }
+
+    if (err == cudaSuccess && active) {
+        err = cudaStreamSynchronize(stream);
+    }
+
+    if (err == cudaSuccess && active) {
+        cudaEventElapsedTime(&stats.kernelMs, kernelStart, kernelStop);
+        cudaEventElapsedTime(&stats.totalMs, start, stop);
+    } else {
+        cudaStreamSynchronize(stream);
+    }
+
+    // The panels of a root may be read by its peers until all of them
+    // have synchronized; errors is only read before this barrier
+    call->barrier->Wait();
+    call->errors[i] = err;
+
+    MatmulFree(handle, call->d_A[i]);
+    MatmulFree(handle, call->d_B[i]);
+    MatmulFree(handle, d_C);
+    cudaEvent_t events[] = {call->uploaded[i], start, stop, kernelStart,
+                            kernelStop};
+
+    for (int e = 0; e < 5; e++) {
+        if (events[e] != NULL) {
+            cudaEventDestroy(events[e]);
+        }
+    }
+}
+
+cudaError_t MatmulMultiplyMultiGpu(MatmulHandle *handles, int count,
+                                   int tile, float *h_C, const float *h_A,
+                                   const float *h_B, int M, int N, int K,
+                                   MatmulDeviceStats *stats) {
+    NvtxRange range("MatmulMultiplyMultiGpu");
+
+    if (handles == NULL || count < 1 || tile < 0 || h_C == NULL ||
+            h_A == NULL || h_B == NULL || M <= 0 || N <= 0 || K <= 0) {
+        return cudaErrorInvalidValue;
+    }
+
+    // Panels are copied as they are, so the kernels must work in fp32
+    for (int i = 0; i < count; i++) {
+        if (handles[i] == NULL ||
+                handles[i]->kernel->inType != MATMUL_FP32 ||
+                handles[i]->kernel->outType != MATMUL_FP32) {
+            return cudaErrorInvalidValue;
+        }
+    }
+
+    MultiGpuCall call;
+    DeviceGrid(count, &call.gridRows, &call.gridCols);
+    call.edge = tile;
+
+    if (tile == 0) {
+        int rowEdge = (M + call.gridRows * MULTI_GPU_CYCLES - 1) /
+                      (call.gridRows * MULTI_GPU_CYCLES);
+        int colEdge = (N + call.gridCols * MULTI_GPU_CYCLES - 1) /
+                      (call.gridCols * MULTI_GPU_CYCLES);
+        int edge = rowEdge < colEdge ? rowEdge : colEdge;
+        call.edge = (edge + MULTI_GPU_ALIGN - 1) / MULTI_GPU_ALIGN *
+                    MULTI_GPU_ALIGN;
+    }
+
+    std::vector<MatmulDeviceStats> ownStats;
+
+    if (stats == NULL) {
+        ownStats.resize(count);
+        stats = &ownStats[0];
+    }
+
+    Barrier barrier(count);
+    call.handles = handles;
+    call.h_C = h_C;
+    call.h_A = h_A;
+    call.h_B = h_B;
+    call.M = M;
+    call.N = N;
+    call.K = K;
+    call.d_A.assign(count, NULL);
+    call.d_B.assign(count, NULL);
+    call.uploaded.assign(count, NULL);
+    call.errors.assign(count, cudaSuccess);
+    call.stats = stats;
+    call.barrier = &barrier;
+
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < count; i++) {
+        workers.push_back(std::thread(Worker, &call, i));
+    }
+
+    for (int i = 0; i < count; i++) {
+        workers[i].join();
+    }
+
+    for (int i = 0; i < count; i++) {
+        MATMUL_TRY(call.errors[i]);
+    }
+
+    return cudaSuccess;
+}
@@ -0,0 +1,335 @@
+/**
+ * Multi-block matrix multiplication kernels, from the simplest to the most
+ * pipelined one: straight from global memory (MatrixMulGlobalCUDA), through
+ * shared memory tiles (MatrixMulSharedCUDA), double buffered
+ * (MatrixMulDoubleBufferCUDA) and with a ring of STAGES tiles
+ * (MatrixMulStagesCUDA). All of them use a BLOCK_SIZE x BLOCK_SIZE block
+ * computing one element of C per thread. The shared memory kernels take
+ * the layout of their tiles (SmemLayout) as a template parameter.
+ */
+
+#ifndef MULTIBLOCK_KERNELS_CUH_
+#define MULTIBLOCK_KERNELS_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "sharedLayout.cuh"
+
+/**
+ * Matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * Every thread reads its row of A and column of B straight from global memory.
+ */
+template <int BLOCK_SIZE> __global__ void MatrixMulGlobalCUDA(float *C,
+	const float *A, const float *B, int hA,
+	int wA, int wB) {
+	// Block index
+	int bx = blockIdx.x;
+	int by = blockIdx.y;
+
+	// Thread index
+	int tx = threadIdx.x;
+	int ty = threadIdx.y;
+
+	int row = by * blockDim.y + ty;
+	int col = bx * blockDim.x + tx;
+	float C_local = 0;
+
+	if (row < hA && col < wB) {
+		for (int k = 0; k < wA; k++) {
+			C_local += A[static_cast<size_t>(row) * wA + k] *
+				B[static_cast<size_t>(k) * wB + col];
+		}
+
+		C[static_cast<size_t>(row) * wB + col] = C_local;
+	}
+}
+
+/**
+ * Matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * The block stages BLOCK_SIZE x BLOCK_SIZE tiles of A and B in shared
+ * memory; the tiles are stored transposed, element (tx, ty) of a tile in
+ * the LAYOUT of sharedLayout.cuh.
+ */
+template <int BLOCK_SIZE, int LAYOUT> __global__ void MatrixMulSharedCUDA(
+	float *C, const float *A, const float *B, int hA, int wA, int wB) {
+	// Block index
+	int bx = blockIdx.x;
+	int by = blockIdx.y;
+
+	// Thread index
+	int tx = threadIdx.x;
+	int ty = threadIdx.y;
+
+	int row = by * blockDim.y + ty;
+	int col = bx * blockDim.x + tx;
+	float C_local = 0;
+
+	typedef SmemTile<BLOCK_SIZE, LAYOUT> Tile;
+	__shared__ float Ads[Tile::kSize];
+	__shared__ float Bds[Tile::kSize];
+
+	// Offset of the element of a tile loaded by the thread
+	int own = Tile::Index(tx, ty);
+
+	for (int m = 0; m < (wA + BLOCK_SIZE - 1) / BLOCK_SIZE; ++m) {
+		int t = m * BLOCK_SIZE;
+
+		// Elements past the edges of A and B are loaded as zeros
+		Ads[own] = (row < hA && t + tx < wA) ?
+			A[static_cast<size_t>(row) * wA + t + tx] : 0.0f;
+		Bds[own] = (t + ty < wA && col < wB) ?
+			B[static_cast<size_t>(t + ty) * wB + col] : 0.0f;
+		__syncthreads();
+
+		// (k, ty) of Ads holds A(row, t + k) and (tx, k) of Bds
+		// holds B(t + k, col)
+		for (int k = 0; k < BLOCK_SIZE; ++k)
+			C_local += Ads[Tile::Index(k, ty)] * Bds[Tile::Index(tx, k)];
+		__syncthreads();
+	}
+
+	if (row < hA && col < wB)
+		C[static_cast<size_t>(row) * wB + col] = C_local;
+}
+
+/**
+ * Copy one float from global to shared memory without blocking the thread,
+ * or store a zero when pred is false (the element lies past an edge).
+ * On devices of compute capability 8.0 and higher this is cp.async, which
+ * bypasses the registers; the copy is only guaranteed to have landed after
+ * the matching CpAsyncWait. Older devices fall back to a plain load/store.
+ */
+__device__ __forceinline__ void CpAsync(float *smem, const float *gmem,
+	bool pred) {
+	if (!pred) {
+		*smem = 0.0f;
+		return;
+	}
+#if __CUDA_ARCH__ >= 800
+	unsigned int saddr =
+		static_cast<unsigned int>(__cvta_generic_to_shared(smem));
+	asm volatile("cp.async.ca.shared.global [%0], [%1], 4;\n"
+		:: "r"(saddr), "l"(gmem));
+#else
+	*smem = *gmem;
+#endif
+}
+
+// Close the group of cp.async copies issued by this thread so far
+__device__ __forceinline__ void CpAsyncCommit() {
+#if __CUDA_ARCH__ >= 800
+	asm volatile("cp.async.commit_group;\n" ::);
+#endif
+}
+
+// Wait until at most N of this thread's cp.async groups are still pending
+template <int N> __device__ __forceinline__ void CpAsyncWait() {
+#if __CUDA_ARCH__ >= 800
+	asm volatile("cp.async.wait_group %0;\n" :: "n"(N));
+#endif
+}
+
+/**
+ * Matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * Double buffered: the block alternates between two shared tiles by index.
+ * The global loads of tile m + 1 are issued into registers before tile m is
+ * multiplied, so their latency is hidden behind the k-loop, and are stored
+ * into the other tile afterwards. One barrier per k-step is enough because
+ * a tile is only overwritten one iteration after it was last read.
+ */
+template <int BLOCK_SIZE, int LAYOUT> __global__ void
+MatrixMulDoubleBufferCUDA(float *C,
+	const float *A, const float *B, int hA,
+	int wA, int wB) {
+	// Block index
+	int bx = blockIdx.x;
+	int by = blockIdx.y;
+
+	// Thread index
+	int tx = threadIdx.x;
+	int ty = threadIdx.y;
+
+	int row = by * blockDim.y + ty;
+	int col = bx * blockDim.x + tx;
+	float C_local = 0;
+
+	typedef SmemTile<BLOCK_SIZE, LAYOUT> Tile;
+	__shared__ float Ads[2][Tile::kSize];
+	__shared__ float Bds[2][Tile::kSize];
+
+	// Offset of the element of a tile loaded by the thread
+	int own = Tile::Index(tx, ty);
+
+	int numTiles = (wA + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+	// Load the first tile into buffer 0; elements past the edges
+	// of A and B are loaded as zeros
+	Ads[0][own] = (row < hA && tx < wA) ?
+		A[static_cast<size_t>(row) * wA + tx] : 0.0f;
+	Bds[0][own] = (ty < wA && col < wB) ?
+		B[static_cast<size_t>(ty) * wB + col] : 0.0f;
+	__syncthreads();
+
+	for (int m = 0; m < numTiles; ++m) {
+		int cur = m & 1;
+
+		// Issue the loads of the next tile before computing on this one
+		float aNext = 0;
+		float bNext = 0;
+
+		if (m + 1 < numTiles) {
+			int t = (m + 1) * BLOCK_SIZE;
+
+			if (row < hA && t + tx < wA)
+				aNext = A[static_cast<size_t>(row) * wA + t + tx];
+			if (t + ty < wA && col < wB)
+				bNext = B[static_cast<size_t>(t + ty) * wB + col];
+		}
+
+		// (k, ty) of Ads holds A(row, t + k) and (tx, k) of Bds
+		// holds B(t + k, col)
+#pragma unroll
+		for (int k = 0; k < BLOCK_SIZE; ++k)
+			C_local += Ads[cur][Tile::Index(k, ty)] *
+				Bds[cur][Tile::Index(tx, k)];
+
+		// The other buffer was last read in iteration m - 1, which every
+		// thread finished before the barrier at its end
+		if (m + 1 < numTiles) {
+			Ads[cur ^ 1][own] = aNext;
+			Bds[cur ^ 1][own] = bNext;
+		}
+		__syncthreads();
+	}
+
+	if (row < hA && col < wB)
+		C[static_cast<size_t>(row) * wB + col] = C_local;
+}
+
+/**
+ * Matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * STAGES-deep variant of MatrixMulDoubleBufferCUDA: the shared tiles form
+ * a ring and tile m + STAGES - 1 is requested while tile m is multiplied.
+ * With cp.async (compute capability 8.0+) up to STAGES - 1 tiles are in
+ * flight at once.
+ * Older devices stage the next tile through registers, so only one tile is
+ * in flight, but still only one barrier is needed per k-step.
+ */
+template <int BLOCK_SIZE, int STAGES, int LAYOUT> __global__ void
+MatrixMulStagesCUDA(
+	float *C, const float *A, const float *B, int hA, int wA, int wB) {
+	// Block index
+	int bx = blockIdx.x;
+	int by = blockIdx.y;
+
+	// Thread index
+	int tx = threadIdx.x;
+	int ty = threadIdx.y;
+
+	int row = by * blockDim.y + ty;
+	int col = bx * blockDim.x + tx;
+	float C_local = 0;
+
+	typedef SmemTile<BLOCK_SIZE, LAYOUT> Tile;
+	__shared__ float Ads[STAGES][Tile::kSize];
+	__shared__ float Bds[STAGES][Tile::kSize];
+
+	// Offset of the element of a tile loaded by the thread
+	int own = Tile::Index(tx, ty);
+
+	int numTiles = (wA + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+#if __CUDA_ARCH__ >= 800
+	// Put the first STAGES - 1 tiles in flight, one commit group per tile.
+	// Empty groups are committed as well so that the group count stays
+	// in step with the tile index.
+	for (int s = 0; s < STAGES - 1; ++s) {
+		if (s < numTiles) {
+			int t = s * BLOCK_SIZE;
+			CpAsync(&Ads[s][own], &A[static_cast<size_t>(row) * wA + t + tx],
+				row < hA && t + tx < wA);
+			CpAsync(&Bds[s][own], &B[static_cast<size_t>(t + ty) * wB + col],
+				t + ty < wA && col < wB);
+		}
+		CpAsyncCommit();
+	}
+
+	for (int m = 0; m < numTiles; ++m) {
+		// Tile m has landed once at most STAGES - 2 groups are pending;
+		// the barrier makes it visible to the whole block and guarantees
+		// that the slot read in iteration m - 1 is free again
+		CpAsyncWait<STAGES - 2>();
+		__syncthreads();
+
+		int next = m + STAGES - 1;
+
+		if (next < numTiles) {
+			int slot = next % STAGES;
+			int t = next * BLOCK_SIZE;
+			CpAsync(&Ads[slot][own], &A[static_cast<size_t>(row) * wA + t + tx],
+				row < hA && t + tx < wA);
+			CpAsync(&Bds[slot][own], &B[static_cast<size_t>(t + ty) * wB + col],
+				t + ty < wA && col < wB);
+		}
+		CpAsyncCommit();
+
+		int cur = m % STAGES;
+#pragma unroll
+		for (int k = 0; k < BLOCK_SIZE; ++k)
+			C_local += Ads[cur][Tile::Index(k, ty)] *
+				Bds[cur][Tile::Index(tx, k)];
+	}
+#else
+	// Fill the first STAGES - 1 slots of the ring
+	for (int s = 0; s < STAGES - 1 && s < numTiles; ++s) {
+		int t = s * BLOCK_SIZE;
+		Ads[s][own] = (row < hA && t + tx < wA) ?
+			A[static_cast<size_t>(row) * wA + t + tx] : 0.0f;
+		Bds[s][own] = (t + ty < wA && col < wB) ?
+			B[static_cast<size_t>(t + ty) * wB + col] : 0.0f;
+	}
+	__syncthreads();
+
+	for (int m = 0; m < numTiles; ++m) {
+		int next = m + STAGES - 1;
+		float aNext = 0;
+		float bNext = 0;
+
+		if (next < numTiles) {
+			int t = next * BLOCK_SIZE;
+
+			if (row < hA && t + tx < wA)
+				aNext = A[static_cast<size_t>(row) * wA + t + tx];
+			if (t + ty < wA && col < wB)
+				bNext = B[static_cast<size_t>(t + ty) * wB + col];
+		}
+
+		int cur = m % STAGES;
+#pragma unroll
+		for (int k = 0; k < BLOCK_SIZE; ++k)
+			C_local += Ads[cur][Tile::Index(k, ty)] *
+				Bds[cur][Tile::Index(tx, k)];
+
+		// Slot next % STAGES is the one read in iteration m - 1
+		if (next < numTiles) {
+			Ads[next % STAGES][own] = aNext;
+			Bds[next % STAGES][own] = bNext;
+		}
+		__syncthreads();
+	}
+#endif
+
+	if (row < hA && col < wB)
+		C[static_cast<size_t>(row) * wB + col] = C_local;
+}
+
+#endif  // MULTIBLOCK_KERNELS_CUH_
@@ -0,0 +1,47 @@
+/**
+ * NVTX ranges that name the phases and kernels of a run on the timelines
+ * of Nsight Systems and Nsight Compute (e.g. nsys profile --trace=cuda,nvtx
+ * or ncu --nvtx --nvtx-include "regTile4/16/"). NVTX v3 is header-only and
+ * ships with the CUDA toolkit; without a tool attached a range costs a few
+ * nanoseconds. Define MATMUL_NO_NVTX to compile the ranges out.
+ */
+
+#ifndef NVTX_RANGE_H_
+#define NVTX_RANGE_H_
+
+#if !defined(MATMUL_NO_NVTX)
+#include <nvtx3/nvToolsExt.h>
+#endif
+
+inline void NvtxPush(const char *name) {
+#if !defined(MATMUL_NO_NVTX)
+    nvtxRangePushA(name);
+#else
+    (void)name;
+#endif
+}
+
+inline void NvtxPop() {
+#if !defined(MATMUL_NO_NVTX)
+    nvtxRangePop();
+#endif
+}
+
+// A range for the lifetime of the object
+class NvtxRange {
+ public:
+    explicit NvtxRange(const char *name) {
+        NvtxPush(name);
+    }
+
+    ~NvtxRange() {
+        NvtxPop();
+    }
+
+ private:
+    // Not copyable
+    NvtxRange(const NvtxRange &);
+    NvtxRange &operator=(const NvtxRange &);
+};
+
+#endif  // NVTX_RANGE_H_
@@ -0,0 +1,355 @@
+/**
+ * Out-of-core mode of the library: matrices larger than device memory.
+ *
+ * C is computed tile by tile. For every tile the K dimension is cut into
+ * slices; the blocks of A and B of a slice are staged into pinned memory
+ * by the host, copied to the device on a copy stream and multiplied on a
+ * compute stream, the partial products being accumulated into the tile.
+ * Two slots of blocks alternate, so that the host stages and the copy
+ * engine uploads slice g + 1 while the kernel of slice g runs, and two
+ * tiles of C alternate, so that a finished tile is copied back while the
+ * next one is computed.
+ */
+
+// System includes
+#include <math.h>
+#include <string.h>
+
+#include "matmulContext.h"
+#include "matmulKernels.cuh"
+#include "matmulLibrary.h"
+#include "matrixUtils.h"
+#include "nvtxRange.h"
+
+// Share of the free device memory used when no budget is set
+#define OUT_OF_CORE_FREE_SHARE 0.8
+
+// Tile edges are a multiple of this, like the panels of the pipeline
+#define OUT_OF_CORE_ALIGN 64
+
+// Streams: host-to-device copies, kernels, device-to-host copies
+enum { OOC_UPLOAD, OOC_COMPUTE, OOC_DOWNLOAD, OOC_STREAMS };
+
+cudaError_t MatmulSetOutOfCore(MatmulHandle handle, size_t deviceBytes) {
+    if (handle == NULL) {
+        return cudaErrorInvalidValue;
+    }
+
+    handle->outOfCoreBytes = deviceBytes;
+    return cudaSuccess;
+}
+
+// Events of one call, see MatmulMultiplyOutOfCore
+struct OutOfCoreEvents {
+    // Blocks of slot s are on the device / no longer read by the kernel
+    cudaEvent_t uploaded[2];
+    cudaEvent_t consumed[2];
+
+    // Tile c of C is complete / back in its pinned buffer
+    cudaEvent_t computed[2];
+    cudaEvent_t downloaded[2];
+};
+
+// Device buffers of one call
+struct OutOfCoreBuffers {
+    void *d_A[2];
+    void *d_B[2];
+    float *d_C[2];
+    float *d_P;
+};
+
+// Tile of C that a C slot last held, rows = 0 if none
+struct OutOfCoreTile {
+    int row;
+    int col;
+    int rows;
+    int cols;
+};
+
+/**
+ * Edge of the square tiles of C and depth of the K-slices so that two
+ * slots of A and B blocks plus three tiles of C fit in bytes. The buffers
+ * come from the handle's allocator, which rounds every one up to its size
+ * class, so the edge is lowered until the rounded sizes fit.
+ */
+static int TileEdge(size_t bytes, size_t in, int M, int N, int K) {
+    double perElement = 4.0 * in + 3.0 * sizeof(float);
+    int edge = static_cast<int>(sqrt(bytes / perElement));
+    edge = edge / OUT_OF_CORE_ALIGN * OUT_OF_CORE_ALIGN;
+
+    for (; edge >= OUT_OF_CORE_ALIGN; edge -= OUT_OF_CORE_ALIGN) {
+        size_t elements = static_cast<size_t>(edge) * edge;
+        size_t used = 4 * DeviceAllocator::BlockBytes(in * elements) +
+                      3 * DeviceAllocator::BlockBytes(sizeof(float) *
+                                                      elements);
+
+        if (used <= bytes) {
+            break;
+        }
+    }
+
+    if (edge < OUT_OF_CORE_ALIGN) {
+        return 0;
+    }
+
+    int largest = M > N ? M : N;
+    largest = largest > K ? largest : K;
+    return edge < largest ? edge : largest;
+}
+
+/**
+ * Convert the rows x cols block at (row, col) of the row-major host matrix
+ * src with ld columns into the dense buffer dst
+ */
+static void StageBlock(MatmulType type, const float *src, int ld, int row,
+                       int col, int rows, int cols, void *dst) {
+    size_t elem = MatmulTypeSize(type);
+
+    for (int r = 0; r < rows; r++) {
+        ConvertFromFloat(type, src + static_cast<size_t>(row + r) * ld + col,
+                         static_cast<char *>(dst) + elem * r * cols, cols);
+    }
+}
+
+// Copy the finished tile of C slot c from its pinned buffer to h_C
+static cudaError_t DrainTile(MatmulHandle handle, int c,
+                             OutOfCoreTile *tile,
+                             const OutOfCoreEvents &events, float *h_C,
+                             int N) {
+    if (tile->rows == 0) {
+        return cudaSuccess;
+    }
+
+    MATMUL_TRY(cudaEventSynchronize(events.downloaded[c]));
+    const float *src = static_cast<const float *>(
+                           handle->pinned[MATMUL_PINNED_C_PANEL(c)].ptr);
+
+    for (int r = 0; r < tile->rows; r++) {
+        memcpy(h_C + static_cast<size_t>(tile->row + r) * N + tile->col,
+               src + static_cast<size_t>(r) * tile->cols,
+               sizeof(float) * tile->cols);
+    }
+
+    tile->rows = 0;
+    return cudaSuccess;
+}
+
+static cudaError_t RunOutOfCore(MatmulHandle handle, float *h_C,
+                                const float *h_A, const float *h_B, int M,
+                                int N, int K, int edge,
+                                const OutOfCoreBuffers &buf,
+                                const OutOfCoreEvents &events) {
+    const KernelEntry *kernel = handle->kernel;
+    size_t in = MatmulTypeSize(kernel->inType);
+    cudaStream_t upload = handle->pipeStreams[OOC_UPLOAD];
+    cudaStream_t compute = handle->pipeStreams[OOC_COMPUTE];
+    cudaStream_t download = handle->pipeStreams[OOC_DOWNLOAD];
+    OutOfCoreTile tiles[2] = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+    bool slotUsed[2] = {false, false};
+    int step = 0;
+    int tileIndex = 0;
+
+    for (int s = 0; s < 2; s++) {
+        MATMUL_TRY(ReservePinned(handle, MATMUL_PINNED_A_PANEL(s),
+                                 in * edge * edge));
+        MATMUL_TRY(ReservePinned(handle, MATMUL_PINNED_B_PANEL(s),
+                                 in * edge * edge));
+        MATMUL_TRY(ReservePinned(handle, MATMUL_PINNED_C_PANEL(s),
+                                 sizeof(float) * edge * edge));
+    }
+
+    for (int row = 0; row < M; row += edge) {
+        for (int col = 0; col < N; col += edge, tileIndex++) {
+            int rows = M - row < edge ? M - row : edge;
+            int cols = N - col < edge ? N - col : edge;
+            int c = tileIndex % 2;
+
+            // The C slot is free once its previous tile has been copied
+            // back; the stream order of OOC_DOWNLOAD covers the device side
+            MATMUL_TRY(DrainTile(handle, c, &tiles[c], events, h_C, N));
+            MATMUL_TRY(cudaStreamWaitEvent(compute, events.downloaded[c],
+                                           0));
+
+            for (int k = 0; k < K; k += edge, step++) {
+                int depth = K - k < edge ? K - k : edge;
+                int s = step % 2;
+                void *pinned_A = handle->pinned[MATMUL_PINNED_A_PANEL(s)].ptr;
+                void *pinned_B = handle->pinned[MATMUL_PINNED_B_PANEL(s)].ptr;
+
+                // Stage the next blocks while the GPU works on the previous
+                // slot; the pinned buffers of this slot are free once its
+                // last upload has finished
+                if (slotUsed[s]) {
+                    MATMUL_TRY(cudaEventSynchronize(events.uploaded[s]));
+                }
+
+                StageBlock(kernel->inType, h_A, K, row, k, rows, depth,
+                           pinned_A);
+                StageBlock(kernel->inType, h_B, N, k, col, depth, cols,
+                           pinned_B);
+
+                // The device blocks of the slot may still be read by the
+                // kernel of two steps ago
+                MATMUL_TRY(cudaStreamWaitEvent(upload, events.consumed[s],
+                                               0));
+                MATMUL_TRY(cudaMemcpyAsync(buf.d_A[s], pinned_A,
+                                           in * rows * depth,
+                                           cudaMemcpyHostToDevice, upload));
+                MATMUL_TRY(cudaMemcpyAsync(buf.d_B[s], pinned_B,
+                                           in * depth * cols,
+                                           cudaMemcpyHostToDevice, upload));
+                MATMUL_TRY(cudaEventRecord(events.uploaded[s], upload));
+                slotUsed[s] = true;
+
+                // The first slice writes the tile, later ones accumulate
+                MATMUL_TRY(cudaStreamWaitEvent(compute, events.uploaded[s],
+                                               0));
+                float *target = k == 0 ? buf.d_C[c] : buf.d_P;
+                MATMUL_TRY(LaunchKernel(handle, kernel, target, buf.d_A[s],
+                                        buf.d_B[s], rows, cols, depth,
+                                        compute));
+
+                if (k > 0) {
+                    size_t n = static_cast<size_t>(rows) * cols;
+                    int blocks = static_cast<int>((n + 255) / 256);
+                    blocks = blocks < 1024 ? blocks : 1024;
+                    MatrixAccumulateCUDA<float>
+                        <<< blocks, 256, 0, compute >>>(buf.d_C[c], buf.d_P,
+                                                        n);
+                }
+
+                MATMUL_TRY(cudaGetLastError());
+                MATMUL_TRY(cudaEventRecord(events.consumed[s], compute));
+            }
+
+            MATMUL_TRY(cudaEventRecord(events.computed[c], compute));
+            MATMUL_TRY(cudaStreamWaitEvent(download, events.computed[c],
+                                           0));
+            MATMUL_TRY(cudaMemcpyAsync(
+                handle->pinned[MATMUL_PINNED_C_PANEL(c)].ptr, buf.d_C[c],
+                sizeof(float) * rows * cols, cudaMemcpyDeviceToHost,
+                download));
+            MATMUL_TRY(cudaEventRecord(events.downloaded[c], download));
+
+            tiles[c].row = row;
+            tiles[c].col = col;
+            tiles[c].rows = rows;
+            tiles[c].cols = cols;
+        }
+    }
+
+    for (int c = 0; c < 2; c++) {
+        MATMUL_TRY(DrainTile(handle, c, &tiles[c], events, h_C, N));
+    }
+
+    return cudaSuccess;
+}
+
+cudaError_t MatmulMultiplyOutOfCore(MatmulHandle handle, float *h_C,
+                                    const float *h_A, const float *h_B,
+                                    int M, int N, int K) {
+    NvtxRange range("MatmulMultiplyOutOfCore");
+
+    if (handle == NULL || h_C == NULL || h_A == NULL || h_B == NULL ||
+            M <= 0 || N <= 0 || K <= 0) {
+        return cudaErrorInvalidValue;
+    }
+
+    // Partial products are accumulated in C, which needs fp32
+    const KernelEntry *kernel = handle->kernel;
+
+    if (kernel->outType != MATMUL_FP32) {
+        return cudaErrorInvalidValue;
+    }
+
+    size_t budget = handle->outOfCoreBytes;
+
+    if (budget == 0) {
+        size_t freeBytes, totalBytes;
+        MATMUL_TRY(cudaMemGetInfo(&freeBytes, &totalBytes));
+        budget = static_cast<size_t>(freeBytes * OUT_OF_CORE_FREE_SHARE);
+    }
+
+    size_t in = MatmulTypeSize(kernel->inType);
+    int edge = TileEdge(budget, in, M, N, K);
+
+    if (edge == 0) {
+        return cudaErrorMemoryAllocation;
+    }
+
+    MATMUL_TRY(ReservePipelineStreams(handle, OOC_STREAMS));
+    MATMUL_TRY(cudaStreamSynchronize(handle->stream));
+
+    // A fresh event counts as complete, so waiting on the events of slots
+    // that have not been used yet returns at once
+    OutOfCoreEvents events;
+    memset(&events, 0, sizeof(events));
+    cudaError_t err = cudaSuccess;
+
+    for (int s = 0; s < 2 && err == cudaSuccess; s++) {
+        cudaEvent_t *created[4] = {&events.uploaded[s], &events.consumed[s],
+                                   &events.computed[s],
+                                   &events.downloaded[s]};
+
+        for (int e = 0; e < 4 && err == cudaSuccess; e++) {
+            err = cudaEventCreateWithFlags(created[e],
+                                           cudaEventDisableTiming);
+        }
+    }
+
+    cudaStream_t upload = handle->pipeStreams[OOC_UPLOAD];
+    cudaStream_t compute = handle->pipeStreams[OOC_COMPUTE];
+    size_t blockBytes = in * edge * edge;
+    size_t tileBytes = sizeof(float) * edge * edge;
+    OutOfCoreBuffers buf;
+    void *d_P = NULL;
+    void *d_C[2] = {NULL, NULL};
+
+    for (int s = 0; s < 2; s++) {
+        buf.d_A[s] = NULL;
+        buf.d_B[s] = NULL;
+    }
+
+    for (int s = 0; s < 2 && err == cudaSuccess; s++) {
+        err = handle->pool.Allocate(&buf.d_A[s], blockBytes, upload);
+
+        if (err == cudaSuccess) {
+            err = handle->pool.Allocate(&buf.d_B[s], blockBytes, upload);
+        }
+
+        if (err == cudaSuccess) {
+            err = handle->pool.Allocate(&d_C[s], tileBytes, compute);
+        }
+    }
+
+    if (err == cudaSuccess) {
+        err = handle->pool.Allocate(&d_P, tileBytes, compute);
+    }
+
+    if (err == cudaSuccess) {
+        buf.d_C[0] = static_cast<float *>(d_C[0]);
+        buf.d_C[1] = static_cast<float *>(d_C[1]);
+        buf.d_P = static_cast<float *>(d_P);
+        err = RunOutOfCore(handle, h_C, h_A, h_B, M, N, K, edge, buf,
+                           events);
+    }
+
+    SynchronizeContext(handle);
+    handle->pool.Free(d_P);
+
+    for (int s = 0; s < 2; s++) {
+        handle->pool.Free(buf.d_A[s]);
+        handle->pool.Free(buf.d_B[s]);
+        handle->pool.Free(d_C[s]);
+        cudaEvent_t created[4] = {events.uploaded[s], events.consumed[s],
+                                  events.computed[s], events.downloaded[s]};
+
+        for (int e = 0; e < 4; e++) {
+            if (created[e] != NULL) {
+                cudaEventDestroy(created[e]);
+            }
+        }
+    }
+
+    return err;
+}
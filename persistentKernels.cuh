@@ -0,0 +1,77 @@
+/**
+ * Persistent matrix multiplication kernel: a grid of one wave of blocks
+ * that fetch tiles of C from an atomic work counter until none are left,
+ * instead of one block per tile.
+ *
+ * Tile numbers are rasterized in groups of GROUP tile rows: within a group
+ * the tiles are walked column by column, so the blocks that run at the
+ * same time share GROUP row panels of A and a few column panels of B,
+ * which then stay in L2, instead of each streaming a different panel of B
+ * as in the row-major order of blockIdx.
+ */
+
+#ifndef PERSISTENT_KERNELS_CUH_
+#define PERSISTENT_KERNELS_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+#include "splitKKernels.cuh"
+
+/**
+ * Tile (bx, by) of number t in the grouped order over tilesX x tilesY
+ * tiles; GROUP = 1 is the row-major order of blockIdx
+ */
+__host__ __device__ inline void RasterizeTile(int t, int tilesX, int tilesY,
+                                              int group, int *bx, int *by) {
+    int perGroup = group * tilesX;
+    int first = t / perGroup * group;
+    int rows = tilesY - first < group ? tilesY - first : group;
+    int inGroup = t % perGroup;
+    *by = first + inGroup % rows;
+    *bx = inGroup / rows;
+}
+
+/**
+ * Persistent matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * *counter must be zero at launch; every block takes the next tile number
+ * from it until all tiles are done.
+ * hA is A's height, wA is A's width and wB is B's width
+ */
+template <int BLOCK_SIZE, int GROUP> __global__ void
+MatrixMulPersistentCUDA(float *C, const float *A, const float *B, int hA,
+                        int wA, int wB, int *counter) {
+    __shared__ int next;
+    int tilesX = (wB + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    int tilesY = (hA + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    for (;;) {
+        if (threadIdx.x == 0 && threadIdx.y == 0) {
+            next = atomicAdd(counter, 1);
+        }
+
+        __syncthreads();
+        int t = next;
+
+        // Nobody may overwrite next before all threads have read it
+        __syncthreads();
+
+        if (t >= tilesX * tilesY) {
+            return;
+        }
+
+        int bx, by;
+        RasterizeTile(t, tilesX, tilesY, GROUP, &bx, &by);
+        float Csub = MatrixMulBlockPartial<BLOCK_SIZE>(A, B, hA, wA, wB, bx,
+                                                       by, 0, wA);
+
+        int row = BLOCK_SIZE * by + threadIdx.y;
+        int col = BLOCK_SIZE * bx + threadIdx.x;
+
+        if (row < hA && col < wB) {
+            C[static_cast<size_t>(row) * wB + col] = Csub;
+        }
+    }
+}
+
+#endif  // PERSISTENT_KERNELS_CUH_
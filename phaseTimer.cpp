@@ -0,0 +1,156 @@
+/**
+ * Phase timing with a ring of CUDA events and the host clock.
+ */
+
+// System includes
+#include <stdio.h>
+#include <chrono>
+
+#include "matmulContext.h"
+#include "nvtxRange.h"
+#include "phaseTimer.h"
+
+// Phases that do their work on the host
+static bool IsHostPhase(TimedPhase phase) {
+    return phase == PHASE_ALLOC || phase == PHASE_VERIFY;
+}
+
+static double HostMs() {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Add the pending pair of slot to its phase, waiting for it if needed
+static cudaError_t Retire(PhaseTimer *timer, int slot) {
+    TimedPhase phase = timer->pending[slot];
+
+    if (phase == PHASE_COUNT) {
+        return cudaSuccess;
+    }
+
+    float ms;
+    MATMUL_TRY(cudaEventSynchronize(timer->stop[slot]));
+    MATMUL_TRY(cudaEventElapsedTime(&ms, timer->start[slot],
+                                    timer->stop[slot]));
+    timer->totalMs[phase] += ms;
+    timer->pending[slot] = PHASE_COUNT;
+    return cudaSuccess;
+}
+
+const char *PhaseName(TimedPhase phase) {
+    switch (phase) {
+    case PHASE_ALLOC:
+        return "alloc";
+
+    case PHASE_H2D:
+        return "h2d";
+
+    case PHASE_KERNEL:
+        return "kernel";
+
+    case PHASE_D2H:
+        return "d2h";
+
+    case PHASE_VERIFY:
+        return "verify";
+
+    default:
+        return "none";
+    }
+}
+
+cudaError_t PhaseTimerCreate(PhaseTimer *timer, cudaStream_t stream) {
+    timer->stream = stream;
+    timer->next = 0;
+    timer->open = PHASE_COUNT;
+    timer->hostStartMs = 0.0;
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        timer->totalMs[p] = 0.0;
+        timer->calls[p] = 0;
+    }
+
+    for (int i = 0; i < PHASE_EVENT_RING; i++) {
+        timer->pending[i] = PHASE_COUNT;
+        MATMUL_TRY(cudaEventCreate(&timer->start[i]));
+        MATMUL_TRY(cudaEventCreate(&timer->stop[i]));
+    }
+
+    return cudaSuccess;
+}
+
+cudaError_t PhaseTimerDestroy(PhaseTimer *timer) {
+    for (int i = 0; i < PHASE_EVENT_RING; i++) {
+        MATMUL_TRY(cudaEventDestroy(timer->start[i]));
+        MATMUL_TRY(cudaEventDestroy(timer->stop[i]));
+    }
+
+    return cudaSuccess;
+}
+
+cudaError_t PhaseBegin(PhaseTimer *timer, TimedPhase phase,
+                       const char *name) {
+    NvtxPush(name != NULL ? name : PhaseName(phase));
+    timer->open = phase;
+    timer->calls[phase]++;
+
+    if (IsHostPhase(phase)) {
+        timer->hostStartMs = HostMs();
+        return cudaSuccess;
+    }
+
+    // The ring has come round: the oldest pair is read back first
+    MATMUL_TRY(Retire(timer, timer->next));
+    return cudaEventRecord(timer->start[timer->next], timer->stream);
+}
+
+cudaError_t PhaseEnd(PhaseTimer *timer) {
+    TimedPhase phase = timer->open;
+    timer->open = PHASE_COUNT;
+    NvtxPop();
+
+    if (phase == PHASE_COUNT) {
+        return cudaSuccess;
+    }
+
+    if (IsHostPhase(phase)) {
+        timer->totalMs[phase] += HostMs() - timer->hostStartMs;
+        return cudaSuccess;
+    }
+
+    int slot = timer->next;
+    MATMUL_TRY(cudaEventRecord(timer->stop[slot], timer->stream));
+    timer->pending[slot] = phase;
+    timer->next = (slot + 1) % PHASE_EVENT_RING;
+    return cudaSuccess;
+}
+
+cudaError_t PhaseTimerFlush(PhaseTimer *timer) {
+    for (int i = 0; i < PHASE_EVENT_RING; i++) {
+        MATMUL_TRY(Retire(timer, i));
+    }
+
+    return cudaSuccess;
+}
+
+void PrintPhases(const PhaseTimer &timer) {
+    double total = 0.0;
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        total += timer.totalMs[p];
+    }
+
+    printf("%-8s %12s %8s %12s %7s\n", "phase", "total_ms", "calls",
+           "mean_ms", "share");
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        if (timer.calls[p] == 0) {
+            continue;
+        }
+
+        printf("%-8s %12.3f %8d %12.4f %6.1f%%\n",
+               PhaseName(static_cast<TimedPhase>(p)), timer.totalMs[p],
+               timer.calls[p], timer.totalMs[p] / timer.calls[p],
+               total > 0.0 ? 100.0 * timer.totalMs[p] / total : 0.0);
+    }
+}
@@ -0,0 +1,69 @@
+/**
+ * Time spent in the phases of a run (allocation, uploads, kernels,
+ * downloads, verification), each bracketed by an NVTX range.
+ *
+ * Phases that only queue work into the timer's stream are timed with CUDA
+ * events, from a fixed ring of event pairs: a pair is read back lazily,
+ * when the ring comes round to it again or at PhaseTimerFlush, so timing a
+ * phase does not synchronize the stream. Host phases (allocation,
+ * verification on the host) are timed with the host clock.
+ */
+
+#ifndef PHASE_TIMER_H_
+#define PHASE_TIMER_H_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+enum TimedPhase {
+    PHASE_ALLOC,
+    PHASE_H2D,
+    PHASE_KERNEL,
+    PHASE_D2H,
+    PHASE_VERIFY,
+    PHASE_COUNT
+};
+
+// Event pairs in flight before the oldest one is read back
+#define PHASE_EVENT_RING 16
+
+struct PhaseTimer {
+    cudaStream_t stream;
+
+    double totalMs[PHASE_COUNT];
+    int calls[PHASE_COUNT];
+
+    // The ring, and the phase each pair in it is still to be added to
+    // (PHASE_COUNT if none)
+    cudaEvent_t start[PHASE_EVENT_RING];
+    cudaEvent_t stop[PHASE_EVENT_RING];
+    TimedPhase pending[PHASE_EVENT_RING];
+    int next;
+
+    // The phase between PhaseBegin and PhaseEnd, and its host start time
+    TimedPhase open;
+    double hostStartMs;
+};
+
+const char *PhaseName(TimedPhase phase);
+
+cudaError_t PhaseTimerCreate(PhaseTimer *timer, cudaStream_t stream);
+
+cudaError_t PhaseTimerDestroy(PhaseTimer *timer);
+
+/**
+ * Start phase, which lasts until the next PhaseEnd; phases do not nest.
+ * name labels the NVTX range, NULL for the name of the phase.
+ */
+cudaError_t PhaseBegin(PhaseTimer *timer, TimedPhase phase,
+                       const char *name = NULL);
+
+cudaError_t PhaseEnd(PhaseTimer *timer);
+
+// Wait for the pending event pairs and add their times
+cudaError_t PhaseTimerFlush(PhaseTimer *timer);
+
+// Print the total, count and mean of every phase that ran
+void PrintPhases(const PhaseTimer &timer);
+
+#endif  // PHASE_TIMER_H_
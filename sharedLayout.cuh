@@ -0,0 +1,82 @@
+/**
+ * Shared memory layouts of the BLOCK_SIZE x BLOCK_SIZE tiles of the
+ * multi-block kernels, usable on the host and on the device.
+ *
+ * The multi-block kernels store element (tx, ty) of a tile at (r, c) =
+ * (tx, ty), with tx the fast thread index, and read it back at (k, ty) and
+ * (tx, k). With the plain row-major layout consecutive lanes of a warp then
+ * hit addresses BLOCK_SIZE floats apart, which for BLOCK_SIZE = 32 is the
+ * same bank on every lane. The padded layout adds one float to every row,
+ * the swizzled layout XORs the column with the row, and both spread the
+ * lanes over all banks without changing the indexing of the kernels.
+ */
+
+#ifndef SHARED_LAYOUT_CUH_
+#define SHARED_LAYOUT_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+enum SmemLayout {
+    // The tile of the kernel can not be changed (not a multi-block kernel)
+    SMEM_FIXED,
+
+    // Row-major, BLOCK_SIZE floats per row
+    SMEM_TRANSPOSED,
+
+    // Row-major, BLOCK_SIZE + 1 floats per row
+    SMEM_PADDED,
+
+    // Row-major, column c of row r stored at column c ^ r; needs
+    // BLOCK_SIZE to be a power of two
+    SMEM_SWIZZLED
+};
+
+inline const char *SmemLayoutName(SmemLayout layout) {
+    switch (layout) {
+    case SMEM_TRANSPOSED:
+        return "transposed";
+
+    case SMEM_PADDED:
+        return "padded";
+
+    case SMEM_SWIZZLED:
+        return "swizzled";
+
+    default:
+        return "fixed";
+    }
+}
+
+// Floats per row of a tile
+__host__ __device__ inline int SmemPitch(int layout, int block_size) {
+    return layout == SMEM_PADDED ? block_size + 1 : block_size;
+}
+
+// Offset of element (r, c) of a tile; folds to a constant expression
+// when layout and block_size are template parameters of the kernel
+__host__ __device__ __forceinline__ int SmemIndex(int layout, int block_size,
+                                                  int r, int c) {
+    if (layout == SMEM_SWIZZLED) {
+        return r * block_size + (c ^ (r & (block_size - 1)));
+    }
+
+    return r * SmemPitch(layout, block_size) + c;
+}
+
+// Compile-time view of a layout for the kernels
+template <int BLOCK_SIZE, int LAYOUT> struct SmemTile {
+    static_assert(LAYOUT != SMEM_SWIZZLED ||
+                  (BLOCK_SIZE & (BLOCK_SIZE - 1)) == 0,
+                  "the swizzled layout needs a power of two block size");
+
+    // Floats of one tile
+    static const int kSize = BLOCK_SIZE * (LAYOUT == SMEM_PADDED ?
+                                           BLOCK_SIZE + 1 : BLOCK_SIZE);
+
+    __device__ __forceinline__ static int Index(int r, int c) {
+        return SmemIndex(LAYOUT, BLOCK_SIZE, r, c);
+    }
+};
+
+#endif  // SHARED_LAYOUT_CUH_
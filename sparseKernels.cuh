@@ -0,0 +1,340 @@
+/**
+ * Sparse-times-dense matrix multiplication kernels with the tiling of
+ * MatrixMulCUDA, for sparse A whose zeros come in a structure that the
+ * tiles can skip:
+ *
+ * - MatrixMulBlockedEllCUDA takes A in blocked-ELL format: A is cut into
+ *   BLOCK_SIZE x BLOCK_SIZE blocks, and every block row keeps the same
+ *   number (ellCols) of dense blocks with their block column, -1 for
+ *   padding. The loop over K only visits the stored blocks.
+ * - MatrixMulSparse24CUDA takes A with 2:4 structured sparsity (at most
+ *   two non-zeros in every group of four along K) compressed to the two
+ *   values and their 2-bit positions per group, so that half of A is read
+ *   and half of the FMAs are done.
+ * - MatrixMulSparse24MmaCUDA takes the same compressed A to the sparse
+ *   tensor cores of compute capability 8.0 with mma.sp, in fp16 with fp32
+ *   accumulation; the positions are the metadata of the instruction as
+ *   they are.
+ *
+ * The unstructured CSR kernel lives in matmulSparse.cpp.
+ */
+
+#ifndef SPARSE_KERNELS_CUH_
+#define SPARSE_KERNELS_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+#include <cuda_fp16.h>
+
+// C tile of a block of MatrixMulSparse24MmaCUDA, four warps of 32 x 32,
+// and the depth of A and B consumed per step: the K of one mma.sp
+#define SPARSE_MMA_TILE 64
+#define SPARSE_MMA_DEPTH 32
+#define SPARSE_MMA_THREADS 128
+
+/**
+ * Blocked-ELL matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * blockCols holds ellCols block columns per block row of A, values the
+ * BLOCK_SIZE x BLOCK_SIZE row-major blocks in the same order. Blocks may
+ * run past the edges of A, as long as they are zero there.
+ */
+template <int BLOCK_SIZE> __global__ void
+MatrixMulBlockedEllCUDA(float *C, const int *blockCols, const float *values,
+                        const float *B, int hA, int wA, int wB,
+                        int ellCols) {
+    // Block index
+    int bx = blockIdx.x;
+    int by = blockIdx.y;
+
+    // Thread index
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+
+    // Row and column of C computed by the thread
+    int row = BLOCK_SIZE * by + ty;
+    int col = BLOCK_SIZE * bx + tx;
+
+    // Stored blocks of the block row of A
+    const int *cols = blockCols + static_cast<size_t>(by) * ellCols;
+    const float *blocks = values + static_cast<size_t>(by) * ellCols *
+                          BLOCK_SIZE * BLOCK_SIZE;
+
+    float Csub = 0;
+
+    for (int s = 0; s < ellCols; ++s) {
+        // The padding comes after the stored blocks of a block row
+        int bc = cols[s];
+
+        if (bc < 0) {
+            break;
+        }
+
+        __shared__ float As[BLOCK_SIZE][BLOCK_SIZE];
+        __shared__ float Bs[BLOCK_SIZE][BLOCK_SIZE];
+
+        int k0 = bc * BLOCK_SIZE;
+        As[ty][tx] = blocks[(static_cast<size_t>(s) * BLOCK_SIZE + ty) *
+                            BLOCK_SIZE + tx];
+        Bs[ty][tx] = (k0 + ty < wA && col < wB) ?
+                     B[static_cast<size_t>(k0 + ty) * wB + col] : 0.0f;
+
+        // Synchronize to make sure the matrices are loaded
+        __syncthreads();
+
+#pragma unroll
+        for (int k = 0; k < BLOCK_SIZE; ++k) {
+            Csub += As[ty][k] * Bs[k][tx];
+        }
+
+        // Synchronize to make sure that the preceding
+        // computation is done before loading two new
+        // sub-matrices of A and B in the next iteration
+        __syncthreads();
+    }
+
+    if (row < hA && col < wB) {
+        C[static_cast<size_t>(row) * wB + col] = Csub;
+    }
+}
+
+/**
+ * 2:4 sparse matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * Row r of A is stored as values (wA4 / 2 floats, wA4 the width rounded up
+ * to a multiple of 4) and meta (wA4 / 4 bytes): group g keeps values 2g and
+ * 2g + 1, at columns 4g + (meta & 3) and 4g + (meta >> 2 & 3).
+ * BLOCK_SIZE must be a multiple of 4.
+ */
+template <int BLOCK_SIZE> __global__ void
+MatrixMulSparse24CUDA(float *C, const float *values,
+                      const unsigned char *meta, const float *B, int hA,
+                      int wA, int wB) {
+    const int GROUPS = BLOCK_SIZE / 4;
+    int wA4 = (wA + 3) / 4 * 4;
+
+    // Block index
+    int bx = blockIdx.x;
+    int by = blockIdx.y;
+
+    // Thread index
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+
+    // Row and column of C computed by the thread
+    int row = BLOCK_SIZE * by + ty;
+    int col = BLOCK_SIZE * bx + tx;
+
+    float Csub = 0;
+
+    for (int k0 = 0; k0 < wA; k0 += BLOCK_SIZE) {
+        // Half a tile of A, its positions, and a full tile of B
+        __shared__ float As[BLOCK_SIZE][BLOCK_SIZE / 2];
+        __shared__ unsigned char Ms[BLOCK_SIZE][GROUPS];
+        __shared__ float Bs[BLOCK_SIZE][BLOCK_SIZE];
+
+        bool inside = row < hA;
+
+        if (tx < BLOCK_SIZE / 2) {
+            int v = k0 / 2 + tx;
+            As[ty][tx] = (inside && 2 * v < wA4) ?
+                         values[static_cast<size_t>(row) * (wA4 / 2) + v] :
+                         0.0f;
+        }
+
+        if (tx < GROUPS) {
+            int g = k0 / 4 + tx;
+            Ms[ty][tx] = (inside && 4 * g < wA4) ?
+                         meta[static_cast<size_t>(row) * (wA4 / 4) + g] : 0;
+        }
+
+        Bs[ty][tx] = (k0 + ty < wA && col < wB) ?
+                     B[static_cast<size_t>(k0 + ty) * wB + col] : 0.0f;
+
+        // Synchronize to make sure the matrices are loaded
+        __syncthreads();
+
+#pragma unroll
+        for (int g = 0; g < GROUPS; ++g) {
+            int m = Ms[ty][g];
+            Csub += As[ty][2 * g] * Bs[4 * g + (m & 3)][tx];
+            Csub += As[ty][2 * g + 1] * Bs[4 * g + (m >> 2 & 3)][tx];
+        }
+
+        // Synchronize to make sure that the preceding
+        // computation is done before loading two new
+        // sub-matrices of A and B in the next iteration
+        __syncthreads();
+    }
+
+    if (row < hA && col < wB) {
+        C[static_cast<size_t>(row) * wB + col] = Csub;
+    }
+}
+
+/**
+ * 2:4 sparse matrix multiplication on the sparse tensor cores: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * values and meta are laid out as for MatrixMulSparse24CUDA. Each block
+ * computes a SPARSE_MMA_TILE square of C with SPARSE_MMA_THREADS threads;
+ * every warp issues mma.sp.m16n8k32 on 16 x 8 tiles of its 32 x 32
+ * quarter. A step stages SPARSE_MMA_DEPTH columns of A, compressed to
+ * half, and rows of B in shared memory as fp16, B transposed so that the
+ * column-major B fragments are pairs of consecutive halves. The eight
+ * position bytes per row of a step, a nibble each, are one metadata word:
+ * with sparsity selector 0, lane 4g holds that of row g of the 16 x 8
+ * tile and lane 4g + 1 that of row g + 8. Compiled to nothing below
+ * compute capability 8.0.
+ */
+__global__ void __launch_bounds__(SPARSE_MMA_THREADS)
+MatrixMulSparse24MmaCUDA(float *C, const float *values,
+                         const unsigned char *meta, const float *B, int hA,
+                         int wA, int wB) {
+#if __CUDA_ARCH__ >= 800
+    const int TILE = SPARSE_MMA_TILE;
+    const int DEPTH = SPARSE_MMA_DEPTH;
+    int wA4 = (wA + 3) / 4 * 4;
+    int stride = wA4 / 2;
+    int groups = wA4 / 4;
+
+    // Rows padded by 8 halves, which keeps the fragment loads 4-byte
+    // aligned and moves consecutive rows to other banks
+    __shared__ half As[TILE][DEPTH / 2 + 8];
+    __shared__ unsigned int Es[TILE];
+    __shared__ half Bs[TILE][DEPTH + 8];
+
+    int tid = threadIdx.x;
+    int warp = tid / 32;
+    int lane = tid % 32;
+
+    // Row and pair of the fragments owned by the lane
+    int g = lane / 4;
+    int t = lane % 4;
+
+    int row0 = SPARSE_MMA_TILE * blockIdx.y;
+    int col0 = SPARSE_MMA_TILE * blockIdx.x;
+    int warpRow = 32 * (warp / 2);
+    int warpCol = 32 * (warp % 2);
+
+    float acc[2][4][4];
+
+#pragma unroll
+    for (int mi = 0; mi < 2; mi++) {
+#pragma unroll
+        for (int ni = 0; ni < 4; ni++) {
+#pragma unroll
+            for (int i = 0; i < 4; i++) {
+                acc[mi][ni][i] = 0.0f;
+            }
+        }
+    }
+
+    for (int k0 = 0; k0 < wA; k0 += DEPTH) {
+        for (int i = tid; i < TILE * DEPTH / 2; i += SPARSE_MMA_THREADS) {
+            int r = i / (DEPTH / 2);
+            int v = k0 / 2 + i % (DEPTH / 2);
+            As[r][i % (DEPTH / 2)] = __float2half(
+                row0 + r < hA && v < stride ?
+                values[static_cast<size_t>(row0 + r) * stride + v] : 0.0f);
+        }
+
+        if (tid < TILE) {
+            unsigned int e = 0;
+
+            // Groups past A are zeros at positions 0 and 1
+#pragma unroll
+            for (int j = 0; j < DEPTH / 4; j++) {
+                int group = k0 / 4 + j;
+                unsigned int m = row0 + tid < hA && group < groups ?
+                    meta[static_cast<size_t>(row0 + tid) * groups + group] :
+                    4u;
+                e |= m << (4 * j);
+            }
+
+            Es[tid] = e;
+        }
+
+        for (int i = tid; i < DEPTH * TILE; i += SPARSE_MMA_THREADS) {
+            int k = i / TILE;
+            int n = i % TILE;
+            Bs[n][k] = __float2half(
+                k0 + k < wA && col0 + n < wB ?
+                B[static_cast<size_t>(k0 + k) * wB + col0 + n] : 0.0f);
+        }
+
+        // Synchronize to make sure the matrices are loaded
+        __syncthreads();
+
+        unsigned int a[2][4];
+        unsigned int e[2];
+        unsigned int b[4][4];
+
+#pragma unroll
+        for (int mi = 0; mi < 2; mi++) {
+            int r = warpRow + 16 * mi + g;
+            a[mi][0] = *reinterpret_cast<const unsigned int *>(&As[r][2 * t]);
+            a[mi][1] =
+                *reinterpret_cast<const unsigned int *>(&As[r + 8][2 * t]);
+            a[mi][2] =
+                *reinterpret_cast<const unsigned int *>(&As[r][2 * t + 8]);
+            a[mi][3] = *reinterpret_cast<const unsigned int *>(
+                           &As[r + 8][2 * t + 8]);
+            e[mi] = Es[r + 8 * (t & 1)];
+        }
+
+#pragma unroll
+        for (int ni = 0; ni < 4; ni++) {
+            int n = warpCol + 8 * ni + g;
+
+#pragma unroll
+            for (int j = 0; j < 4; j++) {
+                b[ni][j] = *reinterpret_cast<const unsigned int *>(
+                               &Bs[n][2 * t + 8 * j]);
+            }
+        }
+
+#pragma unroll
+        for (int mi = 0; mi < 2; mi++) {
+#pragma unroll
+            for (int ni = 0; ni < 4; ni++) {
+                float *d = acc[mi][ni];
+                asm volatile(
+                    "mma.sp.sync.aligned.m16n8k32.row.col.f32.f16.f16.f32 "
+                    "{%0, %1, %2, %3}, {%4, %5, %6, %7}, "
+                    "{%8, %9, %10, %11}, {%0, %1, %2, %3}, %12, 0x0;\n"
+                    : "+f"(d[0]), "+f"(d[1]), "+f"(d[2]), "+f"(d[3])
+                    : "r"(a[mi][0]), "r"(a[mi][1]), "r"(a[mi][2]),
+                      "r"(a[mi][3]), "r"(b[ni][0]), "r"(b[ni][1]),
+                      "r"(b[ni][2]), "r"(b[ni][3]), "r"(e[mi]));
+            }
+        }
+
+        // Synchronize to make sure that the preceding
+        // computation is done before loading two new
+        // sub-matrices of A and B in the next iteration
+        __syncthreads();
+    }
+
+    // Lane (g, t) holds columns 2t and 2t + 1 of rows g and g + 8
+#pragma unroll
+    for (int mi = 0; mi < 2; mi++) {
+#pragma unroll
+        for (int ni = 0; ni < 4; ni++) {
+#pragma unroll
+            for (int i = 0; i < 4; i++) {
+                int row = row0 + warpRow + 16 * mi + g + 8 * (i / 2);
+                int col = col0 + warpCol + 8 * ni + 2 * t + i % 2;
+
+                if (row < hA && col < wB) {
+                    C[static_cast<size_t>(row) * wB + col] = acc[mi][ni][i];
+                }
+            }
+        }
+    }
+#endif
+}
+
+#endif  // SPARSE_KERNELS_CUH_
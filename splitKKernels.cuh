@@ -0,0 +1,166 @@
+/**
+ * Matrix multiplication kernels that split the K dimension over blocks,
+ * for problems whose output has too few tiles to fill the GPU (a 64 x 64
+ * C with a long K is only a handful of blocks in the output-stationary
+ * grid of MatrixMulCUDA).
+ *
+ * Split-K (MatrixMulSplitKCUDA) adds a grid dimension over K-slices: each
+ * block computes the partial product of one slice of one tile, and the
+ * slices are summed either with atomics into C or through a workspace and
+ * a reduction kernel (MatrixSumSlicesCUDA). Stream-K
+ * (MatrixMulStreamKCUDA) launches one wave of blocks and gives each of
+ * them an equal share of the tiles x K-steps iteration space, in tile
+ * order; a block that covers only part of a tile adds its partial sum to C
+ * atomically.
+ *
+ * See also:
+ * M. Osama, D. Merrill, C. Cecka, M. Garland and J. D. Owens, "Stream-K:
+ * Work-centric parallel decomposition for dense matrix-matrix
+ * multiplication on the GPU," in Proc. 28th ACM SIGPLAN Annual Symposium
+ * on Principles and Practice of Parallel Programming (PPoPP '23), 2023.
+ */
+
+#ifndef SPLIT_K_KERNELS_CUH_
+#define SPLIT_K_KERNELS_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+/**
+ * Partial sum over k in [kBegin, kEnd) of the element of block sub-matrix
+ * (bx, by) of C = A * B owned by the thread; kBegin must be a multiple of
+ * BLOCK_SIZE. Loads outside A or B are replaced by zeros.
+ * hA is A's height, wA is A's width and wB is B's width
+ */
+template <int BLOCK_SIZE> __device__ __forceinline__ float
+MatrixMulBlockPartial(const float *A, const float *B, int hA, int wA,
+                      int wB, int bx, int by, int kBegin, int kEnd) {
+    __shared__ float As[BLOCK_SIZE][BLOCK_SIZE];
+    __shared__ float Bs[BLOCK_SIZE][BLOCK_SIZE];
+
+    int tx = threadIdx.x;
+    int ty = threadIdx.y;
+    int row = BLOCK_SIZE * by + ty;
+    int col = BLOCK_SIZE * bx + tx;
+    float Csub = 0;
+
+    for (int k0 = kBegin; k0 < kEnd; k0 += BLOCK_SIZE) {
+        As[ty][tx] = (row < hA && k0 + tx < kEnd) ?
+                     A[static_cast<size_t>(row) * wA + k0 + tx] : 0.0f;
+        Bs[ty][tx] = (k0 + ty < kEnd && col < wB) ?
+                     B[static_cast<size_t>(k0 + ty) * wB + col] : 0.0f;
+        __syncthreads();
+
+#pragma unroll
+        for (int k = 0; k < BLOCK_SIZE; ++k) {
+            Csub += As[ty][k] * Bs[k][tx];
+        }
+
+        __syncthreads();
+    }
+
+    return Csub;
+}
+
+/**
+ * Split-K matrix multiplication (CUDA Kernel) on the device: block
+ * (bx, by, z) computes slice z, columns [z * kChunk, (z + 1) * kChunk) of
+ * A, of tile (bx, by). With ATOMIC the slices are added into C, which must
+ * be zero unless there is a single slice; otherwise slice z is stored in
+ * the hA x wB matrix C + z * hA * wB, to be summed by MatrixSumSlicesCUDA.
+ * hA is A's height, wA is A's width and wB is B's width
+ */
+template <int BLOCK_SIZE, bool ATOMIC> __global__ void
+MatrixMulSplitKCUDA(float *C, const float *A, const float *B, int hA,
+                    int wA, int wB, int kChunk) {
+    int kBegin = blockIdx.z * kChunk;
+    int kEnd = kBegin + kChunk < wA ? kBegin + kChunk : wA;
+    float Csub = MatrixMulBlockPartial<BLOCK_SIZE>(A, B, hA, wA, wB,
+                                                   blockIdx.x, blockIdx.y,
+                                                   kBegin, kEnd);
+
+    int row = BLOCK_SIZE * blockIdx.y + threadIdx.y;
+    int col = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+
+    if (row >= hA || col >= wB) {
+        return;
+    }
+
+    size_t c = static_cast<size_t>(row) * wB + col;
+
+    if (ATOMIC && gridDim.z > 1) {
+        atomicAdd(&C[c], Csub);
+    } else {
+        C[c + static_cast<size_t>(blockIdx.z) * hA * wB] = Csub;
+    }
+}
+
+/**
+ * C[i] = sum of P[s * n + i] over the slices s < slices, for i < n
+ */
+template <typename T> __global__ void
+MatrixSumSlicesCUDA(T *C, const T *P, size_t n, int slices) {
+    for (size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) +
+                    threadIdx.x; i < n;
+            i += static_cast<size_t>(gridDim.x) * blockDim.x) {
+        T sum = P[i];
+
+        for (int s = 1; s < slices; ++s) {
+            sum += P[s * n + i];
+        }
+
+        C[i] = sum;
+    }
+}
+
+/**
+ * Stream-K matrix multiplication (CUDA Kernel) on the device: the
+ * iteration space of all tiles times their BLOCK_SIZE-deep K-steps is cut
+ * into gridDim.x contiguous, equal ranges, one per block. A tile that a
+ * block covers completely is stored; the parts of tiles shared between
+ * blocks are added into C with atomics, so C must be zero beforehand.
+ * hA is A's height, wA is A's width and wB is B's width
+ */
+template <int BLOCK_SIZE> __global__ void
+MatrixMulStreamKCUDA(float *C, const float *A, const float *B, int hA,
+                     int wA, int wB) {
+    int tilesX = (wB + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    int tilesY = (hA + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    int steps = (wA + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    long long total = static_cast<long long>(tilesX) * tilesY * steps;
+    long long begin = total * blockIdx.x / gridDim.x;
+    long long end = total * (blockIdx.x + 1) / gridDim.x;
+
+    // The range is uniform over the block, so are the loop and the
+    // barriers in it
+    while (begin < end) {
+        int tile = static_cast<int>(begin / steps);
+        long long tileEnd = static_cast<long long>(tile + 1) * steps;
+        long long stop = end < tileEnd ? end : tileEnd;
+        int kBegin = static_cast<int>(begin - tileEnd + steps) * BLOCK_SIZE;
+        int kEnd = static_cast<int>(stop - tileEnd + steps) * BLOCK_SIZE;
+        kEnd = kEnd < wA ? kEnd : wA;
+
+        int bx = tile % tilesX;
+        int by = tile / tilesX;
+        float Csub = MatrixMulBlockPartial<BLOCK_SIZE>(A, B, hA, wA, wB, bx,
+                                                       by, kBegin, kEnd);
+
+        int row = BLOCK_SIZE * by + threadIdx.y;
+        int col = BLOCK_SIZE * bx + threadIdx.x;
+
+        if (row < hA && col < wB) {
+            size_t c = static_cast<size_t>(row) * wB + col;
+
+            if (kBegin == 0 && kEnd == wA) {
+                C[c] = Csub;
+            } else {
+                atomicAdd(&C[c], Csub);
+            }
+        }
+
+        begin = stop;
+    }
+}
+
+#endif  // SPLIT_K_KERNELS_CUH_
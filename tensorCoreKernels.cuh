@@ -0,0 +1,280 @@
+/**
+ * Tensor Core matrix multiplication: fp16 or bf16 A and B, fp32 accumulation
+ * through WMMA fragments, fp32 or fp16 C. The tiling is the one of
+ * MatrixMulCUDA, except that each warp of the block computes a 16 x 16
+ * fragment of the block sub-matrix instead of each thread computing one
+ * element. fp16 needs compute capability 7.0, bf16 needs 8.0.
+ *
+ * MatrixMulTf32CUDA runs fp32 A and B through the TF32 tensor cores of
+ * compute capability 8.0, either rounded to TF32 or, with SPLIT, as
+ * 3xTF32: every operand x is split into hi = tf32(x) and lo = tf32(x - hi),
+ * and hi * hi + hi * lo + lo * hi is accumulated, which leaves out only
+ * the lo * lo term and so is about as accurate as fp32 FMAs.
+ */
+
+#ifndef TENSOR_CORE_KERNELS_CUH_
+#define TENSOR_CORE_KERNELS_CUH_
+
+// CUDA runtime
+#include <cuda_runtime.h>
+#include <mma.h>
+
+#include "matmulTypes.cuh"
+
+using namespace nvcuda;
+
+// Dimensions of a WMMA fragment (M = N = K)
+#define WMMA_TILE 16
+
+#ifdef __CUDA_ARCH__
+#define WMMA_ARCH __CUDA_ARCH__
+#else
+#define WMMA_ARCH 0
+#endif
+
+// Lowest compute capability (as in __CUDA_ARCH__) with WMMA support for T
+template <typename T> struct WmmaMinArch;
+template <> struct WmmaMinArch<half> { enum { value = 700 }; };
+template <> struct WmmaMinArch<__nv_bfloat16> { enum { value = 800 }; };
+
+/**
+ * Block sub-matrix computation of MatrixMulWmmaCUDA. The primary template is
+ * what gets compiled for architectures without WMMA support for T.
+ */
+template <int BLOCK_SIZE, typename T, typename OutT, bool Enabled>
+struct WmmaTile {
+    static __device__ void Run(OutT *C, const T *A, const T *B,
+                               int hA, int wA, int wB) {}
+};
+
+template <int BLOCK_SIZE, typename T, typename OutT>
+struct WmmaTile<BLOCK_SIZE, T, OutT, true> {
+    static __device__ void Run(OutT *C, const T *A, const T *B,
+                               int hA, int wA, int wB) {
+        // Fragments per side of the block sub-matrix
+        const int TILES = BLOCK_SIZE / WMMA_TILE;
+
+        // Block index
+        int bx = blockIdx.x;
+        int by = blockIdx.y;
+
+        // Thread index and the fragment of the block sub-matrix
+        // owned by its warp
+        int tid = threadIdx.x;
+        int warp = tid / warpSize;
+        int wy = warp / TILES;
+        int wx = warp % TILES;
+
+        // First row and column of the block sub-matrix of C
+        int row0 = BLOCK_SIZE * by;
+        int col0 = BLOCK_SIZE * bx;
+
+        __shared__ __align__(32) T As[BLOCK_SIZE][BLOCK_SIZE];
+        __shared__ __align__(32) T Bs[BLOCK_SIZE][BLOCK_SIZE];
+
+        // Staging area for the accumulators, so that edges and the
+        // conversion to OutT are handled element by element
+        __shared__ __align__(32) float Cs[BLOCK_SIZE][BLOCK_SIZE];
+
+        wmma::fragment<wmma::accumulator, WMMA_TILE, WMMA_TILE, WMMA_TILE,
+                       float> acc;
+        wmma::fill_fragment(acc, 0.0f);
+
+        // Loop over all the sub-matrices of A and B
+        // required to compute the block sub-matrix
+        for (int k0 = 0; k0 < wA; k0 += BLOCK_SIZE) {
+            // Load the matrices from device memory to shared memory;
+            // elements past the edges of A and B are loaded as zeros
+            for (int i = tid; i < BLOCK_SIZE * BLOCK_SIZE; i += blockDim.x) {
+                int r = i / BLOCK_SIZE;
+                int c = i % BLOCK_SIZE;
+                As[r][c] = (row0 + r < hA && k0 + c < wA) ?
+                           A[static_cast<size_t>(row0 + r) * wA + k0 + c] :
+                           FromFloat<T>(0.0f);
+                Bs[r][c] = (k0 + r < wA && col0 + c < wB) ?
+                           B[static_cast<size_t>(k0 + r) * wB + col0 + c] :
+                           FromFloat<T>(0.0f);
+            }
+
+            // Synchronize to make sure the matrices are loaded
+            __syncthreads();
+
+            // Each warp multiplies its row strip of As by its
+            // column strip of Bs, one fragment of K at a time
+#pragma unroll
+            for (int kk = 0; kk < BLOCK_SIZE; kk += WMMA_TILE) {
+                wmma::fragment<wmma::matrix_a, WMMA_TILE, WMMA_TILE,
+                               WMMA_TILE, T, wmma::row_major> aFrag;
+                wmma::fragment<wmma::matrix_b, WMMA_TILE, WMMA_TILE,
+                               WMMA_TILE, T, wmma::row_major> bFrag;
+
+                wmma::load_matrix_sync(aFrag, &As[wy * WMMA_TILE][kk],
+                                       BLOCK_SIZE);
+                wmma::load_matrix_sync(bFrag, &Bs[kk][wx * WMMA_TILE],
+                                       BLOCK_SIZE);
+                wmma::mma_sync(acc, aFrag, bFrag, acc);
+            }
+
+            // Synchronize to make sure that the preceding
+            // computation is done before loading two new
+            // sub-matrices of A and B in the next iteration
+            __syncthreads();
+        }
+
+        wmma::store_matrix_sync(&Cs[wy * WMMA_TILE][wx * WMMA_TILE], acc,
+                                BLOCK_SIZE, wmma::mem_row_major);
+        __syncthreads();
+
+        // Write the block sub-matrix to device memory
+        for (int i = tid; i < BLOCK_SIZE * BLOCK_SIZE; i += blockDim.x) {
+            int r = i / BLOCK_SIZE;
+            int c = i % BLOCK_SIZE;
+
+            if (row0 + r < hA && col0 + c < wB) {
+                C[static_cast<size_t>(row0 + r) * wB + col0 + c] =
+                    FromFloat<OutT>(Cs[r][c]);
+            }
+        }
+    }
+};
+
+/**
+ * Tensor Core matrix multiplication (CUDA Kernel) on the device: C = A * B
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * Launch with (BLOCK_SIZE / 16)^2 warps per block; BLOCK_SIZE must be a
+ * multiple of 16. T is half or __nv_bfloat16, OutT is float or half.
+ */
+template <int BLOCK_SIZE, typename T, typename OutT> __global__ void
+MatrixMulWmmaCUDA(OutT *C, const T *A, const T *B, int hA, int wA, int wB) {
+    WmmaTile<BLOCK_SIZE, T, OutT, (WMMA_ARCH >= WmmaMinArch<T>::value)>::Run(
+        C, A, B, hA, wA, wB);
+}
+
+// K-depth of a TF32 fragment
+#define TF32_TILE_K 8
+
+/**
+ * Block sub-matrix computation of MatrixMulTf32CUDA; as for WmmaTile, the
+ * primary template is compiled for architectures without TF32
+ */
+template <int BLOCK_SIZE, bool SPLIT, bool Enabled> struct Tf32Tile {
+    static __device__ void Run(float *C, const float *A, const float *B,
+                               int hA, int wA, int wB) {}
+};
+
+/**
+ * Round every element of frag to TF32; with SPLIT, lo receives the TF32
+ * remainders
+ */
+template <bool SPLIT, typename Fragment> __device__ __forceinline__ void
+SplitTf32(Fragment *frag, Fragment *lo) {
+#pragma unroll
+    for (int i = 0; i < frag->num_elements; i++) {
+        float x = frag->x[i];
+        float hi = wmma::__float_to_tf32(x);
+        frag->x[i] = hi;
+
+        if (SPLIT) {
+            lo->x[i] = wmma::__float_to_tf32(x - hi);
+        }
+    }
+}
+
+template <int BLOCK_SIZE, bool SPLIT>
+struct Tf32Tile<BLOCK_SIZE, SPLIT, true> {
+    static __device__ void Run(float *C, const float *A, const float *B,
+                               int hA, int wA, int wB) {
+        const int TILES = BLOCK_SIZE / WMMA_TILE;
+
+        int tid = threadIdx.x;
+        int warp = tid / warpSize;
+        int wy = warp / TILES;
+        int wx = warp % TILES;
+        int row0 = BLOCK_SIZE * blockIdx.y;
+        int col0 = BLOCK_SIZE * blockIdx.x;
+
+        // The tiles stay fp32 in shared memory and are rounded once
+        // loaded into fragments; Cs stages the accumulators as in WmmaTile
+        __shared__ __align__(32) float As[BLOCK_SIZE][BLOCK_SIZE];
+        __shared__ __align__(32) float Bs[BLOCK_SIZE][BLOCK_SIZE];
+        __shared__ __align__(32) float Cs[BLOCK_SIZE][BLOCK_SIZE];
+
+        wmma::fragment<wmma::accumulator, WMMA_TILE, WMMA_TILE, TF32_TILE_K,
+                       float> acc;
+        wmma::fill_fragment(acc, 0.0f);
+
+        for (int k0 = 0; k0 < wA; k0 += BLOCK_SIZE) {
+            for (int i = tid; i < BLOCK_SIZE * BLOCK_SIZE; i += blockDim.x) {
+                int r = i / BLOCK_SIZE;
+                int c = i % BLOCK_SIZE;
+                As[r][c] = (row0 + r < hA && k0 + c < wA) ?
+                           A[static_cast<size_t>(row0 + r) * wA + k0 + c] :
+                           0.0f;
+                Bs[r][c] = (k0 + r < wA && col0 + c < wB) ?
+                           B[static_cast<size_t>(k0 + r) * wB + col0 + c] :
+                           0.0f;
+            }
+
+            __syncthreads();
+
+#pragma unroll
+            for (int kk = 0; kk < BLOCK_SIZE; kk += TF32_TILE_K) {
+                wmma::fragment<wmma::matrix_a, WMMA_TILE, WMMA_TILE,
+                               TF32_TILE_K, wmma::precision::tf32,
+                               wmma::row_major> aHi, aLo;
+                wmma::fragment<wmma::matrix_b, WMMA_TILE, WMMA_TILE,
+                               TF32_TILE_K, wmma::precision::tf32,
+                               wmma::row_major> bHi, bLo;
+
+                wmma::load_matrix_sync(aHi, &As[wy * WMMA_TILE][kk],
+                                       BLOCK_SIZE);
+                wmma::load_matrix_sync(bHi, &Bs[kk][wx * WMMA_TILE],
+                                       BLOCK_SIZE);
+                SplitTf32<SPLIT>(&aHi, &aLo);
+                SplitTf32<SPLIT>(&bHi, &bLo);
+
+                // The small terms first, so that they are not lost
+                // against the large one
+                if (SPLIT) {
+                    wmma::mma_sync(acc, aLo, bHi, acc);
+                    wmma::mma_sync(acc, aHi, bLo, acc);
+                }
+
+                wmma::mma_sync(acc, aHi, bHi, acc);
+            }
+
+            __syncthreads();
+        }
+
+        wmma::store_matrix_sync(&Cs[wy * WMMA_TILE][wx * WMMA_TILE], acc,
+                                BLOCK_SIZE, wmma::mem_row_major);
+        __syncthreads();
+
+        for (int i = tid; i < BLOCK_SIZE * BLOCK_SIZE; i += blockDim.x) {
+            int r = i / BLOCK_SIZE;
+            int c = i % BLOCK_SIZE;
+
+            if (row0 + r < hA && col0 + c < wB) {
+                C[static_cast<size_t>(row0 + r) * wB + col0 + c] = Cs[r][c];
+            }
+        }
+    }
+};
+
+/**
+ * TF32 (or, with SPLIT, 3xTF32) Tensor Core matrix multiplication (CUDA
+ * Kernel) on the device: C = A * B in fp32
+ * hA is A's height, wA is A's width and wB is B's width
+ *
+ * Launch with (BLOCK_SIZE / 16)^2 warps per block; BLOCK_SIZE must be a
+ * multiple of 16.
+ */
+template <int BLOCK_SIZE, bool SPLIT> __global__ void
+MatrixMulTf32CUDA(float *C, const float *A, const float *B, int hA, int wA,
+                  int wB) {
+    Tf32Tile<BLOCK_SIZE, SPLIT, (WMMA_ARCH >= 800)>::Run(C, A, B, hA, wA,
+                                                         wB);
+}
+
+#endif  // TENSOR_CORE_KERNELS_CUH_
@@ -0,0 +1,47 @@
+/**
+ * Barrier for a fixed group of host threads, reusable for any number of
+ * rounds.
+ */
+
+#ifndef THREAD_BARRIER_H_
+#define THREAD_BARRIER_H_
+
+// System includes
+#include <condition_variable>
+#include <mutex>
+
+class Barrier {
+ public:
+    explicit Barrier(int count) : count_(count), waiting_(0),
+        generation_(0) {}
+
+    // Block until all count threads have called Wait in this round
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        int generation = generation_;
+
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            generation_++;
+            released_.notify_all();
+            return;
+        }
+
+        while (generation == generation_) {
+            released_.wait(lock);
+        }
+    }
+
+ private:
+    int count_;
+    int waiting_;
+    int generation_;
+    std::mutex mutex_;
+    std::condition_variable released_;
+
+    // Not copyable
+    Barrier(const Barrier &);
+    Barrier &operator=(const Barrier &);
+};
+
+#endif  // THREAD_BARRIER_H_
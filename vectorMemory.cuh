@@ -0,0 +1,117 @@
+/**
+ * Vectorized global memory access for the tiled kernels.
+ *
+ * A row of VEC consecutive floats (VEC = 1, 2 or 4) is moved with a single
+ * float, float2 or float4 instruction when its address is aligned to the
+ * vector size and it lies completely inside the matrix; otherwise it falls
+ * back to VEC predicated scalar accesses. Whether a matrix allows vector
+ * access at all is detected once per kernel with IsVecAligned.
+ */
+
+#ifndef VECTOR_MEMORY_CUH_
+#define VECTOR_MEMORY_CUH_
+
+// System includes
+#include <stdint.h>
+
+// CUDA runtime
+#include <cuda_runtime.h>
+
+// Vector type of VEC floats
+template <int VEC> struct FloatVec;
+template <> struct FloatVec<1> { typedef float Type; };
+template <> struct FloatVec<2> { typedef float2 Type; };
+template <> struct FloatVec<4> { typedef float4 Type; };
+
+/**
+ * True if every row of the matrix at p with leading dimension ld starts on
+ * a VEC-float boundary, so that any access at a column that is a multiple
+ * of VEC is aligned
+ */
+template <int VEC> __host__ __device__ inline bool
+IsVecAligned(const void *p, int ld) {
+    return reinterpret_cast<uintptr_t>(p) % (VEC * sizeof(float)) == 0 &&
+           ld % VEC == 0;
+}
+
+/**
+ * dst[0..VEC) = src[col..col + VEC) of row row of the rows x cols matrix
+ * src with leading dimension ld, zero outside the matrix. col must be a
+ * multiple of VEC for the vector path to be taken.
+ */
+template <int VEC> __device__ inline void
+LoadVec(float *dst, const float *src, int row, int col, int rows, int cols,
+        int ld, bool aligned) {
+    typedef typename FloatVec<VEC>::Type V;
+    const float *from = src + static_cast<size_t>(row) * ld + col;
+
+    if (aligned && row < rows && col + VEC <= cols) {
+        *reinterpret_cast<V *>(dst) = *reinterpret_cast<const V *>(from);
+        return;
+    }
+
+#pragma unroll
+    for (int v = 0; v < VEC; ++v) {
+        dst[v] = (row < rows && col + v < cols) ? from[v] : 0.0f;
+    }
+}
+
+/**
+ * dst[col..col + VEC) of row row = src[0..VEC), skipping the elements
+ * outside the rows x cols matrix dst with leading dimension ld
+ */
+template <int VEC> __device__ inline void
+StoreVec(float *dst, const float *src, int row, int col, int rows, int cols,
+         int ld, bool aligned) {
+    typedef typename FloatVec<VEC>::Type V;
+    float *to = dst + static_cast<size_t>(row) * ld + col;
+
+    if (aligned && row < rows && col + VEC <= cols) {
+        // src is usually a register array, so assemble the vector
+        // element-wise instead of assuming it is aligned
+        V value;
+
+#pragma unroll
+        for (int v = 0; v < VEC; ++v) {
+            reinterpret_cast<float *>(&value)[v] = src[v];
+        }
+
+        *reinterpret_cast<V *>(to) = value;
+        return;
+    }
+
+#pragma unroll
+    for (int v = 0; v < VEC; ++v) {
+        if (row < rows && col + v < cols) {
+            to[v] = src[v];
+        }
+    }
+}
+
+/**
+ * Cooperative load of a ROWS x COLS tile into the row-major shared array
+ * tile by THREADS threads, VEC consecutive floats per thread and step.
+ * src points at the first element of the tile, rows and cols are the
+ * extents of the matrix that remain from there. tile must be aligned to
+ * VEC floats.
+ */
+template <int ROWS, int COLS, int VEC, int THREADS> __device__ inline void
+LoadTileVec(float *tile, const float *src, int ld, int rows, int cols,
+            int tid, bool aligned) {
+    static_assert(COLS % VEC == 0, "tile rows must be whole vectors");
+    const int VECS = ROWS * COLS / VEC;
+
+#pragma unroll
+    for (int it = 0; it < (VECS + THREADS - 1) / THREADS; ++it) {
+        int v = tid + it * THREADS;
+
+        if (VECS % THREADS == 0 || v < VECS) {
+            int r = v * VEC / COLS;
+            int c = v * VEC % COLS;
+            LoadVec<VEC>(&tile[r * COLS + c], src, r, c, rows, cols, ld,
+                         aligned);
+        }
+    }
+}
+
+#endif  // VECTOR_MEMORY_CUH_